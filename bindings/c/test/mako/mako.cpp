@@ -876,6 +876,7 @@ Arguments::Arguments() {
 	}
 	client_threads_per_version = 0;
 	disable_client_bypass = false;
+	client_thread_transaction_sharding = false;
 	disable_ryw = 0;
 	json_output_path[0] = '\0';
 	stats_export_path[0] = '\0';
@@ -994,6 +995,14 @@ int Arguments::setGlobalOptions() const {
 			return -1;
 		}
 	}
+
+	if (client_thread_transaction_sharding) {
+		err = network::setOptionNothrow(FDB_NET_OPTION_CLIENT_THREAD_TRANSACTION_SHARDING);
+		if (err) {
+			logr.error("network::setOption (FDB_NET_OPTION_CLIENT_THREAD_TRANSACTION_SHARDING): {}", err.what());
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -1178,6 +1187,9 @@ void usage() {
 	printf("%-24s %s\n", "    --disable_ryw", "Disable snapshot read-your-writes");
 	printf(
 	    "%-24s %s\n", "    --disable_client_bypass", "Disable client-bypass forcing mako to use multi-version client");
+	printf("%-24s %s\n",
+	       "    --client_thread_transaction_sharding",
+	       "Spread the transactions of each database across all client threads");
 	printf("%-24s %s\n", "    --json_report=PATH", "Output stats to the specified json file (Default: mako.json)");
 	printf("%-24s %s\n",
 	       "    --bg_file_path=PATH",
@@ -1271,6 +1283,7 @@ int parseArguments(int argc, char* argv[], Arguments& args) {
 			{ "trace", no_argument, NULL, ARG_TRACE },
 			{ "version", no_argument, NULL, ARG_VERSION },
 			{ "disable_client_bypass", no_argument, NULL, ARG_DISABLE_CLIENT_BYPASS },
+			{ "client_thread_transaction_sharding", no_argument, NULL, ARG_CLIENT_THREAD_TRANSACTION_SHARDING },
 			{ "disable_ryw", no_argument, NULL, ARG_DISABLE_RYW },
 			{ "enable_token_based_authorization", no_argument, NULL, ARG_ENABLE_TOKEN_BASED_AUTHORIZATION },
 			{ NULL, 0, NULL, 0 }
@@ -1483,6 +1496,9 @@ int parseArguments(int argc, char* argv[], Arguments& args) {
 		case ARG_DISABLE_CLIENT_BYPASS:
 			args.disable_client_bypass = true;
 			break;
+		case ARG_CLIENT_THREAD_TRANSACTION_SHARDING:
+			args.client_thread_transaction_sharding = true;
+			break;
 		case ARG_DISABLE_RYW:
 			args.disable_ryw = 1;
 			break;
@@ -79,6 +79,7 @@ enum ArgKind {
 	ARG_DISABLE_RYW,
 	ARG_CLIENT_THREADS_PER_VERSION,
 	ARG_DISABLE_CLIENT_BYPASS,
+	ARG_CLIENT_THREAD_TRANSACTION_SHARDING,
 	ARG_JSON_REPORT,
 	ARG_BG_FILE_PATH, // if blob granule files are stored locally, mako will read and materialize them if this is set
 	ARG_EXPORT_PATH,
@@ -195,6 +196,7 @@ struct Arguments {
 	FDBStreamingMode streaming_mode;
 	int64_t client_threads_per_version;
 	bool disable_client_bypass;
+	bool client_thread_transaction_sharding;
 	int disable_ryw;
 	char json_output_path[PATH_MAX];
 	bool bg_materialize_files;
@@ -240,6 +240,66 @@ struct RunResult set(struct ResultSet* rs, FDBTransaction* tr) {
 	return RES(SET_COUNT / (end - start), 0);
 }
 
+uint32_t CONCURRENT_SET_COUNT = 100000;
+#define CONCURRENT_SET_THREADS 4
+const char* CONCURRENT_SET_KPI = "C concurrent set throughput per thread (local client)";
+
+struct ConcurrentSetArgs {
+	FDBDatabase* db;
+	int thread;
+	double opsPerSecond;
+	fdb_error_t e;
+};
+
+void* concurrentSetThread(void* arg) {
+	struct ConcurrentSetArgs* args = (struct ConcurrentSetArgs*)arg;
+	FDBTransaction* tr = NULL;
+	args->e = fdb_database_create_transaction(args->db, &tr);
+	if (args->e)
+		return NULL;
+
+	double start = getTime();
+	uint32_t i;
+	for (i = 0; i < CONCURRENT_SET_COUNT; i++) {
+		int k = (int)(((uint64_t)i * 7919 + args->thread) % numKeys);
+		fdb_transaction_set(tr, keys[k], keySize, valueStr, valueSize);
+	}
+	// Wait for the network thread to apply every set, so that the handoff is included in the rate
+	FDBFuture* f = fdb_transaction_get_approximate_size(tr);
+	args->e = waitError(f);
+	fdb_future_destroy(f);
+	double end = getTime();
+
+	fdb_transaction_destroy(tr); // Don't actually set things.
+	args->opsPerSecond = CONCURRENT_SET_COUNT / (end - start);
+	return NULL;
+}
+
+// Sets from several binding threads at once, each on its own transaction, to measure the cost of handing calls to
+// the network thread when it is shared.
+struct RunResult concurrentSet(struct ResultSet* rs, FDBDatabase* db) {
+	pthread_t threads[CONCURRENT_SET_THREADS];
+	struct ConcurrentSetArgs args[CONCURRENT_SET_THREADS];
+	int i;
+	for (i = 0; i < CONCURRENT_SET_THREADS; i++) {
+		args[i].db = db;
+		args[i].thread = i;
+		args[i].opsPerSecond = 0;
+		args[i].e = 0;
+		pthread_create(&threads[i], NULL, &concurrentSetThread, &args[i]);
+	}
+
+	double total = 0;
+	fdb_error_t e = 0;
+	for (i = 0; i < CONCURRENT_SET_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		total += args[i].opsPerSecond;
+		if (args[i].e)
+			e = args[i].e;
+	}
+	return RES(total / CONCURRENT_SET_THREADS, e);
+}
+
 uint32_t PARALLEL_GET_COUNT = 10000;
 const char* PARALLEL_GET_KPI = "C parallel get throughput (local client)";
 struct RunResult parallelGet(struct ResultSet* rs, FDBTransaction* tr) {
@@ -613,6 +673,9 @@ void runTests(struct ResultSet* rs) {
 	printf("set\n");
 	runTest(&set, db, rs, SET_KPI);
 
+	printf("concurrent_set\n");
+	runTestDb(&concurrentSet, db, rs, CONCURRENT_SET_KPI);
+
 	printf("parallel_get\n");
 	runTest(&parallelGet, db, rs, PARALLEL_GET_KPI);
 
@@ -627,6 +627,76 @@ class TransactionInfoLoader(object):
         )
 
 
+class ProfileFileLoader(object):
+    """
+    Reads transactions from the binary profiling files that clients write next to their trace files when the
+    CSI_FILE_SINK knob is set. Each record is, in little endian:
+        uint32 - length of the rest of the record
+        double - time the record was written
+        uint32 - length of the transaction's debug identifier, followed by the identifier
+        the transaction's serialized events, in the same format as the values under client_latency/
+    """
+
+    def __init__(
+        self,
+        paths,
+        full_output=True,
+        type_filter=None,
+        min_timestamp=None,
+        max_timestamp=None,
+    ):
+        self.paths = paths
+        self.full_output = full_output
+        self.type_filter = type_filter
+        self.min_timestamp = min_timestamp
+        self.max_timestamp = max_timestamp
+
+    @staticmethod
+    def read_records(path):
+        with open(path, "rb") as f:
+            data = f.read()
+        offset = 0
+        while offset + 4 <= len(data):
+            length = struct.unpack_from("<I", data, offset)[0]
+            offset += 4
+            if offset + length > len(data):
+                logger.error("Truncated record at offset %d of %s" % (offset - 4, path))
+                return
+            timestamp = struct.unpack_from("<d", data, offset)[0]
+            id_length = struct.unpack_from("<I", data, offset + 8)[0]
+            identifier = data[offset + 12 : offset + 12 + id_length]
+            events = data[offset + 12 + id_length : offset + length]
+            offset += length
+            yield timestamp, identifier, events
+
+    def fetch_transaction_info(self):
+        transaction_infos = 0
+        invalid_transaction_infos = 0
+        for path in self.paths:
+            for timestamp, _, events in self.read_records(path):
+                if self.min_timestamp and timestamp < self.min_timestamp:
+                    continue
+                if self.max_timestamp and timestamp > self.max_timestamp:
+                    continue
+                transaction_infos += 1
+                try:
+                    info = ClientTransactionInfo(
+                        ByteBuffer(events),
+                        full_output=self.full_output,
+                        type_filter=self.type_filter,
+                    )
+                except (UnsupportedProtocolVersionError, ValueError, IndexError):
+                    invalid_transaction_infos += 1
+                    continue
+                if info.has_types():
+                    yield info
+
+        print(
+            "Processed %d transactions, %d invalid\n"
+            % (transaction_infos, invalid_transaction_infos)
+        )
+
+
 def has_sortedcontainers():
     try:
         import sortedcontainers
@@ -771,7 +841,8 @@ class ReadCounter(object):
                 this_range_start_key, last_end, opened_this_range, count_this_range
             )
 
-        shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
+        if shard_finder:
+            shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
         return output_range_counts
 
 
@@ -901,7 +972,8 @@ class WriteCounter(object):
         if count_this_range > 0:
             add_boundary(start_key, k, count_this_range)
 
-        shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
+        if shard_finder:
+            shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
         return output_range_counts
 
     def get_total_writes(self):
@@ -940,6 +1012,13 @@ def connect(cluster_file=None):
 def main():
     parser = argparse.ArgumentParser(description="TransactionProfilingAnalyzer")
     parser.add_argument("-C", "--cluster-file", type=str, help="Cluster file")
+    parser.add_argument(
+        "-f",
+        "--profile-file",
+        action="append",
+        help="Read transactions from a binary profiling file written by a client with the CSI_FILE_SINK knob set, "
+        "instead of from the database. This option can be used multiple times.",
+    )
     parser.add_argument(
         "--full-output", action="store_true", help="Print full output from mutations"
     )
@@ -1076,6 +1155,8 @@ def main():
         import dateparser
 
         min_timestamp = int(dateparser.parse(args.start_time).timestamp())
+    elif args.profile_file:
+        min_timestamp = None
     else:
         raise Exception("Must specify start time")
 
@@ -1087,29 +1168,44 @@ def main():
         import dateparser
 
         max_timestamp = int(dateparser.parse(args.end_time).timestamp())
+    elif args.profile_file:
+        max_timestamp = None
     else:
         raise Exception("Must specify end time")
 
     now = time.time()
-    if max_timestamp > now:
+    if max_timestamp and max_timestamp > now:
         raise Exception(
             "max_timestamp is %d seconds in the future" % (max_timestamp - now)
         )
-    if min_timestamp > now:
+    if min_timestamp and min_timestamp > now:
         raise Exception(
             "min_timestamp is %d seconds in the future" % (min_timestamp - now)
         )
 
-    logger.info("Loading transactions from %d to %d" % (min_timestamp, max_timestamp))
-
-    db = connect(cluster_file=args.cluster_file)
-    loader = TransactionInfoLoader(
-        db,
-        full_output=full_output,
-        type_filter=type_filter,
-        min_timestamp=min_timestamp,
-        max_timestamp=max_timestamp,
-    )
+    if args.profile_file:
+        logger.info("Loading transactions from %s" % ", ".join(args.profile_file))
+        # Shard locations are only looked up if a cluster is given
+        db = connect(cluster_file=args.cluster_file) if args.cluster_file else None
+        loader = ProfileFileLoader(
+            args.profile_file,
+            full_output=full_output,
+            type_filter=type_filter,
+            min_timestamp=min_timestamp,
+            max_timestamp=max_timestamp,
+        )
+    else:
+        logger.info(
+            "Loading transactions from %d to %d" % (min_timestamp, max_timestamp)
+        )
+        db = connect(cluster_file=args.cluster_file)
+        loader = TransactionInfoLoader(
+            db,
+            full_output=full_output,
+            type_filter=type_filter,
+            min_timestamp=min_timestamp,
+            max_timestamp=max_timestamp,
+        )
 
     for info in loader.fetch_transaction_info():
         if info.has_types():
@@ -1209,11 +1305,12 @@ def main():
             else:
                 print(" %d - %d. Omitted\n" % (omit_start + 1, len(range_boundaries)))
 
-    shard_finder = ShardFinder(db, args.exclude_ports)
+    shard_finder = ShardFinder(db, args.exclude_ports) if db else None
 
-    print(
-        "NOTE: shard locations are current and may not reflect where an operation was performed in the past\n"
-    )
+    if shard_finder:
+        print(
+            "NOTE: shard locations are current and may not reflect where an operation was performed in the past\n"
+        )
 
     if write_counter:
         if args.top_requests:
@@ -486,8 +486,9 @@ static void printProgramUsage(const char* name) {
 	       "                 Sets the LogGroup field with the specified value for all\n"
 	       "                 events in the trace output (defaults to `default').\n"
 	       "  --trace-format FORMAT\n"
-	       "                 Select the format of the log files. xml (the default) and json\n"
-	       "                 are supported. Has no effect unless --log is specified.\n"
+	       "                 Select the format of the log files. xml (the default), json\n"
+	       "                 and binary are supported. Has no effect unless --log is\n"
+	       "                 specified.\n"
 	       "  --exec CMDS    Immediately executes the semicolon separated CLI commands\n"
 	       "                 and then exits.\n"
 	       "  --no-status    Disables the initial status check done when starting\n"
@@ -78,6 +78,7 @@ void ClientKnobs::initialize(Randomize randomize) {
 	init( VALUE_SIZE_LIMIT,                        1e5 );
 	init( SPLIT_KEY_SIZE_LIMIT,                    KEY_SIZE_LIMIT/2 );  if( randomize && BUGGIFY ) SPLIT_KEY_SIZE_LIMIT = KEY_SIZE_LIMIT - 31;//serverKeysPrefixFor(UID()).size() - 1;
 	init( METADATA_VERSION_CACHE_SIZE,            1000 );
+	init( METADATA_VERSION_READ_CACHE_BYTES,       1e7 ); if( randomize && BUGGIFY ) METADATA_VERSION_READ_CACHE_BYTES = 1000;
 	init( CHANGE_FEED_LOCATION_LIMIT,            10000 );
 	init( CHANGE_FEED_CACHE_SIZE,               100000 ); if( randomize && BUGGIFY ) CHANGE_FEED_CACHE_SIZE = 1;
 	init( CHANGE_FEED_POP_TIMEOUT,                10.0 );
@@ -100,6 +101,7 @@ void ClientKnobs::initialize(Randomize randomize) {
 
 	init( GET_RANGE_SHARD_LIMIT,                     2 );
 	init( WARM_RANGE_SHARD_LIMIT,                  100 );
+	init( LOCATION_CACHE_PREFETCH_SHARD_LIMIT,       0 ); if( randomize && BUGGIFY ) LOCATION_CACHE_PREFETCH_SHARD_LIMIT = deterministicRandom()->randomInt(1, 1000);
 	init( STORAGE_METRICS_SHARD_LIMIT,             100 ); if( randomize && BUGGIFY ) STORAGE_METRICS_SHARD_LIMIT = 10;
 	init( SHARD_COUNT_LIMIT,                        80 ); if( randomize && BUGGIFY ) SHARD_COUNT_LIMIT = 3;
 	init( STORAGE_METRICS_UNFAIR_SPLIT_LIMIT,  2.0/3.0 );
@@ -267,6 +269,8 @@ void ClientKnobs::initialize(Randomize randomize) {
 		CSI_SIZE_LIMIT = deterministicRandom()->randomInt(1024 * 1024, 100 * 1024 * 1024); // 1 MB - 100 MB
 	}
 	init(CSI_STATUS_DELAY,						  10.0  );
+	init( CSI_FILE_SINK,                          false );
+	init( CSI_TAG_SAMPLING_PROBABILITIES,            "" );
 
 	init( CONSISTENCY_CHECK_RATE_LIMIT_MAX,        50e6 ); // Limit in per sec
 	init( CONSISTENCY_CHECK_ONE_ROUND_TARGET_COMPLETION_TIME,	7 * 24 * 60 * 60 ); // 7 days
@@ -306,6 +310,13 @@ void ClientKnobs::initialize(Randomize randomize) {
 	init( BUSYNESS_SPIKE_START_THRESHOLD,         0.100 );
 	init( BUSYNESS_SPIKE_SATURATED_THRESHOLD,     0.500 );
 
+	// Thread safe client API
+	init( THREAD_SAFE_TRANSACTION_MUTATION_BATCH_SIZE,    64 ); if( randomize && BUGGIFY ) THREAD_SAFE_TRANSACTION_MUTATION_BATCH_SIZE = deterministicRandom()->randomInt(0, 4);
+	init( THREAD_SAFE_TRANSACTION_MUTATION_BATCH_BYTES, 1e5 ); if( randomize && BUGGIFY ) THREAD_SAFE_TRANSACTION_MUTATION_BATCH_BYTES = 100;
+
+	// Read your writes
+	init( WRITE_MAP_FLAT_ENTRY_LIMIT,                   32 ); if( randomize && BUGGIFY ) WRITE_MAP_FLAT_ENTRY_LIMIT = deterministicRandom()->randomInt(0, 8);
+
 	// Blob granules
 	init( BG_MAX_GRANULE_PARALLELISM,                10 );
 	init( BG_TOO_MANY_GRANULES,                   20000 );
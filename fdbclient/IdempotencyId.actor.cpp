@@ -25,10 +25,77 @@
 #include "flow/UnitTest.h"
 #include "flow/actorcompiler.h" // this has to be the last include
 
+namespace {
+
+// See design/idempotency_ids.md for the value formats. A value in the compact format has a zero byte where the
+// original format has the length of its first id, which is at least 16.
+constexpr uint8_t compactFormatMarker = 0;
+constexpr uint8_t fixedLengthIdsFlag = 0x1;
+constexpr uint8_t batchIndexBitmapFlag = 0x2;
+constexpr int fixedIdLength = 16;
+constexpr int batchIndexBitmapBytes = 256 / 8;
+
+// Calls f(id, lowOrderBatchIndex) for each id in value, in batch index order, until f returns true. Returns whether f
+// returned true.
+template <class F>
+bool forEachIdempotencyId(BinaryReader& reader, F const& f) {
+	if (reader.empty()) {
+		return false;
+	}
+	if (*reinterpret_cast<const uint8_t*>(reader.peekBytes(1)) != compactFormatMarker) {
+		while (!reader.empty()) {
+			uint8_t length;
+			reader >> length;
+			StringRef id{ reinterpret_cast<const uint8_t*>(reader.readBytes(length)), length };
+			uint8_t lowOrderBatchIndex;
+			reader >> lowOrderBatchIndex;
+			if (f(id, lowOrderBatchIndex)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint8_t marker, flags;
+	reader >> marker >> flags;
+	uint8_t batchIndices[256];
+	int count = 0;
+	if (flags & batchIndexBitmapFlag) {
+		const uint8_t* bitmap = reinterpret_cast<const uint8_t*>(reader.readBytes(batchIndexBitmapBytes));
+		for (int i = 0; i < 256; i++) {
+			if (bitmap[i / 8] & (1 << (i % 8))) {
+				batchIndices[count++] = i;
+			}
+		}
+	} else {
+		uint8_t countMinusOne;
+		reader >> countMinusOne;
+		count = countMinusOne + 1;
+		memcpy(batchIndices, reader.readBytes(count), count);
+	}
+	for (int i = 0; i < count; i++) {
+		uint8_t length = fixedIdLength;
+		if (!(flags & fixedLengthIdsFlag)) {
+			reader >> length;
+		}
+		StringRef id{ reinterpret_cast<const uint8_t*>(reader.readBytes(length)), length };
+		if (f(id, batchIndices[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
 struct IdempotencyIdKVBuilderImpl {
 	Optional<Version> commitVersion;
 	Optional<uint8_t> batchIndexHighOrderByte;
-	BinaryWriter value{ IncludeVersion() };
+	bool compactFormat = true;
+	// The ids added since the last buildAndClear, back to back, with their lengths and low order batch index bytes
+	std::string ids;
+	std::vector<uint8_t> idLengths;
+	std::vector<uint8_t> lowOrderBatchIndices;
 };
 
 IdempotencyIdKVBuilder::IdempotencyIdKVBuilder() : impl(PImpl<IdempotencyIdKVBuilderImpl>::create()) {}
@@ -37,18 +104,22 @@ void IdempotencyIdKVBuilder::setCommitVersion(Version commitVersion) {
 	impl->commitVersion = commitVersion;
 }
 
+void IdempotencyIdKVBuilder::setCompactFormat(bool compactFormat) {
+	impl->compactFormat = compactFormat;
+}
+
 void IdempotencyIdKVBuilder::add(const IdempotencyIdRef& id, uint16_t batchIndex) {
 	ASSERT(id.valid());
 	if (impl->batchIndexHighOrderByte.present()) {
 		ASSERT((batchIndex >> 8) == impl->batchIndexHighOrderByte.get());
+		ASSERT(uint8_t(batchIndex) > impl->lowOrderBatchIndices.back());
 	} else {
 		impl->batchIndexHighOrderByte = batchIndex >> 8;
-		impl->value << int64_t(now());
 	}
 	StringRef s = id.asStringRefUnsafe();
-	impl->value << uint8_t(s.size());
-	impl->value.serializeBytes(s);
-	impl->value << uint8_t(batchIndex); // Low order byte of batchIndex
+	impl->ids.append(reinterpret_cast<const char*>(s.begin()), s.size());
+	impl->idLengths.push_back(s.size());
+	impl->lowOrderBatchIndices.push_back(uint8_t(batchIndex));
 }
 
 Optional<KeyValue> IdempotencyIdKVBuilder::buildAndClear() {
@@ -57,12 +128,49 @@ Optional<KeyValue> IdempotencyIdKVBuilder::buildAndClear() {
 		return {};
 	}
 
-	Value v = impl->value.toValue();
+	const int count = impl->lowOrderBatchIndices.size();
+	const bool fixedLength = std::all_of(
+	    impl->idLengths.begin(), impl->idLengths.end(), [](uint8_t length) { return length == fixedIdLength; });
+	BinaryWriter writer{ IncludeVersion() };
+	writer << int64_t(now());
+	if (impl->compactFormat) {
+		// Low order batch indices take a byte each, or a bitmap once that's smaller
+		const bool bitmap = count > batchIndexBitmapBytes;
+		writer << compactFormatMarker
+		       << uint8_t((fixedLength ? fixedLengthIdsFlag : 0) | (bitmap ? batchIndexBitmapFlag : 0));
+		if (bitmap) {
+			uint8_t bits[batchIndexBitmapBytes] = {};
+			for (uint8_t i : impl->lowOrderBatchIndices) {
+				bits[i / 8] |= 1 << (i % 8);
+			}
+			writer.serializeBytes(bits, batchIndexBitmapBytes);
+		} else {
+			writer << uint8_t(count - 1);
+			writer.serializeBytes(impl->lowOrderBatchIndices.data(), count);
+		}
+	}
+	if (impl->compactFormat && fixedLength) {
+		writer.serializeBytes(impl->ids.data(), impl->ids.size());
+	} else {
+		int offset = 0;
+		for (int i = 0; i < count; i++) {
+			writer << impl->idLengths[i];
+			writer.serializeBytes(impl->ids.data() + offset, impl->idLengths[i]);
+			offset += impl->idLengths[i];
+			if (!impl->compactFormat) {
+				writer << impl->lowOrderBatchIndices[i];
+			}
+		}
+	}
+
+	Value v = writer.toValue();
 
 	KeyRef key =
 	    makeIdempotencySingleKeyRange(v.arena(), impl->commitVersion.get(), impl->batchIndexHighOrderByte.get()).begin;
 
-	impl->value = BinaryWriter(IncludeVersion());
+	impl->ids.clear();
+	impl->idLengths.clear();
+	impl->lowOrderBatchIndices.clear();
 	impl->batchIndexHighOrderByte = Optional<uint8_t>();
 
 	Optional<KeyValue> result = KeyValue();
@@ -90,22 +198,31 @@ Optional<CommitResult> kvContainsIdempotencyId(const KeyValueRef& kv, const Idem
 	BinaryReader reader(kv.value.begin(), kv.value.size(), IncludeVersion());
 	int64_t timestamp; // ignored
 	reader >> timestamp;
-	while (!reader.empty()) {
-		uint8_t length;
-		reader >> length;
-		StringRef candidate{ reinterpret_cast<const uint8_t*>(reader.readBytes(length)), length };
-		uint8_t lowOrderBatchIndex;
-		reader >> lowOrderBatchIndex;
-		if (candidate == needle) {
-			Version commitVersion;
-			uint8_t highOrderBatchIndex;
-			decodeIdempotencyKey(kv.key, commitVersion, highOrderBatchIndex);
-			return CommitResult{ commitVersion,
-				                 static_cast<uint16_t>((uint16_t(highOrderBatchIndex) << 8) |
-				                                       uint16_t(lowOrderBatchIndex)) };
+	Optional<CommitResult> result;
+	forEachIdempotencyId(reader, [&](StringRef candidate, uint8_t lowOrderBatchIndex) {
+		if (candidate != needle) {
+			return false;
 		}
-	}
-	return {};
+		Version commitVersion;
+		uint8_t highOrderBatchIndex;
+		decodeIdempotencyKey(kv.key, commitVersion, highOrderBatchIndex);
+		result = CommitResult{ commitVersion,
+			                   static_cast<uint16_t>((uint16_t(highOrderBatchIndex) << 8) |
+			                                         uint16_t(lowOrderBatchIndex)) };
+		return true;
+	});
+	return result;
+}
+
+int64_t decodeIdempotencyIdValue(ValueRef value, std::function<void(StringRef, uint8_t)> const& onId) {
+	BinaryReader reader(value.begin(), value.size(), IncludeVersion());
+	int64_t timestamp;
+	reader >> timestamp;
+	forEachIdempotencyId(reader, [&](StringRef id, uint8_t lowOrderBatchIndex) {
+		onId(id, lowOrderBatchIndex);
+		return false;
+	});
+	return timestamp;
 }
 
 void forceLinkIdempotencyIdTests() {}
@@ -174,6 +291,57 @@ TEST_CASE("/fdbclient/IdempotencyId/serialization") {
 	return Void();
 }
 
+TEST_CASE("/fdbclient/IdempotencyId/formats") {
+	for (int i = 0; i < 100; ++i) {
+		Arena arena;
+		const bool compactFormat = deterministicRandom()->coinflip();
+		const bool fixedLength = deterministicRandom()->coinflip();
+		// Enough ids to exercise both ways of storing batch indices in the compact format
+		const int count = deterministicRandom()->randomInt(1, 2 * batchIndexBitmapBytes);
+		const uint8_t highOrderBatchIndex = deterministicRandom()->randomInt(0, 256);
+		const Version commitVersion = deterministicRandom()->randomInt64(0, std::numeric_limits<Version>::max());
+		IdempotencyIdKVBuilder builder;
+		builder.setCommitVersion(commitVersion);
+		builder.setCompactFormat(compactFormat);
+
+		std::vector<uint8_t> lowOrderBatchIndices;
+		for (int b = 0; b < 256; ++b) {
+			lowOrderBatchIndices.push_back(b);
+		}
+		deterministicRandom()->randomShuffle(lowOrderBatchIndices);
+		lowOrderBatchIndices.resize(count);
+		std::sort(lowOrderBatchIndices.begin(), lowOrderBatchIndices.end());
+
+		std::vector<IdempotencyIdRef> ids;
+		for (uint8_t lowOrderBatchIndex : lowOrderBatchIndices) {
+			StringRef id = makeString(fixedLength ? fixedIdLength : deterministicRandom()->randomInt(16, 256), arena);
+			deterministicRandom()->randomBytes(mutateString(id), id.size());
+			ids.emplace_back(id);
+			builder.add(ids.back(), (uint16_t(highOrderBatchIndex) << 8) | lowOrderBatchIndex);
+		}
+		Optional<KeyValue> kv = builder.buildAndClear();
+		ASSERT(kv.present());
+		ASSERT_EQ(kv.get().value[sizeof(uint64_t) + sizeof(int64_t)] == compactFormatMarker, compactFormat);
+
+		int decoded = 0;
+		decodeIdempotencyIdValue(kv.get().value, [&](StringRef id, uint8_t lowOrderBatchIndex) {
+			ASSERT(id == ids[decoded].asStringRefUnsafe());
+			ASSERT_EQ(lowOrderBatchIndex, lowOrderBatchIndices[decoded]);
+			++decoded;
+		});
+		ASSERT_EQ(decoded, count);
+
+		for (int j = 0; j < count; ++j) {
+			auto commitResult = kvContainsIdempotencyId(kv.get(), ids[j]);
+			ASSERT(commitResult.present());
+			ASSERT_EQ(commitResult.get().commitVersion, commitVersion);
+			ASSERT_EQ(commitResult.get().batchIndex, (uint16_t(highOrderBatchIndex) << 8) | lowOrderBatchIndices[j]);
+		}
+		ASSERT(!kvContainsIdempotencyId(kv.get(), generate(arena)).present());
+	}
+	return Void();
+}
+
 KeyRangeRef makeIdempotencySingleKeyRange(Arena& arena, Version version, uint8_t highOrderBatchIndex) {
 	static const auto size =
 	    idempotencyIdKeys.begin.size() + sizeof(version) + sizeof(highOrderBatchIndex) + /*\x00*/ 1;
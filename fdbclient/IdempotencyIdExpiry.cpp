@@ -0,0 +1,265 @@
+/*
+ * IdempotencyIdExpiry.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/IdempotencyIdExpiry.h"
+
+#include "fdbclient/SystemData.h"
+#include "flow/UnitTest.h"
+
+namespace {
+
+// The first idempotency id key at or after version
+KeyRef idempotencyIdVersionKey(Arena& arena, Version version) {
+	StringRef key = makeString(idempotencyIdKeys.begin.size() + sizeof(version), arena);
+	uint8_t* dst = mutateString(key);
+	memcpy(dst, idempotencyIdKeys.begin.begin(), idempotencyIdKeys.begin.size());
+	version = bigEndian64(version);
+	memcpy(dst + idempotencyIdKeys.begin.size(), &version, sizeof(version));
+	return key;
+}
+
+} // namespace
+
+void IdempotencyIdExpiry::addBatch(Version prevVersion,
+                                   Version commitVersion,
+                                   std::vector<std::pair<uint8_t, int16_t>> const& idCounts,
+                                   double now) {
+	ASSERT_LT(prevVersion, commitVersion);
+	Batch& batch = batches[commitVersion];
+	batch = Batch{ prevVersion, 0, !idCounts.empty(), now };
+	if (idCounts.empty()) {
+		return;
+	}
+
+	auto& batchKeys = keys[commitVersion];
+	for (auto [highOrderBatchIndex, count] : idCounts) {
+		KeyState& state = batchKeys[highOrderBatchIndex];
+		ASSERT_EQ(state.expectedCount, 0);
+		ASSERT_LE(state.receivedCount, count);
+		if (state.receivedCount == count) {
+			batchKeys.erase(highOrderBatchIndex);
+			continue;
+		}
+		state.expectedCount = count;
+		if (state.time == 0) {
+			state.time = now;
+		}
+		++batch.unexpiredKeys;
+	}
+	if (batchKeys.empty()) {
+		keys.erase(commitVersion);
+	}
+}
+
+void IdempotencyIdExpiry::expire(Version commitVersion, uint8_t highOrderBatchIndex, double now) {
+	auto& batchKeys = keys[commitVersion];
+	KeyState& state = batchKeys[highOrderBatchIndex];
+	++state.receivedCount;
+	if (state.time == 0) {
+		state.time = now;
+	}
+	CODE_PROBE(state.expectedCount == 0, "ExpireIdempotencyIdRequest received before count is known");
+	if (state.expectedCount == 0) {
+		return;
+	}
+	ASSERT_LE(state.receivedCount, state.expectedCount);
+	if (state.receivedCount == state.expectedCount) {
+		batchKeys.erase(highOrderBatchIndex);
+		if (batchKeys.empty()) {
+			keys.erase(commitVersion);
+		}
+		onKeyExpired(commitVersion);
+	}
+}
+
+void IdempotencyIdExpiry::onKeyExpired(Version commitVersion) {
+	auto batch = batches.find(commitVersion);
+	if (batch != batches.end()) {
+		ASSERT_GT(batch->second.unexpiredKeys, 0);
+		--batch->second.unexpiredKeys;
+	}
+}
+
+void IdempotencyIdExpiry::takeClears(Standalone<VectorRef<MutationRef>>& clears) {
+	auto runBegin = batches.begin();
+	while (runBegin != batches.end()) {
+		if (runBegin->second.unexpiredKeys > 0) {
+			++runBegin;
+			continue;
+		}
+
+		// Extend the run while the next batch is expired and picks up at the version this one ended at
+		bool hasIds = runBegin->second.hasIds;
+		auto runEnd = std::next(runBegin);
+		while (runEnd != batches.end() && runEnd->second.unexpiredKeys == 0 &&
+		       runEnd->second.prevVersion == std::prev(runEnd)->first) {
+			hasIds = hasIds || runEnd->second.hasIds;
+			++runEnd;
+		}
+
+		if (hasIds) {
+			CODE_PROBE(std::next(runBegin) != runEnd, "Idempotency ids of several commit batches cleared together");
+			clears.push_back(clears.arena(),
+			                 MutationRef(MutationRef::ClearRange,
+			                             idempotencyIdVersionKey(clears.arena(), runBegin->second.prevVersion + 1),
+			                             idempotencyIdVersionKey(clears.arena(), std::prev(runEnd)->first + 1)));
+			runBegin = batches.erase(runBegin, runEnd);
+		} else if (runEnd != batches.end()) {
+			// Batches without ids only matter for joining the runs on either side of them, and this run can no
+			// longer be joined to a later one
+			runBegin = batches.erase(runBegin, runEnd);
+		} else {
+			runBegin = runEnd;
+		}
+	}
+}
+
+void IdempotencyIdExpiry::purge(double before) {
+	for (auto batch = batches.begin(); batch != batches.end();) {
+		batch = batch->second.time < before ? batches.erase(batch) : std::next(batch);
+	}
+	for (auto batchKeys = keys.begin(); batchKeys != keys.end();) {
+		auto& states = batchKeys->second;
+		for (auto state = states.begin(); state != states.end();) {
+			state = state->second.time < before ? states.erase(state) : std::next(state);
+		}
+		batchKeys = states.empty() ? keys.erase(batchKeys) : std::next(batchKeys);
+	}
+}
+
+namespace {
+
+Version clearBeginVersion(MutationRef const& clear) {
+	return bigEndian64(*reinterpret_cast<const Version*>(clear.param1.begin() + idempotencyIdKeys.begin.size()));
+}
+
+Version clearEndVersion(MutationRef const& clear) {
+	return bigEndian64(*reinterpret_cast<const Version*>(clear.param2.begin() + idempotencyIdKeys.begin.size()));
+}
+
+} // namespace
+
+TEST_CASE("/fdbclient/IdempotencyIdExpiry/simple") {
+	IdempotencyIdExpiry expiry;
+	Standalone<VectorRef<MutationRef>> clears;
+
+	// Three adjacent batches, the middle one without ids
+	expiry.addBatch(0, 10, { { 0, 2 }, { 1, 1 } }, 1.0);
+	expiry.addBatch(10, 20, {}, 1.0);
+	expiry.addBatch(20, 30, { { 0, 1 } }, 1.0);
+	expiry.takeClears(clears);
+	ASSERT_EQ(clears.size(), 0);
+
+	expiry.expire(10, 0, 1.0);
+	expiry.expire(10, 1, 1.0);
+	expiry.takeClears(clears);
+	ASSERT_EQ(clears.size(), 0);
+
+	// An expire request can arrive before its batch
+	expiry.expire(40, 0, 1.0);
+	expiry.expire(30, 0, 1.0);
+	expiry.expire(10, 0, 1.0);
+	expiry.addBatch(30, 40, { { 0, 1 } }, 1.0);
+	expiry.takeClears(clears);
+	ASSERT_EQ(clears.size(), 1);
+	ASSERT(clears[0].type == MutationRef::ClearRange);
+	ASSERT_EQ(clearBeginVersion(clears[0]), 1);
+	ASSERT_EQ(clearEndVersion(clears[0]), 41);
+	ASSERT_EQ(expiry.batchCount(), 0);
+
+	// Batches from other proxies in between split runs
+	clears = Standalone<VectorRef<MutationRef>>();
+	expiry.addBatch(45, 50, { { 0, 1 } }, 2.0);
+	expiry.addBatch(55, 60, { { 0, 1 } }, 2.0);
+	expiry.expire(50, 0, 2.0);
+	expiry.expire(60, 0, 2.0);
+	expiry.takeClears(clears);
+	ASSERT_EQ(clears.size(), 2);
+	ASSERT_EQ(clearBeginVersion(clears[0]), 46);
+	ASSERT_EQ(clearEndVersion(clears[0]), 51);
+	ASSERT_EQ(clearBeginVersion(clears[1]), 56);
+	ASSERT_EQ(clearEndVersion(clears[1]), 61);
+
+	// Ids that never expire are forgotten, and so is the batch they hold back
+	clears = Standalone<VectorRef<MutationRef>>();
+	expiry.addBatch(60, 70, { { 0, 2 } }, 3.0);
+	expiry.addBatch(70, 80, {}, 3.0);
+	expiry.expire(70, 0, 3.0);
+	expiry.takeClears(clears);
+	ASSERT_EQ(clears.size(), 0);
+	ASSERT_EQ(expiry.batchCount(), 2);
+	expiry.purge(4.0);
+	ASSERT_EQ(expiry.batchCount(), 0);
+	expiry.expire(70, 0, 5.0);
+	expiry.takeClears(clears);
+	ASSERT_EQ(clears.size(), 0);
+	return Void();
+}
+
+TEST_CASE("/fdbclient/IdempotencyIdExpiry/random") {
+	IdempotencyIdExpiry expiry;
+	Standalone<VectorRef<MutationRef>> clears;
+	// Expire requests not sent yet, by commit version and high order batch index
+	std::vector<std::pair<Version, uint8_t>> pending;
+	std::map<Version, bool> batchHasIds;
+	Version version = 0;
+	for (int i = 0; i < 1000; i++) {
+		const Version prevVersion = version + (deterministicRandom()->random01() < 0.1 ? 5 : 0);
+		version = prevVersion + deterministicRandom()->randomInt(1, 10);
+		std::vector<std::pair<uint8_t, int16_t>> idCounts;
+		const int keyCount = deterministicRandom()->randomInt(0, 3);
+		for (int key = 0; key < keyCount; key++) {
+			idCounts.emplace_back(key, deterministicRandom()->randomInt(1, 4));
+			for (int id = 0; id < idCounts.back().second; id++) {
+				pending.emplace_back(version, key);
+			}
+		}
+		batchHasIds[version] = !idCounts.empty();
+		expiry.addBatch(prevVersion, version, idCounts, 0.0);
+		deterministicRandom()->randomShuffle(pending);
+		while (pending.size() > 20) {
+			expiry.expire(pending.back().first, pending.back().second, 0.0);
+			pending.pop_back();
+		}
+		if (deterministicRandom()->coinflip()) {
+			expiry.takeClears(clears);
+		}
+	}
+	for (auto [commitVersion, highOrderBatchIndex] : pending) {
+		expiry.expire(commitVersion, highOrderBatchIndex, 0.0);
+	}
+	expiry.takeClears(clears);
+
+	// Every batch with ids is cleared exactly once
+	std::map<Version, int> clearCount;
+	for (auto const& clear : clears) {
+		const Version begin = clearBeginVersion(clear);
+		const Version end = clearEndVersion(clear);
+		ASSERT_LT(begin, end);
+		for (auto batch = batchHasIds.lower_bound(begin); batch != batchHasIds.end() && batch->first < end; ++batch) {
+			++clearCount[batch->first];
+		}
+	}
+	for (auto [commitVersion, hasIds] : batchHasIds) {
+		ASSERT(!hasIds || clearCount[commitVersion] == 1);
+		ASSERT_LE(clearCount[commitVersion], 1);
+	}
+	return Void();
+}
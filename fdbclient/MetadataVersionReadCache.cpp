@@ -0,0 +1,235 @@
+/*
+ * MetadataVersionReadCache.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/MetadataVersionReadCache.h"
+
+#include <algorithm>
+
+#include "fdbclient/Knobs.h"
+#include "flow/UnitTest.h"
+
+namespace {
+
+// Metadata versions are versionstamps, so they order like the versions they were committed at. A database whose
+// metadata version key was never set has no metadata version.
+bool isOlder(Optional<Value> const& a, Optional<Value> const& b) {
+	return b.present() && (!a.present() || a.get() < b.get());
+}
+
+} // namespace
+
+void MetadataVersionReadCache::addPrefix(KeyRef prefix) {
+	prefixes.push_back(prefixRange(prefix));
+}
+
+bool MetadataVersionReadCache::isCached(KeyRangeRef keys) const {
+	return std::any_of(
+	    prefixes.begin(), prefixes.end(), [&](KeyRange const& prefix) { return prefix.contains(keys); });
+}
+
+Optional<RangeResult> MetadataVersionReadCache::get(KeyRangeRef keys,
+                                                    Optional<Value> const& metadataVersion,
+                                                    GetRangeLimits limits,
+                                                    Reverse reverse) const {
+	if (entries.empty() || !(metadataVersion == this->metadataVersion)) {
+		return Optional<RangeResult>();
+	}
+	auto entry = entries.upper_bound(keys.begin);
+	if (entry == entries.begin()) {
+		return Optional<RangeResult>();
+	}
+	--entry;
+	if (entry->second.end < keys.end) {
+		return Optional<RangeResult>();
+	}
+
+	RangeResult const& rows = entry->second.rows;
+	auto keyLess = [](KeyValueRef const& row, KeyRef key) { return row.key < key; };
+	auto first = std::lower_bound(rows.begin(), rows.end(), keys.begin, keyLess);
+	auto last = std::lower_bound(first, rows.end(), keys.end, keyLess);
+
+	RangeResult result;
+	result.arena().dependsOn(rows.arena());
+	while (first != last && !limits.isReached()) {
+		KeyValueRef const& row = reverse ? *--last : *first++;
+		result.push_back(result.arena(), row);
+		limits.decrement(row);
+	}
+	result.more = first != last;
+	return result;
+}
+
+void MetadataVersionReadCache::insert(KeyRangeRef keys,
+                                      RangeResultRef const& rows,
+                                      Optional<Value> const& metadataVersion,
+                                      Reverse reverse) {
+	if (!entries.empty() && !(metadataVersion == this->metadataVersion)) {
+		if (isOlder(metadataVersion, this->metadataVersion)) {
+			// A transaction with an older read version finished after the cache moved on
+			return;
+		}
+		clear();
+	}
+
+	Entry entry{ Key(keys.end), RangeResult(), 0 };
+	entry.rows.reserve(entry.rows.arena(), rows.size());
+	for (int i = 0; i < rows.size(); i++) {
+		entry.rows.push_back_deep(entry.rows.arena(), rows[reverse ? rows.size() - 1 - i : i]);
+	}
+	entry.bytes = keys.expectedSize() + entry.rows.expectedSize();
+	if (entry.bytes > CLIENT_KNOBS->METADATA_VERSION_READ_CACHE_BYTES) {
+		return;
+	}
+	if (bytes + entry.bytes > CLIENT_KNOBS->METADATA_VERSION_READ_CACHE_BYTES) {
+		CODE_PROBE(true, "Metadata version read cache full");
+		clear();
+	}
+	this->metadataVersion = metadataVersion;
+
+	auto overlap = entries.upper_bound(keys.begin);
+	if (overlap != entries.begin() && std::prev(overlap)->second.end > keys.begin) {
+		--overlap;
+	}
+	while (overlap != entries.end() && overlap->first < keys.end) {
+		bytes -= overlap->second.bytes;
+		overlap = entries.erase(overlap);
+	}
+	bytes += entry.bytes;
+	entries.emplace(Key(keys.begin), std::move(entry));
+}
+
+void MetadataVersionReadCache::clear() {
+	entries.clear();
+	bytes = 0;
+	metadataVersion = Optional<Value>();
+}
+
+TEST_CASE("/fdbclient/MetadataVersionReadCache/simple") {
+	MetadataVersionReadCache cache;
+	ASSERT(!cache.hasPrefixes());
+	cache.addPrefix("config/"_sr);
+	ASSERT(cache.hasPrefixes());
+	ASSERT(cache.isCached(KeyRangeRef("config/a"_sr, "config/b"_sr)));
+	ASSERT(!cache.isCached(KeyRangeRef("config/a"_sr, "configz"_sr)));
+	ASSERT(!cache.isCached(singleKeyRange("data"_sr)));
+
+	const Optional<Value> v1 = Value("\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00"_sr);
+	const Optional<Value> v2 = Value("\x00\x00\x00\x00\x00\x00\x00\x02\x00\x00"_sr);
+	const KeyRange all = prefixRange("config/"_sr);
+	ASSERT(!cache.get(all, v1, GetRangeLimits(), Reverse::False).present());
+
+	RangeResult rows;
+	for (int i = 0; i < 10; i++) {
+		rows.push_back_deep(rows.arena(), KeyValueRef(Key(format("config/%02d", i)), Value(format("value%d", i))));
+	}
+	cache.insert(all, rows, v1, Reverse::False);
+	ASSERT_GT(cache.getBytes(), 0);
+
+	// Only transactions that saw the same metadata version are served
+	ASSERT(!cache.get(all, v2, GetRangeLimits(), Reverse::False).present());
+	ASSERT(!cache.get(all, Optional<Value>(), GetRangeLimits(), Reverse::False).present());
+
+	Optional<RangeResult> hit = cache.get(all, v1, GetRangeLimits(), Reverse::False);
+	ASSERT(hit.present() && hit.get().size() == 10 && !hit.get().more);
+
+	hit = cache.get(KeyRangeRef("config/03"_sr, "config/07"_sr), v1, GetRangeLimits(), Reverse::False);
+	ASSERT(hit.present() && hit.get().size() == 4 && !hit.get().more);
+	ASSERT(hit.get()[0].key == "config/03"_sr);
+
+	hit = cache.get(all, v1, GetRangeLimits(3), Reverse::True);
+	ASSERT(hit.present() && hit.get().size() == 3 && hit.get().more);
+	ASSERT(hit.get()[0].key == "config/09"_sr && hit.get()[2].key == "config/07"_sr);
+
+	// Inserting a range replaces the entries it overlaps, and reads of keys that are no longer cached miss
+	cache.insert(KeyRangeRef("config/"_sr, "config/05"_sr),
+	             RangeResultRef(VectorRef<KeyValueRef>(rows.begin(), 5), false),
+	             v1,
+	             Reverse::False);
+	ASSERT(!cache.get(KeyRangeRef("config/04"_sr, "config/06"_sr), v1, GetRangeLimits(), Reverse::False).present());
+
+	// An older metadata version doesn't displace the cache, and a newer one drops it
+	cache.insert(all, rows, Optional<Value>(), Reverse::False);
+	ASSERT(!cache.get(all, Optional<Value>(), GetRangeLimits(), Reverse::False).present());
+	cache.insert(singleKeyRange("config/00"_sr),
+	             RangeResultRef(VectorRef<KeyValueRef>(rows.begin(), 1), false),
+	             v2,
+	             Reverse::False);
+	ASSERT(!cache.get(singleKeyRange("config/01"_sr), v1, GetRangeLimits(), Reverse::False).present());
+	hit = cache.get(singleKeyRange("config/00"_sr), v2, GetRangeLimits(), Reverse::False);
+	ASSERT(hit.present() && hit.get().size() == 1 && hit.get()[0].value == "value0"_sr);
+
+	cache.clear();
+	ASSERT_EQ(cache.getBytes(), 0);
+	return Void();
+}
+
+TEST_CASE("/fdbclient/MetadataVersionReadCache/random") {
+	MetadataVersionReadCache cache;
+	const Optional<Value> version = Value("\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00"_sr);
+	std::map<Key, Value> data;
+	for (int i = 0; i < 100; i++) {
+		data[Key(format("%03d", deterministicRandom()->randomInt(0, 1000)))] = Value(format("%d", i));
+	}
+
+	auto readRange = [&](KeyRangeRef keys) {
+		RangeResult rows;
+		for (auto it = data.lower_bound(keys.begin); it != data.end() && it->first < keys.end; ++it) {
+			rows.push_back_deep(rows.arena(), KeyValueRef(it->first, it->second));
+		}
+		return rows;
+	};
+	auto randomRange = [] {
+		int a = deterministicRandom()->randomInt(0, 1001);
+		int b = deterministicRandom()->randomInt(0, 1001);
+		return KeyRange(KeyRangeRef(Key(format("%03d", std::min(a, b))), Key(format("%03d", std::max(a, b)))));
+	};
+
+	for (int i = 0; i < 1000; i++) {
+		KeyRange keys = randomRange();
+		if (deterministicRandom()->coinflip()) {
+			const Reverse reverse{ deterministicRandom()->coinflip() };
+			RangeResult rows = readRange(keys);
+			if (reverse) {
+				std::reverse(rows.begin(), rows.end());
+			}
+			cache.insert(keys, rows, version, reverse);
+			continue;
+		}
+
+		const Reverse reverse{ deterministicRandom()->coinflip() };
+		GetRangeLimits limits(deterministicRandom()->coinflip() ? GetRangeLimits::ROW_LIMIT_UNLIMITED
+		                                                        : deterministicRandom()->randomInt(1, 10));
+		Optional<RangeResult> hit = cache.get(keys, version, limits, reverse);
+		if (!hit.present()) {
+			continue;
+		}
+		RangeResult expected = readRange(keys);
+		if (reverse) {
+			std::reverse(expected.begin(), expected.end());
+		}
+		const int rows = limits.hasRowLimit() ? std::min(limits.rows, expected.size()) : expected.size();
+		ASSERT_EQ(hit.get().size(), rows);
+		ASSERT_EQ(hit.get().more, rows < expected.size());
+		for (int j = 0; j < rows; j++) {
+			ASSERT(hit.get()[j] == expected[j]);
+		}
+	}
+	return Void();
+}
@@ -2708,6 +2708,108 @@ void MultiVersionDatabase::LegacyVersionMonitor::close() {
 	}
 }
 
+// ShardedMultiVersionDatabase
+ShardedMultiVersionDatabase::ShardedMultiVersionDatabase(std::vector<Reference<IDatabase>> shards)
+  : shards(std::move(shards)) {
+	ASSERT(!this->shards.empty());
+}
+
+Reference<IDatabase> const& ShardedMultiVersionDatabase::nextShard() {
+	return shards[next.fetch_add(1, std::memory_order_relaxed) % shards.size()];
+}
+
+Reference<ITenant> ShardedMultiVersionDatabase::openTenant(TenantNameRef tenantName) {
+	return nextShard()->openTenant(tenantName);
+}
+
+Reference<ITransaction> ShardedMultiVersionDatabase::createTransaction() {
+	return nextShard()->createTransaction();
+}
+
+void ShardedMultiVersionDatabase::setOption(FDBDatabaseOptions::Option option, Optional<StringRef> value) {
+	for (auto& shard : shards) {
+		shard->setOption(option, value);
+	}
+}
+
+// The busiest client thread determines whether the database as a whole is saturated
+double ShardedMultiVersionDatabase::getMainThreadBusyness() {
+	double busyness = 0.0;
+	for (auto& shard : shards) {
+		busyness = std::max(busyness, shard->getMainThreadBusyness());
+	}
+	return busyness;
+}
+
+ThreadFuture<ProtocolVersion> ShardedMultiVersionDatabase::getServerProtocol(
+    Optional<ProtocolVersion> expectedVersion) {
+	return shards[0]->getServerProtocol(expectedVersion);
+}
+
+ThreadFuture<int64_t> ShardedMultiVersionDatabase::rebootWorker(const StringRef& address, bool check, int duration) {
+	return shards[0]->rebootWorker(address, check, duration);
+}
+
+ThreadFuture<Void> ShardedMultiVersionDatabase::forceRecoveryWithDataLoss(const StringRef& dcid) {
+	return shards[0]->forceRecoveryWithDataLoss(dcid);
+}
+
+ThreadFuture<Void> ShardedMultiVersionDatabase::createSnapshot(const StringRef& uid,
+                                                              const StringRef& snapshot_command) {
+	return shards[0]->createSnapshot(uid, snapshot_command);
+}
+
+ThreadFuture<Key> ShardedMultiVersionDatabase::purgeBlobGranules(const KeyRangeRef& keyRange,
+                                                                 Version purgeVersion,
+                                                                 bool force) {
+	return shards[0]->purgeBlobGranules(keyRange, purgeVersion, force);
+}
+
+ThreadFuture<Void> ShardedMultiVersionDatabase::waitPurgeGranulesComplete(const KeyRef& purgeKey) {
+	return shards[0]->waitPurgeGranulesComplete(purgeKey);
+}
+
+ThreadFuture<bool> ShardedMultiVersionDatabase::blobbifyRange(const KeyRangeRef& keyRange) {
+	return shards[0]->blobbifyRange(keyRange);
+}
+
+ThreadFuture<bool> ShardedMultiVersionDatabase::blobbifyRangeBlocking(const KeyRangeRef& keyRange) {
+	return shards[0]->blobbifyRangeBlocking(keyRange);
+}
+
+ThreadFuture<bool> ShardedMultiVersionDatabase::unblobbifyRange(const KeyRangeRef& keyRange) {
+	return shards[0]->unblobbifyRange(keyRange);
+}
+
+ThreadFuture<Standalone<VectorRef<KeyRangeRef>>> ShardedMultiVersionDatabase::listBlobbifiedRanges(
+    const KeyRangeRef& keyRange,
+    int rangeLimit) {
+	return shards[0]->listBlobbifiedRanges(keyRange, rangeLimit);
+}
+
+ThreadFuture<Version> ShardedMultiVersionDatabase::verifyBlobRange(const KeyRangeRef& keyRange,
+                                                                   Optional<Version> version) {
+	return shards[0]->verifyBlobRange(keyRange, version);
+}
+
+ThreadFuture<bool> ShardedMultiVersionDatabase::flushBlobRange(const KeyRangeRef& keyRange,
+                                                               bool compact,
+                                                               Optional<Version> version) {
+	return shards[0]->flushBlobRange(keyRange, compact, version);
+}
+
+ThreadFuture<DatabaseSharedState*> ShardedMultiVersionDatabase::createSharedState() {
+	return shards[0]->createSharedState();
+}
+
+void ShardedMultiVersionDatabase::setSharedState(DatabaseSharedState* p) {
+	shards[0]->setSharedState(p);
+}
+
+ThreadFuture<Standalone<StringRef>> ShardedMultiVersionDatabase::getClientStatus() {
+	return shards[0]->getClientStatus();
+}
+
 // MultiVersionApi
 void MultiVersionApi::runOnExternalClientsAllThreads(std::function<void(Reference<ClientInfo>)> func,
                                                      bool runOnFailedClients,
@@ -3035,6 +3137,13 @@ void MultiVersionApi::setNetworkOptionInternal(FDBNetworkOptions::Option option,
 		// multiple client threads are not supported on windows.
 		threadCount = extractIntOption(value, 1, 1);
 #endif
+	} else if (option == FDBNetworkOptions::CLIENT_THREAD_TRANSACTION_SHARDING) {
+		MutexHolder holder(lock);
+		validateOption(value, false, true);
+		if (networkStartSetup) {
+			throw invalid_option();
+		}
+		shardTransactionsAcrossThreads = true;
 	} else if (option == FDBNetworkOptions::CLIENT_TMP_DIR) {
 		validateOption(value, true, false, false);
 		tmpDir = abspath(value.get().toString());
@@ -3304,6 +3413,19 @@ Reference<IDatabase> MultiVersionApi::createDatabase(ClusterConnectionRecord con
 	if (localClientDisabled) {
 		ASSERT(!bypassMultiClientApi);
 
+		if (shardTransactionsAcrossThreads && threadCount > 1) {
+			int shardCount = threadCount;
+			lock.leave();
+
+			std::vector<Reference<IDatabase>> shards;
+			for (int threadIdx = 0; threadIdx < shardCount; threadIdx++) {
+				Reference<IDatabase> localDb = connectionRecord.createDatabase(localClient->api);
+				shards.push_back(Reference<IDatabase>(
+				    new MultiVersionDatabase(this, threadIdx, connectionRecord, Reference<IDatabase>(), localDb)));
+			}
+			return Reference<IDatabase>(new ShardedMultiVersionDatabase(std::move(shards)));
+		}
+
 		int threadIdx = nextThread;
 		nextThread = (nextThread + 1) % threadCount;
 		lock.leave();
@@ -3541,8 +3663,9 @@ void MultiVersionApi::loadEnvironmentVariableNetworkOptions() {
 MultiVersionApi::MultiVersionApi()
   : callbackOnMainThread(true), localClientDisabled(false), networkStartSetup(false), networkSetup(false),
     disableBypass(false), bypassMultiClientApi(false), externalClient(false), ignoreExternalClientFailures(false),
-    failIncompatibleClient(false), retainClientLibCopies(false), apiVersion(0), threadCount(0), tmpDir("/tmp"),
-    traceShareBaseNameAmongThreads(false), envOptionsLoaded(false) {}
+    failIncompatibleClient(false), retainClientLibCopies(false), apiVersion(0), threadCount(0),
+    shardTransactionsAcrossThreads(false), tmpDir("/tmp"), traceShareBaseNameAmongThreads(false),
+    envOptionsLoaded(false) {}
 
 MultiVersionApi* MultiVersionApi::api = new MultiVersionApi();
 
@@ -444,6 +444,16 @@ StorageServerInfo::~StorageServerInfo() {
 	}
 }
 
+LocationInfo::Team LocationInfo::getTeam(const std::vector<Reference<ReferencedInterface<StorageServerInterface>>>& v) {
+	Team team;
+	team.reserve(v.size());
+	for (const auto& interf : v) {
+		team.push_back(interf.getPtr());
+	}
+	std::sort(team.begin(), team.end());
+	return team;
+}
+
 std::string printable(const VectorRef<KeyValueRef>& val) {
 	std::string s;
 	for (int i = 0; i < val.size(); i++)
@@ -834,6 +844,102 @@ ACTOR static Future<Void> refreshTransaction(DatabaseContext* self, Transaction*
 	return Void();
 }
 
+// Parses CSI_TAG_SAMPLING_PROBABILITIES, a comma separated list of tag:probability pairs. Malformed pairs are skipped.
+static std::vector<std::pair<TransactionTag, double>> parseTagSamplingProbabilities(std::string const& knob) {
+	std::vector<std::pair<TransactionTag, double>> result;
+	StringRef remaining(knob);
+	while (!remaining.empty()) {
+		StringRef pair = remaining.eat(","_sr);
+		int separator = pair.size() - 1;
+		while (separator >= 0 && pair[separator] != ':') {
+			--separator;
+		}
+		double probability;
+		if (separator <= 0 || sscanf(pair.substr(separator + 1).toString().c_str(), "%lf", &probability) != 1) {
+			TraceEvent(SevWarnAlways, "InvalidTagSamplingProbability").detail("Value", pair);
+			continue;
+		}
+		result.emplace_back(TransactionTag(pair.substr(0, separator)), probability);
+	}
+	return result;
+}
+
+// Client profiling records written with CSI_FILE_SINK are appended to the "fdbprof" binary trace log, to be read by
+// contrib/transaction_profiling_analyzer. Each record is, in little endian:
+//   uint32  length of the rest of the record
+//   double  time the record was written
+//   uint32  length of the transaction's debug identifier, followed by the identifier
+//   the transaction's serialized FdbClientLogEvents, as stored in the values under fdbClientInfo/client_latency/
+static std::string encodeClientProfilingRecords(std::vector<std::pair<std::string, BinaryWriter>>& transactions) {
+	BinaryWriter records(Unversioned());
+	for (auto& [identifier, events] : transactions) {
+		records << uint32_t(sizeof(double) + sizeof(uint32_t) + identifier.size() + events.getLength()) << now()
+		        << uint32_t(identifier.size());
+		records.serializeBytes(StringRef(identifier));
+		records.serializeBytes(events.getData(), events.getLength());
+	}
+	return std::string(static_cast<const char*>(records.getData()), records.getLength());
+}
+
+static void writeClientProfilingRecords(std::vector<std::pair<std::string, BinaryWriter>>& transactions) {
+	if (!writeBinaryTraceLog("fdbprof", encodeClientProfilingRecords(transactions))) {
+		CODE_PROBE(true, "Client profiling records dropped without trace files");
+	}
+}
+
+TEST_CASE("/fdbclient/NativeAPI/ClientProfilingFileSink") {
+	if (!traceFileIsOpen()) {
+		return Void();
+	}
+	// An extension of its own keeps the test's records out of the real client profiling files
+	state std::string extension = "fdbproftest" + deterministicRandom()->randomAlphaNumeric(8);
+	state std::vector<std::pair<std::string, BinaryWriter>> transactions;
+	for (int i = 0; i < 3; i++) {
+		BinaryWriter events(IncludeVersion());
+		for (int j = 0; j <= i; j++) {
+			events << FdbClientLogEvents::EventGet(now(),
+			                                       Optional<Standalone<StringRef>>(),
+			                                       0.001 * j,
+			                                       10 * j,
+			                                       Key(format("key%d", j)),
+			                                       Optional<TenantName>());
+		}
+		transactions.emplace_back(i ? format("transaction%d", i) : "", std::move(events));
+	}
+	ASSERT(writeBinaryTraceLog(extension, encodeClientProfilingRecords(transactions)));
+	wait(pingTraceLogWriterThread());
+
+	std::vector<std::string> files = getBinaryTraceLogFiles(extension);
+	ASSERT_EQ(files.size(), 1);
+	std::string data = readFileBytes(files[0], 1 << 20);
+	deleteFile(files[0]);
+
+	BinaryReader reader(data, Unversioned());
+	for (int i = 0; i < transactions.size(); i++) {
+		uint32_t length, identifierLength;
+		double time;
+		reader >> length >> time >> identifierLength;
+		ASSERT_LE(time, now());
+		ASSERT_EQ(std::string((const char*)reader.readBytes(identifierLength), identifierLength), transactions[i].first);
+		const int eventsLength = length - sizeof(double) - sizeof(uint32_t) - identifierLength;
+		ASSERT_EQ(eventsLength, transactions[i].second.getLength());
+
+		BinaryReader events(reader.readBytes(eventsLength), eventsLength, IncludeVersion());
+		for (int j = 0; j <= i; j++) {
+			FdbClientLogEvents::Event event;
+			events >> event;
+			ASSERT(event.type == FdbClientLogEvents::EventType::GET_LATENCY);
+			FdbClientLogEvents::EventGet get;
+			events >> get;
+			ASSERT_EQ(get.valueSize, 10 * j);
+			ASSERT(get.key == Key(format("key%d", j)));
+		}
+		ASSERT(events.empty());
+	}
+	ASSERT(reader.empty());
+	return Void();
+}
+
 // The reason for getting a pointer to DatabaseContext instead of a reference counted object is because reference
 // counting will increment reference count for DatabaseContext which holds the future of this actor. This creates a
 // cyclic reference and hence this actor and Database object will not be destroyed at all.
@@ -851,6 +957,15 @@ ACTOR static Future<Void> clientStatusUpdateActor(DatabaseContext* cx) {
 		try {
 			ASSERT(cx->clientStatusUpdater.outStatusQ.empty());
 			cx->clientStatusUpdater.inStatusQ.swap(cx->clientStatusUpdater.outStatusQ);
+			if (CLIENT_KNOBS->CSI_FILE_SINK) {
+				// Local files are not size limited by CSI_SIZE_LIMIT, so there is nothing to clean up in the database
+				if (!cx->clientStatusUpdater.outStatusQ.empty()) {
+					writeClientProfilingRecords(cx->clientStatusUpdater.outStatusQ);
+				}
+				cx->clientStatusUpdater.outStatusQ.clear();
+				wait(delay(CLIENT_KNOBS->CSI_STATUS_DELAY));
+				continue;
+			}
 			// Split Transaction Info into chunks
 			state std::vector<TrInfoChunk> trChunksQ;
 			for (auto& entry : cx->clientStatusUpdater.outStatusQ) {
@@ -1546,6 +1661,7 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<IClusterConnection
     transactionGetRangeStreamRequests("GetRangeStreamRequests", cc), transactionWatchRequests("WatchRequests", cc),
     transactionGetAddressesForKeyRequests("GetAddressesForKeyRequests", cc), transactionBytesRead("BytesRead", cc),
     transactionKeysRead("KeysRead", cc), transactionMetadataVersionReads("MetadataVersionReads", cc),
+    transactionMetadataVersionCacheHits("MetadataVersionCacheHits", cc),
     transactionCommittedMutations("CommittedMutations", cc),
     transactionCommittedMutationBytes("CommittedMutationBytes", cc), transactionSetMutations("SetMutations", cc),
     transactionClearMutations("ClearMutations", cc), transactionAtomicMutations("AtomicMutations", cc),
@@ -1561,6 +1677,7 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<IClusterConnection
     transactionsProcessBehind("ProcessBehind", cc), transactionsThrottled("Throttled", cc),
     transactionsExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc),
     transactionGrvFullBatches("NumGrvFullBatches", cc), transactionGrvTimedOutBatches("NumGrvTimedOutBatches", cc),
+    transactionSharedGrvHits("SharedGrvHits", cc), transactionSharedGrvMisses("SharedGrvMisses", cc),
     transactionCommitVersionNotFoundForSS("CommitVersionNotFoundForSS", cc), anyBGReads(false),
     ccBG("BlobGranuleReadMetrics", dbId.toString()), bgReadInputBytes("BGReadInputBytes", ccBG),
     bgReadOutputBytes("BGReadOutputBytes", ccBG), bgReadSnapshotRows("BGReadSnapshotRows", ccBG),
@@ -1599,6 +1716,11 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<IClusterConnection
 	clientDBInfoMonitor = monitorClientDBInfoChange(this, clientInfo, &proxiesChangeTrigger);
 	tssMismatchHandler = handleTssMismatches(this);
 	clientStatusUpdater.actor = clientStatusUpdateActor(this);
+	for (const auto& [tag, probability] : parseTagSamplingProbabilities(CLIENT_KNOBS->CSI_TAG_SAMPLING_PROBABILITIES)) {
+		clientStatusUpdater.tagSamplingProbabilities[tag] = probability;
+		clientStatusUpdater.maxTagSamplingProbability =
+		    std::max(clientStatusUpdater.maxTagSamplingProbability, probability);
+	}
 	cacheListMonitor = monitorCacheList(this);
 
 	smoothMidShardSize.reset(CLIENT_KNOBS->INIT_MID_SHARD_BYTES);
@@ -1859,6 +1981,7 @@ DatabaseContext::DatabaseContext(const Error& err)
     transactionGetRangeStreamRequests("GetRangeStreamRequests", cc), transactionWatchRequests("WatchRequests", cc),
     transactionGetAddressesForKeyRequests("GetAddressesForKeyRequests", cc), transactionBytesRead("BytesRead", cc),
     transactionKeysRead("KeysRead", cc), transactionMetadataVersionReads("MetadataVersionReads", cc),
+    transactionMetadataVersionCacheHits("MetadataVersionCacheHits", cc),
     transactionCommittedMutations("CommittedMutations", cc),
     transactionCommittedMutationBytes("CommittedMutationBytes", cc), transactionSetMutations("SetMutations", cc),
     transactionClearMutations("ClearMutations", cc), transactionAtomicMutations("AtomicMutations", cc),
@@ -1874,6 +1997,7 @@ DatabaseContext::DatabaseContext(const Error& err)
     transactionsProcessBehind("ProcessBehind", cc), transactionsThrottled("Throttled", cc),
     transactionsExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc),
     transactionGrvFullBatches("NumGrvFullBatches", cc), transactionGrvTimedOutBatches("NumGrvTimedOutBatches", cc),
+    transactionSharedGrvHits("SharedGrvHits", cc), transactionSharedGrvMisses("SharedGrvMisses", cc),
     transactionCommitVersionNotFoundForSS("CommitVersionNotFoundForSS", cc), anyBGReads(false),
     ccBG("BlobGranuleReadMetrics"), bgReadInputBytes("BGReadInputBytes", ccBG),
     bgReadOutputBytes("BGReadOutputBytes", ccBG), bgReadSnapshotRows("BGReadSnapshotRows", ccBG),
@@ -1929,6 +2053,7 @@ DatabaseContext::~DatabaseContext() {
 	for (auto it = server_interf.begin(); it != server_interf.end(); it = server_interf.erase(it))
 		it->second->notifyContextDestroyed();
 	ASSERT_ABORT(server_interf.empty());
+	locationTeams.clear();
 	locationCache.insert(allKeys, Reference<LocationInfo>());
 	for (auto& it : notAtLatestChangeFeeds) {
 		it.second->context = nullptr;
@@ -2007,19 +2132,53 @@ Reference<LocationInfo> DatabaseContext::setCachedLocation(const KeyRangeRef& ab
 		serverRefs.push_back(StorageServerInfo::getInterface(this, interf, clientLocality));
 	}
 
+	// Shards served by the same team share a LocationInfo, which saves memory for large clusters and skips building
+	// the load balancing order for every shard
+	Reference<LocationInfo> loc;
+	LocationInfo::Team team = LocationInfo::getTeam(serverRefs);
+	auto it = locationTeams.find(team);
+	if (it != locationTeams.end()) {
+		loc = it->second;
+	} else {
+		if (locationTeams.size() >= locationTeamsPruneSize) {
+			for (auto t = locationTeams.begin(); t != locationTeams.end();) {
+				t = t->second->isSoleOwner() ? locationTeams.erase(t) : std::next(t);
+			}
+			locationTeamsPruneSize = std::max<size_t>(16, 2 * locationTeams.size());
+		}
+		loc = makeReference<LocationInfo>(serverRefs);
+		locationTeams[std::move(team)] = loc;
+	}
+
 	int maxEvictionAttempts = 100, attempts = 0;
-	auto loc = makeReference<LocationInfo>(serverRefs);
 	while (locationCache.size() > locationCacheSize && attempts < maxEvictionAttempts) {
 		CODE_PROBE(true, "NativeAPI storage server locationCache entry evicted");
 		attempts++;
 		auto r = locationCache.randomRange();
 		Key begin = r.begin(), end = r.end(); // insert invalidates r, so can't be passed a mere reference into it
-		locationCache.insert(KeyRangeRef(begin, end), Reference<LocationInfo>());
+		clearCachedLocations(KeyRangeRef(begin, end));
 	}
 	locationCache.insert(absoluteKeys, loc);
 	return loc;
 }
 
+void DatabaseContext::clearCachedLocations(const KeyRangeRef& keys) {
+	Key begin = keys.begin, end = keys.end;
+	if (begin != allKeys.begin) {
+		auto before = locationCache.rangeContainingKeyBefore(begin);
+		if (!before->value()) {
+			begin = before->begin();
+		}
+	}
+	if (end != allKeys.end) {
+		auto after = locationCache.rangeContaining(end);
+		if (!after->value()) {
+			end = after->end();
+		}
+	}
+	locationCache.insert(KeyRangeRef(begin, end), Reference<LocationInfo>());
+}
+
 void DatabaseContext::invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRef& key, Reverse isBackward) {
 	Arena arena;
 	KeyRef resolvedKey = key;
@@ -2046,7 +2205,7 @@ void DatabaseContext::invalidateCache(const Optional<KeyRef>& tenantPrefix, cons
 	auto rs = locationCache.intersectingRanges(resolvedKeys);
 	Key begin = rs.begin().begin(),
 	    end = rs.end().begin(); // insert invalidates rs, so can't be passed a mere reference into it
-	locationCache.insert(KeyRangeRef(begin, end), Reference<LocationInfo>());
+	clearCachedLocations(KeyRangeRef(begin, end));
 }
 
 void DatabaseContext::setFailedEndpointOnHealthyServer(const Endpoint& endpoint) {
@@ -2163,6 +2322,13 @@ void DatabaseContext::setOption(FDBDatabaseOptions::Option option, Optional<Stri
 			validateOptionValueNotPresent(value);
 			snapshotRywEnabled--;
 			break;
+		case FDBDatabaseOptions::METADATA_VERSION_CACHED_PREFIX:
+			validateOptionValuePresent(value);
+			if (value.get().empty()) {
+				throw invalid_option_value();
+			}
+			metadataVersionReadCache.addPrefix(value.get());
+			break;
 		case FDBDatabaseOptions::USE_CONFIG_DATABASE:
 			validateOptionValueNotPresent(value);
 			useConfigDatabase = true;
@@ -3242,6 +3408,34 @@ ACTOR Future<std::vector<KeyRangeLocationInfo>> getKeyRangeLocations_internal(
 	}
 }
 
+// Fetches the locations of up to limit shards of keys after a location cache miss. If
+// LOCATION_CACHE_PREFETCH_SHARD_LIMIT is larger, locations for that many shards are fetched and cached, so that a scan
+// of a large range warms the location cache in a few requests instead of one request per GET_RANGE_SHARD_LIMIT shards.
+Future<std::vector<KeyRangeLocationInfo>> getKeyRangeLocationsWithPrefetch(Database const& cx,
+                                                                           TenantInfo const& tenant,
+                                                                           KeyRange const& keys,
+                                                                           int limit,
+                                                                           Reverse reverse,
+                                                                           SpanContext const& spanContext,
+                                                                           Optional<UID> const& debugID,
+                                                                           UseProvisionalProxies useProvisionalProxies,
+                                                                           Version version) {
+	const int prefetchLimit = std::min(CLIENT_KNOBS->LOCATION_CACHE_PREFETCH_SHARD_LIMIT, cx->locationCacheSize / 2);
+	if (limit >= prefetchLimit) {
+		return getKeyRangeLocations_internal(
+		    cx, tenant, keys, limit, reverse, spanContext, debugID, useProvisionalProxies, version);
+	}
+	CODE_PROBE(true, "Prefetching shard locations");
+	return map(getKeyRangeLocations_internal(
+	               cx, tenant, keys, prefetchLimit, reverse, spanContext, debugID, useProvisionalProxies, version),
+	           [limit](std::vector<KeyRangeLocationInfo> locations) {
+		           if (locations.size() > static_cast<size_t>(limit)) {
+			           locations.erase(locations.begin() + limit, locations.end());
+		           }
+		           return locations;
+	           });
+}
+
 // Get the SS locations for each shard in the 'keys' key-range;
 // Returned vector size is the number of shards in the input keys key-range.
 // Returned vector element is <ShardRange, storage server location info> pairs, where
@@ -3264,7 +3458,7 @@ Future<std::vector<KeyRangeLocationInfo>> getKeyRangeLocations(Database const& c
 
 	std::vector<KeyRangeLocationInfo> locations;
 	if (!cx->getCachedLocations(tenant, keys, locations, limit, reverse)) {
-		return getKeyRangeLocations_internal(
+		return getKeyRangeLocationsWithPrefetch(
 		    cx, tenant, keys, limit, reverse, spanContext, debugID, useProvisionalProxies, version);
 	}
 
@@ -3285,7 +3479,7 @@ Future<std::vector<KeyRangeLocationInfo>> getKeyRangeLocations(Database const& c
 
 	if (foundFailed) {
 		// Refresh the cache with a new getKeyRangeLocations made to proxies.
-		return getKeyRangeLocations_internal(
+		return getKeyRangeLocationsWithPrefetch(
 		    cx, tenant, keys, limit, reverse, spanContext, debugID, useProvisionalProxies, version);
 	}
 
@@ -5489,6 +5683,137 @@ ACTOR Future<Void> getRangeStream(Reference<TransactionState> trState,
 	return Void();
 }
 
+// Reads a range for a transaction with PARALLEL_RANGE_READS set. The range is read through getRangeStream, which reads
+// several fragments concurrently and merges them back in key order, and the stream is cut off as soon as the limits are
+// reached. The conflict range only covers the rows returned.
+ACTOR Future<RangeResult> getRangeParallel(Reference<TransactionState> trState,
+                                           KeySelector begin,
+                                           KeySelector end,
+                                           GetRangeLimits limits,
+                                           Promise<std::pair<Key, Key>> conflictRange,
+                                           Snapshot snapshot) {
+	state PromiseStream<RangeResult> results;
+	state Promise<std::pair<Key, Key>> streamConflictRange;
+	state Future<Void> stream = forwardErrors(
+	    getRangeStream(trState, results, begin, end, GetRangeLimits(), streamConflictRange, snapshot, Reverse::False),
+	    results);
+	state RangeResult output;
+
+	try {
+		loop {
+			RangeResult fragment = waitNext(results.getFuture());
+			output.arena().dependsOn(fragment.arena());
+			for (const auto& kv : fragment) {
+				output.push_back(output.arena(), kv);
+				limits.decrement(kv);
+				if (limits.isReached()) {
+					break;
+				}
+			}
+			if (limits.isReached()) {
+				CODE_PROBE(true, "Parallel range read cut off by its limits");
+				output.more = true;
+				break;
+			}
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_end_of_stream) {
+			throw;
+		}
+		output.more = false;
+	}
+	stream.cancel();
+
+	if (!snapshot) {
+		std::pair<Key, Key> range = wait(streamConflictRange.getFuture());
+		if (output.more) {
+			range.second = keyAfter(output.back().key);
+		}
+		conflictRange.send(range);
+	}
+	return output;
+}
+
+// The metadata version that came with the transaction's read version, if the read version came from a GRV proxy
+Optional<Optional<Value>> getKnownMetadataVersion(Reference<TransactionState> const& trState) {
+	Future<Optional<Value>> metadataVersion = trState->metadataVersion.getFuture();
+	if (metadataVersion.isReady() && !metadataVersion.isError()) {
+		return Optional<Optional<Value>>(metadataVersion.get());
+	}
+	return Optional<Optional<Value>>();
+}
+
+// Reads a key under a METADATA_VERSION_CACHED_PREFIX prefix, serving it from the database's read cache if the cached
+// value was read at the same metadata version as this transaction's read version.
+ACTOR Future<Optional<Value>> getValueThroughReadCache(Reference<TransactionState> trState, Key key) {
+	wait(trState->startTransaction());
+	state Optional<Optional<Value>> metadataVersion = getKnownMetadataVersion(trState);
+	if (trState->hasTenant() || !metadataVersion.present()) {
+		Optional<Value> value = wait(getValue(trState, key, UseTenant::True));
+		return value;
+	}
+
+	{
+		Optional<RangeResult> cached = trState->cx->metadataVersionReadCache.get(
+		    singleKeyRange(key), metadataVersion.get(), GetRangeLimits(1), Reverse::False);
+		if (cached.present()) {
+			++trState->cx->transactionMetadataVersionCacheHits;
+			if (cached.get().empty()) {
+				return Optional<Value>();
+			}
+			return Value(cached.get()[0].value, cached.get().arena());
+		}
+	}
+
+	Optional<Value> value = wait(getValue(trState, key, UseTenant::True));
+	RangeResult rows;
+	if (value.present()) {
+		rows.push_back_deep(rows.arena(), KeyValueRef(key, value.get()));
+	}
+	trState->cx->metadataVersionReadCache.insert(singleKeyRange(key), rows, metadataVersion.get(), Reverse::False);
+	return value;
+}
+
+// Reads a range under a METADATA_VERSION_CACHED_PREFIX prefix, serving it from the database's read cache if the range
+// was cached at the same metadata version as this transaction's read version. Complete reads of a range are cached.
+ACTOR Future<RangeResult> getRangeThroughReadCache(Reference<TransactionState> trState,
+                                                   KeyRange keys,
+                                                   GetRangeLimits limits,
+                                                   Promise<std::pair<Key, Key>> conflictRange,
+                                                   Snapshot snapshot,
+                                                   Reverse reverse) {
+	wait(trState->startTransaction());
+	state Optional<Optional<Value>> metadataVersion = getKnownMetadataVersion(trState);
+	if (!trState->hasTenant() && metadataVersion.present()) {
+		Optional<RangeResult> cached =
+		    trState->cx->metadataVersionReadCache.get(keys, metadataVersion.get(), limits, reverse);
+		if (cached.present()) {
+			++trState->cx->transactionMetadataVersionCacheHits;
+			if (!snapshot) {
+				std::pair<Key, Key> range(keys.begin, keys.end);
+				if (cached.get().more) {
+					if (reverse) {
+						range.first = cached.get().back().key;
+					} else {
+						range.second = keyAfter(cached.get().back().key);
+					}
+				}
+				conflictRange.send(range);
+			}
+			return cached.get();
+		}
+	}
+
+	state KeySelector begin = firstGreaterOrEqual(keys.begin);
+	state KeySelector end = firstGreaterOrEqual(keys.end);
+	RangeResult result = wait(::getRange<GetKeyValuesRequest, GetKeyValuesReply, RangeResult>(
+	    trState, begin, end, ""_sr, limits, conflictRange, snapshot, reverse));
+	if (!trState->hasTenant() && metadataVersion.present() && !result.more) {
+		trState->cx->metadataVersionReadCache.insert(keys, result, metadataVersion.get(), reverse);
+	}
+	return result;
+}
+
 Future<RangeResult> getRange(Reference<TransactionState> const& trState,
                              KeySelector const& begin,
                              KeySelector const& end,
@@ -5561,8 +5886,20 @@ void Transaction::operator=(Transaction&& r) noexcept {
 void Transaction::flushTrLogsIfEnabled() {
 	if (trState && trState->trLogInfo && trState->trLogInfo->logsAdded && trState->trLogInfo->trLogWriter.getData()) {
 		ASSERT(trState->trLogInfo->flushed == false);
-		trState->cx->clientStatusUpdater.inStatusQ.push_back(
-		    { trState->trLogInfo->identifier, std::move(trState->trLogInfo->trLogWriter) });
+		// Thin out transactions that were only sampled in case one of their tags had a higher sample rate
+		const auto& tagProbabilities = trState->cx->clientStatusUpdater.tagSamplingProbabilities;
+		Optional<double> tagProbability;
+		for (const auto& tag : trState->options.tags) {
+			auto it = tagProbabilities.find(tag);
+			if (it != tagProbabilities.end()) {
+				tagProbability = std::max(tagProbability.orDefault(0.0), it->second);
+			}
+		}
+		const double probability = tagProbability.orDefault(trState->trLogInfo->untaggedSampleProbability);
+		if (deterministicRandom()->random01() * trState->trLogInfo->sampleProbability < probability) {
+			trState->cx->clientStatusUpdater.inStatusQ.push_back(
+			    { trState->trLogInfo->identifier, std::move(trState->trLogInfo->trLogWriter) });
+		}
 		trState->trLogInfo->flushed = true;
 	}
 }
@@ -5639,6 +5976,10 @@ Future<Optional<Value>> Transaction::get(const Key& key, Snapshot snapshot) {
 		}
 	}
 
+	if (useTenant && trState->cx->metadataVersionReadCache.isCached(singleKeyRange(key))) {
+		return getValueThroughReadCache(trState, key);
+	}
+
 	return getValue(trState, key, useTenant);
 }
 
@@ -5903,6 +6244,20 @@ Future<RangeResultFamily> Transaction::getRangeInternal(const KeySelector& begin
 		extraConflictRanges.push_back(conflictRange.getFuture());
 	}
 
+	if constexpr (std::is_same_v<GetKeyValuesFamilyRequest, GetKeyValuesRequest>) {
+		// Reading fragments ahead only pays off when the result may span more than one storage server reply
+		if (trState->options.parallelRangeReads && !reverse && !limits.hasRowLimit() &&
+		    (!limits.hasByteLimit() || limits.bytes > CLIENT_KNOBS->REPLY_BYTE_LIMIT)) {
+			++trState->cx->transactionGetRangeStreamRequests;
+			return getRangeParallel(trState, b, e, limits, conflictRange, snapshot);
+		}
+		if (b.isFirstGreaterOrEqual() && e.isFirstGreaterOrEqual() &&
+		    trState->cx->metadataVersionReadCache.isCached(KeyRangeRef(b.getKey(), e.getKey()))) {
+			return getRangeThroughReadCache(
+			    trState, KeyRange(KeyRangeRef(b.getKey(), e.getKey())), limits, conflictRange, snapshot, reverse);
+		}
+	}
+
 	return ::getRange<GetKeyValuesFamilyRequest, GetKeyValuesFamilyReply, RangeResultFamily>(
 	    trState, b, e, mapper, limits, conflictRange, snapshot, reverse);
 }
@@ -6216,7 +6571,10 @@ void TransactionOptions::clear() {
 	rawAccess = false;
 	bypassStorageQuota = false;
 	enableReplicaConsistencyCheck = false;
+	parallelRangeReads = false;
 	requiredReplicas = 0;
+	readVersionMaxStaleness = 0.0;
+	sharedReadVersionMaxAge = 0.0;
 }
 
 TransactionOptions::TransactionOptions() {
@@ -6696,13 +7054,35 @@ ACTOR static Future<Void> tryCommit(Reference<TransactionState> trState, CommitT
 		state int alternativeChosen = -1;
 		// Only valid if alternativeChosen >= 0
 		state Reference<CommitProxyInfo> proxiesUsed;
+		// The proxy the request was sent to, if known, for transactions pipelined behind this one
+		state Optional<CommitProxyInterface> proxySentTo;
 
-		if (trState->options.commitOnFirstProxy) {
+		state CommitRequestSent pipelineLeader;
+		if (trState->pipelineLeader.isValid()) {
+			try {
+				wait(store(pipelineLeader, trState->pipelineLeader));
+			} catch (Error& e) {
+				// The leader's transaction was reset or destroyed before its commit request was sent
+				if (e.code() != error_code_broken_promise) {
+					throw;
+				}
+				throw not_committed();
+			}
+		}
+
+		if (pipelineLeader.proxy.present()) {
+			req.pipelineLeader = pipelineLeader.replyToken;
+			proxySentTo = pipelineLeader.proxy;
+			reply = throwErrorOr(brokenPromiseToMaybeDelivered(proxySentTo.get().commit.tryGetReply(req)));
+		} else if (trState->options.commitOnFirstProxy) {
 			if (trState->cx->clientInfo->get().firstCommitProxy.present()) {
-				reply = throwErrorOr(brokenPromiseToMaybeDelivered(
-				    trState->cx->clientInfo->get().firstCommitProxy.get().commit.tryGetReply(req)));
+				proxySentTo = trState->cx->clientInfo->get().firstCommitProxy;
+				reply = throwErrorOr(brokenPromiseToMaybeDelivered(proxySentTo.get().commit.tryGetReply(req)));
 			} else {
 				const std::vector<CommitProxyInterface>& proxies = trState->cx->clientInfo->get().commitProxies;
+				if (proxies.size()) {
+					proxySentTo = proxies[0];
+				}
 				reply = proxies.size() ? throwErrorOr(brokenPromiseToMaybeDelivered(proxies[0].commit.tryGetReply(req)))
 				                       : Never();
 			}
@@ -6714,6 +7094,12 @@ ACTOR static Future<Void> tryCommit(Reference<TransactionState> trState, CommitT
 			                         TaskPriority::DefaultPromiseEndpoint,
 			                         AtMostOnce::True,
 			                         &alternativeChosen);
+			if (alternativeChosen >= 0) {
+				proxySentTo = proxiesUsed->getInterface(alternativeChosen);
+			}
+		}
+		if (proxySentTo.present() && trState->commitRequestSent.canBeSet()) {
+			trState->commitRequestSent.send(CommitRequestSent{ proxySentTo, req.reply.getEndpoint().token });
 		}
 		state double grvTime = now();
 		choose {
@@ -6883,6 +7269,15 @@ Future<Void> Transaction::commitMutations() {
 		if (trState->options.readOnly)
 			return transaction_read_only();
 
+		if (trState->pipelineLeader.isValid()) {
+			// The commit proxy can't back out the metadata effects of a follower whose leader doesn't commit
+			for (auto const& m : tr.transaction.mutations) {
+				if (m.type == MutationRef::ClearRange ? m.param2 > systemKeys.begin : m.param1 >= systemKeys.begin) {
+					return client_invalid_operation();
+				}
+			}
+		}
+
 		trState->cx->mutationsPerCommit.addSample(tr.transaction.mutations.size());
 		trState->cx->bytesPerCommit.addSample(tr.transaction.mutations.expectedSize());
 		if (trState->options.tags.size())
@@ -6987,6 +7382,11 @@ ACTOR Future<Void> commitAndWatch(Transaction* self) {
 	try {
 		wait(self->commitMutations());
 
+		if (self->trState->commitRequestSent.canBeSet()) {
+			// Nothing was sent, so transactions pipelined behind this one are committed on their own
+			self->trState->commitRequestSent.send(CommitRequestSent());
+		}
+
 		self->getDatabase()->transactionTracingSample =
 		    (self->getCommittedVersion() % 60000000) < (60000000 * FLOW_KNOBS->TRACING_SAMPLE_RATE);
 
@@ -7000,6 +7400,9 @@ ACTOR Future<Void> commitAndWatch(Transaction* self) {
 
 		return Void();
 	} catch (Error& e) {
+		if (self->trState->commitRequestSent.canBeSet()) {
+			self->trState->commitRequestSent.sendError(not_committed());
+		}
 		if (e.code() != error_code_actor_cancelled) {
 			if (!self->watches.empty()) {
 				self->cancelWatches(e);
@@ -7022,6 +7425,11 @@ Future<Void> Transaction::commit() {
 	return committing;
 }
 
+void Transaction::setPipelineLeader(Transaction const& leader) {
+	ASSERT(!committing.isValid());
+	trState->pipelineLeader = leader.trState->commitRequestSent.getFuture();
+}
+
 void Transaction::setOption(FDBTransactionOptions::Option option, Optional<StringRef> value) {
 	switch (option) {
 	case FDBTransactionOptions::INITIALIZE_NEW_DATABASE:
@@ -7251,6 +7659,11 @@ void Transaction::setOption(FDBTransactionOptions::Option option, Optional<Strin
 		trState->options.bypassStorageQuota = true;
 		break;
 
+	case FDBTransactionOptions::PARALLEL_RANGE_READS:
+		validateOptionValueNotPresent(value);
+		trState->options.parallelRangeReads = true;
+		break;
+
 	case FDBTransactionOptions::AUTHORIZATION_TOKEN:
 		if (value.present())
 			trState->authToken = WipedString(value.get());
@@ -7308,6 +7721,25 @@ void Transaction::setOption(FDBTransactionOptions::Option option, Optional<Strin
 	case FDBTransactionOptions::CONSISTENCY_CHECK_REQUIRED_REPLICAS:
 		validateOptionValuePresent(value);
 		trState->options.requiredReplicas = extractIntOption(value, -2, std::numeric_limits<int64_t>::max());
+		break;
+
+	case FDBTransactionOptions::READ_VERSION_MAX_STALENESS: {
+		validateOptionValuePresent(value);
+		int64_t maxStalenessMs = extractIntOption(value, 0, std::numeric_limits<int32_t>::max());
+		if (maxStalenessMs > 0) {
+			trState->options.getReadVersionFlags |= GetReadVersionRequest::FLAG_BOUNDED_STALENESS;
+		} else {
+			trState->options.getReadVersionFlags &= ~GetReadVersionRequest::FLAG_BOUNDED_STALENESS;
+		}
+		trState->options.readVersionMaxStaleness = maxStalenessMs / 1000.0;
+		break;
+	}
+
+	case FDBTransactionOptions::SHARE_READ_VERSION:
+		validateOptionValuePresent(value);
+		trState->options.sharedReadVersionMaxAge =
+		    extractIntOption(value, 0, std::numeric_limits<int32_t>::max()) / 1000.0;
+		break;
 
 	default:
 		break;
@@ -7320,7 +7752,8 @@ ACTOR Future<GetReadVersionReply> getConsistentReadVersion(SpanContext parentSpa
                                                            TransactionPriority priority,
                                                            uint32_t flags,
                                                            TransactionTagMap<uint32_t> tags,
-                                                           Optional<UID> debugID) {
+                                                           Optional<UID> debugID,
+                                                           double maxStaleness) {
 	state Span span("NAPI:getConsistentReadVersion"_loc, parentSpan);
 
 	++cx->transactionReadVersionBatches;
@@ -7334,7 +7767,8 @@ ACTOR Future<GetReadVersionReply> getConsistentReadVersion(SpanContext parentSpa
 			                                cx->ssVersionVectorCache.getMaxVersion(),
 			                                flags,
 			                                tags,
-			                                debugID);
+			                                debugID,
+			                                maxStaleness);
 			state Future<Void> onProxiesChanged = cx->onProxiesChanged();
 
 			choose {
@@ -7413,6 +7847,8 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 	state double lastRequestTime = now();
 
 	state TransactionTagMap<uint32_t> tags;
+	// The tightest staleness bound of the requests in the batch
+	state double maxStaleness = std::numeric_limits<double>::max();
 
 	// dynamic batching
 	state PromiseStream<double> replyTimes;
@@ -7433,6 +7869,7 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 				for (auto tag : req.tags) {
 					++tags[tag];
 				}
+				maxStaleness = std::min(maxStaleness, req.maxStaleness);
 
 				if (requests.size() == CLIENT_KNOBS->MAX_BATCH_SIZE) {
 					send_batch = true;
@@ -7468,12 +7905,14 @@ ACTOR Future<Void> readVersionBatcher(DatabaseContext* cx,
 			addActor.send(ready(timeReply(GRVReply.getFuture(), replyTimes)));
 
 			Future<Void> batch = incrementalBroadcastWithError(
-			    getConsistentReadVersion(span.context, cx, count, priority, flags, std::move(tags), std::move(debugID)),
+			    getConsistentReadVersion(
+			        span.context, cx, count, priority, flags, std::move(tags), std::move(debugID), maxStaleness),
 			    std::move(requests),
 			    CLIENT_KNOBS->BROADCAST_BATCH_SIZE);
 
 			span = Span("NAPI:readVersionBatcher"_loc);
 			tags.clear();
+			maxStaleness = std::numeric_limits<double>::max();
 			debugID = Optional<UID>();
 			requests.clear();
 			addActor.send(batch);
@@ -7654,17 +8093,47 @@ Future<Version> TransactionState::getReadVersion(uint32_t flags) {
 		}
 	}
 
+	Location location = "NAPI:getReadVersion"_loc;
+
+	// Like the GRV cache, sharing is opt in and gives up strict serializability, and shared read versions are not
+	// admitted by ratekeeper, so it is off while ratekeeper throttles. Tagged transactions are left alone so that the
+	// proxy sees them for tag throttling, and lock aware and system transactions always get a fresh read version.
+	const bool shareable = options.sharedReadVersionMaxAge > 0 && options.tags.size() == 0 && !options.lockAware &&
+	                       options.priority != TransactionPriority::IMMEDIATE &&
+	                       !(flags & GetReadVersionRequest::FLAG_USE_MIN_KNOWN_COMMITTED_VERSION) &&
+	                       rkThrottlingCooledDown(cx.getPtr(), options.priority);
+	if (shareable) {
+		auto& shared = cx->sharedReadVersions[flags];
+		if (shared.reply.isValid() && !shared.reply.isError() &&
+		    now() - shared.requestTime <= options.sharedReadVersionMaxAge) {
+			// Either a reply requested recently enough, or an in flight request that this transaction joins
+			++cx->transactionSharedGrvHits;
+			startTime = now();
+			return extractReadVersion(
+			    Reference<TransactionState>::addRef(this), location, spanContext, shared.reply, metadataVersion);
+		}
+		++cx->transactionSharedGrvMisses;
+	}
+
 	auto& batcher = cx->versionBatcher[flags];
 	if (!batcher.actor.isValid()) {
 		batcher.actor = readVersionBatcher(cx.getPtr(), batcher.stream.getFuture(), options.priority, flags);
 	}
 
-	Location location = "NAPI:getReadVersion"_loc;
 	SpanContext derivedSpanContext = generateSpanID(cx->transactionTracingSample, spanContext);
 	Optional<UID> versionDebugID = readOptions.present() ? readOptions.get().debugID : Optional<UID>();
-	auto const req = DatabaseContext::VersionRequest(derivedSpanContext, options.tags, versionDebugID);
+	auto const req = DatabaseContext::VersionRequest(
+	    derivedSpanContext,
+	    options.tags,
+	    versionDebugID,
+	    (flags & GetReadVersionRequest::FLAG_BOUNDED_STALENESS) ? options.readVersionMaxStaleness : 0.0);
 	batcher.stream.send(req);
 	startTime = now();
+	if (shareable) {
+		auto& shared = cx->sharedReadVersions[flags];
+		shared.reply = req.reply.getFuture();
+		shared.requestTime = startTime;
+	}
 	return extractReadVersion(
 	    Reference<TransactionState>::addRef(this), location, spanContext, req.reply.getFuture(), metadataVersion);
 }
@@ -9079,10 +9548,17 @@ Reference<TransactionLogInfo> Transaction::createTrLogInfoProbabilistically(cons
 		double sampleRate =
 		    cx->globalConfig->get<double>(fdbClientInfoTxnSampleRate, std::numeric_limits<double>::infinity());
 		double clientSamplingProbability = std::isinf(sampleRate) ? CLIENT_KNOBS->CSI_SAMPLING_PROBABILITY : sampleRate;
+		// Tags are set after the transaction is created, so sample at the largest tag sample rate and thin out the
+		// samples when the transaction is flushed
+		double sampleProbability =
+		    std::max(clientSamplingProbability, cx->clientStatusUpdater.maxTagSamplingProbability);
 		if (((networkOptions.logClientInfo.present() && networkOptions.logClientInfo.get()) || BUGGIFY) &&
-		    deterministicRandom()->random01() < clientSamplingProbability &&
+		    deterministicRandom()->random01() < sampleProbability &&
 		    (!g_network->isSimulated() || !g_simulator->speedUpSimulation)) {
-			return makeReference<TransactionLogInfo>(TransactionLogInfo::DATABASE);
+			auto trLogInfo = makeReference<TransactionLogInfo>(TransactionLogInfo::DATABASE);
+			trLogInfo->sampleProbability = sampleProbability;
+			trLogInfo->untaggedSampleProbability = clientSamplingProbability;
+			return trLogInfo;
 		}
 	}
 
@@ -821,3 +821,66 @@ TEST_CASE("/fdbclient/WriteMap/random") {
 
 	return Void();
 }
+
+// Asserts that two write maps, or snapshots of them, have the same segments
+static void checkSameSegments(WriteMap::iterator a, WriteMap::iterator b) {
+	a.skip(allKeys.begin);
+	b.skip(allKeys.begin);
+	while (a.beginKey() < allKeys.end || b.beginKey() < allKeys.end) {
+		ASSERT(a.beginKey() == b.beginKey() && a.endKey() == b.endKey());
+		ASSERT(a.type() == b.type());
+		ASSERT(a.is_conflict_range() == b.is_conflict_range() && a.is_unreadable() == b.is_unreadable());
+		if (a.is_operation()) {
+			ASSERT(a.op() == b.op());
+		}
+		++a;
+		++b;
+	}
+	--a;
+	--b;
+	ASSERT(a.beginKey() == b.beginKey() && a.type() == b.type());
+}
+
+TEST_CASE("/fdbclient/WriteMap/flat") {
+	Arena arena = Arena();
+	// Sorted array only, tree only, and a sorted array that moves to the tree partway through
+	WriteMap flat(&arena, std::numeric_limits<int>::max());
+	WriteMap tree(&arena, 0);
+	WriteMap mixed(&arena, deterministicRandom()->randomInt(3, 20));
+	std::vector<WriteMap*> maps = { &flat, &tree, &mixed };
+
+	Optional<WriteMap::iterator> flatSnapshot, treeSnapshot;
+	for (int i = 0; i < 200; i++) {
+		if (i == 50) {
+			// Writes made after an iterator is created must not be visible through it
+			flatSnapshot = WriteMap::iterator(&flat);
+			treeSnapshot = WriteMap::iterator(&tree);
+		}
+		int r = deterministicRandom()->randomInt(0, 6);
+		bool addConflict = deterministicRandom()->coinflip();
+		KeyRangeRef range = RandomTestImpl::getRandomRange(arena);
+		KeyRef key = RandomTestImpl::getRandomKey(arena);
+		ValueRef value = RandomTestImpl::getRandomValue(arena);
+		for (WriteMap* writes : maps) {
+			if (r == 0) {
+				writes->addConflictRange(range);
+			} else if (r == 1) {
+				writes->addUnmodifiedAndUnreadableRange(range);
+			} else if (r == 2) {
+				writes->clear(range, addConflict);
+			} else if (r == 3) {
+				writes->mutate(key, MutationRef::AddValue, value, addConflict);
+			} else {
+				writes->mutate(key, MutationRef::SetValue, value, addConflict);
+			}
+		}
+		checkSameSegments(WriteMap::iterator(&flat), WriteMap::iterator(&tree));
+		checkSameSegments(WriteMap::iterator(&mixed), WriteMap::iterator(&tree));
+		if (flatSnapshot.present()) {
+			checkSameSegments(flatSnapshot.get(), treeSnapshot.get());
+		}
+	}
+	ASSERT_EQ(getWriteMapCount(&flat), getWriteMapCount(&tree));
+
+	return Void();
+}
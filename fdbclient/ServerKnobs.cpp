@@ -667,6 +667,17 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( COMMIT_TRANSACTION_BATCH_BYTES_MAX,                  100000 ); if( randomize && BUGGIFY ) { COMMIT_TRANSACTION_BATCH_BYTES_MIN = COMMIT_TRANSACTION_BATCH_BYTES_MAX = 1000000; }
 	init( COMMIT_TRANSACTION_BATCH_BYTES_SCALE_BASE,           100000 );
 	init( COMMIT_TRANSACTION_BATCH_BYTES_SCALE_POWER,             0.0 );
+	init( COMMIT_BATCH_ADAPTIVE_CONTROL,                        false ); if( randomize && BUGGIFY ) COMMIT_BATCH_ADAPTIVE_CONTROL = true;
+	init( COMMIT_BATCH_TARGET_P99_LATENCY,                       0.05 ); if( randomize && BUGGIFY ) COMMIT_BATCH_TARGET_P99_LATENCY = deterministicRandom()->random01() * 0.1;
+	init( COMMIT_BATCH_CONTROL_WINDOW,                            0.5 ); if( randomize && BUGGIFY ) COMMIT_BATCH_CONTROL_WINDOW = 0.05;
+	init( COMMIT_BATCH_CONTROL_MIN_SAMPLES,                        20 );
+	init( COMMIT_BATCH_CONTROL_HISTORY,                            10 ); // Windows over which the unloaded resolution + logging latency is estimated
+	init( COMMIT_BATCH_QUEUEING_TOLERANCE,                       0.25 );
+	init( COMMIT_BATCH_INTERVAL_GAIN,                            1.25 );
+	init( COMMIT_BATCH_MIN_BYTES_FRACTION,                     0.0625 );
+	init( COMMIT_BATCH_SHRINK_MAX_BATCHES_IN_FLIGHT,              2.0 ); // Latency misses with more batches in flight come from load, and do not shrink batches
+	init( COMMIT_BATCH_CONTROL_DEAD_BAND,                         0.1 ); // Fraction of the target around it in which the interval does not move
+	init( COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS,                     2 ); // Windows in a row needed to reverse the direction of the interval
 
 	init( RESOLVER_COALESCE_TIME,                                1.0 );
 	init( BUGGIFIED_ROW_LIMIT,                  APPLY_MUTATION_BYTES ); if( randomize && BUGGIFY ) BUGGIFIED_ROW_LIMIT = deterministicRandom()->randomInt(3, 30);
@@ -691,6 +702,8 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 
 	bool buggfyUseResolverPrivateMutations = randomize && BUGGIFY && !ENABLE_VERSION_VECTOR_TLOG_UNICAST;
 	init( PROXY_USE_RESOLVER_PRIVATE_MUTATIONS,                 false ); if( buggfyUseResolverPrivateMutations ) PROXY_USE_RESOLVER_PRIVATE_MUTATIONS = deterministicRandom()->coinflip();
+	init( PROXY_ENCRYPTION_THREADS,                                 0 ); if( randomize && BUGGIFY ) PROXY_ENCRYPTION_THREADS = deterministicRandom()->randomInt(1, 4);
+	init( PROXY_USE_FLAT_TAG_INDEX,                             false ); if( randomize && BUGGIFY ) PROXY_USE_FLAT_TAG_INDEX = true;
 
 	init( BURSTINESS_METRICS_ENABLED  ,                         false );
 	init( BURSTINESS_METRICS_LOG_INTERVAL,                        0.1 );
@@ -704,6 +717,11 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( GLOBAL_CONFIG_REFRESH_INTERVAL,                         1.0 ); if ( randomize && BUGGIFY ) GLOBAL_CONFIG_REFRESH_INTERVAL = 0.1;
 	init( GLOBAL_CONFIG_REFRESH_TIMEOUT,                         10.0 ); if ( randomize && BUGGIFY ) GLOBAL_CONFIG_REFRESH_TIMEOUT = 1.0;
 
+	// GRV proxy read version lease, see READ_VERSION_MAX_STALENESS
+	init( GRV_READ_VERSION_LEASE_MAX_STALENESS,                  0.1 ); if( randomize && BUGGIFY ) GRV_READ_VERSION_LEASE_MAX_STALENESS = deterministicRandom()->coinflip() ? 0.0 : 1.0;
+	init( GRV_READ_VERSION_LEASE_REFRESH_INTERVAL,              0.01 ); if( randomize && BUGGIFY ) GRV_READ_VERSION_LEASE_REFRESH_INTERVAL = 0.5;
+	init( GRV_READ_VERSION_LEASE_IDLE_TIMEOUT,                   5.0 );
+
 	// Master Server
 	// masterCommitter() in the master server will allow lower priority tasks (e.g. DataDistibution)
 	//  by delay()ing for this amount of time between accepted batches of TransactionRequests.
@@ -1344,6 +1362,11 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	// Drop in-memory state associated with an idempotency id after this many seconds. Once dropped, this id cannot be
 	// expired proactively, but will eventually get cleaned up by the idempotency id cleaner.
 	init( IDEMPOTENCY_ID_IN_MEMORY_LIFETIME,                       10);
+	// Write idempotency ids with the compact value format, see design/idempotency_ids.md. Clients older than this
+	// format can't read it, so only set this once every client of the cluster can.
+	init( IDEMPOTENCY_ID_COMPACT_FORMAT,                        false ); if( randomize && BUGGIFY ) IDEMPOTENCY_ID_COMPACT_FORMAT = true;
+	// Clear the idempotency ids of expired commit batches this often, so that adjacent batches are cleared together
+	init( IDEMPOTENCY_ID_CLEAR_INTERVAL,                          1.0 ); if( randomize && BUGGIFY ) IDEMPOTENCY_ID_CLEAR_INTERVAL = deterministicRandom()->random01();
 	// Attempt to clean old idempotency ids automatically this often
  	init( IDEMPOTENCY_IDS_CLEANER_POLLING_INTERVAL,                10);
 	// Don't clean idempotency ids younger than this
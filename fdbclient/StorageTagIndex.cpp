@@ -0,0 +1,264 @@
+/*
+ * StorageTagIndex.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/StorageTagIndex.h"
+
+#include <bit>
+#include <map>
+
+#include "flow/UnitTest.h"
+
+namespace {
+
+// Assigns shards next, next + 1, ... to the 1-based Eytzinger subtree rooted at slot k, in order. Returns the next
+// unassigned shard.
+int fillEytzinger(std::vector<int>& slots, int next, size_t k) {
+	if (k < slots.size()) {
+		next = fillEytzinger(slots, next, 2 * k);
+		slots[k] = next++;
+		next = fillEytzinger(slots, next, 2 * k + 1);
+	}
+	return next;
+}
+
+} // namespace
+
+// The first 8 bytes of key as a big-endian integer, zero padded. Ordering of prefixes agrees with the ordering of the
+// keys, except that keys sharing their first 8 bytes compare equal.
+uint64_t StorageTagIndex::keyPrefix(KeyRef key) {
+	uint64_t prefix = 0;
+	const int n = std::min(key.size(), 8);
+	for (int i = 0; i < n; i++) {
+		prefix |= uint64_t(key[i]) << (56 - 8 * i);
+	}
+	return prefix;
+}
+
+int StorageTagIndex::internTeam(std::vector<Tag> const& tags) {
+	auto [team, inserted] = teamIndex.try_emplace(tags, teams.size());
+	if (inserted) {
+		teams.push_back(tags);
+	}
+	return team->second;
+}
+
+void StorageTagIndex::rebuild(KeyRangeMap<ServerCacheInfo>& keyInfo) {
+	arena = Arena();
+	shardBegins.clear();
+	shardTeams.clear();
+	teams.clear();
+	teamIndex.clear();
+	overlay.clear();
+
+	for (auto r : keyInfo.ranges()) {
+		r.value().populateTags();
+		shardBegins.push_back(KeyRef(arena, r.begin()));
+		shardTeams.push_back(internTeam(r.value().tags));
+	}
+
+	eytzingerShards.assign(shardBegins.size() + 1, -1);
+	fillEytzinger(eytzingerShards, 0, 1);
+	eytzingerPrefixes.assign(shardBegins.size() + 1, 0);
+	for (int k = 1; k < eytzingerShards.size(); k++) {
+		eytzingerPrefixes[k] = keyPrefix(shardBegins[eytzingerShards[k]]);
+	}
+	valid = true;
+}
+
+int StorageTagIndex::shardContaining(KeyRef key) const {
+	ASSERT(valid && !shardBegins.empty());
+	const uint64_t prefix = keyPrefix(key);
+	const size_t n = shardBegins.size();
+	size_t k = 1;
+	while (k <= n) {
+		const uint64_t p = eytzingerPrefixes[k];
+		const bool after = p > prefix || (p == prefix && shardBegins[eytzingerShards[k]] > key);
+		k = 2 * k + !after;
+	}
+	// Drop the trailing "went right" steps and the last "went left" step, leaving the slot of the first shard that
+	// begins after key, or 0 if every shard begins at or before key.
+	k >>= std::countr_one(k) + 1;
+	return (k == 0 ? n : eytzingerShards[k]) - 1;
+}
+
+void StorageTagIndex::update(KeyRangeMap<ServerCacheInfo>& keyInfo, KeyRangeRef range) {
+	if (!valid || range.empty()) {
+		return;
+	}
+	if (overlay.empty()) {
+		overlay.emplace(Key(), -1);
+	}
+	// Keys from range.end on haven't changed, so whatever the overlay said there still holds
+	const int teamAfter = std::prev(overlay.upper_bound(range.end))->second;
+	overlay.erase(overlay.lower_bound(range.begin), overlay.lower_bound(range.end));
+	for (auto r : keyInfo.intersectingRanges(range)) {
+		r.value().populateTags();
+		overlay[Key(std::max<KeyRef>(r.begin(), range.begin))] = internTeam(r.value().tags);
+	}
+	overlay.try_emplace(Key(range.end), teamAfter);
+
+	if (overlay.size() > maxOverlayBoundaries) {
+		rebuild(keyInfo);
+	}
+}
+
+const std::vector<Tag>* StorageTagIndex::tagsForRange(KeyRangeRef range, std::set<Tag>& tags) const {
+	if (overlay.empty()) {
+		return flatTagsForRange(range, tags);
+	}
+	auto boundary = std::prev(overlay.upper_bound(range.begin));
+	auto next = std::next(boundary);
+	if (next == overlay.end() || next->first >= range.end) {
+		return boundary->second >= 0 ? &teams[boundary->second] : flatTagsForRange(range, tags);
+	}
+	for (; boundary != overlay.end() && boundary->first < range.end; boundary = next) {
+		next = std::next(boundary);
+		KeyRangeRef part(std::max<KeyRef>(boundary->first, range.begin),
+		                 next == overlay.end() ? range.end : std::min<KeyRef>(next->first, range.end));
+		const std::vector<Tag>* team = boundary->second >= 0 ? &teams[boundary->second] : flatTagsForRange(part, tags);
+		if (team) {
+			tags.insert(team->begin(), team->end());
+		}
+	}
+	return nullptr;
+}
+
+const std::vector<Tag>* StorageTagIndex::flatTagsForRange(KeyRangeRef range, std::set<Tag>& tags) const {
+	int shard = shardContaining(range.begin);
+	if (shard + 1 == shardBegins.size() || shardBegins[shard + 1] >= range.end) {
+		return &teams[shardTeams[shard]];
+	}
+	for (; shard < shardBegins.size() && shardBegins[shard] < range.end; shard++) {
+		const std::vector<Tag>& team = teams[shardTeams[shard]];
+		tags.insert(team.begin(), team.end());
+	}
+	return nullptr;
+}
+
+TEST_CASE("/fdbclient/StorageTagIndex/lookup") {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	std::vector<Key> boundaries;
+	const int shards = deterministicRandom()->randomInt(1, 300);
+	for (int i = 0; i < shards; i++) {
+		// Short keys and keys sharing long prefixes exercise both the prefix and the full key comparison
+		boundaries.push_back(deterministicRandom()->coinflip()
+		                         ? Key(deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(1, 4)))
+		                         : Key("commonprefix/" + deterministicRandom()->randomAlphaNumeric(3)));
+	}
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+	for (int i = 0; i < boundaries.size(); i++) {
+		ServerCacheInfo info;
+		info.tags.emplace_back(0, deterministicRandom()->randomInt(0, 5));
+		keyInfo.insert(KeyRangeRef(boundaries[i], i + 1 < boundaries.size() ? boundaries[i + 1] : allKeys.end), info);
+	}
+
+	StorageTagIndex index;
+	ASSERT(!index.isValid());
+	index.rebuild(keyInfo);
+	ASSERT(index.isValid());
+	ASSERT_EQ(index.shardCount(), keyInfo.size());
+	ASSERT_LE(index.teamCount(), 5);
+
+	for (int i = 0; i < 1000; i++) {
+		Key key = deterministicRandom()->coinflip()
+		              ? Key(deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(0, 4)))
+		              : Key("commonprefix/" + deterministicRandom()->randomAlphaNumeric(3));
+		ASSERT(index.tagsForKey(key) == keyInfo[key].tags);
+
+		Key end = keyAfter(key).withSuffix(deterministicRandom()->randomAlphaNumeric(2));
+		std::set<Tag> expected;
+		for (auto r : keyInfo.intersectingRanges(KeyRangeRef(key, end))) {
+			expected.insert(r.value().tags.begin(), r.value().tags.end());
+		}
+		std::set<Tag> tags;
+		const std::vector<Tag>* single = index.tagsForRange(KeyRangeRef(key, end), tags);
+		if (single) {
+			ASSERT(tags.empty());
+			tags.insert(single->begin(), single->end());
+		}
+		ASSERT(tags == expected);
+	}
+
+	index.invalidate();
+	ASSERT(!index.isValid());
+	return Void();
+}
+
+TEST_CASE("/fdbclient/StorageTagIndex/update") {
+	auto randomKey = [] {
+		return deterministicRandom()->coinflip()
+		           ? Key(deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(0, 4)))
+		           : Key("commonprefix/" + deterministicRandom()->randomAlphaNumeric(3));
+	};
+	auto randomInfo = [] {
+		ServerCacheInfo info;
+		info.tags.emplace_back(0, deterministicRandom()->randomInt(0, 8));
+		return info;
+	};
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	keyInfo.insert(allKeys, randomInfo());
+	StorageTagIndex index;
+	index.rebuild(keyInfo);
+
+	// Enough changes to fold the overlay into the flat copy a few times
+	bool rebuilt = false;
+	for (int i = 0; i < StorageTagIndex::maxOverlayBoundaries * 2; i++) {
+		// Mostly the narrow ranges of single shard moves, which grow the overlay
+		Key begin = randomKey();
+		Key end = deterministicRandom()->random01() < 0.9
+		              ? begin.withSuffix(deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(1, 3)))
+		              : randomKey();
+		if (end < begin) {
+			std::swap(begin, end);
+		}
+		KeyRange range(KeyRangeRef(begin, end));
+		if (deterministicRandom()->coinflip()) {
+			keyInfo.insert(range, randomInfo());
+		} else if (!range.empty()) {
+			// As clearing keyServers does: the range takes on the tags of the shard before it
+			keyInfo.insert(range,
+			               range.begin == StringRef() ? randomInfo() : keyInfo.rangeContainingKeyBefore(range.begin).value());
+		}
+		int boundariesBefore = index.overlayBoundaries();
+		index.update(keyInfo, range);
+		rebuilt = rebuilt || index.overlayBoundaries() < boundariesBefore;
+
+		for (int j = 0; j < 10; j++) {
+			Key key = randomKey();
+			ASSERT(index.tagsForKey(key) == keyInfo[key].tags);
+
+			Key rangeEnd = keyAfter(key).withSuffix(deterministicRandom()->randomAlphaNumeric(2));
+			std::set<Tag> expected;
+			for (auto r : keyInfo.intersectingRanges(KeyRangeRef(key, rangeEnd))) {
+				expected.insert(r.value().tags.begin(), r.value().tags.end());
+			}
+			std::set<Tag> tags;
+			const std::vector<Tag>* single = index.tagsForRange(KeyRangeRef(key, rangeEnd), tags);
+			if (single) {
+				ASSERT(tags.empty());
+				tags.insert(single->begin(), single->end());
+			}
+			ASSERT(tags == expected);
+		}
+	}
+	ASSERT(rebuilt);
+	return Void();
+}
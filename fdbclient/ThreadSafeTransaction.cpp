@@ -390,6 +390,10 @@ ThreadSafeTransaction::ThreadSafeTransaction(DatabaseContext* cx,
 		}
 		*init = true;
 	});
+
+	if (CLIENT_KNOBS->THREAD_SAFE_TRANSACTION_MUTATION_BATCH_SIZE > 1) {
+		mutationBatch = std::make_unique<MutationBatch>();
+	}
 }
 
 // This constructor is only used while refactoring fdbcli and only called from the main thread
@@ -400,22 +404,26 @@ ThreadSafeTransaction::ThreadSafeTransaction(ReadYourWritesTransaction* ryw)
 }
 
 ThreadSafeTransaction::~ThreadSafeTransaction() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	if (tr)
 		onMainThreadVoid([tr]() { tr->delref(); });
 }
 
 void ThreadSafeTransaction::cancel() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	onMainThreadVoid([tr]() { tr->cancel(); });
 }
 
 void ThreadSafeTransaction::setVersion(Version v) {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	onMainThreadVoid([tr, v]() { tr->setVersion(v); }, tr, &ISingleThreadTransaction::deferredError);
 }
 
 ThreadFuture<Version> ThreadSafeTransaction::getReadVersion() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<Version> {
 		tr->checkDeferredError();
@@ -424,6 +432,7 @@ ThreadFuture<Version> ThreadSafeTransaction::getReadVersion() {
 }
 
 ThreadFuture<Optional<Value>> ThreadSafeTransaction::get(const KeyRef& key, bool snapshot) {
+	flushMutations();
 	Key k = key;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -434,6 +443,7 @@ ThreadFuture<Optional<Value>> ThreadSafeTransaction::get(const KeyRef& key, bool
 }
 
 ThreadFuture<Key> ThreadSafeTransaction::getKey(const KeySelectorRef& key, bool snapshot) {
+	flushMutations();
 	KeySelector k = key;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -444,6 +454,7 @@ ThreadFuture<Key> ThreadSafeTransaction::getKey(const KeySelectorRef& key, bool
 }
 
 ThreadFuture<int64_t> ThreadSafeTransaction::getEstimatedRangeSizeBytes(const KeyRangeRef& keys) {
+	flushMutations();
 	KeyRange r = keys;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -455,6 +466,7 @@ ThreadFuture<int64_t> ThreadSafeTransaction::getEstimatedRangeSizeBytes(const Ke
 
 ThreadFuture<Standalone<VectorRef<KeyRef>>> ThreadSafeTransaction::getRangeSplitPoints(const KeyRangeRef& range,
                                                                                        int64_t chunkSize) {
+	flushMutations();
 	KeyRange r = range;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -469,6 +481,7 @@ ThreadFuture<RangeResult> ThreadSafeTransaction::getRange(const KeySelectorRef&
                                                           int limit,
                                                           bool snapshot,
                                                           bool reverse) {
+	flushMutations();
 	KeySelector b = begin;
 	KeySelector e = end;
 
@@ -484,6 +497,7 @@ ThreadFuture<RangeResult> ThreadSafeTransaction::getRange(const KeySelectorRef&
                                                           GetRangeLimits limits,
                                                           bool snapshot,
                                                           bool reverse) {
+	flushMutations();
 	KeySelector b = begin;
 	KeySelector e = end;
 
@@ -500,6 +514,7 @@ ThreadFuture<MappedRangeResult> ThreadSafeTransaction::getMappedRange(const KeyS
                                                                       GetRangeLimits limits,
                                                                       bool snapshot,
                                                                       bool reverse) {
+	flushMutations();
 	KeySelector b = begin;
 	KeySelector e = end;
 	Key h = mapper;
@@ -512,6 +527,7 @@ ThreadFuture<MappedRangeResult> ThreadSafeTransaction::getMappedRange(const KeyS
 }
 
 ThreadFuture<Standalone<VectorRef<const char*>>> ThreadSafeTransaction::getAddressesForKey(const KeyRef& key) {
+	flushMutations();
 	Key k = key;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -524,6 +540,7 @@ ThreadFuture<Standalone<VectorRef<const char*>>> ThreadSafeTransaction::getAddre
 ThreadFuture<Standalone<VectorRef<KeyRangeRef>>> ThreadSafeTransaction::getBlobGranuleRanges(
     const KeyRangeRef& keyRange,
     int rangeLimit) {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	KeyRange r = keyRange;
 
@@ -546,6 +563,7 @@ ThreadFuture<Standalone<VectorRef<BlobGranuleChunkRef>>> ThreadSafeTransaction::
     Version beginVersion,
     Optional<Version> readVersion,
     Version* readVersionOut) {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	KeyRange r = keyRange;
 
@@ -577,6 +595,7 @@ ThreadFuture<Standalone<VectorRef<BlobGranuleSummaryRef>>> ThreadSafeTransaction
     const KeyRangeRef& keyRange,
     Optional<Version> summaryVersion,
     int rangeLimit) {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	KeyRange r = keyRange;
 
@@ -586,7 +605,80 @@ ThreadFuture<Standalone<VectorRef<BlobGranuleSummaryRef>>> ThreadSafeTransaction
 	});
 }
 
+void ThreadSafeTransaction::addMutation(MutationBatch::Type type,
+                                        KeyRef key,
+                                        ValueRef value,
+                                        uint32_t operationType) {
+	ThreadSpinLockHolder holder(mutationBatch->lock);
+	auto& ops = mutationBatch->ops;
+	ops.push_back(ops.arena(),
+	              MutationBatch::Op{ type, operationType, KeyRef(ops.arena(), key), ValueRef(ops.arena(), value) });
+	mutationBatch->bytes += key.size() + value.size();
+	if (ops.size() >= CLIENT_KNOBS->THREAD_SAFE_TRANSACTION_MUTATION_BATCH_SIZE ||
+	    mutationBatch->bytes >= CLIENT_KNOBS->THREAD_SAFE_TRANSACTION_MUTATION_BATCH_BYTES) {
+		flushMutationsLocked();
+	}
+}
+
+void ThreadSafeTransaction::flushMutations() {
+	if (mutationBatch) {
+		ThreadSpinLockHolder holder(mutationBatch->lock);
+		flushMutationsLocked();
+	}
+}
+
+void ThreadSafeTransaction::flushMutationsLocked() {
+	if (mutationBatch->ops.empty()) {
+		return;
+	}
+	Standalone<VectorRef<MutationBatch::Op>> ops = mutationBatch->ops;
+	mutationBatch->ops = Standalone<VectorRef<MutationBatch::Op>>();
+	mutationBatch->bytes = 0;
+
+	// Submitted while holding the lock so that batches flushed from different threads are not reordered
+	ISingleThreadTransaction* tr = this->tr;
+	onMainThreadVoid([tr, ops]() {
+		using Type = MutationBatch::Type;
+		for (const auto& op : ops) {
+			// Matches calling onMainThreadVoid with deferredError once per mutation
+			if (tr->deferredError.code() != invalid_error_code) {
+				return;
+			}
+			try {
+				switch (op.type) {
+				case Type::Set:
+					tr->set(op.key, op.value);
+					break;
+				case Type::ClearKey:
+					tr->clear(op.key);
+					break;
+				case Type::ClearRange:
+					if (op.key > op.value)
+						throw inverted_range();
+					tr->clear(KeyRangeRef(op.key, op.value));
+					break;
+				case Type::AtomicOp:
+					tr->atomicOp(op.key, op.value, op.operationType);
+					break;
+				case Type::ReadConflictRange:
+					tr->addReadConflictRange(KeyRangeRef(op.key, op.value));
+					break;
+				case Type::WriteConflictRange:
+					tr->addWriteConflictRange(KeyRangeRef(op.key, op.value));
+					break;
+				}
+			} catch (Error& e) {
+				tr->deferredError = e;
+			}
+		}
+	});
+}
+
 void ThreadSafeTransaction::addReadConflictRange(const KeyRangeRef& keys) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::ReadConflictRange, keys.begin, keys.end);
+		return;
+	}
 	KeyRange r = keys;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -594,11 +686,16 @@ void ThreadSafeTransaction::addReadConflictRange(const KeyRangeRef& keys) {
 }
 
 void ThreadSafeTransaction::makeSelfConflicting() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	onMainThreadVoid([tr]() { tr->makeSelfConflicting(); }, tr, &ISingleThreadTransaction::deferredError);
 }
 
 void ThreadSafeTransaction::atomicOp(const KeyRef& key, const ValueRef& value, uint32_t operationType) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::AtomicOp, key, value, operationType);
+		return;
+	}
 	Key k = key;
 	Value v = value;
 
@@ -609,6 +706,10 @@ void ThreadSafeTransaction::atomicOp(const KeyRef& key, const ValueRef& value, u
 }
 
 void ThreadSafeTransaction::set(const KeyRef& key, const ValueRef& value) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::Set, key, value);
+		return;
+	}
 	Key k = key;
 	Value v = value;
 
@@ -617,6 +718,10 @@ void ThreadSafeTransaction::set(const KeyRef& key, const ValueRef& value) {
 }
 
 void ThreadSafeTransaction::clear(const KeyRangeRef& range) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::ClearRange, range.begin, range.end);
+		return;
+	}
 	KeyRange r = range;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -624,6 +729,10 @@ void ThreadSafeTransaction::clear(const KeyRangeRef& range) {
 }
 
 void ThreadSafeTransaction::clear(const KeyRef& begin, const KeyRef& end) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::ClearRange, begin, end);
+		return;
+	}
 	Key b = begin;
 	Key e = end;
 
@@ -640,6 +749,10 @@ void ThreadSafeTransaction::clear(const KeyRef& begin, const KeyRef& end) {
 }
 
 void ThreadSafeTransaction::clear(const KeyRef& key) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::ClearKey, key, ValueRef());
+		return;
+	}
 	Key k = key;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -647,6 +760,7 @@ void ThreadSafeTransaction::clear(const KeyRef& key) {
 }
 
 ThreadFuture<Void> ThreadSafeTransaction::watch(const KeyRef& key) {
+	flushMutations();
 	Key k = key;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -657,6 +771,10 @@ ThreadFuture<Void> ThreadSafeTransaction::watch(const KeyRef& key) {
 }
 
 void ThreadSafeTransaction::addWriteConflictRange(const KeyRangeRef& keys) {
+	if (mutationBatch) {
+		addMutation(MutationBatch::Type::WriteConflictRange, keys.begin, keys.end);
+		return;
+	}
 	KeyRange r = keys;
 
 	ISingleThreadTransaction* tr = this->tr;
@@ -664,6 +782,7 @@ void ThreadSafeTransaction::addWriteConflictRange(const KeyRangeRef& keys) {
 }
 
 ThreadFuture<Void> ThreadSafeTransaction::commit() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<Void> {
 		tr->checkDeferredError();
@@ -680,6 +799,7 @@ Version ThreadSafeTransaction::getCommittedVersion() {
 }
 
 ThreadFuture<VersionVector> ThreadSafeTransaction::getVersionVector() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<VersionVector> {
 		tr->checkDeferredError();
@@ -688,6 +808,7 @@ ThreadFuture<VersionVector> ThreadSafeTransaction::getVersionVector() {
 }
 
 ThreadFuture<SpanContext> ThreadSafeTransaction::getSpanContext() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<SpanContext> {
 		tr->checkDeferredError();
@@ -696,6 +817,7 @@ ThreadFuture<SpanContext> ThreadSafeTransaction::getSpanContext() {
 }
 
 ThreadFuture<double> ThreadSafeTransaction::getTagThrottledDuration() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<double> {
 		tr->checkDeferredError();
@@ -704,6 +826,7 @@ ThreadFuture<double> ThreadSafeTransaction::getTagThrottledDuration() {
 }
 
 ThreadFuture<int64_t> ThreadSafeTransaction::getTotalCost() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<int64_t> {
 		tr->checkDeferredError();
@@ -712,6 +835,7 @@ ThreadFuture<int64_t> ThreadSafeTransaction::getTotalCost() {
 }
 
 ThreadFuture<int64_t> ThreadSafeTransaction::getApproximateSize() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<int64_t> {
 		tr->checkDeferredError();
@@ -720,6 +844,7 @@ ThreadFuture<int64_t> ThreadSafeTransaction::getApproximateSize() {
 }
 
 ThreadFuture<Standalone<StringRef>> ThreadSafeTransaction::getVersionstamp() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() -> Future<Standalone<StringRef>> {
 		tr->checkDeferredError();
@@ -728,6 +853,7 @@ ThreadFuture<Standalone<StringRef>> ThreadSafeTransaction::getVersionstamp() {
 }
 
 void ThreadSafeTransaction::setOption(FDBTransactionOptions::Option option, Optional<StringRef> value) {
+	flushMutations();
 	auto itr = FDBTransactionOptions::optionInfo.find(option);
 	if (itr == FDBTransactionOptions::optionInfo.end()) {
 		TraceEvent("UnknownTransactionOption").detail("Option", option);
@@ -743,6 +869,7 @@ void ThreadSafeTransaction::setOption(FDBTransactionOptions::Option option, Opti
 }
 
 ThreadFuture<Void> ThreadSafeTransaction::checkDeferredError() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr]() {
 		try {
@@ -756,6 +883,7 @@ ThreadFuture<Void> ThreadSafeTransaction::checkDeferredError() {
 }
 
 ThreadFuture<Void> ThreadSafeTransaction::onError(Error const& e) {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	return onMainThread([tr, e]() { return tr->onError(e); });
 }
@@ -765,23 +893,28 @@ Optional<TenantName> ThreadSafeTransaction::getTenant() {
 }
 
 void ThreadSafeTransaction::operator=(ThreadSafeTransaction&& r) noexcept {
+	flushMutations();
 	tr = r.tr;
 	r.tr = nullptr;
 	initialized = std::move(r.initialized);
+	mutationBatch = std::move(r.mutationBatch);
 }
 
 ThreadSafeTransaction::ThreadSafeTransaction(ThreadSafeTransaction&& r) noexcept {
 	tr = r.tr;
 	r.tr = nullptr;
 	initialized = std::move(r.initialized);
+	mutationBatch = std::move(r.mutationBatch);
 }
 
 void ThreadSafeTransaction::reset() {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	onMainThreadVoid([tr]() { tr->reset(); });
 }
 
 void ThreadSafeTransaction::debugTrace(BaseTraceEvent&& ev) {
+	flushMutations();
 	if (ev.isEnabled()) {
 		ISingleThreadTransaction* tr = this->tr;
 		std::shared_ptr<BaseTraceEvent> evPtr = std::make_shared<BaseTraceEvent>(std::move(ev));
@@ -790,6 +923,7 @@ void ThreadSafeTransaction::debugTrace(BaseTraceEvent&& ev) {
 };
 
 void ThreadSafeTransaction::debugPrint(std::string const& message) {
+	flushMutations();
 	ISingleThreadTransaction* tr = this->tr;
 	onMainThreadVoid([tr, message]() { tr->debugPrint(message); });
 }
@@ -38,15 +38,56 @@ static double bigEndianDouble(double orig) {
 	return *(double*)&big;
 }
 
+// Escaped nulls are rare, so rather than testing every byte this jumps between nulls with memchr, which the C library
+// vectorizes.
 static size_t findStringTerminator(const StringRef data, size_t offset) {
+	const size_t last = data.size() - 1;
 	size_t i = offset;
-	while (i < data.size() - 1 && !(data[i] == '\x00' && data[i + 1] != (uint8_t)'\xff')) {
-		i += (data[i] == '\x00' ? 2 : 1);
+	while (i < last) {
+		const uint8_t* zero = (const uint8_t*)memchr(data.begin() + i, '\x00', last - i);
+		if (zero == nullptr) {
+			return last;
+		}
+		i = zero - data.begin();
+		if (data[i + 1] != (uint8_t)'\xff') {
+			return i;
+		}
+		i += 2;
 	}
 
 	return i;
 }
 
+static bool isUserTypeCode(uint8_t code) {
+	return code >= USER_TYPE_START && code <= USER_TYPE_END;
+}
+
+// Returns the offset just past the element that starts at offset i, which may be beyond the end of data if the
+// element is incomplete.
+static size_t skipElement(const StringRef data, size_t i, bool include_user_type) {
+	const uint8_t code = data[i];
+	if (code == '\x01' || code == '\x02') {
+		return findStringTerminator(data, i + 1) + 1;
+	} else if (code >= '\x0c' && code <= '\x1c') {
+		return i + abs(code - '\x14') + 1;
+	} else if (code == 0x20) {
+		return i + sizeof(float) + 1;
+	} else if (code == 0x21) {
+		return i + sizeof(double) + 1;
+	} else if (code == 0x26 || code == 0x27) {
+		return i + 1;
+	} else if (code == '\x00') {
+		return i + 1;
+	} else if (code == VERSIONSTAMP_96_CODE) {
+		return i + VERSIONSTAMP_TUPLE_SIZE + 1;
+	} else if (include_user_type && isUserTypeCode(code)) {
+		// User defined codes must come at the end of a Tuple and are not delimited.
+		return data.size();
+	} else {
+		throw invalid_tuple_data_type();
+	}
+}
+
 // If encoding and the sign bit is 1 (the number is negative), flip all the bits.
 // If decoding and the sign bit is 0 (the number is negative), flip all the bits.
 // Otherwise, the number is positive, so flip the sign bit.
@@ -67,27 +108,7 @@ Tuple::Tuple(StringRef const& str, bool exclude_incomplete, bool include_user_ty
 	size_t i = 0;
 	while (i < data.size()) {
 		offsets.push_back(i);
-
-		if (data[i] == '\x01' || data[i] == '\x02') {
-			i = findStringTerminator(str, i + 1) + 1;
-		} else if (data[i] >= '\x0c' && data[i] <= '\x1c') {
-			i += abs(data[i] - '\x14') + 1;
-		} else if (data[i] == 0x20) {
-			i += sizeof(float) + 1;
-		} else if (data[i] == 0x21) {
-			i += sizeof(double) + 1;
-		} else if (data[i] == 0x26 || data[i] == 0x27) {
-			i += 1;
-		} else if (data[i] == '\x00') {
-			i += 1;
-		} else if (data[i] == VERSIONSTAMP_96_CODE) {
-			i += VERSIONSTAMP_TUPLE_SIZE + 1;
-		} else if (include_user_type && isUserType(data[i])) {
-			// User defined codes must come at the end of a Tuple and are not delimited.
-			i = data.size();
-		} else {
-			throw invalid_tuple_data_type();
-		}
+		i = skipElement(str, i, include_user_type);
 	}
 	// If incomplete tuples are allowed, remove the last offset if i is now beyond size()
 	// Strings will never be considered incomplete due to the way the string end is found.
@@ -99,6 +120,18 @@ Tuple Tuple::unpack(StringRef const& str, bool exclude_incomplete) {
 	return Tuple(str, exclude_incomplete);
 }
 
+StringRef Tuple::elementRawString(StringRef const& str, size_t index, bool include_user_type) {
+	size_t i = 0;
+	for (; index > 0 && i < str.size(); index--) {
+		i = skipElement(str, i, include_user_type);
+	}
+	if (i >= str.size()) {
+		throw invalid_tuple_index();
+	}
+	const size_t end = std::min<size_t>(skipElement(str, i, include_user_type), str.size());
+	return str.substr(i, end - i);
+}
+
 std::string Tuple::tupleToString(const Tuple& tuple) {
 	std::string str;
 	if (tuple.size() > 1) {
@@ -146,7 +179,7 @@ Tuple Tuple::unpackUserType(StringRef const& str, bool exclude_incomplete) {
 }
 
 bool Tuple::isUserType(uint8_t code) const {
-	return code >= USER_TYPE_START && code <= USER_TYPE_END;
+	return isUserTypeCode(code);
 }
 
 Tuple& Tuple::append(Tuple const& tuple) {
@@ -171,20 +204,23 @@ Tuple& Tuple::append(TupleVersionstamp const& vs) {
 Tuple& Tuple::append(StringRef const& str, bool utf8) {
 	offsets.push_back(data.size());
 
-	const uint8_t utfChar = uint8_t(utf8 ? '\x02' : '\x01');
-	data.append(data.arena(), &utfChar, 1);
+	// Most strings contain no nulls, so make room for the unescaped string up front and copy it in runs between nulls
+	data.reserve(data.arena(), data.size() + str.size() + 2);
+	data.push_back(data.arena(), uint8_t(utf8 ? '\x02' : '\x01'));
 
-	size_t lastPos = 0;
-	for (size_t pos = 0; pos < str.size(); ++pos) {
-		if (str[pos] == '\x00') {
-			data.append(data.arena(), str.begin() + lastPos, pos - lastPos);
-			data.push_back(data.arena(), (uint8_t)'\x00');
-			data.push_back(data.arena(), (uint8_t)'\xff');
-			lastPos = pos + 1;
+	const uint8_t* pos = str.begin();
+	const uint8_t* end = str.end();
+	while (pos != end) {
+		const uint8_t* zero = (const uint8_t*)memchr(pos, '\x00', end - pos);
+		if (zero == nullptr) {
+			break;
 		}
+		data.append(data.arena(), pos, zero + 1 - pos);
+		data.push_back(data.arena(), (uint8_t)'\xff');
+		pos = zero + 1;
 	}
 
-	data.append(data.arena(), str.begin() + lastPos, str.size() - lastPos);
+	data.append(data.arena(), pos, end - pos);
 	data.push_back(data.arena(), (uint8_t)'\x00');
 
 	return *this;
@@ -330,24 +366,27 @@ Standalone<StringRef> Tuple::getString(size_t index) const {
 		e = data.size();
 	}
 
+	const uint8_t* begin = data.begin() + b;
+	const uint8_t* end = data.begin() + e;
+	const uint8_t* zero = (const uint8_t*)memchr(begin, '\x00', end - begin);
+	if (zero == nullptr || zero == end - 1) {
+		// Without escaped nulls the string is a slice of the packed tuple, minus its terminator if present
+		return Standalone<StringRef>(StringRef(begin, (zero ? zero : end) - begin), data.arena());
+	}
+
 	Standalone<StringRef> result;
 	VectorRef<uint8_t> staging;
+	staging.reserve(result.arena(), end - begin);
 
-	for (size_t i = b; i < e; ++i) {
-		if (data[i] == '\x00') {
-			staging.append(result.arena(), data.begin() + b, i - b);
-			++i;
-			b = i + 1;
-
-			if (i < e) {
-				staging.push_back(result.arena(), '\x00');
-			}
+	while (zero != nullptr) {
+		staging.append(result.arena(), begin, zero - begin);
+		if (zero + 1 < end) {
+			staging.push_back(result.arena(), '\x00');
 		}
+		begin = std::min(zero + 2, end);
+		zero = (const uint8_t*)memchr(begin, '\x00', end - begin);
 	}
-
-	if (b < e) {
-		staging.append(result.arena(), data.begin() + b, e - b);
-	}
+	staging.append(result.arena(), begin, end - begin);
 
 	result.StringRef::operator=(StringRef(staging.begin(), staging.size()));
 	return result;
@@ -601,3 +640,52 @@ TEST_CASE("/fdbclient/Tuple/unpack") {
 
 	return Void();
 }
+
+TEST_CASE("/fdbclient/Tuple/strings") {
+	// Escaped nulls at either end, in a run and alone must all round trip
+	std::vector<Standalone<StringRef>> strings = { ""_sr,          "abc"_sr,          "\x00"_sr,
+	                                               "\x00\x00"_sr,  "a\x00"_sr,        "\x00z"_sr,
+	                                               "a\x00\xff"_sr, "\xff\x00\xff"_sr, "\x00\x00x\x00"_sr };
+
+	for (int i = 0; i < 100; i++) {
+		std::string s = deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(0, 40));
+		for (auto& c : s) {
+			if (deterministicRandom()->random01() < 0.2) {
+				c = deterministicRandom()->coinflip() ? '\x00' : '\xff';
+			}
+		}
+		strings.push_back(Standalone<StringRef>(s));
+	}
+
+	for (const auto& str : strings) {
+		Tuple t = Tuple::makeTuple(str, 7, Tuple::UnicodeStr(str));
+		Standalone<StringRef> packed = t.pack();
+		Tuple unpacked = Tuple::unpack(packed);
+		ASSERT_EQ(unpacked.size(), 3);
+		ASSERT(unpacked.getString(0) == str);
+		ASSERT_EQ(unpacked.getInt(1), 7);
+		ASSERT(unpacked.getString(2) == str);
+
+		// Each element can be decoded on its own
+		ASSERT(Tuple::unpack(Tuple::elementRawString(packed, 0)).getString(0) == str);
+		ASSERT_EQ(Tuple::unpack(Tuple::elementRawString(packed, 1)).getInt(0), 7);
+		ASSERT(Tuple::elementRawString(packed, 2) == t.subTupleRawString(2));
+	}
+
+	try {
+		Tuple::elementRawString(Tuple::makeTuple(1, 2).pack(), 2);
+		ASSERT(false);
+	} catch (Error& e) {
+		if (e.code() != error_code_invalid_tuple_index) {
+			throw e;
+		}
+	}
+
+	// A string truncated before its terminator is still readable
+	Standalone<StringRef> packed = Tuple::makeTuple("ab\x00"_sr).pack();
+	ASSERT(Tuple::unpack(packed.substr(0, packed.size() - 1)).getString(0) == "ab\x00"_sr);
+	ASSERT(Tuple::unpack(packed.substr(0, packed.size() - 2)).getString(0) == "ab"_sr);
+	ASSERT(Tuple::unpack(packed.substr(0, packed.size() - 3)).getString(0) == "ab"_sr);
+
+	return Void();
+}
@@ -19,6 +19,7 @@
  */
 
 #include "fdbclient/WriteMap.h"
+#include "fdbclient/Knobs.h"
 
 void OperationStack::reset(RYWMutation initialEntry) {
 	defaultConstructed = false;
@@ -75,9 +76,23 @@ bool OperationStack::operator==(const OperationStack& r) const {
 	return true;
 }
 
+WriteMap::WriteMap(Arena* arena) : WriteMap(arena, CLIENT_KNOBS->WRITE_MAP_FLAT_ENTRY_LIMIT) {}
+
+WriteMap::WriteMap(Arena* arena, int flatEntryLimit)
+  : arena(arena), writeMapEmpty(true), flatEntryLimit(flatEntryLimit), ver(-1), scratch_iterator(this) {
+	if (flatEntryLimit >= 3) {
+		flat = makeReference<FlatWrites>();
+	}
+	insertEntry(WriteMapEntry(allKeys.begin, OperationStack(), false, false, false, false, false));
+	insertEntry(WriteMapEntry(allKeys.end, OperationStack(), false, false, false, false, false));
+	insertEntry(WriteMapEntry(afterAllKeys, OperationStack(), false, false, false, false, false));
+}
+
 WriteMap& WriteMap::operator=(WriteMap&& r) noexcept {
 	writeMapEmpty = r.writeMapEmpty;
 	writes = std::move(r.writes);
+	flat = std::move(r.flat);
+	flatEntryLimit = r.flatEntryLimit;
 	ver = r.ver;
 	scratch_iterator = std::move(r.scratch_iterator);
 	arena = r.arena;
@@ -87,7 +102,7 @@ WriteMap& WriteMap::operator=(WriteMap&& r) noexcept {
 void WriteMap::mutate(KeyRef key, MutationRef::Type operation, ValueRef param, bool addConflict) {
 	writeMapEmpty = false;
 	auto& it = scratch_iterator;
-	it.reset(writes, ver);
+	it.reset(*this);
 	it.skip(key);
 
 	bool is_cleared = it.entry().following_keys_cleared;
@@ -101,40 +116,33 @@ void WriteMap::mutate(KeyRef key, MutationRef::Type operation, ValueRef param, b
 
 	if (it.entry().key != key) {
 		if (it.is_cleared_range() && is_dependent) {
-			it.tree.clear();
+			it.release();
 			OperationStack op(RYWMutation(Optional<StringRef>(), MutationRef::SetValue));
 			coalesceOver(op, RYWMutation(param, operation), *arena);
-			PTreeImpl::insert(
-			    writes,
-			    ver,
-			    WriteMapEntry(
-			        key, std::move(op), true, following_conflict, is_conflict, following_unreadable, is_unreadable));
+			insertEntry(WriteMapEntry(
+			    key, std::move(op), true, following_conflict, is_conflict, following_unreadable, is_unreadable));
 		} else {
-			it.tree.clear();
-			PTreeImpl::insert(writes,
-			                  ver,
-			                  WriteMapEntry(key,
-			                                OperationStack(RYWMutation(param, operation)),
-			                                is_cleared,
-			                                following_conflict,
-			                                is_conflict,
-			                                following_unreadable,
-			                                is_unreadable));
+			it.release();
+			insertEntry(WriteMapEntry(key,
+			                          OperationStack(RYWMutation(param, operation)),
+			                          is_cleared,
+			                          following_conflict,
+			                          is_conflict,
+			                          following_unreadable,
+			                          is_unreadable));
 		}
 	} else {
 		if (!it.is_unreadable() &&
 		    (operation == MutationRef::SetValue || operation == MutationRef::SetVersionstampedValue)) {
-			it.tree.clear();
-			PTreeImpl::remove(writes, ver, key);
-			PTreeImpl::insert(writes,
-			                  ver,
-			                  WriteMapEntry(key,
-			                                OperationStack(RYWMutation(param, operation)),
-			                                is_cleared,
-			                                following_conflict,
-			                                is_conflict,
-			                                following_unreadable,
-			                                is_unreadable));
+			it.release();
+			removeEntry(key);
+			insertEntry(WriteMapEntry(key,
+			                          OperationStack(RYWMutation(param, operation)),
+			                          is_cleared,
+			                          following_conflict,
+			                          is_conflict,
+			                          following_unreadable,
+			                          is_unreadable));
 		} else {
 			WriteMapEntry e(it.entry());
 			e.is_conflict = is_conflict;
@@ -147,12 +155,9 @@ void WriteMap::mutate(KeyRef key, MutationRef::Type operation, ValueRef param, b
 			else
 				e.stack.push(RYWMutation(param, operation));
 
-			it.tree.clear();
-			PTreeImpl::remove(
-			    writes,
-			    ver,
-			    e.key); // FIXME: Make PTreeImpl::insert do this automatically (see also VersionedMap.h FIXME)
-			PTreeImpl::insert(writes, ver, std::move(e));
+			it.release();
+			removeEntry(e.key); // FIXME: Make insertEntry do this automatically (see also VersionedMap.h FIXME)
+			insertEntry(std::move(e));
 		}
 	}
 }
@@ -165,7 +170,7 @@ void WriteMap::clear(KeyRangeRef keys, bool addConflict) {
 	}
 
 	auto& it = scratch_iterator;
-	it.reset(writes, ver);
+	it.reset(*this);
 	it.skip(keys.begin);
 
 	bool insert_begin = !it.is_cleared_range() || !it.is_conflict_range() || it.is_unreadable();
@@ -184,27 +189,21 @@ void WriteMap::clear(KeyRangeRef keys, bool addConflict) {
 	bool end_cleared = it.is_cleared_range();
 	bool end_unreadable = it.is_unreadable();
 
-	it.tree.clear();
+	it.release();
 
-	PTreeImpl::remove(writes,
-	                  ver,
-	                  ExtStringRef(keys.begin, !insert_begin ? 1 : 0),
-	                  ExtStringRef(keys.end, end_coalesce_clear ? 1 : 0));
+	removeEntries(ExtStringRef(keys.begin, !insert_begin ? 1 : 0), ExtStringRef(keys.end, end_coalesce_clear ? 1 : 0));
 
 	if (insert_begin)
-		PTreeImpl::insert(writes, ver, WriteMapEntry(keys.begin, OperationStack(), true, true, true, false, false));
+		insertEntry(WriteMapEntry(keys.begin, OperationStack(), true, true, true, false, false));
 
 	if (insert_end)
-		PTreeImpl::insert(
-		    writes,
-		    ver,
-		    WriteMapEntry(
-		        keys.end, OperationStack(), end_cleared, end_conflict, end_conflict, end_unreadable, end_unreadable));
+		insertEntry(WriteMapEntry(
+		    keys.end, OperationStack(), end_cleared, end_conflict, end_conflict, end_unreadable, end_unreadable));
 }
 
 void WriteMap::addUnmodifiedAndUnreadableRange(KeyRangeRef keys) {
 	auto& it = scratch_iterator;
-	it.reset(writes, ver);
+	it.reset(*this);
 	it.skip(keys.begin);
 
 	bool insert_begin = !it.is_unmodified_range() || it.is_conflict_range() || !it.is_unreadable();
@@ -223,28 +222,23 @@ void WriteMap::addUnmodifiedAndUnreadableRange(KeyRangeRef keys) {
 	bool end_cleared = it.is_cleared_range();
 	bool end_unreadable = it.is_unreadable();
 
-	it.tree.clear();
+	it.release();
 
-	PTreeImpl::remove(writes,
-	                  ver,
-	                  ExtStringRef(keys.begin, !insert_begin ? 1 : 0),
-	                  ExtStringRef(keys.end, end_coalesce_unmodified ? 1 : 0));
+	removeEntries(ExtStringRef(keys.begin, !insert_begin ? 1 : 0),
+	              ExtStringRef(keys.end, end_coalesce_unmodified ? 1 : 0));
 
 	if (insert_begin)
-		PTreeImpl::insert(writes, ver, WriteMapEntry(keys.begin, OperationStack(), false, false, false, true, true));
+		insertEntry(WriteMapEntry(keys.begin, OperationStack(), false, false, false, true, true));
 
 	if (insert_end)
-		PTreeImpl::insert(
-		    writes,
-		    ver,
-		    WriteMapEntry(
-		        keys.end, OperationStack(), end_cleared, end_conflict, end_conflict, end_unreadable, end_unreadable));
+		insertEntry(WriteMapEntry(
+		    keys.end, OperationStack(), end_cleared, end_conflict, end_conflict, end_unreadable, end_unreadable));
 }
 
 void WriteMap::addConflictRange(KeyRangeRef keys) {
 	writeMapEmpty = false;
 	auto& it = scratch_iterator;
-	it.reset(writes, ver);
+	it.reset(*this);
 	it.skip(keys.begin);
 
 	std::vector<ExtStringRef> removals;
@@ -287,18 +281,15 @@ void WriteMap::addConflictRange(KeyRangeRef keys) {
 		}
 	}
 
-	it.tree.clear();
+	it.release();
 
 	// SOMEDAY: optimize this code by having a PTree removal/insertion that takes and returns an iterator
 	for (int i = 0; i < removals.size(); i++) {
-		PTreeImpl::remove(
-		    writes,
-		    ver,
-		    removals[i]); // FIXME: Make PTreeImpl::insert do this automatically (see also VersionedMap.h FIXME)
+		removeEntry(removals[i]); // FIXME: Make insertEntry do this automatically (see also VersionedMap.h FIXME)
 	}
 
 	for (int i = 0; i < insertions.size(); i++) {
-		PTreeImpl::insert(writes, ver, std::move(insertions[i]));
+		insertEntry(std::move(insertions[i]));
 	}
 }
 
@@ -313,9 +304,7 @@ WriteMap::iterator& WriteMap::iterator::operator++() {
 	if (!offset && !equalsKeyAfter(entry().key, nextEntry().key)) {
 		offset = true;
 	} else {
-		beginLen = endLen;
-		finger.resize(beginLen);
-		endLen = PTreeImpl::halfNext(at, finger);
+		next();
 		offset = !entry().stack.size();
 	}
 	return *this;
@@ -324,33 +313,57 @@ WriteMap::iterator& WriteMap::iterator::operator--() {
 	if (offset && entry().stack.size()) {
 		offset = false;
 	} else {
-		endLen = beginLen;
-		finger.resize(endLen);
-		beginLen = PTreeImpl::halfPrevious(at, finger);
+		previous();
 		offset = !entry().stack.size() || !equalsKeyAfter(entry().key, nextEntry().key);
 	}
 	return *this;
 }
 
+void WriteMap::iterator::next() {
+	if (flat) {
+		++flatIndex;
+		return;
+	}
+	beginLen = endLen;
+	finger.resize(beginLen);
+	endLen = PTreeImpl::halfNext(at, finger);
+}
+
+void WriteMap::iterator::previous() {
+	if (flat) {
+		--flatIndex;
+		return;
+	}
+	endLen = beginLen;
+	finger.resize(endLen);
+	beginLen = PTreeImpl::halfPrevious(at, finger);
+}
+
 void WriteMap::iterator::skip(
     KeyRef key) { // Changes *this to the segment containing key (so that beginKey()<=key && key < endKey())
-	finger.clear();
+	if (flat) {
+		const std::vector<WriteMapEntry>& entries = flat->entries;
+		flatIndex = std::upper_bound(entries.begin(), entries.end(), key) - entries.begin() - 1;
+	} else {
+		finger.clear();
 
-	if (key == allKeys.end)
-		PTreeImpl::last(tree, at, finger);
-	else
-		PTreeImpl::upper_bound(tree, at, key, finger);
-	endLen = finger.size();
-	beginLen = PTreeImpl::halfPrevious(at, finger);
+		if (key == allKeys.end)
+			PTreeImpl::last(tree, at, finger);
+		else
+			PTreeImpl::upper_bound(tree, at, key, finger);
+		endLen = finger.size();
+		beginLen = PTreeImpl::halfPrevious(at, finger);
+	}
 
 	offset = !entry().stack.size() || (entry().key != key);
 }
 
-void WriteMap::iterator::reset(Tree const& tree, Version ver) {
-	this->tree = tree;
-	this->at = ver;
+void WriteMap::iterator::reset(WriteMap const& map) {
+	this->tree = map.writes;
+	this->flat = map.flat;
+	this->at = map.ver;
 	this->finger.clear();
-	beginLen = endLen = 0;
+	beginLen = endLen = flatIndex = 0;
 	offset = false;
 }
 
@@ -507,6 +520,59 @@ RYWMutation WriteMap::coalesceUnder(OperationStack const& stack, Optional<ValueR
 	return currentEntry;
 }
 
+std::vector<WriteMapEntry>& WriteMap::mutableFlatEntries() {
+	if (!flat->isSoleOwner()) {
+		auto copy = makeReference<FlatWrites>();
+		copy->entries = flat->entries;
+		flat = copy;
+	}
+	return flat->entries;
+}
+
+void WriteMap::insertEntry(WriteMapEntry&& entry) {
+	if (!flat) {
+		PTreeImpl::insert(writes, ver, entry);
+		return;
+	}
+	std::vector<WriteMapEntry>& entries = mutableFlatEntries();
+	auto i = std::lower_bound(entries.begin(), entries.end(), entry.key);
+	if (i != entries.end() && i->key == entry.key) {
+		*i = std::move(entry);
+	} else {
+		entries.insert(i, std::move(entry));
+	}
+
+	if (entries.size() > static_cast<size_t>(flatEntryLimit)) {
+		CODE_PROBE(true, "WriteMap moved from sorted array to tree");
+		for (const auto& e : entries) {
+			PTreeImpl::insert(writes, ver, e);
+		}
+		flat.clear();
+	}
+}
+
+void WriteMap::removeEntry(ExtStringRef const& key) {
+	if (!flat) {
+		PTreeImpl::remove(writes, ver, key);
+		return;
+	}
+	std::vector<WriteMapEntry>& entries = mutableFlatEntries();
+	auto i = std::lower_bound(entries.begin(), entries.end(), key);
+	ASSERT(i != entries.end() && !(key < *i)); // attempt to remove item not present in WriteMap
+	entries.erase(i);
+}
+
+void WriteMap::removeEntries(ExtStringRef const& begin, ExtStringRef const& end) {
+	if (!flat) {
+		PTreeImpl::remove(writes, ver, begin, end);
+		return;
+	}
+	std::vector<WriteMapEntry>& entries = mutableFlatEntries();
+	auto first = std::lower_bound(entries.begin(), entries.end(), begin);
+	auto last = std::lower_bound(first, entries.end(), end);
+	entries.erase(first, last);
+}
+
 void WriteMap::dump() {
 	iterator it(this);
 	it.skip(allKeys.begin);
@@ -526,7 +592,7 @@ void WriteMap::dump() {
 
 void WriteMap::clearNoConflict(KeyRangeRef keys) {
 	auto& it = scratch_iterator;
-	it.reset(writes, ver);
+	it.reset(*this);
 
 	// Find all write conflict ranges within the cleared range
 	it.skip(keys.begin);
@@ -569,28 +635,19 @@ void WriteMap::clearNoConflict(KeyRangeRef keys) {
 
 	CODE_PROBE(it.is_conflict_range() != lastConflicted, "not last conflicted");
 
-	it.tree.clear();
+	it.release();
 
-	PTreeImpl::remove(writes,
-	                  ver,
-	                  ExtStringRef(keys.begin, !insert_begin ? 1 : 0),
-	                  ExtStringRef(keys.end, end_coalesce_clear ? 1 : 0));
+	removeEntries(ExtStringRef(keys.begin, !insert_begin ? 1 : 0), ExtStringRef(keys.end, end_coalesce_clear ? 1 : 0));
 
 	for (int i = 0; i < conflict_ranges.size(); i++) {
-		PTreeImpl::insert(
-		    writes,
-		    ver,
-		    WriteMapEntry(
-		        conflict_ranges[i].toArenaOrRef(*arena), OperationStack(), true, conflicted, conflicted, false, false));
+		insertEntry(WriteMapEntry(
+		    conflict_ranges[i].toArenaOrRef(*arena), OperationStack(), true, conflicted, conflicted, false, false));
 		conflicted = !conflicted;
 	}
 
 	ASSERT(conflicted != lastConflicted);
 
 	if (insert_end)
-		PTreeImpl::insert(
-		    writes,
-		    ver,
-		    WriteMapEntry(
-		        keys.end, OperationStack(), end_cleared, end_conflict, end_conflict, end_unreadable, end_unreadable));
+		insertEntry(WriteMapEntry(
+		    keys.end, OperationStack(), end_cleared, end_conflict, end_conflict, end_unreadable, end_unreadable));
 }
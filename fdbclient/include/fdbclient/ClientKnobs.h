@@ -74,6 +74,7 @@ public:
 	int64_t VALUE_SIZE_LIMIT;
 	int64_t SPLIT_KEY_SIZE_LIMIT;
 	int METADATA_VERSION_CACHE_SIZE;
+	int64_t METADATA_VERSION_READ_CACHE_BYTES; // Bytes of rows kept for the METADATA_VERSION_CACHED_PREFIX option
 	int64_t CHANGE_FEED_LOCATION_LIMIT;
 	int64_t CHANGE_FEED_CACHE_SIZE;
 	double CHANGE_FEED_POP_TIMEOUT;
@@ -97,6 +98,8 @@ public:
 
 	int GET_RANGE_SHARD_LIMIT;
 	int WARM_RANGE_SHARD_LIMIT;
+	int LOCATION_CACHE_PREFETCH_SHARD_LIMIT; // On a location cache miss, fetch locations for up to this many shards of
+	                                         // the requested range so that scans warm the cache in a few requests
 	int STORAGE_METRICS_SHARD_LIMIT;
 	int SHARD_COUNT_LIMIT;
 	double STORAGE_METRICS_UNFAIR_SPLIT_LIMIT;
@@ -222,6 +225,8 @@ public:
 	double CSI_SAMPLING_PROBABILITY;
 	int64_t CSI_SIZE_LIMIT;
 	double CSI_STATUS_DELAY;
+	bool CSI_FILE_SINK; // Write sampled transaction profiles to binary files next to the trace files, not the database
+	std::string CSI_TAG_SAMPLING_PROBABILITIES; // Comma separated tag:probability pairs overriding the sample rate
 
 	bool HTTP_REQUEST_AWS_V4_HEADER; // setting this knob to true will enable AWS V4 style header.
 	std::string BLOBSTORE_ENCRYPTION_TYPE;
@@ -296,6 +301,15 @@ public:
 	double BUSYNESS_SPIKE_START_THRESHOLD;
 	double BUSYNESS_SPIKE_SATURATED_THRESHOLD;
 
+	// Thread safe client API
+	int THREAD_SAFE_TRANSACTION_MUTATION_BATCH_SIZE; // Mutations buffered on the calling thread before they are handed
+	                                                 // to the network thread together; values below 2 disable batching
+	int THREAD_SAFE_TRANSACTION_MUTATION_BATCH_BYTES; // Bytes of buffered keys and values that force a handoff
+
+	// Read your writes
+	int WRITE_MAP_FLAT_ENTRY_LIMIT; // A transaction's write map is kept in a sorted array until it has more than this
+	                                // many entries, then moved to a tree; values below 3 always use the tree
+
 	// Blob Granules
 	int BG_MAX_GRANULE_PARALLELISM;
 	int BG_TOO_MANY_GRANULES;
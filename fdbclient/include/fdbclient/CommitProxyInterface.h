@@ -229,6 +229,10 @@ struct CommitTransactionRequest : TimedRequest {
 
 	TenantInfo tenantInfo;
 
+	// Set on a pipelined follower (see Transaction::setPipelineLeader) to the reply token of the commit request it was
+	// submitted behind. The follower commits only if that request commits ahead of it in the same commit batch.
+	Optional<UID> pipelineLeader;
+
 	CommitTransactionRequest() : CommitTransactionRequest(SpanContext()) {}
 	CommitTransactionRequest(SpanContext const& context) : spanContext(context), flags(0) {}
 
@@ -246,6 +250,7 @@ struct CommitTransactionRequest : TimedRequest {
 		           spanContext,
 		           tenantInfo,
 		           idempotencyId,
+		           pipelineLeader,
 		           arena);
 	}
 };
@@ -306,6 +311,7 @@ struct GetReadVersionRequest : TimedRequest {
 		PRIORITY_BATCH = 1 << 24
 	};
 	enum {
+		FLAG_BOUNDED_STALENESS = 8,
 		FLAG_USE_MIN_KNOWN_COMMITTED_VERSION = 4,
 		FLAG_USE_PROVISIONAL_PROXIES = 2,
 		FLAG_CAUSAL_READ_RISKY = 1,
@@ -328,6 +334,10 @@ struct GetReadVersionRequest : TimedRequest {
 
 	Version maxVersion; // max version in the client's version vector cache
 
+	// With FLAG_BOUNDED_STALENESS, the proxy may reply with a version that was the latest committed version at most
+	// this many seconds ago
+	double maxStaleness{ 0.0 };
+
 	GetReadVersionRequest() : transactionCount(1), flags(0), maxVersion(invalidVersion) {}
 	GetReadVersionRequest(SpanContext spanContext,
 	                      uint32_t transactionCount,
@@ -335,9 +345,10 @@ struct GetReadVersionRequest : TimedRequest {
 	                      Version maxVersion,
 	                      uint32_t flags = 0,
 	                      TransactionTagMap<uint32_t> tags = TransactionTagMap<uint32_t>(),
-	                      Optional<UID> debugID = Optional<UID>())
+	                      Optional<UID> debugID = Optional<UID>(),
+	                      double maxStaleness = 0.0)
 	  : spanContext(spanContext), transactionCount(transactionCount), flags(flags), priority(priority), tags(tags),
-	    debugID(debugID), maxVersion(maxVersion) {
+	    debugID(debugID), maxVersion(maxVersion), maxStaleness(maxStaleness) {
 		flags = flags & ~FLAG_PRIORITY_MASK;
 		switch (priority) {
 		case TransactionPriority::BATCH:
@@ -362,7 +373,7 @@ struct GetReadVersionRequest : TimedRequest {
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, transactionCount, flags, tags, debugID, reply, spanContext, maxVersion);
+		serializer(ar, transactionCount, flags, tags, debugID, reply, spanContext, maxVersion, maxStaleness);
 
 		if (ar.isDeserializing) {
 			if ((flags & PRIORITY_SYSTEM_IMMEDIATE) == PRIORITY_SYSTEM_IMMEDIATE) {
@@ -45,6 +45,7 @@
 #include "fdbclient/EventTypes.actor.h"
 #include "fdbrpc/Smoother.h"
 #include "fdbrpc/DDSketch.h"
+#include "fdbclient/MetadataVersionReadCache.h"
 
 class StorageServerInfo : public ReferencedInterface<StorageServerInterface> {
 public:
@@ -71,8 +72,13 @@ struct LocationInfo : MultiInterface<ReferencedInterface<StorageServerInterface>
 	LocationInfo(LocationInfo&&) = delete;
 	LocationInfo& operator=(const LocationInfo&) = delete;
 	LocationInfo& operator=(LocationInfo&&) = delete;
+
 	bool hasCaches = false;
 	Reference<Locations> locations() { return Reference<Locations>::addRef(this); }
+
+	// Identifies a storage team by its servers' interface objects, independent of their order
+	using Team = std::vector<const ReferencedInterface<StorageServerInterface>*>;
+	static Team getTeam(const std::vector<Reference<ReferencedInterface<StorageServerInterface>>>& v);
 };
 
 using CommitProxyInfo = ModelInterface<CommitProxyInterface>;
@@ -306,6 +312,8 @@ public:
 	                        int limit,
 	                        Reverse reverse);
 	Reference<LocationInfo> setCachedLocation(const KeyRangeRef&, const std::vector<struct StorageServerInterface>&);
+	// Clears the locations of keys, merging the cleared range with adjacent uncached ranges
+	void clearCachedLocations(const KeyRangeRef& keys);
 	void invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRef& key, Reverse isBackward = Reverse::False);
 	void invalidateCache(const Optional<KeyRef>& tenantPrefix, const KeyRangeRef& keys);
 
@@ -512,9 +520,13 @@ public:
 		Promise<GetReadVersionReply> reply;
 		TagSet tags;
 		Optional<UID> debugID;
+		double maxStaleness;
 
-		VersionRequest(SpanContext spanContext, TagSet tags = TagSet(), Optional<UID> debugID = Optional<UID>())
-		  : spanContext(spanContext), tags(tags), debugID(debugID) {}
+		VersionRequest(SpanContext spanContext,
+		               TagSet tags = TagSet(),
+		               Optional<UID> debugID = Optional<UID>(),
+		               double maxStaleness = 0.0)
+		  : spanContext(spanContext), tags(tags), debugID(debugID), maxStaleness(maxStaleness) {}
 	};
 
 	// Transaction start request batching
@@ -524,6 +536,14 @@ public:
 	};
 	std::map<uint32_t, VersionBatcher> versionBatcher;
 
+	// The most recent GRV reply, or the pending one, for each set of GRV flags. Transactions with the same flags and
+	// the SHARE_READ_VERSION option share it while it is younger than the age they allow.
+	struct SharedReadVersion {
+		Future<GetReadVersionReply> reply;
+		double requestTime = 0.0;
+	};
+	std::map<uint32_t, SharedReadVersion> sharedReadVersions;
+
 	AsyncTrigger connectionFileChangedTrigger;
 
 	// Disallow any reads at a read version lower than minAcceptableReadVersion.  This way the client does not have to
@@ -537,12 +557,24 @@ public:
 		std::vector<std::pair<std::string, BinaryWriter>> inStatusQ;
 		std::vector<std::pair<std::string, BinaryWriter>> outStatusQ;
 		Future<Void> actor;
+
+		// Sample rates of transactions carrying these tags, from CSI_TAG_SAMPLING_PROBABILITIES
+		std::map<TransactionTag, double, std::less<>> tagSamplingProbabilities;
+		double maxTagSamplingProbability = 0;
 	};
 	ClientStatusUpdater clientStatusUpdater;
 
-	// Cache of location information
+	// Cache of location information. Shards served by the same storage team share one interned LocationInfo, so the
+	// cache is a KeyRangeMap rather than a CoalescedKeyRangeMap: adjacent shards must keep their own boundaries even
+	// when they map to the same object, because storage servers reject reads that cross their shard boundaries.
+	// Shard boundaries are kept as whole keys rather than prefix compressed: the map's boundaries are the Keys of a
+	// RangeMap shared with every other KeyRangeMap user, and lookups need them as contiguous keys to compare against.
 	int locationCacheSize;
-	CoalescedKeyRangeMap<Reference<LocationInfo>> locationCache;
+	KeyRangeMap<Reference<LocationInfo>> locationCache;
+	// Interned teams. Teams that only this map still references are dropped by setCachedLocation() once the map has
+	// doubled in size since it last did, rather than by each LocationInfo when it is destroyed.
+	std::map<LocationInfo::Team, Reference<LocationInfo>> locationTeams;
+	size_t locationTeamsPruneSize = 0;
 	std::unordered_map<Endpoint, EndpointFailureInfo> failedEndpointsOnHealthyServersInfo;
 
 	std::map<UID, StorageServerInfo*> server_interf;
@@ -607,6 +639,7 @@ public:
 	Counter transactionBytesRead;
 	Counter transactionKeysRead;
 	Counter transactionMetadataVersionReads;
+	Counter transactionMetadataVersionCacheHits;
 	Counter transactionCommittedMutations;
 	Counter transactionCommittedMutationBytes;
 	Counter transactionSetMutations;
@@ -631,6 +664,8 @@ public:
 	Counter transactionsExpensiveClearCostEstCount;
 	Counter transactionGrvFullBatches;
 	Counter transactionGrvTimedOutBatches;
+	Counter transactionSharedGrvHits;
+	Counter transactionSharedGrvMisses;
 	Counter transactionCommitVersionNotFoundForSS;
 
 	// Blob Granule Read metrics. Omit from logging if not used.
@@ -680,6 +715,9 @@ public:
 
 	int snapshotRywEnabled;
 
+	// Reads under the prefixes registered with METADATA_VERSION_CACHED_PREFIX
+	MetadataVersionReadCache metadataVersionReadCache;
+
 	bool transactionTracingSample;
 	double verifyCausalReadsProp = 0.0;
 	bool blobGranuleNoMaterialize = false;
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "fdbclient/FDBTypes.h"
 #include "fdbclient/JsonBuilder.h"
 #include "fdbclient/PImpl.h"
@@ -169,7 +171,10 @@ static_assert(sizeof(IdempotencyIdRef) == 16);
 struct IdempotencyIdKVBuilder : NonCopyable {
 	IdempotencyIdKVBuilder();
 	void setCommitVersion(Version commitVersion);
-	// All calls to add must share the same high order byte of batchIndex (until the next call to buildAndClear)
+	// Defaults to the compact format, see design/idempotency_ids.md
+	void setCompactFormat(bool compactFormat);
+	// All calls to add must share the same high order byte of batchIndex (until the next call to buildAndClear), and be
+	// in increasing batchIndex order
 	void add(const IdempotencyIdRef& id, uint16_t batchIndex);
 	// Must call setCommitVersion before calling buildAndClear. After calling buildAndClear, this object is ready to
 	// start a new kv pair for the high order byte of batchIndex.
@@ -184,6 +189,10 @@ private:
 // Check if id is present in kv, and if so return the commit version and batchIndex
 Optional<CommitResult> kvContainsIdempotencyId(const KeyValueRef& kv, const IdempotencyIdRef& id);
 
+// Calls onId with each id in an idempotency id value and the low order byte of its batchIndex, in batchIndex order, and
+// returns the value's timestamp. Accepts either value format.
+int64_t decodeIdempotencyIdValue(ValueRef value, std::function<void(StringRef, uint8_t)> const& onId);
+
 // Make a range containing only the idempotency key associated with version and highOrderBatchIndex
 KeyRangeRef makeIdempotencySingleKeyRange(Arena& arena, Version version, uint8_t highOrderBatchIndex);
 
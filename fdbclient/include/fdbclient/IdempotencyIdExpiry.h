@@ -0,0 +1,84 @@
+/*
+ * IdempotencyIdExpiry.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_IDEMPOTENCY_ID_EXPIRY_H
+#define FDBCLIENT_IDEMPOTENCY_ID_EXPIRY_H
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fdbclient/CommitTransaction.h"
+#include "fdbclient/FDBTypes.h"
+
+// Used by a commit proxy to proactively clear the idempotency ids of its commit batches once their clients are done
+// with them (see ExpireIdempotencyIdRequest).
+//
+// Each commit batch owns the versions (prevVersion, commitVersion] it was given, so the idempotency id keys in that
+// version range were all written by this proxy. Once every id of a batch has expired its keys can be cleared, and a run
+// of batches whose version ranges are adjacent is cleared with a single range clear. Batches without idempotency ids
+// are tracked too while ids are in use, so that they don't split runs.
+class IdempotencyIdExpiry {
+public:
+	// Starts tracking a commit batch. idCounts has the number of idempotency ids written under each high order batch
+	// index byte, and is empty if the batch wrote none.
+	void addBatch(Version prevVersion,
+	              Version commitVersion,
+	              std::vector<std::pair<uint8_t, int16_t>> const& idCounts,
+	              double now);
+
+	// Records that a client is done with an idempotency id written by the batch at commitVersion. May be called before
+	// the batch is added.
+	void expire(Version commitVersion, uint8_t highOrderBatchIndex, double now);
+
+	// Appends a clear for each run of adjacent batches whose ids have all expired, and stops tracking those batches.
+	void takeClears(Standalone<VectorRef<MutationRef>>& clears);
+
+	// Stops tracking batches and ids first seen before the given time. Their ids are left to cleanIdempotencyIds.
+	void purge(double before);
+
+	int batchCount() const { return batches.size(); }
+
+private:
+	struct Batch {
+		Version prevVersion;
+		// Number of idempotency id keys written by the batch that still have unexpired ids
+		int unexpiredKeys;
+		bool hasIds;
+		double time;
+	};
+
+	struct KeyState {
+		int expectedCount = 0;
+		int receivedCount = 0;
+		double time = 0;
+	};
+
+	void onKeyExpired(Version commitVersion);
+
+	std::map<Version, Batch> batches;
+	// Expire counts by commit version and high order batch index byte
+	std::unordered_map<Version, std::map<uint8_t, KeyState>> keys;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * MetadataVersionReadCache.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef FDBCLIENT_METADATA_VERSION_READ_CACHE_H
+#define FDBCLIENT_METADATA_VERSION_READ_CACHE_H
+
+#include <map>
+#include <vector>
+
+#include "fdbclient/ClientBooleanParams.h"
+#include "fdbclient/FDBTypes.h"
+
+// A client-side cache of the rows under key prefixes registered with the METADATA_VERSION_CACHED_PREFIX database
+// option, for data such as configuration and schema subspaces that is read by most transactions but rarely written.
+//
+// Following design/metadata-version.md, every transaction that writes under a cached prefix must also bump the
+// metadata version key. Rows are cached together with the metadata version that came with the read version they were
+// read at, and are only served to transactions whose read version came with the same metadata version: no write under
+// the prefix can have been committed in between. Once a newer metadata version is seen, the whole cache is dropped.
+class MetadataVersionReadCache {
+public:
+	void addPrefix(KeyRef prefix);
+	bool hasPrefixes() const { return !prefixes.empty(); }
+
+	// True if keys lies entirely under one of the cached prefixes
+	bool isCached(KeyRangeRef keys) const;
+
+	// Returns the rows of keys, up to limits and in the order given by reverse, if all of keys was cached at
+	// metadataVersion. more is set if limits cut the result short.
+	Optional<RangeResult> get(KeyRangeRef keys,
+	                          Optional<Value> const& metadataVersion,
+	                          GetRangeLimits limits,
+	                          Reverse reverse) const;
+
+	// Caches rows, which must be all of the rows of keys in the order given by reverse, as read at a version with the
+	// given metadata version.
+	void insert(KeyRangeRef keys, RangeResultRef const& rows, Optional<Value> const& metadataVersion, Reverse reverse);
+
+	void clear();
+	int64_t getBytes() const { return bytes; }
+
+private:
+	struct Entry {
+		Key end;
+		RangeResult rows;
+		int64_t bytes;
+	};
+
+	std::vector<KeyRange> prefixes;
+	// Every entry was read at this metadata version
+	Optional<Value> metadataVersion;
+	// Cached ranges by begin key, which don't overlap
+	std::map<Key, Entry> entries;
+	int64_t bytes = 0;
+};
+
+#endif
@@ -1165,6 +1165,60 @@ public:
 	friend class MultiVersionTransaction;
 };
 
+// An implementation of IDatabase that spreads the transactions of one database across all client threads.
+//
+// Without it, each database is serviced by a single client thread and its network thread becomes the bottleneck
+// for clients that run many concurrent transactions against one cluster. When client_thread_transaction_sharding is
+// set, one MultiVersionDatabase is created per client thread and transactions and tenants are handed out
+// round-robin. Each thread has its own copy of the client library, and therefore its own connections, location
+// cache and read version batching; nothing mutable is shared between the shards. Options are applied to every
+// shard, while management and status operations are served by the first one.
+class ShardedMultiVersionDatabase final : public IDatabase, ThreadSafeReferenceCounted<ShardedMultiVersionDatabase> {
+public:
+	explicit ShardedMultiVersionDatabase(std::vector<Reference<IDatabase>> shards);
+
+	Reference<ITenant> openTenant(TenantNameRef tenantName) override;
+	Reference<ITransaction> createTransaction() override;
+	void setOption(FDBDatabaseOptions::Option option, Optional<StringRef> value = Optional<StringRef>()) override;
+	double getMainThreadBusyness() override;
+
+	ThreadFuture<ProtocolVersion> getServerProtocol(
+	    Optional<ProtocolVersion> expectedVersion = Optional<ProtocolVersion>()) override;
+
+	void addref() override { ThreadSafeReferenceCounted<ShardedMultiVersionDatabase>::addref(); }
+	void delref() override { ThreadSafeReferenceCounted<ShardedMultiVersionDatabase>::delref(); }
+
+	ThreadFuture<int64_t> rebootWorker(const StringRef& address, bool check, int duration) override;
+	ThreadFuture<Void> forceRecoveryWithDataLoss(const StringRef& dcid) override;
+	ThreadFuture<Void> createSnapshot(const StringRef& uid, const StringRef& snapshot_command) override;
+
+	ThreadFuture<Key> purgeBlobGranules(const KeyRangeRef& keyRange, Version purgeVersion, bool force) override;
+	ThreadFuture<Void> waitPurgeGranulesComplete(const KeyRef& purgeKey) override;
+
+	ThreadFuture<bool> blobbifyRange(const KeyRangeRef& keyRange) override;
+	ThreadFuture<bool> blobbifyRangeBlocking(const KeyRangeRef& keyRange) override;
+	ThreadFuture<bool> unblobbifyRange(const KeyRangeRef& keyRange) override;
+	ThreadFuture<Standalone<VectorRef<KeyRangeRef>>> listBlobbifiedRanges(const KeyRangeRef& keyRange,
+	                                                                      int rangeLimit) override;
+	ThreadFuture<Version> verifyBlobRange(const KeyRangeRef& keyRange, Optional<Version> version) override;
+	ThreadFuture<bool> flushBlobRange(const KeyRangeRef& keyRange, bool compact, Optional<Version> version) override;
+
+	// Shared state belongs to a single copy of the client library, so only the first shard takes part
+	ThreadFuture<DatabaseSharedState*> createSharedState() override;
+	void setSharedState(DatabaseSharedState* p) override;
+
+	ThreadFuture<Standalone<StringRef>> getClientStatus() override;
+
+	int shardCount() const { return shards.size(); }
+
+private:
+	// Returns the shard that the next transaction or tenant should be created on
+	Reference<IDatabase> const& nextShard();
+
+	const std::vector<Reference<IDatabase>> shards;
+	std::atomic<uint32_t> next{ 0 };
+};
+
 // An implementation of IClientApi that can choose between multiple different client implementations either provided
 // locally within the primary loaded fdb_c client or through any number of dynamically loaded clients.
 //
@@ -1250,6 +1304,7 @@ private:
 
 	int nextThread = 0;
 	int threadCount;
+	bool shardTransactionsAcrossThreads;
 	std::string tmpDir;
 	bool traceShareBaseNameAmongThreads;
 	std::string traceFileIdentifier;
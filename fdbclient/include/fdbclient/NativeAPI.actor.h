@@ -170,7 +170,10 @@ struct TransactionOptions {
 	bool rawAccess : 1;
 	bool bypassStorageQuota : 1;
 	bool enableReplicaConsistencyCheck : 1;
+	bool parallelRangeReads : 1;
 	int requiredReplicas;
+	double readVersionMaxStaleness; // Used with GetReadVersionRequest::FLAG_BOUNDED_STALENESS
+	double sharedReadVersionMaxAge; // Set by SHARE_READ_VERSION
 
 	TransactionPriority priority;
 
@@ -223,6 +226,10 @@ struct TransactionLogInfo : public ReferenceCounted<TransactionLogInfo>, NonCopy
 	BinaryWriter trLogWriter{ IncludeVersion() };
 	bool logsAdded{ false };
 	bool flushed{ false };
+	// The probability the transaction was sampled with, and the probability it should be kept with unless one of its
+	// tags has a sample rate of its own
+	double sampleProbability{ 1.0 };
+	double untaggedSampleProbability{ 1.0 };
 	int logLocation;
 	int maxFieldLength;
 	std::string identifier;
@@ -273,6 +280,13 @@ struct Traceable<Tenant> : std::true_type {
 	static std::string toString(const Tenant& tenant) { return printable(tenant.description()); }
 };
 
+// Where a transaction's commit request was sent, for transactions pipelined behind it. The proxy is absent if the
+// transaction finished its commit without sending a request, e.g. because it was read-only.
+struct CommitRequestSent {
+	Optional<CommitProxyInterface> proxy;
+	UID replyToken;
+};
+
 FDB_BOOLEAN_PARAM(AllowInvalidTenantID);
 FDB_BOOLEAN_PARAM(ResolveDefaultTenant);
 
@@ -306,6 +320,11 @@ struct TransactionState : ReferenceCounted<TransactionState> {
 	double startTime = 0;
 	Promise<Standalone<StringRef>> versionstampPromise;
 
+	// Fulfilled once the commit request has been sent, or with not_committed if the commit fails before that
+	Promise<CommitRequestSent> commitRequestSent;
+	// Valid if the commit is pipelined behind another transaction's, see Transaction::setPipelineLeader()
+	Future<CommitRequestSent> pipelineLeader;
+
 	Version committedVersion{ invalidVersion };
 
 	// Used to save conflicting keys if FDBTransactionOptions::REPORT_CONFLICTING_KEYS is enabled
@@ -494,6 +513,13 @@ public:
 	// Throws not_committed or commit_unknown_result errors in normal operation
 	[[nodiscard]] Future<Void> commit();
 
+	// Pipelines this transaction's commit behind the commit of leader, which need not have completed (or even started)
+	// yet. The commit request is sent to the same commit proxy right after leader's, and commits after leader and only
+	// if leader commits in the same commit batch; otherwise it fails with not_committed. Reads don't observe leader's
+	// writes, so reading a key that leader writes makes this transaction conflict. Pipelined transactions can't write
+	// to the system key space. Cleared by reset() and onError().
+	void setPipelineLeader(Transaction const& leader);
+
 	void setOption(FDBTransactionOptions::Option option, Optional<StringRef> value = Optional<StringRef>());
 
 	// May be called only after commit() returns success
@@ -146,6 +146,8 @@ public:
 	void addWriteConflictRange(KeyRangeRef const& keys) override;
 
 	[[nodiscard]] Future<Void> commit() override;
+	// See Transaction::setPipelineLeader()
+	void setPipelineLeader(ReadYourWritesTransaction const& leader) { tr.setPipelineLeader(leader.tr); }
 	Version getCommittedVersion() const override { return tr.getCommittedVersion(); }
 	VersionVector getVersionVector() const override { return tr.getVersionVector(); }
 	SpanContext getSpanContext() const override { return tr.getSpanContext(); }
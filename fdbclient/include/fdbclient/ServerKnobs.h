@@ -623,6 +623,17 @@ public:
 	int COMMIT_TRANSACTION_BATCH_BYTES_MAX;
 	double COMMIT_TRANSACTION_BATCH_BYTES_SCALE_BASE;
 	double COMMIT_TRANSACTION_BATCH_BYTES_SCALE_POWER;
+	bool COMMIT_BATCH_ADAPTIVE_CONTROL; // Choose batch interval and size to meet COMMIT_BATCH_TARGET_P99_LATENCY
+	double COMMIT_BATCH_TARGET_P99_LATENCY;
+	double COMMIT_BATCH_CONTROL_WINDOW;
+	int COMMIT_BATCH_CONTROL_MIN_SAMPLES;
+	int COMMIT_BATCH_CONTROL_HISTORY;
+	double COMMIT_BATCH_QUEUEING_TOLERANCE;
+	double COMMIT_BATCH_INTERVAL_GAIN;
+	double COMMIT_BATCH_MIN_BYTES_FRACTION;
+	double COMMIT_BATCH_SHRINK_MAX_BATCHES_IN_FLIGHT;
+	double COMMIT_BATCH_CONTROL_DEAD_BAND;
+	int COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS;
 	int64_t COMMIT_BATCHES_MEM_BYTES_HARD_LIMIT;
 	double COMMIT_BATCHES_MEM_FRACTION_OF_TOTAL;
 	double COMMIT_BATCHES_MEM_TO_TOTAL_MEM_SCALE_FACTOR;
@@ -647,6 +658,8 @@ public:
 	double REPORT_TRANSACTION_COST_ESTIMATION_DELAY;
 	bool PROXY_REJECT_BATCH_QUEUED_TOO_LONG;
 	bool PROXY_USE_RESOLVER_PRIVATE_MUTATIONS;
+	int PROXY_ENCRYPTION_THREADS; // Threads encrypting mutations off the network thread; 0 encrypts inline
+	bool PROXY_USE_FLAT_TAG_INDEX; // Look up mutation tags in a StorageTagIndex rebuilt whenever keyInfo changes
 	bool BURSTINESS_METRICS_ENABLED;
 	// Interval on which to emit burstiness metrics on the commit proxy (in
 	// seconds).
@@ -661,6 +674,11 @@ public:
 	double GLOBAL_CONFIG_REFRESH_INTERVAL;
 	double GLOBAL_CONFIG_REFRESH_TIMEOUT;
 
+	// GRV proxy read version lease
+	double GRV_READ_VERSION_LEASE_MAX_STALENESS; // Upper bound on the staleness allowed by READ_VERSION_MAX_STALENESS
+	double GRV_READ_VERSION_LEASE_REFRESH_INTERVAL;
+	double GRV_READ_VERSION_LEASE_IDLE_TIMEOUT;
+
 	// Master Server
 	double COMMIT_SLEEP_TIME;
 	double MIN_BALANCE_TIME;
@@ -1364,6 +1382,8 @@ public:
 
 	// Idempotency ids
 	double IDEMPOTENCY_ID_IN_MEMORY_LIFETIME;
+	bool IDEMPOTENCY_ID_COMPACT_FORMAT;
+	double IDEMPOTENCY_ID_CLEAR_INTERVAL;
 	double IDEMPOTENCY_IDS_CLEANER_POLLING_INTERVAL;
 	double IDEMPOTENCY_IDS_MIN_AGE_SECONDS;
 
@@ -0,0 +1,101 @@
+/*
+ * StorageTagIndex.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_STORAGE_TAG_INDEX_H
+#define FDBCLIENT_STORAGE_TAG_INDEX_H
+#pragma once
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/KeyRangeMap.h"
+#include "fdbclient/StorageServerInterface.h"
+
+// A flat copy of the shard boundaries and storage server tags of a KeyRangeMap<ServerCacheInfo>, as kept by commit
+// proxies in keyInfo. Shard begin keys are stored contiguously and searched in Eytzinger (BFS) order on an 8-byte key
+// prefix, falling back to a full key comparison only when prefixes tie, which keeps the lookup within a few cache
+// lines even with hundreds of thousands of shards. Shards served by the same set of tags share one tag vector.
+//
+// The index does not track changes to the map it was built from. When the map changes within a range, the owner calls
+// update(), which records the new shards of that range in a small overlay that is consulted before the flat copy; the
+// flat copy is rebuilt once the overlay grows past maxOverlayBoundaries. Changes that aren't confined to a range (such
+// as a storage server's tag changing) call invalidate() instead, and rebuild() before the next lookup.
+class StorageTagIndex {
+public:
+	static constexpr int maxOverlayBoundaries = 1024;
+
+	bool isValid() const { return valid; }
+	void invalidate() { valid = false; }
+
+	// Rebuilds the index from keyInfo, populating the tags of any range that does not have them yet.
+	void rebuild(KeyRangeMap<ServerCacheInfo>& keyInfo);
+
+	// Brings a valid index up to date with keyInfo, whose boundaries and tags have changed only within range.
+	void update(KeyRangeMap<ServerCacheInfo>& keyInfo, KeyRangeRef range);
+
+	// Returns the tags of the shard containing key.
+	const std::vector<Tag>& tagsForKey(KeyRef key) const {
+		if (!overlay.empty()) {
+			int team = std::prev(overlay.upper_bound(key))->second;
+			if (team >= 0) {
+				return teams[team];
+			}
+		}
+		return teams[shardTeams[shardContaining(key)]];
+	}
+
+	// Returns the tags of the shard containing range if it lies in a single shard. Otherwise adds the tags of every
+	// shard intersecting range to tags and returns nullptr. (A range that the overlay splits may also be answered
+	// through tags, even if it lies in one shard of the map.)
+	const std::vector<Tag>* tagsForRange(KeyRangeRef range, std::set<Tag>& tags) const;
+
+	int shardCount() const { return shardBegins.size(); }
+	int teamCount() const { return teams.size(); }
+	int overlayBoundaries() const { return overlay.size(); }
+
+private:
+	static uint64_t keyPrefix(KeyRef key);
+
+	// Returns the position in shard order of the flat copy's shard containing key.
+	int shardContaining(KeyRef key) const;
+	const std::vector<Tag>* flatTagsForRange(KeyRangeRef range, std::set<Tag>& tags) const;
+	int internTeam(std::vector<Tag> const& tags);
+
+	bool valid = false;
+	Arena arena;
+	// Shard begin keys, in key order
+	std::vector<KeyRef> shardBegins;
+	// Index into teams for each shard, in key order
+	std::vector<int> shardTeams;
+	// Distinct tag sets. A deque, so that the tags returned by lookups stay put while update() adds to it.
+	std::deque<std::vector<Tag>> teams;
+	std::map<std::vector<Tag>, int> teamIndex;
+	// 1-based Eytzinger layout of the shard begin key prefixes, and the shard each slot refers to
+	std::vector<uint64_t> eytzingerPrefixes;
+	std::vector<int> eytzingerShards;
+	// Empty, or boundaries covering all keys from the empty key on: from each boundary to the next, the index into
+	// teams of the tags there, or -1 where the flat copy is still current
+	std::map<Key, int, std::less<>> overlay;
+};
+
+#endif
@@ -241,9 +241,35 @@ public:
 	void debugPrint(std::string const& message) override;
 
 private:
+	// Mutations and conflict ranges accepted from the calling threads but not yet handed to the network thread. They
+	// are sent together in a single onMainThreadVoid call once the batch is full and before any other operation on the
+	// transaction is submitted, so the network thread still sees the calls in the order they were made. This saves a
+	// promise, an actor and a network thread wakeup per mutation.
+	struct MutationBatch {
+		enum class Type : uint8_t { Set, ClearKey, ClearRange, AtomicOp, ReadConflictRange, WriteConflictRange };
+		struct Op {
+			Type type;
+			uint32_t operationType;
+			KeyRef key; // The begin key for ranges
+			ValueRef value; // The end key for ranges
+		};
+
+		ThreadSpinLock lock;
+		Standalone<VectorRef<Op>> ops;
+		int bytes = 0;
+	};
+
+	// Buffers a mutation, handing the batch to the network thread if it is full
+	void addMutation(MutationBatch::Type type, KeyRef key, ValueRef value, uint32_t operationType = 0);
+	// Hands any buffered mutations to the network thread. Must be called before submitting any other operation.
+	void flushMutations();
+	void flushMutationsLocked();
+
 	ISingleThreadTransaction* tr;
 	const Optional<TenantName> tenantName;
 	std::shared_ptr<std::atomic_bool> initialized;
+	// Null if mutation batching is disabled
+	std::unique_ptr<MutationBatch> mutationBatch;
 };
 
 // An implementation of IClientApi that serializes operations onto the network thread and interacts with the lower-level
@@ -51,6 +51,10 @@ struct Tuple {
 	static std::string tupleToString(Tuple const& tuple);
 	static Tuple unpackUserType(StringRef const& str, bool exclude_incomplete = false);
 
+	// Returns the encoded bytes of the element at index of the Tuple encoded str, without decoding or copying the
+	// elements before it. The result can be decoded with unpack().
+	static StringRef elementRawString(StringRef const& str, size_t index, bool include_user_type = false);
+
 	Tuple& append(Tuple const& tuple);
 
 	// the str needs to be a Tuple encoded string.
@@ -112,6 +116,7 @@ struct Tuple {
 	template <class... Types>
 	static Tuple makeTuple(Types&&... args) {
 		Tuple t;
+		t.reserve(sizeof...(Types));
 
 		// Use a fold expression to append each argument using the << operator.
 		// https://en.cppreference.com/w/cpp/language/fold
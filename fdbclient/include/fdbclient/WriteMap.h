@@ -125,18 +125,22 @@ private:
 	typedef PTreeImpl::PTreeFinger<WriteMapEntry> PTreeFingerT;
 	typedef Reference<PTreeT> Tree;
 
+	// Most transactions write only a handful of keys, for which a sorted array is much cheaper to build and search
+	// than the tree. Iterators share the array with the map, so it is copied before being written while an iterator
+	// (other than the scratch iterator) still refers to it.
+	struct FlatWrites : ReferenceCounted<FlatWrites>, FastAllocated<FlatWrites> {
+		std::vector<WriteMapEntry> entries;
+	};
+
 public:
-	explicit WriteMap(Arena* arena) : arena(arena), writeMapEmpty(true), ver(-1), scratch_iterator(this) {
-		PTreeImpl::insert(
-		    writes, ver, WriteMapEntry(allKeys.begin, OperationStack(), false, false, false, false, false));
-		PTreeImpl::insert(writes, ver, WriteMapEntry(allKeys.end, OperationStack(), false, false, false, false, false));
-		PTreeImpl::insert(
-		    writes, ver, WriteMapEntry(afterAllKeys, OperationStack(), false, false, false, false, false));
-	}
+	// A map starts out as a sorted array and moves to the tree once it holds more than flatEntryLimit entries
+	// (CLIENT_KNOBS->WRITE_MAP_FLAT_ENTRY_LIMIT by default). The map always holds at least three entries.
+	explicit WriteMap(Arena* arena);
+	WriteMap(Arena* arena, int flatEntryLimit);
 
 	WriteMap(WriteMap&& r) noexcept
-	  : arena(r.arena), writeMapEmpty(r.writeMapEmpty), writes(std::move(r.writes)), ver(r.ver),
-	    scratch_iterator(std::move(r.scratch_iterator)) {}
+	  : arena(r.arena), writeMapEmpty(r.writeMapEmpty), writes(std::move(r.writes)), flat(std::move(r.flat)),
+	    flatEntryLimit(r.flatEntryLimit), ver(r.ver), scratch_iterator(std::move(r.scratch_iterator)) {}
 
 	WriteMap& operator=(WriteMap&& r) noexcept;
 
@@ -155,7 +159,9 @@ public:
 		// regardless of the snapshot value) Every key will belong to exactly one segment.  The first segment begins at
 		// "" and the last segment ends at \xff\xff.
 
-		explicit iterator(WriteMap* map) : tree(map->writes), at(map->ver), offset(false) { ++map->ver; }
+		explicit iterator(WriteMap* map) : tree(map->writes), flat(map->flat), at(map->ver), offset(false) {
+			++map->ver;
+		}
 		// Creates an iterator which is conceptually before the beginning of map (you may essentially only call skip()
 		// or ++ on it) This iterator also represents a snapshot (will be unaffected by future writes)
 
@@ -184,23 +190,37 @@ public:
 		iterator& operator++();
 		iterator& operator--();
 		bool operator==(const iterator& r) const {
+			if (flat) {
+				return offset == r.offset && flat == r.flat && flatIndex == r.flatIndex;
+			}
 			return offset == r.offset && beginLen == r.beginLen && finger[beginLen - 1] == r.finger[beginLen - 1];
 		}
 		void skip(KeyRef key);
 
 	private:
 		friend class WriteMap;
-		void reset(Tree const& tree, Version ver);
+		void reset(WriteMap const& map);
+		// Drops the iterator's reference to the map's entries, so that they can be modified in place
+		void release() {
+			tree.clear();
+			flat.clear();
+		}
 
-		WriteMapEntry const& entry() const { return finger[beginLen - 1]->data; }
-		WriteMapEntry const& nextEntry() const { return finger[endLen - 1]->data; }
+		WriteMapEntry const& entry() const { return flat ? flat->entries[flatIndex] : finger[beginLen - 1]->data; }
+		WriteMapEntry const& nextEntry() const {
+			return flat ? flat->entries[flatIndex + 1] : finger[endLen - 1]->data;
+		}
+		void next();
+		void previous();
 
 		bool keyAtBegin() { return !offset || !entry().stack.size(); }
 
 		Tree tree;
+		Reference<FlatWrites> flat; // If set, the entries are in the sorted array rather than the tree
 		Version at;
 		int beginLen, endLen;
 		PTreeFingerT finger;
+		int flatIndex; // Index of entry() in flat
 		bool offset; // false-> the operation stack at entry(); true-> the following cleared or unmodified range
 	};
 
@@ -215,6 +235,8 @@ private:
 	Arena* arena;
 	bool writeMapEmpty;
 	Tree writes;
+	Reference<FlatWrites> flat; // Holds the entries instead of writes until there are more than flatEntryLimit of them
+	int flatEntryLimit;
 	// an internal version number for the tree - no connection to database versions!  Currently this is
 	// incremented after reads, so that consecutive writes have the same version and those separated by
 	// reads have different versions.
@@ -223,6 +245,13 @@ private:
 
 	void dump();
 
+	// Storage of the entries, in whichever of the sorted array or the tree currently holds them. insertEntry replaces
+	// an entry with the same key, and removeEntries removes the entries with begin <= key < end.
+	void insertEntry(WriteMapEntry&& entry);
+	void removeEntry(ExtStringRef const& key);
+	void removeEntries(ExtStringRef const& begin, ExtStringRef const& end);
+	std::vector<WriteMapEntry>& mutableFlatEntries();
+
 	// SOMEDAY: clearNoConflict replaces cleared sets with two map entries for everyone one item cleared
 	void clearNoConflict(KeyRangeRef keys);
 };
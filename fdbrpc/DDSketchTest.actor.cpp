@@ -4,6 +4,7 @@
 #include "flow/UnitTest.h"
 #include <limits>
 #include <random>
+#include <thread>
 #include "flow/actorcompiler.h" // has to be last include
 void forceLinkDDSketchTests() {}
 
@@ -60,3 +61,38 @@ TEST_CASE("/fdbrpc/ddsketch/correctness") {
 	ASSERT(p999 > 0 && p999 != std::numeric_limits<double>::infinity());
 	return Void{};
 }
+
+TEST_CASE("/fdbrpc/ddsketch/sharded") {
+	ShardedDDSketch<double> sharded;
+	DDSketch<double> expected;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&sharded, t] {
+			for (int i = 0; i < 10000; i++) {
+				sharded.addSample((t * 10000 + i) * 0.001);
+			}
+		});
+	}
+	for (int t = 0; t < 4; t++) {
+		for (int i = 0; i < 10000; i++) {
+			expected.addSample((t * 10000 + i) * 0.001);
+		}
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	DDSketch<double> collected;
+	sharded.collectInto(collected);
+	ASSERT_EQ(collected.getPopulationSize(), expected.getPopulationSize());
+	ASSERT(collected.getSamples() == expected.getSamples());
+	ASSERT_EQ(collected.min(), expected.min());
+	ASSERT_EQ(collected.max(), expected.max());
+
+	// Samples are only collected once
+	sharded.addSample(1.0);
+	DDSketch<double> next;
+	sharded.collectInto(next);
+	ASSERT_EQ(next.getPopulationSize(), 1);
+	return Void();
+}
@@ -24,9 +24,11 @@
 #include "flow/OTELMetrics.h"
 #include "flow/TDMetric.actor.h"
 #include "flow/Trace.h"
+#include "flow/UnitTest.h"
 #include "flow/flow.h"
 #include "flow/network.h"
 #include <string>
+#include <thread>
 #include "flow/actorcompiler.h" // has to be last include
 
 Counter::Counter(std::string const& name, CounterCollection& collection, bool skipTraceOnSilentInterval)
@@ -89,6 +91,29 @@ void Counter::clear() {
 	metric = 0;
 }
 
+ShardedCounter::ShardedCounter(std::string const& name,
+                               CounterCollection& collection,
+                               bool skipTraceOnSilentInterval)
+  : name(name), interval_start(0), interval_start_value(0), skip_trace_on_silent_interval(skipTraceOnSilentInterval) {
+	collection.addCounter(this);
+}
+
+ShardedCounter::Value ShardedCounter::getValue() const {
+	Value value = 0;
+	shards.forEach([&value](Shard const& shard) { value += shard.value.load(std::memory_order_relaxed); });
+	return value;
+}
+
+double ShardedCounter::getRate() const {
+	double elapsed = now() - interval_start;
+	return elapsed > 0 ? getIntervalDelta() / elapsed : 0;
+}
+
+void ShardedCounter::resetInterval() {
+	interval_start_value = getValue();
+	interval_start = now();
+}
+
 void CounterCollection::logToTraceEvent(TraceEvent& te) {
 	NetworkAddress addr = g_network->getLocalAddress();
 	for (ICounter* c : counters) {
@@ -223,7 +248,7 @@ LatencySample::LatencySample(std::string name,
                              double accuracy,
                              bool skipTraceOnSilentInterval)
   : name(name), IMetric(knobToMetricModel(FLOW_KNOBS->METRICS_DATA_MODEL)), id(id), sampleEmit(now()), sketch(accuracy),
-    latencySampleEventHolder(makeReference<EventCacheHolder>(id.toString() + "/" + name)),
+    threadSketch(accuracy), latencySampleEventHolder(makeReference<EventCacheHolder>(id.toString() + "/" + name)),
     skipTraceOnSilentInterval(skipTraceOnSilentInterval) {
 	logger = recurring([this]() { logSample(); }, loggingInterval);
 	p50id = deterministicRandom()->randomUniqueID();
@@ -237,7 +262,12 @@ void LatencySample::addMeasurement(double measurement) {
 	sketch.addSample(measurement);
 }
 
+void LatencySample::addMeasurementOnAnyThread(double measurement) {
+	threadSketch.addSample(measurement);
+}
+
 void LatencySample::logSample() {
+	threadSketch.collectInto(sketch);
 	if (skipTraceOnSilentInterval && sketch.getPopulationSize() == 0) {
 		return;
 	}
@@ -312,3 +342,33 @@ void LatencySample::logSample() {
 	sketch.clear();
 	sampleEmit = now();
 }
+
+TEST_CASE("/fdbrpc/Stats/ShardedCounter") {
+	CounterCollection cc("ShardedCounterTest");
+	ShardedCounter counter("Adds", cc);
+	counter.resetInterval();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&counter] {
+			for (int i = 0; i < 10000; i++) {
+				++counter;
+			}
+		});
+	}
+	counter += 5;
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQ(counter.getValue(), 40005);
+	ASSERT_EQ(counter.getIntervalDelta(), 40005);
+
+	counter.resetInterval();
+	ASSERT_EQ(counter.getIntervalDelta(), 0);
+	counter += 2;
+	ASSERT_EQ(counter.getValue(), 40007);
+	ASSERT_EQ(counter.getIntervalDelta(), 2);
+
+	// Logged as "rate roughness value", like Counter
+	ASSERT(Traceable<ICounter*>::toString(&counter).ends_with(" -1 40007"));
+	return Void();
+}
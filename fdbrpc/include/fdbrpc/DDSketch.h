@@ -30,6 +30,7 @@
 #include <cassert>
 #include <cmath>
 #include "flow/Error.h"
+#include "flow/ThreadShards.h"
 #include "flow/UnitTest.h"
 
 // A namespace for fast log() computation.
@@ -299,4 +300,40 @@ private:
 	constexpr static double gamma = 1.189207115;
 };
 
+// A DDSketch that any thread can add samples to. Each thread adds to a sketch of its own, behind a lock that only
+// collectInto() contends for.
+template <class T>
+class ShardedDDSketch : NonCopyable {
+public:
+	explicit ShardedDDSketch(double errorGuarantee = 0.005) : errorGuarantee(errorGuarantee) {}
+
+	void addSample(T sample) {
+		Shard& shard = shards.local(errorGuarantee);
+		ThreadSpinLockHolder holder(shard.lock);
+		shard.sketch.addSample(sample);
+	}
+
+	// Moves the samples added since the last call into sketch, which must have the same error guarantee
+	void collectInto(DDSketch<T>& sketch) {
+		shards.forEach([&sketch](Shard& shard) {
+			ThreadSpinLockHolder holder(shard.lock);
+			if (shard.sketch.getPopulationSize()) {
+				sketch.mergeWith(shard.sketch);
+				shard.sketch.clear();
+			}
+		});
+	}
+
+private:
+	struct Shard {
+		ThreadSpinLock lock;
+		DDSketch<T> sketch;
+
+		explicit Shard(double errorGuarantee) : sketch(errorGuarantee) {}
+	};
+
+	double errorGuarantee;
+	ThreadShards<Shard> shards;
+};
+
 #endif
@@ -45,6 +45,7 @@ MyCounters() : foo("foo", cc), bar("bar", cc), baz("baz", cc) {}
 #include <cstddef>
 #include "flow/flow.h"
 #include "flow/TDMetric.actor.h"
+#include "flow/ThreadShards.h"
 #include "fdbrpc/DDSketch.h"
 
 struct ICounter : public IMetric {
@@ -163,6 +164,49 @@ struct Traceable<Counter> : std::true_type {
 	}
 };
 
+// A counter that any thread can add to, such as a storage engine's or a TLS handshake thread. Each thread adds to a
+// shard of its own, and the shards are summed when the counter is logged. It is logged in the same "rate roughness
+// value" format as Counter, but its roughness would need the time of each increment, so it is always reported as -1,
+// the value Counter reports when it has none.
+struct ShardedCounter final : public ICounter, NonCopyable {
+public:
+	typedef int64_t Value;
+
+	ShardedCounter(std::string const& name, CounterCollection& collection, bool skipTraceOnSilentInterval = false);
+
+	void operator+=(Value delta) {
+		std::atomic<Value>& value = shards.local().value;
+		value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+	}
+	void operator++() { *this += 1; }
+	void resetInterval() override;
+
+	std::string const& getName() const override { return name; }
+
+	Value getIntervalDelta() const { return getValue() - interval_start_value; }
+	Value getValue() const override;
+
+	double getRate() const override;
+
+	bool hasRate() const override { return true; }
+	bool hasRoughness() const override { return true; }
+	double getRoughness() const override { return -1; }
+
+	bool suppressTrace() const override { return skip_trace_on_silent_interval && getIntervalDelta() == 0; }
+
+private:
+	struct Shard {
+		// Only stored to by the thread adding to it
+		std::atomic<Value> value{ 0 };
+	};
+
+	std::string name;
+	ThreadShards<Shard> shards;
+	double interval_start;
+	Value interval_start_value;
+	bool skip_trace_on_silent_interval;
+};
+
 template <class F>
 struct SpecialCounter final : ICounter, FastAllocated<SpecialCounter<F>>, NonCopyable {
 	SpecialCounter(CounterCollection& collection, std::string const& name, F&& f) : name(name), f(f) {
@@ -237,6 +281,8 @@ public:
 	              double accuracy,
 	              bool skipTraceOnSilentInterval = false);
 	void addMeasurement(double measurement);
+	// Like addMeasurement(), but may be called from any thread
+	void addMeasurementOnAnyThread(double measurement);
 
 private:
 	std::string name;
@@ -255,6 +301,7 @@ private:
 	double sampleEmit;
 
 	DDSketch<double> sketch;
+	ShardedDDSketch<double> threadSketch;
 	Future<Void> logger;
 	bool skipTraceOnSilentInterval;
 
@@ -2625,6 +2625,9 @@ public:
 		explicit PromiseTask(ProcessInfo* machine, swift::Job* swiftJob) : machine(machine), swiftJob(swiftJob) {}
 		PromiseTask(ProcessInfo* machine, Promise<Void>&& promise)
 		  : machine(machine), promise(std::move(promise)), swiftJob(nullptr) {}
+
+		// A delay nobody waits on anymore
+		bool isCancelled() const { return !swiftJob && promise.getFutureReferenceCount() == 0; }
 	};
 
 	void execTask(struct PromiseTask& t) {
@@ -23,6 +23,7 @@
 #include "fdbclient/MetaclusterRegistration.h"
 #include "fdbclient/MutationList.h"
 #include "fdbclient/Notified.h"
+#include "fdbclient/StorageTagIndex.h"
 #include "fdbclient/SystemData.h"
 #include "fdbclient/Tenant.h"
 #include "fdbserver/AccumulativeChecksumUtil.h"
@@ -82,7 +83,7 @@ public:
 	    txnStateStore(proxyCommitData_.txnStateStore), toCommit(toCommit_), cipherKeys(cipherKeys_),
 	    encryptMode(encryptMode), confChange(confChange_), logSystem(logSystem_), version(version),
 	    popVersion(popVersion_), vecBackupKeys(&proxyCommitData_.vecBackupKeys), keyInfo(&proxyCommitData_.keyInfo),
-	    cacheInfo(&proxyCommitData_.cacheInfo),
+	    keyInfoTagIndex(&proxyCommitData_.keyInfoTagIndex), cacheInfo(&proxyCommitData_.cacheInfo),
 	    uid_applyMutationsData(proxyCommitData_.firstProxy ? &proxyCommitData_.uid_applyMutationsData : nullptr),
 	    commit(proxyCommitData_.commit), cx(proxyCommitData_.cx), committedVersion(&proxyCommitData_.committedVersion),
 	    storageCache(&proxyCommitData_.storageCache), tag_popped(&proxyCommitData_.tag_popped),
@@ -150,6 +151,7 @@ private:
 	Version popVersion = 0;
 	KeyRangeMap<std::set<Key>>* vecBackupKeys = nullptr;
 	KeyRangeMap<ServerCacheInfo>* keyInfo = nullptr;
+	StorageTagIndex* keyInfoTagIndex = nullptr; // Must be updated or invalidated whenever keyInfo changes
 	KeyRangeMap<bool>* cacheInfo = nullptr;
 	std::map<Key, ApplyMutationsData>* uid_applyMutationsData = nullptr;
 	PublicRequestStream<CommitTransactionRequest> commit = PublicRequestStream<CommitTransactionRequest>();
@@ -211,6 +213,19 @@ private:
 		}
 	}
 
+	void invalidateKeyInfoTagIndex() {
+		if (keyInfoTagIndex) {
+			keyInfoTagIndex->invalidate();
+		}
+	}
+
+	// For changes to keyInfo confined to range, which the index can patch instead of being rebuilt
+	void updateKeyInfoTagIndex(KeyRangeRef range) {
+		if (keyInfoTagIndex) {
+			keyInfoTagIndex->update(*keyInfo, range);
+		}
+	}
+
 	void checkSetKeyServersPrefix(MutationRef m) {
 		if (!m.param1.startsWith(keyServersPrefix)) {
 			return;
@@ -257,6 +272,7 @@ private:
 		}
 		uniquify(info.tags);
 		keyInfo->insert(insertRange, info);
+		updateKeyInfoTagIndex(insertRange);
 		if (toCommit && SERVER_KNOBS->ENABLE_VERSION_VECTOR_TLOG_UNICAST) {
 			toCommit->setShardChanged();
 		}
@@ -338,6 +354,7 @@ private:
 					for (auto& it : keyInfo->ranges()) {
 						it.value().tags.clear();
 					}
+					invalidateKeyInfoTagIndex();
 				}
 			}
 		}
@@ -927,6 +944,7 @@ private:
 			                clearRange.begin == StringRef()
 			                    ? ServerCacheInfo()
 			                    : keyInfo->rangeContainingKeyBefore(clearRange.begin).value());
+			updateKeyInfoTagIndex(clearRange);
 			if (toCommit && SERVER_KNOBS->ENABLE_VERSION_VECTOR_TLOG_UNICAST) {
 				toCommit->setShardChanged();
 			}
@@ -0,0 +1,239 @@
+/*
+ * CommitBatchController.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbserver/CommitBatchController.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "fdbserver/Knobs.h"
+#include "flow/UnitTest.h"
+
+CommitBatchController::Stats& CommitBatchController::processStats() {
+	static Stats stats;
+	return stats;
+}
+
+CommitBatchController::CommitBatchController(double initialInterval) : batchInterval(initialInterval) {}
+
+bool CommitBatchController::update(double now) {
+	if (windowStart == 0.0) {
+		windowStart = now;
+	}
+	if (now - windowStart < SERVER_KNOBS->COMMIT_BATCH_CONTROL_WINDOW ||
+	    commitLatency.getPopulationSize() < static_cast<uint64_t>(SERVER_KNOBS->COMMIT_BATCH_CONTROL_MIN_SAMPLES) ||
+	    resolutionLatency.getPopulationSize() == 0 || loggingLatency.getPopulationSize() == 0) {
+		return false;
+	}
+
+	const double target = SERVER_KNOBS->COMMIT_BATCH_TARGET_P99_LATENCY;
+	const double gain = SERVER_KNOBS->COMMIT_BATCH_INTERVAL_GAIN;
+	const double deadBand = SERVER_KNOBS->COMMIT_BATCH_CONTROL_DEAD_BAND;
+	lastCommitP99 = commitLatency.percentile(0.99);
+	lastPipelineMedian = resolutionLatency.median() + loggingLatency.median();
+	lastBatchesInFlight = batchesInFlightSamples ? double(batchesInFlightSum) / batchesInFlightSamples : 0.0;
+	const double pipelineP99 = resolutionLatency.percentile(0.99) + loggingLatency.percentile(0.99);
+
+	pipelineHistory.push_back(lastPipelineMedian);
+	while (pipelineHistory.size() > std::max<size_t>(1, SERVER_KNOBS->COMMIT_BATCH_CONTROL_HISTORY)) {
+		pipelineHistory.pop_front();
+	}
+	lastPipelineBaseline = *std::min_element(pipelineHistory.begin(), pipelineHistory.end());
+	const bool queueing =
+	    lastPipelineMedian > lastPipelineBaseline * (1.0 + SERVER_KNOBS->COMMIT_BATCH_QUEUEING_TOLERANCE);
+	const bool loaded = queueing || lastBatchesInFlight > SERVER_KNOBS->COMMIT_BATCH_SHRINK_MAX_BATCHES_IN_FLIGHT;
+
+	enum class Move { Hold, Cut, Grow, Decay } move = Move::Hold;
+	if (lastCommitP99 > target * (1.0 + deadBand)) {
+		move = loaded ? Move::Hold : Move::Cut;
+	} else if (queueing && lastCommitP99 <= target) {
+		move = Move::Grow;
+	} else if (lastCommitP99 < target * (1.0 - deadBand)) {
+		move = Move::Decay;
+	}
+	if (move == Move::Decay) {
+		sizeFraction = std::min(1.0, sizeFraction + SERVER_KNOBS->COMMIT_BATCH_MIN_BYTES_FRACTION);
+		// Decaying below the interval that last ended queueing would only bring the queueing back
+		if (batchInterval <= intervalFloor) {
+			move = Move::Hold;
+		}
+	}
+
+	const int direction = move == Move::Grow ? 1 : move == Move::Hold ? 0 : -1;
+	if (direction != 0 && direction == -lastDirection) {
+		if (++opposingWindows < SERVER_KNOBS->COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS) {
+			move = Move::Hold;
+		} else {
+			processStats().reversals++;
+		}
+	} else {
+		opposingWindows = 0;
+	}
+
+	if (move == Move::Cut) {
+		batchInterval /= gain;
+		sizeFraction = std::max(SERVER_KNOBS->COMMIT_BATCH_MIN_BYTES_FRACTION, sizeFraction / 2);
+		intervalFloor = 0.0;
+	} else if (move == Move::Grow) {
+		batchInterval *= gain;
+		intervalFloor = batchInterval;
+		windowsAtFloor = 0;
+	} else if (move == Move::Decay) {
+		batchInterval = std::max(intervalFloor, batchInterval / std::sqrt(gain));
+	}
+	if (move != Move::Hold) {
+		lastDirection = direction;
+		opposingWindows = 0;
+	}
+	// The load may since have dropped, so the floor is lowered a step after it has held the interval for as long as
+	// the pipeline baseline is remembered
+	if (batchInterval <= intervalFloor && ++windowsAtFloor >= SERVER_KNOBS->COMMIT_BATCH_CONTROL_HISTORY) {
+		intervalFloor /= std::sqrt(gain);
+		windowsAtFloor = 0;
+	}
+	const double maxInterval = std::max(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
+	                                    std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
+	                                             target - pipelineP99));
+	batchInterval = std::clamp(batchInterval, SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN, maxInterval);
+
+	commitLatency.clear();
+	resolutionLatency.clear();
+	loggingLatency.clear();
+	batchesInFlightSum = 0;
+	batchesInFlightSamples = 0;
+	windowStart = now;
+	processStats().windows++;
+	return true;
+}
+
+int CommitBatchController::getBatchBytesLimit(int desiredBytes) const {
+	return std::max(1, static_cast<int>(desiredBytes * sizeFraction));
+}
+
+namespace {
+
+// Feeds one control window of samples and closes it
+bool runWindow(CommitBatchController& controller,
+               double& now,
+               double commitLatency,
+               double pipelineLatency,
+               int batchesInFlight = 0) {
+	for (int i = 0; i < SERVER_KNOBS->COMMIT_BATCH_CONTROL_MIN_SAMPLES; i++) {
+		controller.addCommitLatency(commitLatency);
+		controller.addResolutionLatency(pipelineLatency / 2);
+		controller.addLoggingLatency(pipelineLatency / 2);
+		controller.addBatchesInFlight(batchesInFlight);
+	}
+	now += SERVER_KNOBS->COMMIT_BATCH_CONTROL_WINDOW;
+	return controller.update(now);
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/CommitBatchController/Simple") {
+	const double minInterval = SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN;
+	const double target = SERVER_KNOBS->COMMIT_BATCH_TARGET_P99_LATENCY;
+	const double pipeline = target / 10;
+	CommitBatchController controller(minInterval);
+	double now = 1.0;
+	ASSERT(!controller.update(now));
+
+	// An unloaded pipeline well within the target keeps the interval at the minimum
+	ASSERT(runWindow(controller, now, target / 2, pipeline));
+	ASSERT_EQ(controller.getBatchInterval(), minInterval);
+	ASSERT_EQ(controller.getBatchBytesLimit(1000), 1000);
+
+	// Resolver or TLog queueing grows the interval, but never past the latency left for batching
+	double interval = controller.getBatchInterval();
+	for (int i = 0; i < SERVER_KNOBS->COMMIT_BATCH_CONTROL_HISTORY / 2; i++) {
+		ASSERT(runWindow(controller, now, target / 2, pipeline * 2));
+		ASSERT_GE(controller.getBatchInterval(), interval);
+		ASSERT_LE(controller.getBatchInterval(),
+		          std::max(minInterval,
+		                   std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX, target - pipeline)));
+		interval = controller.getBatchInterval();
+	}
+	ASSERT_LT(controller.getPipelineBaseline(), controller.getPipelineMedian());
+
+	// Missing the target because of load holds both the interval and the batch size
+	ASSERT(runWindow(controller, now, target * 2, pipeline * 2));
+	ASSERT_EQ(controller.getBatchInterval(), interval);
+	ASSERT_EQ(controller.getBatchBytesLimit(1000), 1000);
+	ASSERT(runWindow(controller, now, target * 2, pipeline, 10));
+	ASSERT_EQ(controller.getBatchInterval(), interval);
+	ASSERT_EQ(controller.getBatchBytesLimit(1000), 1000);
+
+	// Latency within the dead band around the target holds the interval too
+	ASSERT(runWindow(controller, now, target, pipeline));
+	ASSERT_EQ(controller.getBatchInterval(), interval);
+
+	// Missing the target with a short queue shrinks both the interval and the batch size, once it has been missed
+	// for long enough to reverse the growth
+	for (int i = 0; i < SERVER_KNOBS->COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS; i++) {
+		ASSERT_EQ(controller.getBatchInterval(), interval);
+		ASSERT(runWindow(controller, now, target * 2, pipeline));
+	}
+	ASSERT_LE(controller.getBatchInterval(), interval);
+	ASSERT_LT(controller.getBatchBytesLimit(1000), 1000);
+
+	// Once latency recovers the batch size grows back
+	for (int i = 0; i < 100; i++) {
+		ASSERT(runWindow(controller, now, target / 2, pipeline));
+	}
+	ASSERT_EQ(controller.getBatchInterval(), minInterval);
+	ASSERT_EQ(controller.getBatchBytesLimit(1000), 1000);
+	return Void();
+}
+
+// Drives the controller with a model of a proxy whose load ramps up and then holds steady: each batch costs the
+// pipeline a fixed amount plus an amount per transaction, and pipeline latency grows with its utilization. Checks that
+// the interval settles instead of oscillating.
+TEST_CASE("/fdbserver/CommitBatchController/Converges") {
+	const double minInterval = SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN;
+	const double target = SERVER_KNOBS->COMMIT_BATCH_TARGET_P99_LATENCY;
+	const double unloadedPipeline = target / 10;
+	const double perBatch = minInterval / 2;
+	CommitBatchController controller(minInterval);
+	double now = 1.0;
+	ASSERT(!controller.update(now));
+
+	const int windows = 200;
+	int reversals = 0;
+	int lastDirection = 0;
+	double interval = controller.getBatchInterval();
+	for (int i = 0; i < windows; i++) {
+		// Fraction of the pipeline's time spent on the transactions themselves
+		const double load = 0.1 + 0.6 * std::min(1.0, 2.0 * i / windows);
+		const double utilization = std::min(0.95, perBatch / interval + load);
+		const double service = perBatch + load * interval;
+		const double pipelineLatency = unloadedPipeline + service / (1.0 - utilization);
+		const int batchesInFlight = static_cast<int>(utilization / (1.0 - utilization));
+		ASSERT(runWindow(controller, now, interval + pipelineLatency, pipelineLatency, batchesInFlight));
+		const double next = controller.getBatchInterval();
+		const int direction = next > interval ? 1 : next < interval ? -1 : 0;
+		if (direction != 0) {
+			reversals += direction == -lastDirection;
+			lastDirection = direction;
+		}
+		interval = next;
+	}
+	ASSERT_LE(reversals * SERVER_KNOBS->COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS, windows / 4);
+	return Void();
+}
@@ -32,6 +32,7 @@
 #include "fdbclient/DatabaseContext.h"
 #include "fdbclient/FDBTypes.h"
 #include "fdbclient/IdempotencyId.actor.h"
+#include "fdbclient/IdempotencyIdExpiry.h"
 #include "fdbclient/Knobs.h"
 #include "fdbclient/CommitProxyInterface.h"
 #include "fdbclient/NativeAPI.actor.h"
@@ -45,6 +46,7 @@
 #include "fdbserver/AccumulativeChecksumUtil.h"
 #include "fdbserver/ApplyMetadataMutation.h"
 #include "fdbserver/ConflictSet.h"
+#include "fdbserver/CoroFlow.h"
 #include "fdbserver/DataDistributorInterface.h"
 #include "fdbserver/FDBExecHelper.actor.h"
 #include "fdbclient/GetEncryptCipherKeys.h"
@@ -66,6 +68,7 @@
 #include "flow/EncryptUtils.h"
 #include "flow/Error.h"
 #include "flow/IRandom.h"
+#include "flow/IThreadPool.h"
 #include "flow/Knobs.h"
 #include "flow/Trace.h"
 #include "flow/network.h"
@@ -120,6 +123,11 @@ struct ResolutionRequestBuilder {
 	// -> read_conflict_range's original index in the commitTransactionRef
 	std::vector<std::vector<std::vector<int>>> txReadConflictRangeIndexMap;
 
+	// The reply tokens of the transactions that pipelined followers in the batch name as their leader, and the offsets
+	// of those added so far in each resolver's request
+	std::unordered_set<UID> pipelineLeaderTokens;
+	std::unordered_map<UID, std::vector<int>> pipelineLeaderOffsets;
+
 	ResolutionRequestBuilder(ProxyCommitData* self,
 	                         Version version,
 	                         Version prevVersion,
@@ -253,6 +261,10 @@ struct ResolutionRequestBuilder {
 			}
 		}
 
+		if (!pipelineLeaderTokens.empty()) {
+			addPipelineLeader(trRequest);
+		}
+
 		std::vector<int> resolversUsed;
 		for (int r = 0; r < outTr.size(); r++)
 			if (outTr[r]) {
@@ -261,6 +273,39 @@ struct ResolutionRequestBuilder {
 			}
 		transactionResolverMap.emplace_back(std::move(resolversUsed));
 	}
+
+	// Tells the resolvers which transaction a pipelined follower is behind, so that they abort it along with its
+	// leader and keep its writes out of their conflict history. A leader is sent to every resolver, even without
+	// conflict ranges there, so that each resolver the follower goes to sees whether the leader conflicts.
+	void addPipelineLeader(const CommitTransactionRequest& trRequest) {
+		const UID token = trRequest.reply.getEndpoint().token;
+		if (pipelineLeaderTokens.count(token)) {
+			std::vector<int>& offsets = pipelineLeaderOffsets[token];
+			for (int r = 0; r < requests.size(); r++) {
+				offsets.push_back(&getOutTransaction(r, trRequest.transaction.read_snapshot) -
+				                  requests[r].transactions.begin());
+			}
+		}
+
+		const std::vector<int>* leaderOffsets = nullptr;
+		if (trRequest.pipelineLeader.present()) {
+			auto leader = pipelineLeaderOffsets.find(trRequest.pipelineLeader.get());
+			if (leader != pipelineLeaderOffsets.end()) {
+				leaderOffsets = &leader->second;
+			}
+		}
+		for (int r = 0; r < requests.size(); r++) {
+			ResolveTransactionBatchRequest& request = requests[r];
+			while (request.pipelineLeaders.size() < request.transactions.size()) {
+				request.pipelineLeaders.push_back(request.arena, ConflictBatch::NoPipelineLeader);
+			}
+			if (outTr[r] && trRequest.pipelineLeader.present()) {
+				// The leader isn't ahead of the follower in the batch if it went to another proxy or an earlier batch
+				request.pipelineLeaders[outTr[r] - request.transactions.begin()] =
+				    leaderOffsets ? (*leaderOffsets)[r] : ConflictBatch::MissingPipelineLeader;
+			}
+		}
+	}
 };
 
 bool checkTenantNoWait(ProxyCommitData* commitData, int64_t tenant, const char* context, bool logOnFailure) {
@@ -372,6 +417,12 @@ bool verifyTenantPrefix(ProxyCommitData* const commitData, const CommitTransacti
 	return true;
 }
 
+bool hasSystemKeyMutations(const CommitTransactionRequest& req) {
+	return std::any_of(req.transaction.mutations.begin(), req.transaction.mutations.end(), [](MutationRef const& m) {
+		return m.type == MutationRef::ClearRange ? m.param2 > systemKeys.begin : m.param1 >= systemKeys.begin;
+	});
+}
+
 ACTOR Future<Void> commitBatcher(ProxyCommitData* commitData,
                                  PromiseStream<std::pair<std::vector<CommitTransactionRequest>, int>> out,
                                  FutureStream<CommitTransactionRequest> in,
@@ -385,6 +436,9 @@ ACTOR Future<Void> commitBatcher(ProxyCommitData* commitData,
 		state Future<Void> timeout;
 		state std::vector<CommitTransactionRequest> batch;
 		state int batchBytes = 0;
+		state int batchBytesLimit = SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL
+		                                ? commitData->commitBatchController.getBatchBytesLimit(desiredBytes)
+		                                : desiredBytes;
 		// TODO: Enable this assertion (currently failing with gcc)
 		// static_assert(std::is_nothrow_move_constructible_v<CommitTransactionRequest>);
 
@@ -395,7 +449,7 @@ ACTOR Future<Void> commitBatcher(ProxyCommitData* commitData,
 		}
 
 		while (!timeout.isReady() &&
-		       !(batch.size() == SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX || batchBytes >= desiredBytes)) {
+		       !(batch.size() == SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX || batchBytes >= batchBytesLimit)) {
 			choose {
 				when(CommitTransactionRequest req = waitNext(in)) {
 					// WARNING: this code is run at a high priority, so it needs to do as little work as possible
@@ -425,6 +479,13 @@ ACTOR Future<Void> commitBatcher(ProxyCommitData* commitData,
 						continue;
 					}
 
+					if (req.pipelineLeader.present() && hasSystemKeyMutations(req)) {
+						// Metadata effects can't be backed out if the follower is aborted after resolution
+						++commitData->stats.txnCommitErrors;
+						req.reply.sendError(client_invalid_operation());
+						continue;
+					}
+
 					if (SERVER_KNOBS->STORAGE_QUOTA_ENABLED && !req.bypassStorageQuota() &&
 					    req.tenantInfo.hasTenant() &&
 					    commitData->tenantsOverStorageQuota.count(req.tenantInfo.tenantId) > 0) {
@@ -728,8 +789,19 @@ struct CommitBatchContext {
 	// Cipher keys to be used to encrypt mutations
 	std::unordered_map<EncryptCipherDomainId, Reference<BlobCipherKey>> cipherKeys;
 
+	// Set when the batch's mutations are being encrypted on the proxy encryption threads, see preEncryptMutations()
+	Future<Void> preEncryption;
+	double preEncryptionTime = 0;
+
 	IdempotencyIdKVBuilder idempotencyKVBuilder;
 
+	// Set if any transaction in the batch is a pipelined follower, in which case the reply tokens of the transactions
+	// committed so far are tracked so that followers whose leader didn't commit ahead of them can be aborted
+	bool hasPipelinedCommits = false;
+	std::unordered_set<UID> committedPipelineLeaders;
+	// Followers aborted because their leader didn't commit, which have no conflicting keys to report
+	std::unordered_set<int> pipelineFollowersAborted;
+
 	CommitBatchContext(ProxyCommitData*, const std::vector<CommitTransactionRequest>*, const int);
 
 	void setupTraceBatch();
@@ -849,6 +921,9 @@ CommitBatchContext::CommitBatchContext(ProxyCommitData* const pProxyCommitData_,
     committed(trs.size()) {
 
 	evaluateBatchSize();
+	hasPipelinedCommits = std::any_of(
+	    trs.begin(), trs.end(), [](CommitTransactionRequest const& tr) { return tr.pipelineLeader.present(); });
+	idempotencyKVBuilder.setCompactFormat(SERVER_KNOBS->IDEMPOTENCY_ID_COMPACT_FORMAT);
 
 	if (batchOperations != 0) {
 		latencyBucket =
@@ -1069,6 +1144,13 @@ ACTOR Future<Void> getResolution(CommitBatchContext* self) {
 
 	ResolutionRequestBuilder requests(
 	    pProxyCommitData, self->commitVersion, self->prevVersion, pProxyCommitData->version.get(), span);
+	if (self->hasPipelinedCommits) {
+		for (const auto& tr : trs) {
+			if (tr.pipelineLeader.present()) {
+				requests.pipelineLeaderTokens.insert(tr.pipelineLeader.get());
+			}
+		}
+	}
 	int conflictRangeCount = 0;
 	self->maxTransactionBytes = 0;
 	for (int t = 0; t < trs.size(); t++) {
@@ -1141,7 +1223,11 @@ ACTOR Future<Void> getResolution(CommitBatchContext* self) {
 	std::vector<ResolveTransactionBatchReply> resolutionResp = wait(getAll(replies));
 	self->resolution.swap(*const_cast<std::vector<ResolveTransactionBatchReply>*>(&resolutionResp));
 
-	self->pProxyCommitData->stats.resolutionDist->sampleSeconds(g_network->timer_monotonic() - resolutionStart);
+	const double resolutionLatency = g_network->timer_monotonic() - resolutionStart;
+	self->pProxyCommitData->stats.resolutionDist->sampleSeconds(resolutionLatency);
+	if (SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL) {
+		self->pProxyCommitData->commitBatchController.addResolutionLatency(resolutionLatency);
+	}
 	if (self->debugID.present()) {
 		g_traceBatch.addEvent(
 		    "CommitDebug", self->debugID.get().first(), "CommitProxyServer.commitBatch.AfterResolution");
@@ -1653,24 +1739,31 @@ void applyMetadataEffect(CommitBatchContext* self) {
 	}
 }
 
-/// Determine which transactions actually committed (conservatively) by combining results from the resolvers
-void determineCommittedTransactions(CommitBatchContext* self) {
-	auto pProxyCommitData = self->pProxyCommitData;
-	const auto& trs = self->trs;
-
-	ASSERT(self->transactionResolverMap.size() == self->committed.size());
+// Returns what the resolvers decided for each transaction: the lowest verdict of the resolvers it was sent to
+std::vector<uint8_t> getResolverVerdicts(CommitBatchContext const* self, std::vector<int>& nextTr) {
 	// For each commitTransactionRef, it is only sent to resolvers specified in transactionResolverMap
 	// Thus, we use this nextTr to track the correct transaction index on each resolver.
-	self->nextTr.resize(self->resolution.size());
-	for (int t = 0; t < trs.size(); t++) {
+	nextTr.assign(self->resolution.size(), 0);
+	std::vector<uint8_t> verdicts(self->trs.size());
+	for (int t = 0; t < self->trs.size(); t++) {
 		uint8_t commit = ConflictBatch::TransactionCommitted;
 		for (int r : self->transactionResolverMap[t]) {
-			commit = std::min(self->resolution[r].committed[self->nextTr[r]++], commit);
+			commit = std::min(self->resolution[r].committed[nextTr[r]++], commit);
 		}
-		self->committed[t] = commit;
+		verdicts[t] = commit;
 	}
 	for (int r = 0; r < self->resolution.size(); r++)
-		ASSERT(self->nextTr[r] == self->resolution[r].committed.size());
+		ASSERT(nextTr[r] == self->resolution[r].committed.size());
+	return verdicts;
+}
+
+/// Determine which transactions actually committed (conservatively) by combining results from the resolvers
+void determineCommittedTransactions(CommitBatchContext* self) {
+	auto pProxyCommitData = self->pProxyCommitData;
+	const auto& trs = self->trs;
+
+	ASSERT(self->transactionResolverMap.size() == self->committed.size());
+	self->committed = getResolverVerdicts(self, self->nextTr);
 
 	pProxyCommitData->logAdapter->setNextVersion(self->commitVersion);
 
@@ -1706,6 +1799,18 @@ ACTOR Future<Void> applyMetadataToCommittedTransactions(CommitBatchContext* self
 
 	int t;
 	for (t = 0; t < trs.size() && !self->forceRecovery; t++) {
+		if (trs[t].pipelineLeader.present() && !self->committedPipelineLeaders.count(trs[t].pipelineLeader.get())) {
+			// The resolvers abort a follower whose leader conflicted there or isn't ahead of it in the batch. The
+			// leader can still be aborted here, or by another resolver than the follower's, after they committed it.
+			if (self->committed[t] == ConflictBatch::TransactionCommitted) {
+				CODE_PROBE(true, "Pipelined commit aborted after resolution without its leader");
+				self->committed[t] = ConflictBatch::TransactionConflict;
+			}
+			if (self->committed[t] == ConflictBatch::TransactionConflict) {
+				self->pipelineFollowersAborted.insert(t);
+			}
+		}
+
 		Error e = validateAndProcessTenantAccess(trs[t], pProxyCommitData, rawAccessTenantIds);
 		if (e.code() != error_code_success) {
 			trs[t].reply.sendError(e);
@@ -1727,6 +1832,9 @@ ACTOR Future<Void> applyMetadataToCommittedTransactions(CommitBatchContext* self
 			                       self->commitVersion + 1,
 			                       /* initialCommit= */ false,
 			                       /* provisionalCommitProxy */ self->pProxyCommitData->provisional);
+			if (self->hasPipelinedCommits) {
+				self->committedPipelineLeaders.insert(trs[t].reply.getEndpoint().token);
+			}
 		}
 
 		if (self->firstStateMutations) {
@@ -1879,6 +1987,158 @@ Future<WriteMutationRefVar> writeMutation(CommitBatchContext* self,
 	}
 }
 
+// Returns the encryption domain for the mutations of the given transaction, or INVALID_ENCRYPT_DOMAIN_ID if it has to be
+// derived from each mutation's key
+int64_t getTransactionEncryptDomain(ProxyCommitData* const pProxyCommitData, const CommitTransactionRequest& tr) {
+	int64_t encryptDomain = tr.tenantInfo.tenantId;
+	if (pProxyCommitData->encryptMode.mode == EncryptionAtRestMode::CLUSTER_AWARE &&
+	    encryptDomain != SYSTEM_KEYSPACE_ENCRYPT_DOMAIN_ID) {
+		encryptDomain = FDB_DEFAULT_ENCRYPT_DOMAIN_ID;
+	}
+	return encryptDomain;
+}
+
+// Encrypts mutations on the proxy encryption threads. Everything that touches reference counts (cipher keys, arenas,
+// the cipher objects themselves) happens on the network thread; the encryption threads only see the serialized
+// mutation buffers, the cipher contexts and the headers being written.
+struct MutationEncryptionWork : ReferenceCounted<MutationEncryptionWork> {
+	struct Job {
+		int transactionNum;
+		int mutationNum;
+		StringRef buffer; // Serialized mutation, encrypted in place
+		Reference<EncryptBlobCipherAes265Ctr> cipher;
+		BlobCipherEncryptHeaderRef header;
+		double encryptTime = 0;
+	};
+
+	Arena arena;
+	std::vector<Job> jobs;
+};
+
+class MutationEncryptor final : public IThreadPoolReceiver {
+public:
+	void init() override {}
+
+	struct EncryptAction final : TypedAction<MutationEncryptor, EncryptAction> {
+		MutationEncryptionWork* work;
+		int begin;
+		int end;
+		ThreadReturnPromise<Void> result;
+
+		EncryptAction(MutationEncryptionWork* work, int begin, int end) : work(work), begin(begin), end(end) {}
+		double getTimeEstimate() const override { return 0; }
+	};
+
+	void action(EncryptAction& a) {
+		try {
+			for (int i = a.begin; i < a.end; i++) {
+				MutationEncryptionWork::Job& job = a.work->jobs[i];
+				job.cipher->encryptInplace(mutateString(job.buffer), job.buffer.size(), &job.header, &job.encryptTime);
+			}
+			a.result.send(Void());
+		} catch (Error& e) {
+			a.result.sendError(e);
+		}
+	}
+};
+
+// Keeps the work alive until the encryption threads are done with it, even if the commit batch goes away first.
+ACTOR void releaseEncryptionWorkWhenDone(Reference<MutationEncryptionWork> work, Future<Void> done) {
+	try {
+		wait(done);
+	} catch (Error&) {
+	}
+}
+
+// Encrypts the batch's mutations on the proxy encryption threads, so the work overlaps with the post-resolution
+// processing of earlier batches on the network thread. Only transactions the resolvers committed, and mutations whose
+// encryption domain is known before metadata is applied, are handled here; the results become the transactions'
+// encryptedMutations, which assignMutationsToStorageServers() writes out as-is. Everything else is still encrypted
+// inline. A transaction that is aborted later, while metadata is applied, has been encrypted for nothing.
+ACTOR Future<Void> preEncryptMutations(CommitBatchContext* self) {
+	state ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
+	state std::vector<CommitTransactionRequest>& trs = self->trs;
+	state Reference<MutationEncryptionWork> work = makeReference<MutationEncryptionWork>();
+	state std::vector<Future<Void>> results;
+
+	Reference<BlobCipherKey> headerCipherKey;
+	if (FLOW_KNOBS->ENCRYPT_HEADER_AUTH_TOKEN_ENABLED) {
+		auto it = self->cipherKeys.find(ENCRYPT_HEADER_DOMAIN_ID);
+		if (it == self->cipherKeys.end()) {
+			return Void();
+		}
+		headerCipherKey = it->second;
+	}
+
+	std::vector<int> nextTr;
+	std::vector<uint8_t> verdicts = getResolverVerdicts(self, nextTr);
+	for (int t = 0; t < trs.size(); t++) {
+		const CommitTransactionRef& transaction = trs[t].transaction;
+		if (verdicts[t] != ConflictBatch::TransactionCommitted || !transaction.encryptedMutations.empty()) {
+			continue;
+		}
+		auto textCipherKey = self->cipherKeys.find(getTransactionEncryptDomain(pProxyCommitData, trs[t]));
+		if (textCipherKey == self->cipherKeys.end()) {
+			continue;
+		}
+		for (int m = 0; m < transaction.mutations.size(); m++) {
+			const MutationRef& mutation = transaction.mutations[m];
+			if (!isSingleKeyMutation((MutationRef::Type)mutation.type) && mutation.type != MutationRef::ClearRange) {
+				continue;
+			}
+			uint8_t iv[AES_256_IV_LENGTH] = { 0 };
+			deterministicRandom()->randomBytes(iv, AES_256_IV_LENGTH);
+			BinaryWriter bw(AssumeVersion(ProtocolVersion::withEncryptionAtRest()));
+			bw << mutation;
+
+			MutationEncryptionWork::Job& job = work->jobs.emplace_back();
+			job.transactionNum = t;
+			job.mutationNum = m;
+			job.buffer = StringRef(work->arena, StringRef(static_cast<const uint8_t*>(bw.getData()), bw.getLength()));
+			job.cipher = makeReference<EncryptBlobCipherAes265Ctr>(
+			    textCipherKey->second,
+			    headerCipherKey,
+			    iv,
+			    AES_256_IV_LENGTH,
+			    getEncryptAuthTokenMode(EncryptAuthTokenMode::ENCRYPT_HEADER_AUTH_TOKEN_MODE_SINGLE),
+			    BlobCipherMetrics::TLOG);
+		}
+	}
+	if (work->jobs.empty()) {
+		return Void();
+	}
+
+	const int actions = std::min<int>(SERVER_KNOBS->PROXY_ENCRYPTION_THREADS, work->jobs.size());
+	for (int i = 0; i < actions; i++) {
+		auto* a = new MutationEncryptor::EncryptAction(
+		    work.getPtr(), work->jobs.size() * i / actions, work->jobs.size() * (i + 1) / actions);
+		results.push_back(a->result.getFuture());
+		pProxyCommitData->encryptionThreads->post(a);
+	}
+
+	try {
+		wait(waitForAll(results));
+	} catch (Error& e) {
+		releaseEncryptionWorkWhenDone(work, waitForAllReady(results));
+		throw;
+	}
+
+	for (MutationEncryptionWork::Job& job : work->jobs) {
+		CommitTransactionRequest& tr = trs[job.transactionNum];
+		if (tr.transaction.encryptedMutations.empty()) {
+			tr.transaction.encryptedMutations.resize(tr.arena, tr.transaction.mutations.size());
+			tr.arena.dependsOn(work->arena);
+		}
+		Standalone<StringRef> header = BlobCipherEncryptHeaderRef::toStringRef(job.header);
+		work->arena.dependsOn(header.arena());
+		tr.transaction.encryptedMutations[job.mutationNum] = MutationRef(MutationRef::Encrypted, header, job.buffer);
+		self->preEncryptionTime += job.encryptTime;
+	}
+	CODE_PROBE(true, "Commit proxy encrypted mutations on encryption threads");
+
+	return Void();
+}
+
 // Check whether the mutation intersects any legal backup ranges
 // If so, it will be clamped to the intersecting range(s) later
 inline bool shouldBackup(MutationRef const& m) {
@@ -2000,7 +2260,7 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 	state ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
 	state std::vector<CommitTransactionRequest>& trs = self->trs;
 	state double curEncryptionTime = 0;
-	state double totalEncryptionTime = 0;
+	state double totalEncryptionTime = self->preEncryptionTime;
 
 	for (; self->transactionNum < trs.size(); self->transactionNum++) {
 		if (!(self->committed[self->transactionNum] == ConflictBatch::TransactionCommitted &&
@@ -2019,11 +2279,7 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 			ASSERT_EQ(encryptedMutations->size(), pMutations->size());
 		}
 
-		state int64_t encryptDomain = trs[self->transactionNum].tenantInfo.tenantId;
-		if (self->pProxyCommitData->encryptMode.mode == EncryptionAtRestMode::CLUSTER_AWARE &&
-		    encryptDomain != SYSTEM_KEYSPACE_ENCRYPT_DOMAIN_ID) {
-			encryptDomain = FDB_DEFAULT_ENCRYPT_DOMAIN_ID;
-		}
+		state int64_t encryptDomain = getTransactionEncryptDomain(pProxyCommitData, trs[self->transactionNum]);
 
 		self->toCommit.addTransactionInfo(trs[self->transactionNum].spanContext);
 
@@ -2110,77 +2366,117 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 				writtenMutation = std::get<MutationRef>(var);
 			} else if (m.type == MutationRef::ClearRange) {
 				KeyRangeRef clearRange(KeyRangeRef(m.param1, m.param2));
-				auto ranges = pProxyCommitData->keyInfo.intersectingRanges(clearRange);
-				auto firstRange = ranges.begin();
-				++firstRange;
-				if (firstRange == ranges.end()) {
-					// Fast path
-					DEBUG_MUTATION("ProxyCommit", self->commitVersion, m, pProxyCommitData->dbgid)
-					    .detail("To", ranges.begin().value().tags);
-					ranges.begin().value().populateTags();
-					self->toCommit.addTags(ranges.begin().value().tags);
-
-					if (pProxyCommitData->acsBuilder != nullptr) {
-						updateMutationWithAcsAndAddMutationToAcsBuilder(
-						    pProxyCommitData->acsBuilder,
-						    m,
-						    ranges.begin().value().tags,
-						    getCommitProxyAccumulativeChecksumIndex(pProxyCommitData->commitProxyIndex),
-						    pProxyCommitData->epoch,
-						    self->commitVersion,
-						    pProxyCommitData->dbgid);
-					}
-
-					// check whether clear is sampled
-					if (checkSample && !trCost->get().clearIdxCosts.empty() &&
-					    trCost->get().clearIdxCosts[0].first == mutationNum) {
-						auto const& ssInfos = ranges.begin().value().src_info;
-						for (auto const& ssInfo : ssInfos) {
-							auto id = ssInfo->interf.id();
-							pProxyCommitData->updateSSTagCost(id,
-							                                  trs[self->transactionNum].tagSet.get(),
-							                                  m,
-							                                  trCost->get().clearIdxCosts[0].second / ssInfos.size());
+				const bool clearSampled = checkSample && !trCost->get().clearIdxCosts.empty() &&
+				                          trCost->get().clearIdxCosts[0].first == mutationNum;
+				if (SERVER_KNOBS->PROXY_USE_FLAT_TAG_INDEX && !clearSampled) {
+					// Sampled clears take the keyInfo path below, which attributes their cost to each shard's
+					// storage servers
+					std::set<Tag> allSources;
+					const std::vector<Tag>* tags = pProxyCommitData->tagIndex().tagsForRange(clearRange, allSources);
+					if (tags) {
+						DEBUG_MUTATION("ProxyCommit", self->commitVersion, m, pProxyCommitData->dbgid)
+						    .detail("To", *tags);
+						self->toCommit.addTags(*tags);
+						if (pProxyCommitData->acsBuilder != nullptr) {
+							updateMutationWithAcsAndAddMutationToAcsBuilder(
+							    pProxyCommitData->acsBuilder,
+							    m,
+							    *tags,
+							    getCommitProxyAccumulativeChecksumIndex(pProxyCommitData->commitProxyIndex),
+							    pProxyCommitData->epoch,
+							    self->commitVersion,
+							    pProxyCommitData->dbgid);
+						}
+					} else {
+						CODE_PROBE(true, "A clear range extends past a shard boundary in the flat tag index");
+						DEBUG_MUTATION("ProxyCommit", self->commitVersion, m, pProxyCommitData->dbgid)
+						    .detail("To", allSources);
+						self->toCommit.addTags(allSources);
+						if (pProxyCommitData->acsBuilder != nullptr) {
+							updateMutationWithAcsAndAddMutationToAcsBuilder(
+							    pProxyCommitData->acsBuilder,
+							    m,
+							    allSources,
+							    getCommitProxyAccumulativeChecksumIndex(pProxyCommitData->commitProxyIndex),
+							    pProxyCommitData->epoch,
+							    self->commitVersion,
+							    pProxyCommitData->dbgid);
 						}
-						trCost->get().clearIdxCosts.pop_front();
 					}
 				} else {
-					CODE_PROBE(true, "A clear range extends past a shard boundary");
-					std::set<Tag> allSources;
-					for (auto r : ranges) {
-						r.value().populateTags();
-						allSources.insert(r.value().tags.begin(), r.value().tags.end());
+					auto ranges = pProxyCommitData->keyInfo.intersectingRanges(clearRange);
+					auto firstRange = ranges.begin();
+					++firstRange;
+					if (firstRange == ranges.end()) {
+						// Fast path
+						DEBUG_MUTATION("ProxyCommit", self->commitVersion, m, pProxyCommitData->dbgid)
+						    .detail("To", ranges.begin().value().tags);
+						ranges.begin().value().populateTags();
+						self->toCommit.addTags(ranges.begin().value().tags);
+
+						if (pProxyCommitData->acsBuilder != nullptr) {
+							updateMutationWithAcsAndAddMutationToAcsBuilder(
+							    pProxyCommitData->acsBuilder,
+							    m,
+							    ranges.begin().value().tags,
+							    getCommitProxyAccumulativeChecksumIndex(pProxyCommitData->commitProxyIndex),
+							    pProxyCommitData->epoch,
+							    self->commitVersion,
+							    pProxyCommitData->dbgid);
+						}
 
 						// check whether clear is sampled
 						if (checkSample && !trCost->get().clearIdxCosts.empty() &&
 						    trCost->get().clearIdxCosts[0].first == mutationNum) {
-							auto const& ssInfos = r.value().src_info;
+							auto const& ssInfos = ranges.begin().value().src_info;
 							for (auto const& ssInfo : ssInfos) {
 								auto id = ssInfo->interf.id();
-								pProxyCommitData->updateSSTagCost(id,
-								                                  trs[self->transactionNum].tagSet.get(),
-								                                  m,
-								                                  trCost->get().clearIdxCosts[0].second /
-								                                      ssInfos.size());
+								pProxyCommitData->updateSSTagCost(
+								    id,
+								    trs[self->transactionNum].tagSet.get(),
+								    m,
+								    trCost->get().clearIdxCosts[0].second / ssInfos.size());
 							}
 							trCost->get().clearIdxCosts.pop_front();
 						}
-					}
+					} else {
+						CODE_PROBE(true, "A clear range extends past a shard boundary");
+						std::set<Tag> allSources;
+						for (auto r : ranges) {
+							r.value().populateTags();
+							allSources.insert(r.value().tags.begin(), r.value().tags.end());
+
+							// check whether clear is sampled
+							if (checkSample && !trCost->get().clearIdxCosts.empty() &&
+							    trCost->get().clearIdxCosts[0].first == mutationNum) {
+								auto const& ssInfos = r.value().src_info;
+								for (auto const& ssInfo : ssInfos) {
+									auto id = ssInfo->interf.id();
+									pProxyCommitData->updateSSTagCost(id,
+									                                  trs[self->transactionNum].tagSet.get(),
+									                                  m,
+									                                  trCost->get().clearIdxCosts[0].second /
+									                                      ssInfos.size());
+								}
+								trCost->get().clearIdxCosts.pop_front();
+							}
+						}
 
-					DEBUG_MUTATION("ProxyCommit", self->commitVersion, m)
-					    .detail("Dbgid", pProxyCommitData->dbgid)
-					    .detail("To", allSources);
-					self->toCommit.addTags(allSources);
-
-					if (self->pProxyCommitData->acsBuilder != nullptr) {
-						updateMutationWithAcsAndAddMutationToAcsBuilder(
-						    pProxyCommitData->acsBuilder,
-						    m,
-						    allSources,
-						    getCommitProxyAccumulativeChecksumIndex(pProxyCommitData->commitProxyIndex),
-						    pProxyCommitData->epoch,
-						    self->commitVersion,
-						    pProxyCommitData->dbgid);
+						DEBUG_MUTATION("ProxyCommit", self->commitVersion, m)
+						    .detail("Dbgid", pProxyCommitData->dbgid)
+						    .detail("To", allSources);
+						self->toCommit.addTags(allSources);
+
+						if (self->pProxyCommitData->acsBuilder != nullptr) {
+							updateMutationWithAcsAndAddMutationToAcsBuilder(
+							    pProxyCommitData->acsBuilder,
+							    m,
+							    allSources,
+							    getCommitProxyAccumulativeChecksumIndex(pProxyCommitData->commitProxyIndex),
+							    pProxyCommitData->epoch,
+							    self->commitVersion,
+							    pProxyCommitData->dbgid);
+						}
 					}
 				}
 
@@ -2239,6 +2535,11 @@ ACTOR Future<Void> postResolution(CommitBatchContext* self) {
 	state const Optional<UID>& debugID = self->debugID;
 	state Span span("MP:postResolution"_loc, self->span.context);
 
+	// Start encrypting this batch's mutations while earlier batches are still being processed
+	if (pProxyCommitData->encryptionThreads && pProxyCommitData->encryptMode.isEncryptionEnabled()) {
+		self->preEncryption = preEncryptMutations(self);
+	}
+
 	bool queuedCommits = pProxyCommitData->latestLocalCommitBatchLogging.get() < localBatchNumber - 1;
 	CODE_PROBE(queuedCommits, "Queuing post-resolution commit processing");
 	wait(pProxyCommitData->latestLocalCommitBatchLogging.whenAtLeast(localBatchNumber - 1));
@@ -2286,6 +2587,12 @@ ACTOR Future<Void> postResolution(CommitBatchContext* self) {
 		    "CommitDebug", debugID.get().first(), "CommitProxyServer.commitBatch.ApplyMetadataToCommittedTxn");
 	}
 
+	if (self->preEncryption.isValid()) {
+		self->computeDuration += g_network->timer_monotonic() - self->computeStart;
+		wait(self->preEncryption);
+		self->computeStart = g_network->timer_monotonic();
+	}
+
 	// Second pass
 	wait(assignMutationsToStorageServers(self));
 
@@ -2543,7 +2850,14 @@ ACTOR Future<Void> transactionLogging(CommitBatchContext* self) {
 		pProxyCommitData->txsPopVersions.emplace_back(self->commitVersion, self->msg.popTo);
 	}
 	pProxyCommitData->logSystem->popTxs(self->msg.popTo);
-	pProxyCommitData->stats.tlogLoggingDist->sampleSeconds(g_network->timer_monotonic() - tLoggingStart);
+	const double loggingLatency = g_network->timer_monotonic() - tLoggingStart;
+	pProxyCommitData->stats.tlogLoggingDist->sampleSeconds(loggingLatency);
+	if (SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL) {
+		pProxyCommitData->commitBatchController.addLoggingLatency(loggingLatency);
+		// Batches started behind this one that have not reached logging yet
+		pProxyCommitData->commitBatchController.addBatchesInFlight(
+		    pProxyCommitData->localCommitBatchesStarted - pProxyCommitData->latestLocalCommitBatchLogging.get());
+	}
 	return Void();
 }
 
@@ -2636,6 +2950,8 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 		} else if (self->committed[t] == ConflictBatch::TransactionTenantFailure) {
 			// We already sent the error
 			ASSERT(tr.reply.isSet());
+		} else if (self->pipelineFollowersAborted.count(t)) {
+			tr.reply.sendError(not_committed());
 		} else {
 			// If enable the option to report conflicting keys from resolvers, we send back all keyranges' indices
 			// through CommitID
@@ -2668,6 +2984,9 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 		// TODO: filter if pipelined with large commit
 		const double duration = endTime - tr.requestTime();
 		pProxyCommitData->stats.commitLatencySample.addMeasurement(duration);
+		if (SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL) {
+			pProxyCommitData->commitBatchController.addCommitLatency(duration);
+		}
 		if (pProxyCommitData->latencyBandConfig.present()) {
 			bool filter = self->maxTransactionBytes >
 			              pProxyCommitData->latencyBandConfig.get().commitConfig.maxCommitBytes.orDefault(
@@ -2676,9 +2995,16 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 		}
 	}
 
-	for (auto [highOrderBatchIndex, count] : idCountsForKey) {
-		pProxyCommitData->expectedIdempotencyIdCountForKey.send(
-		    ExpectedIdempotencyIdCountForKey{ self->commitVersion, count, highOrderBatchIndex });
+	// Batches without idempotency ids are reported while ids are in use so that the expire server can clear the ids of
+	// the batches around them with a single range clear
+	if (!idCountsForKey.empty()) {
+		pProxyCommitData->lastIdempotencyIdBatchTime = now();
+	}
+	if (now() - pProxyCommitData->lastIdempotencyIdBatchTime < SERVER_KNOBS->IDEMPOTENCY_ID_IN_MEMORY_LIFETIME) {
+		pProxyCommitData->expectedIdempotencyIdCounts.send(ExpectedIdempotencyIdCounts(
+		    self->prevVersion,
+		    self->commitVersion,
+		    std::vector<std::pair<uint8_t, int16_t>>(idCountsForKey.begin(), idCountsForKey.end())));
 	}
 
 	if (self->pProxyCommitData->encryptMode.isEncryptionEnabled() && self->encryptionTime.present()) {
@@ -2719,14 +3045,28 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 	}
 
 	// Dynamic batching for commits
-	double target_latency =
-	    (now() - self->startTime) * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
-	pProxyCommitData->commitBatchInterval =
-	    std::max(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
-	             std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
-	                      target_latency * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA +
-	                          pProxyCommitData->commitBatchInterval *
-	                              (1 - SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA)));
+	if (SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL) {
+		CommitBatchController& controller = pProxyCommitData->commitBatchController;
+		if (controller.update(now())) {
+			pProxyCommitData->commitBatchInterval = controller.getBatchInterval();
+			TraceEvent(SevDebug, "CommitBatchControl", pProxyCommitData->dbgid)
+			    .detail("CommitP99", controller.getCommitP99())
+			    .detail("PipelineMedian", controller.getPipelineMedian())
+			    .detail("PipelineBaseline", controller.getPipelineBaseline())
+			    .detail("BatchesInFlight", controller.getBatchesInFlight())
+			    .detail("BatchInterval", controller.getBatchInterval())
+			    .detail("BatchSizeFraction", controller.getBatchSizeFraction());
+		}
+	} else {
+		double target_latency =
+		    (now() - self->startTime) * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
+		pProxyCommitData->commitBatchInterval =
+		    std::max(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
+		             std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
+		                      target_latency * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA +
+		                          pProxyCommitData->commitBatchInterval *
+		                              (1 - SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA)));
+	}
 
 	pProxyCommitData->stats.commitBatchingWindowSize.addMeasurement(pProxyCommitData->commitBatchInterval);
 	pProxyCommitData->commitBatchesMemBytesCount -= self->currentBatchMemBytesCount;
@@ -3533,93 +3873,32 @@ ACTOR Future<Void> monitorTenantsOverStorageQuota(UID myID,
 	}
 }
 
-namespace {
-struct ExpireServerEntry {
-	int64_t timeReceived;
-	int expectedCount = 0;
-	int receivedCount = 0;
-	bool initialized = false;
-};
-
-struct IdempotencyKey {
-	Version version;
-	uint8_t highOrderBatchIndex;
-	bool operator==(const IdempotencyKey& other) const {
-		return version == other.version && highOrderBatchIndex == other.highOrderBatchIndex;
-	}
-};
-
-} // namespace
-
-namespace std {
-template <>
-struct hash<IdempotencyKey> {
-	std::size_t operator()(const IdempotencyKey& key) const {
-		std::size_t seed = 0;
-		boost::hash_combine(seed, std::hash<Version>{}(key.version));
-		boost::hash_combine(seed, std::hash<uint8_t>{}(key.highOrderBatchIndex));
-		return seed;
-	}
-};
-
-} // namespace std
-
 ACTOR static Future<Void> idempotencyIdsExpireServer(
-    Database db,
     PublicRequestStream<ExpireIdempotencyIdRequest> expireIdempotencyId,
-    PromiseStream<ExpectedIdempotencyIdCountForKey> expectedIdempotencyIdCountForKey,
+    PromiseStream<ExpectedIdempotencyIdCounts> expectedIdempotencyIdCounts,
     Standalone<VectorRef<MutationRef>>* idempotencyClears) {
-	state std::unordered_map<IdempotencyKey, ExpireServerEntry> idStatus;
-	state std::unordered_map<IdempotencyKey, ExpireServerEntry>::iterator iter;
-	state int64_t purgeBefore;
-	state IdempotencyKey key;
-	state ExpireServerEntry* status = nullptr;
-	state Future<Void> purgeOld = Void();
+	state IdempotencyIdExpiry expiry;
+	state Future<Void> purgeOld = delay(SERVER_KNOBS->IDEMPOTENCY_ID_IN_MEMORY_LIFETIME);
+	state Future<Void> flushClears = delay(SERVER_KNOBS->IDEMPOTENCY_ID_CLEAR_INTERVAL);
 	loop {
 		choose {
 			when(ExpireIdempotencyIdRequest req = waitNext(expireIdempotencyId.getFuture())) {
-				key = IdempotencyKey{ req.commitVersion, req.batchIndexHighByte };
-				status = &idStatus[key];
-				status->receivedCount += 1;
-				CODE_PROBE(status->expectedCount == 0, "ExpireIdempotencyIdRequest received before count is known");
-				if (status->expectedCount > 0) {
-					ASSERT_LE(status->receivedCount, status->expectedCount);
-				}
+				expiry.expire(req.commitVersion, req.batchIndexHighByte, now());
+			}
+			when(ExpectedIdempotencyIdCounts req = waitNext(expectedIdempotencyIdCounts.getFuture())) {
+				expiry.addBatch(req.prevVersion, req.commitVersion, req.idCounts, now());
 			}
-			when(ExpectedIdempotencyIdCountForKey req = waitNext(expectedIdempotencyIdCountForKey.getFuture())) {
-				key = IdempotencyKey{ req.commitVersion, req.batchIndexHighByte };
-				status = &idStatus[key];
-				ASSERT_EQ(status->expectedCount, 0);
-				status->expectedCount = req.idempotencyIdCount;
+			when(wait(flushClears)) {
+				// Clears are taken periodically rather than as ids expire so that the ids of adjacent commit batches
+				// are cleared together
+				flushClears = delay(SERVER_KNOBS->IDEMPOTENCY_ID_CLEAR_INTERVAL);
+				expiry.takeClears(*idempotencyClears);
 			}
 			when(wait(purgeOld)) {
 				purgeOld = delay(SERVER_KNOBS->IDEMPOTENCY_ID_IN_MEMORY_LIFETIME);
-				purgeBefore = now() - SERVER_KNOBS->IDEMPOTENCY_ID_IN_MEMORY_LIFETIME;
-				for (iter = idStatus.begin(); iter != idStatus.end();) {
-					// We have exclusive access to idStatus in this when block, so iter will still be valid after the
-					// wait
-					wait(yield());
-					if (iter->second.timeReceived < purgeBefore) {
-						iter = idStatus.erase(iter);
-					} else {
-						++iter;
-					}
-				}
-				continue;
+				expiry.purge(now() - SERVER_KNOBS->IDEMPOTENCY_ID_IN_MEMORY_LIFETIME);
 			}
 		}
-		if (status->initialized) {
-			if (status->receivedCount == status->expectedCount) {
-				auto keyRange =
-				    makeIdempotencySingleKeyRange(idempotencyClears->arena(), key.version, key.highOrderBatchIndex);
-				idempotencyClears->push_back(idempotencyClears->arena(),
-				                             MutationRef(MutationRef::ClearRange, keyRange.begin, keyRange.end));
-				idStatus.erase(key);
-			}
-		} else {
-			status->timeReceived = now();
-			status->initialized = true;
-		}
 	}
 }
 
@@ -3728,6 +4007,7 @@ ACTOR Future<Void> processCompleteTransactionStateRequest(TransactionStateResolv
 		// insert keyTag data separately from metadata mutations so that we can do one bulk insert which
 		// avoids a lot of map lookups.
 		pContext->pCommitData->keyInfo.rawInsert(keyInfoData);
+		pContext->pCommitData->keyInfoTagIndex.invalidate();
 
 		Arena arena;
 		bool confChanges;
@@ -3935,6 +4215,14 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy,
 	    commitData.logAdapter, commitData.db, proxy.id(), 2e9, true, true, true, encryptMode.isEncryptionEnabled());
 	createWhitelistBinPathVec(whitelistBinPaths, commitData.whitelistedBinPathVec);
 
+	if (commitData.encryptMode.isEncryptionEnabled() && SERVER_KNOBS->PROXY_ENCRYPTION_THREADS > 0) {
+		commitData.encryptionThreads =
+		    g_network->isSimulated() ? CoroThreadPool::createThreadPool() : createGenericThreadPool();
+		for (int i = 0; i < SERVER_KNOBS->PROXY_ENCRYPTION_THREADS; i++) {
+			commitData.encryptionThreads->addThread(new CommitBatch::MutationEncryptor(), "fdb-cp-encrypt");
+		}
+	}
+
 	commitData.updateLatencyBandConfig(commitData.db->get().latencyBandConfig);
 
 	// ((SERVER_MEM_LIMIT * COMMIT_BATCHES_MEM_FRACTION_OF_TOTAL) / COMMIT_BATCHES_MEM_TO_TOTAL_MEM_SCALE_FACTOR) is
@@ -3968,7 +4256,7 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy,
 		    SERVER_KNOBS->IDEMPOTENCY_IDS_CLEANER_POLLING_INTERVAL));
 	}
 	addActor.send(idempotencyIdsExpireServer(
-	    openDb, proxy.expireIdempotencyId, commitData.expectedIdempotencyIdCountForKey, &commitData.idempotencyClears));
+	    proxy.expireIdempotencyId, commitData.expectedIdempotencyIdCounts, &commitData.idempotencyClears));
 
 	if (SERVER_KNOBS->STORAGE_QUOTA_ENABLED) {
 		addActor.send(monitorTenantsOverStorageQuota(proxy.id(), db, &commitData));
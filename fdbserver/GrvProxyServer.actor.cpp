@@ -50,6 +50,7 @@ struct GrvProxyStats {
 	Counter txnTagThrottlerIn, txnTagThrottlerOut;
 	Counter txnThrottled;
 	Counter updatesFromRatekeeper, leaseTimeouts;
+	Counter txnStartLeased, readVersionLeaseRefreshes;
 	int systemGRVQueueSize, defaultGRVQueueSize, batchGRVQueueSize;
 	int tagThrottlerGRVQueueSize;
 	double transactionRateAllowed, batchTransactionRateAllowed;
@@ -131,7 +132,9 @@ struct GrvProxyStats {
 	    txnDefaultPriorityStartIn("TxnDefaultPriorityStartIn", cc),
 	    txnDefaultPriorityStartOut("TxnDefaultPriorityStartOut", cc), txnTagThrottlerIn("TxnTagThrottlerIn", cc),
 	    txnTagThrottlerOut("TxnTagThrottlerOut", cc), txnThrottled("TxnThrottled", cc),
-	    updatesFromRatekeeper("UpdatesFromRatekeeper", cc), leaseTimeouts("LeaseTimeouts", cc), systemGRVQueueSize(0),
+	    updatesFromRatekeeper("UpdatesFromRatekeeper", cc), leaseTimeouts("LeaseTimeouts", cc),
+	    txnStartLeased("TxnStartLeased", cc), readVersionLeaseRefreshes("ReadVersionLeaseRefreshes", cc),
+	    systemGRVQueueSize(0),
 	    defaultGRVQueueSize(0), batchGRVQueueSize(0), tagThrottlerGRVQueueSize(0), transactionRateAllowed(0),
 	    batchTransactionRateAllowed(0), transactionLimit(0), batchTransactionLimit(0),
 	    percentageOfDefaultGRVQueueProcessed(0), percentageOfBatchGRVQueueProcessed(0), lastBatchQueueThrottled(false),
@@ -211,6 +214,20 @@ struct GrvProxyData {
 	// Cache of the latest commit versions of storage servers.
 	VersionVector ssVersionVectorCache;
 
+	// The most recent causal reply to getLiveCommittedVersion, and the time its request was started. Requests with
+	// FLAG_BOUNDED_STALENESS are answered from it while it is fresh enough.
+	Optional<GetReadVersionReply> readVersionLease;
+	double readVersionLeaseTime = 0.0;
+	double lastBoundedStalenessRequest = 0.0;
+
+	bool canUseReadVersionLease(GetReadVersionRequest const& req) const {
+		return (req.flags & GetReadVersionRequest::FLAG_BOUNDED_STALENESS) && readVersionLease.present() &&
+		       SERVER_KNOBS->GRV_READ_VERSION_LEASE_MAX_STALENESS > 0 &&
+		       !(req.flags & GetReadVersionRequest::FLAG_USE_MIN_KNOWN_COMMITTED_VERSION) &&
+		       now() - readVersionLeaseTime <=
+		           std::min(req.maxStaleness, SERVER_KNOBS->GRV_READ_VERSION_LEASE_MAX_STALENESS);
+	}
+
 	void updateLatencyBandConfig(Optional<LatencyBandConfig> newLatencyBandConfig) {
 		if (newLatencyBandConfig.present() != latencyBandConfig.present() ||
 		    (newLatencyBandConfig.present() &&
@@ -664,7 +681,9 @@ ACTOR Future<GetReadVersionReply> getLiveCommittedVersion(std::vector<SpanContex
 	    GetRawCommittedVersionRequest(span.context, debugID, grvProxyData->ssVersionVectorCache.getMaxVersion()),
 	    TaskPriority::GetLiveCommittedVersionReply);
 
-	if (!SERVER_KNOBS->ALWAYS_CAUSAL_READ_RISKY && !(flags & GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY)) {
+	state bool causal =
+	    !SERVER_KNOBS->ALWAYS_CAUSAL_READ_RISKY && !(flags & GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY);
+	if (causal) {
 		wait(transformError(updateLastCommit(grvProxyData, debugID), broken_promise(), tlog_failed()));
 	} else if (SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > 0 &&
 	           now() - SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > grvProxyData->lastCommitTime.get()) {
@@ -710,9 +729,33 @@ ACTOR Future<GetReadVersionReply> getLiveCommittedVersion(std::vector<SpanContex
 	grvProxyData->stats.txnDefaultPriorityStartOut += defaultPriTransactionCount;
 	grvProxyData->stats.txnBatchPriorityStartOut += batchPriTransactionCount;
 
+	// rep.version was the latest committed version no earlier than grvStart, unless the epoch was not confirmed live:
+	// a CAUSAL_READ_RISKY reply may come from a master that has been replaced, so it is never leased out
+	if (causal && grvStart > grvProxyData->readVersionLeaseTime && !SERVER_KNOBS->ENABLE_VERSION_VECTOR) {
+		grvProxyData->readVersionLease = rep;
+		grvProxyData->readVersionLeaseTime = grvStart;
+	}
+
 	return rep;
 }
 
+// Keeps the read version lease fresh while clients are asking for bounded staleness read versions, so that their
+// requests do not have to wait for a regular GRV batch to refresh it.
+ACTOR Future<Void> refreshReadVersionLease(GrvProxyData* grvProxyData) {
+	loop {
+		wait(delay(SERVER_KNOBS->GRV_READ_VERSION_LEASE_REFRESH_INTERVAL, TaskPriority::ProxyGRVTimer));
+		if (SERVER_KNOBS->GRV_READ_VERSION_LEASE_MAX_STALENESS <= 0 || SERVER_KNOBS->ENABLE_VERSION_VECTOR ||
+		    SERVER_KNOBS->ALWAYS_CAUSAL_READ_RISKY ||
+		    now() - grvProxyData->lastBoundedStalenessRequest > SERVER_KNOBS->GRV_READ_VERSION_LEASE_IDLE_TIMEOUT ||
+		    now() - grvProxyData->readVersionLeaseTime < SERVER_KNOBS->GRV_READ_VERSION_LEASE_REFRESH_INTERVAL) {
+			continue;
+		}
+		++grvProxyData->stats.readVersionLeaseRefreshes;
+		wait(success(getLiveCommittedVersion(
+		    std::vector<SpanContext>(), grvProxyData, 0, Optional<UID>(), 0, 0, 0, 0)));
+	}
+}
+
 // Returns the current read version (or minimum known committed version if requested),
 // to each request in the provided list. Also check if the request should be throttled.
 // Update GRV statistics according to the request's priority.
@@ -933,14 +976,15 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy,
 		grvProxyData->stats.transactionLimit = normalRateInfo.getLimit();
 		grvProxyData->stats.batchTransactionLimit = batchRateInfo.getLimit();
 
-		int transactionsStarted[2] = { 0, 0 };
-		int systemTransactionsStarted[2] = { 0, 0 };
-		int defaultPriTransactionsStarted[2] = { 0, 0 };
-		int batchPriTransactionsStarted[2] = { 0, 0 };
+		int transactionsStarted[3] = { 0, 0, 0 };
+		int systemTransactionsStarted[3] = { 0, 0, 0 };
+		int defaultPriTransactionsStarted[3] = { 0, 0, 0 };
+		int batchPriTransactionsStarted[3] = { 0, 0, 0 };
 
 		std::vector<std::vector<GetReadVersionRequest>> start(
-		    2); // start[0] is transactions starting with !(flags&CAUSAL_READ_RISKY), start[1] is transactions starting
-		        // with flags&CAUSAL_READ_RISKY
+		    3); // start[0] is transactions starting with !(flags&CAUSAL_READ_RISKY), start[1] is transactions starting
+		        // with flags&CAUSAL_READ_RISKY, start[2] is transactions answered from the read version lease
+		const int leased = 2;
 		Optional<UID> debugID;
 
 		int requestsToStart = 0;
@@ -962,11 +1006,10 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy,
 			auto& req = transactionQueue->front();
 			int tc = req.transactionCount;
 
-			if (req.priority < TransactionPriority::DEFAULT &&
-			    !batchRateInfo.canStart(transactionsStarted[0] + transactionsStarted[1], tc)) {
+			const int totalStarted = transactionsStarted[0] + transactionsStarted[1] + transactionsStarted[leased];
+			if (req.priority < TransactionPriority::DEFAULT && !batchRateInfo.canStart(totalStarted, tc)) {
 				break;
-			} else if (req.priority < TransactionPriority::IMMEDIATE &&
-			           !normalRateInfo.canStart(transactionsStarted[0] + transactionsStarted[1], tc)) {
+			} else if (req.priority < TransactionPriority::IMMEDIATE && !normalRateInfo.canStart(totalStarted, tc)) {
 				break;
 			}
 
@@ -976,24 +1019,28 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy,
 				g_traceBatch.addAttach("TransactionAttachID", req.debugID.get().first(), debugID.get().first());
 			}
 
-			transactionsStarted[req.flags & 1] += tc;
+			if (req.flags & GetReadVersionRequest::FLAG_BOUNDED_STALENESS) {
+				grvProxyData->lastBoundedStalenessRequest = now();
+			}
+			const int group = grvProxyData->canUseReadVersionLease(req) ? leased : req.flags & 1;
+			transactionsStarted[group] += tc;
 			double currentTime = g_network->timer();
 			if (req.priority >= TransactionPriority::IMMEDIATE) {
-				systemTransactionsStarted[req.flags & 1] += tc;
+				systemTransactionsStarted[group] += tc;
 				--grvProxyData->stats.systemGRVQueueSize;
 			} else if (req.priority >= TransactionPriority::DEFAULT) {
-				defaultPriTransactionsStarted[req.flags & 1] += tc;
+				defaultPriTransactionsStarted[group] += tc;
 				grvProxyData->stats.defaultTxnGRVTimeInQueue.addMeasurement(currentTime - req.requestTime());
 				--grvProxyData->stats.defaultGRVQueueSize;
 			} else {
-				batchPriTransactionsStarted[req.flags & 1] += tc;
+				batchPriTransactionsStarted[group] += tc;
 				grvProxyData->stats.batchTxnGRVTimeInQueue.addMeasurement(currentTime - req.requestTime());
 				--grvProxyData->stats.batchGRVQueueSize;
 			}
 			for (auto tag : req.tags) {
 				transactionTagCounter[tag.first] += tag.second;
 			}
-			start[req.flags & 1].push_back(std::move(req));
+			start[group].push_back(std::move(req));
 			static_assert(GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY == 1, "Implementation dependent on flag value");
 			transactionQueue->pop_front();
 			requestsToStart++;
@@ -1033,11 +1080,14 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy,
 		.detail("TransactionBudget", transactionBudget)
 		.detail("BatchTransactionBudget", batchTransactionBudget);*/
 
-		int systemTotalStarted = systemTransactionsStarted[0] + systemTransactionsStarted[1];
-		int normalTotalStarted = defaultPriTransactionsStarted[0] + defaultPriTransactionsStarted[1];
-		int batchTotalStarted = batchPriTransactionsStarted[0] + batchPriTransactionsStarted[1];
+		int systemTotalStarted =
+		    systemTransactionsStarted[0] + systemTransactionsStarted[1] + systemTransactionsStarted[leased];
+		int normalTotalStarted =
+		    defaultPriTransactionsStarted[0] + defaultPriTransactionsStarted[1] + defaultPriTransactionsStarted[leased];
+		int batchTotalStarted =
+		    batchPriTransactionsStarted[0] + batchPriTransactionsStarted[1] + batchPriTransactionsStarted[leased];
 
-		transactionCount += transactionsStarted[0] + transactionsStarted[1];
+		transactionCount += transactionsStarted[0] + transactionsStarted[1] + transactionsStarted[leased];
 		batchTransactionCount += batchTotalStarted;
 
 		normalRateInfo.endReleaseWindow(
@@ -1062,14 +1112,24 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy,
 					spanContexts.push_back(request.spanContext);
 				}
 
-				Future<GetReadVersionReply> readVersionReply = getLiveCommittedVersion(spanContexts,
-				                                                                       grvProxyData,
-				                                                                       i,
-				                                                                       debugID,
-				                                                                       transactionsStarted[i],
-				                                                                       systemTransactionsStarted[i],
-				                                                                       defaultPriTransactionsStarted[i],
-				                                                                       batchPriTransactionsStarted[i]);
+				Future<GetReadVersionReply> readVersionReply;
+				if (i == leased) {
+					readVersionReply = grvProxyData->readVersionLease.get();
+					grvProxyData->stats.txnStartLeased += transactionsStarted[i];
+					grvProxyData->stats.txnStartOut += transactionsStarted[i];
+					grvProxyData->stats.txnSystemPriorityStartOut += systemTransactionsStarted[i];
+					grvProxyData->stats.txnDefaultPriorityStartOut += defaultPriTransactionsStarted[i];
+					grvProxyData->stats.txnBatchPriorityStartOut += batchPriTransactionsStarted[i];
+				} else {
+					readVersionReply = getLiveCommittedVersion(spanContexts,
+					                                           grvProxyData,
+					                                           i,
+					                                           debugID,
+					                                           transactionsStarted[i],
+					                                           systemTransactionsStarted[i],
+					                                           defaultPriTransactionsStarted[i],
+					                                           batchPriTransactionsStarted[i]);
+				}
 				addActor.send(sendGrvReplies(readVersionReply,
 				                             start[i],
 				                             grvProxyData,
@@ -1129,6 +1189,7 @@ ACTOR Future<Void> grvProxyServerCore(GrvProxyInterface proxy,
 	    proxy, grvProxyData.db, addActor, &grvProxyData, &healthMetricsReply, &detailedHealthMetricsReply));
 	addActor.send(healthMetricsRequestServer(proxy, &healthMetricsReply, &detailedHealthMetricsReply));
 	addActor.send(globalConfigRequestServer(&grvProxyData, proxy));
+	addActor.send(refreshReadVersionLease(&grvProxyData));
 
 	if (SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > 0) {
 		addActor.send(lastCommitUpdater(&grvProxyData, addActor));
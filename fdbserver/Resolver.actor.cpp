@@ -336,7 +336,10 @@ ACTOR Future<Void> resolveBatch(Reference<Resolver> self,
 		ConflictBatch conflictBatch(self->conflictSet, &reply.conflictingKeyRangeMap, &reply.arena);
 		const Version newOldestVersion = req.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS;
 		for (int t = 0; t < req.transactions.size(); t++) {
-			conflictBatch.addTransaction(req.transactions[t], newOldestVersion);
+			conflictBatch.addTransaction(req.transactions[t],
+			                             newOldestVersion,
+			                             req.pipelineLeaders.empty() ? ConflictBatch::NoPipelineLeader
+			                                                         : req.pipelineLeaders[t]);
 			self->resolvedReadConflictRanges += req.transactions[t].read_conflict_ranges.size();
 			self->resolvedWriteConflictRanges += req.transactions[t].write_conflict_ranges.size();
 
@@ -33,6 +33,7 @@
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbclient/SystemData.h"
 #include "fdbserver/ConflictSet.h"
+#include "flow/UnitTest.h"
 
 static std::vector<PerfDoubleCounter*> skc;
 
@@ -814,6 +815,7 @@ struct TransactionInfo {
 	VectorRef<std::pair<int, int>> writeRanges;
 	bool tooOld;
 	bool reportConflictingKeys;
+	int pipelineLeader;
 };
 
 bool ConflictBatch::ignoreTooOld() const {
@@ -828,12 +830,14 @@ bool ConflictBatch::ignoreWriteSet() const {
 	return bugs && deterministicRandom()->random01() < bugs->ignoreWriteSetProbability;
 }
 
-void ConflictBatch::addTransaction(const CommitTransactionRef& tr, Version newOldestVersion) {
+void ConflictBatch::addTransaction(const CommitTransactionRef& tr, Version newOldestVersion, int pipelineLeader) {
 	const int t = transactionCount++;
+	ASSERT(pipelineLeader < t);
 
 	Arena& arena = transactionInfo.arena();
 	TransactionInfo* info = new (arena) TransactionInfo;
 	info->reportConflictingKeys = tr.report_conflicting_keys;
+	info->pipelineLeader = pipelineLeader;
 	bool tooOld = tr.read_snapshot < newOldestVersion && tr.read_conflict_ranges.size();
 	if (tooOld && ignoreTooOld()) {
 		bugs->hit();
@@ -916,6 +920,11 @@ void ConflictBatch::checkIntraBatchConflicts() {
 				break;
 			}
 		}
+		// A pipelined follower's leader is ahead of it, so its status is final. Aborting the follower here keeps its
+		// writes out of the conflict history, and reports no conflicting keys for it.
+		if (!conflict && tr.pipelineLeader != NoPipelineLeader) {
+			conflict = tr.pipelineLeader == MissingPipelineLeader || transactionConflictStatus[tr.pipelineLeader];
+		}
 		transactionConflictStatus[t] = conflict;
 		if (!conflict)
 			for (int i = 0; i < tr.writeRanges.size(); i++)
@@ -1200,3 +1209,67 @@ void skipListTest() {
 
 	printf("%d entries in version history\n", cs->versionHistory.count());
 }
+
+namespace {
+// Returns a transaction that reads and writes the given keys, if present
+CommitTransactionRef pipelineTestTransaction(Arena& arena,
+                                             Version readSnapshot,
+                                             Optional<KeyRef> read,
+                                             Optional<KeyRef> write) {
+	CommitTransactionRef tr;
+	tr.read_snapshot = readSnapshot;
+	if (read.present()) {
+		tr.read_conflict_ranges.push_back(arena, singleKeyRange(read.get(), arena));
+	}
+	if (write.present()) {
+		tr.write_conflict_ranges.push_back(arena, singleKeyRange(write.get(), arena));
+	}
+	return tr;
+}
+
+// Resolves the transactions, each with its pipeline leader, as one batch and returns the committed ones' indices
+std::vector<int> resolvePipelineTestBatch(ConflictSet* cs,
+                                          Version version,
+                                          std::vector<std::pair<CommitTransactionRef, int>> const& trs) {
+	ConflictBatch batch(cs);
+	for (const auto& [tr, pipelineLeader] : trs) {
+		batch.addTransaction(tr, 0, pipelineLeader);
+	}
+	std::vector<int> nonConflicting;
+	batch.detectConflicts(version, 0, nonConflicting);
+	return nonConflicting;
+}
+} // namespace
+
+TEST_CASE("/fdbserver/ConflictBatch/PipelinedFollower") {
+	ConflictSet* cs = newConflictSet();
+	Arena arena;
+	const int none = ConflictBatch::NoPipelineLeader;
+
+	ASSERT(resolvePipelineTestBatch(cs, 10, { { pipelineTestTransaction(arena, 0, {}, "a"_sr), none } }) ==
+	       std::vector<int>{ 0 });
+
+	// The leader at 0 read "a" before it was written, so it conflicts, and its followers at 1 and 2 conflict with it.
+	// So does the follower at 3, whose leader isn't in the batch. The followers of the leader at 4 commit with it.
+	std::vector<std::pair<CommitTransactionRef, int>> batch = {
+		{ pipelineTestTransaction(arena, 5, "a"_sr, "b"_sr), none },
+		{ pipelineTestTransaction(arena, 5, {}, "c"_sr), 0 },
+		{ pipelineTestTransaction(arena, 5, {}, "d"_sr), 1 },
+		{ pipelineTestTransaction(arena, 5, {}, "e"_sr), ConflictBatch::MissingPipelineLeader },
+		{ pipelineTestTransaction(arena, 15, "a"_sr, "f"_sr), none },
+		{ pipelineTestTransaction(arena, 15, {}, "g"_sr), 4 },
+		{ pipelineTestTransaction(arena, 15, {}, "h"_sr), 5 },
+	};
+	ASSERT(resolvePipelineTestBatch(cs, 20, batch) == std::vector<int>({ 4, 5, 6 }));
+
+	// Only the committed transactions' writes are in the conflict history, so only reading those from before the
+	// batch conflicts
+	batch.clear();
+	for (KeyRef key : { "b"_sr, "c"_sr, "d"_sr, "e"_sr, "f"_sr, "g"_sr, "h"_sr }) {
+		batch.emplace_back(pipelineTestTransaction(arena, 15, key, {}), none);
+	}
+	ASSERT(resolvePipelineTestBatch(cs, 30, batch) == std::vector<int>({ 0, 1, 2, 3 }));
+
+	destroyConflictSet(cs);
+	return Void();
+}
@@ -665,8 +665,9 @@ static void printUsage(const char* name, bool devhelp) {
 	                 " Sets the LogGroup field with the specified value for all"
 	                 " events in the trace output (defaults to `default').");
 	printOptionUsage("--trace-format FORMAT",
-	                 " Select the format of the log files. xml (the default) and json"
-	                 " are supported.");
+	                 " Select the format of the log files. xml (the default), json"
+	                 " and binary are supported. Binary log files can be converted to"
+	                 " xml or json with traceconvert.");
 	printOptionUsage("--tracer       TRACER",
 	                 " Select a tracer for transaction tracing. Currently disabled"
 	                 " (the default) and log_file are supported.");
@@ -0,0 +1,111 @@
+/*
+ * CommitBatchController.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "fdbrpc/DDSketch.h"
+
+// Used by the commit proxy to choose the commit batching interval and batch size when
+// COMMIT_BATCH_ADAPTIVE_CONTROL is enabled.
+//
+// The controller observes the end-to-end latency of every committed transaction, the resolution and TLog
+// logging latency of every batch, and how many of the proxy's batches are in flight when each one finishes. Once per
+// control window it compares the p99 commit latency against COMMIT_BATCH_TARGET_P99_LATENCY and looks for downstream
+// queueing, in the style of BBR: the median resolution + logging latency is compared against the smallest value seen
+// over the recent windows, which approximates the unloaded pipeline latency.
+//
+// - If the p99 commit latency misses the target while the pipeline is queueing or many batches are in flight, the
+//   interval is held: the miss comes from load, and smaller batches would only lower throughput and lengthen the
+//   queues.
+// - Else if it misses the target, the interval is cut multiplicatively and the batch size halved.
+// - Else if resolvers or TLogs are queueing, the interval grows so that their per-batch work is amortized over more
+//   transactions, trading latency headroom for throughput.
+// - Else if the p99 commit latency is comfortably below the target, the interval decays toward the minimum and the
+//   batch size recovers additively. The interval does not decay below the one that last ended the queueing until
+//   that floor has held for COMMIT_BATCH_CONTROL_HISTORY windows, after which the floor is lowered a step.
+//
+// Latencies within COMMIT_BATCH_CONTROL_DEAD_BAND of the target count as neither a miss nor comfortable, and the
+// interval only moves opposite to its last move once COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS windows in a row call for
+// it, so that the controller settles instead of oscillating. The interval never exceeds the latency left for batching
+// once the p99 pipeline latency is subtracted from the target.
+class CommitBatchController {
+public:
+	// Totals over every controller in the process, which in simulation is every commit proxy's
+	struct Stats {
+		int64_t windows = 0;
+		int64_t reversals = 0; // Moves of the interval opposite to the move before
+	};
+	static Stats& processStats();
+
+	explicit CommitBatchController(double initialInterval);
+
+	void addCommitLatency(double latency) { commitLatency.addSample(latency); }
+	void addResolutionLatency(double latency) { resolutionLatency.addSample(latency); }
+	void addLoggingLatency(double latency) { loggingLatency.addSample(latency); }
+	void addBatchesInFlight(int64_t batches) {
+		batchesInFlightSum += batches;
+		batchesInFlightSamples++;
+	}
+
+	// Closes the control window if it has lasted COMMIT_BATCH_CONTROL_WINDOW and enough samples were collected, and
+	// recomputes the interval and batch size. Returns true if the window was closed.
+	bool update(double now);
+
+	double getBatchInterval() const { return batchInterval; }
+
+	// Returns the batch size limit in bytes, given the configured upper limit.
+	int getBatchBytesLimit(int desiredBytes) const;
+	double getBatchSizeFraction() const { return sizeFraction; }
+
+	double getCommitP99() const { return lastCommitP99; }
+	double getPipelineMedian() const { return lastPipelineMedian; }
+	double getPipelineBaseline() const { return lastPipelineBaseline; }
+	double getBatchesInFlight() const { return lastBatchesInFlight; }
+
+private:
+	double batchInterval;
+	double sizeFraction{ 1.0 };
+	double windowStart{ 0.0 };
+
+	DDSketch<double> commitLatency;
+	DDSketch<double> resolutionLatency;
+	DDSketch<double> loggingLatency;
+	int64_t batchesInFlightSum{ 0 };
+	int64_t batchesInFlightSamples{ 0 };
+	// Median pipeline latency of the most recent windows, oldest first
+	std::deque<double> pipelineHistory;
+
+	// The direction of the last move of the interval (1 up, -1 down, 0 before the first), and for how many windows in
+	// a row the opposite move has been called for
+	int lastDirection{ 0 };
+	int opposingWindows{ 0 };
+	// The interval that last ended downstream queueing, below which it does not decay, and for how many windows the
+	// floor has held the interval
+	double intervalFloor{ 0.0 };
+	int windowsAtFloor{ 0 };
+
+	// Last window's measurements, for tracing
+	double lastCommitP99{ 0.0 };
+	double lastPipelineMedian{ 0.0 };
+	double lastPipelineBaseline{ 0.0 };
+	double lastBatchesInFlight{ 0.0 };
+};
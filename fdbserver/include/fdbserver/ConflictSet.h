@@ -46,7 +46,15 @@ struct ConflictBatch {
 		TransactionCommitted,
 	};
 
-	void addTransaction(const CommitTransactionRef& transaction, Version newOldestVersion);
+	// Values of addTransaction()'s pipelineLeader other than the index of a transaction added earlier
+	static constexpr int NoPipelineLeader = -1;
+	static constexpr int MissingPipelineLeader = -2;
+
+	// pipelineLeader is the index in this batch of the transaction that this one is pipelined behind, if any. The
+	// transaction then conflicts if its leader does, and always if the leader is MissingPipelineLeader.
+	void addTransaction(const CommitTransactionRef& transaction,
+	                    Version newOldestVersion,
+	                    int pipelineLeader = NoPipelineLeader);
 	void detectConflicts(Version now,
 	                     Version newOldestVersion,
 	                     std::vector<int>& nonConflicting,
@@ -27,15 +27,18 @@
 
 #include "fdbclient/FDBTypes.h"
 #include "fdbclient/GetEncryptCipherKeys.h"
+#include "fdbclient/StorageTagIndex.h"
 #include "fdbclient/Tenant.h"
 #include "fdbrpc/Stats.h"
 #include "fdbserver/AccumulativeChecksumUtil.h"
+#include "fdbserver/CommitBatchController.h"
 #include "fdbserver/Knobs.h"
 #include "fdbserver/LogSystem.h"
 #include "fdbserver/LogSystemDiskQueueAdapter.h"
 #include "fdbserver/MasterInterface.h"
 #include "fdbserver/ResolverInterface.h"
 #include "flow/IRandom.h"
+#include "flow/IThreadPool.h"
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -184,14 +187,18 @@ struct ProxyStats {
 	}
 };
 
-struct ExpectedIdempotencyIdCountForKey {
+// The idempotency ids written by a commit batch, by the high order byte of their batch index. Sent for batches
+// without idempotency ids too while ids are in use, see IdempotencyIdExpiry.
+struct ExpectedIdempotencyIdCounts {
+	Version prevVersion = invalidVersion;
 	Version commitVersion = invalidVersion;
-	int16_t idempotencyIdCount = 0;
-	uint8_t batchIndexHighByte = 0;
+	std::vector<std::pair<uint8_t, int16_t>> idCounts;
 
-	ExpectedIdempotencyIdCountForKey() {}
-	ExpectedIdempotencyIdCountForKey(Version commitVersion, int16_t idempotencyIdCount, uint8_t batchIndexHighByte)
-	  : commitVersion(commitVersion), idempotencyIdCount(idempotencyIdCount), batchIndexHighByte(batchIndexHighByte) {}
+	ExpectedIdempotencyIdCounts() {}
+	ExpectedIdempotencyIdCounts(Version prevVersion,
+	                            Version commitVersion,
+	                            std::vector<std::pair<uint8_t, int16_t>> idCounts)
+	  : prevVersion(prevVersion), commitVersion(commitVersion), idCounts(std::move(idCounts)) {}
 };
 
 struct ProxyCommitData {
@@ -222,6 +229,7 @@ struct ProxyCommitData {
 	// only tracks normalKeys. This is used for tracking versions for systemKeys.
 	Deque<Version> systemKeyVersions;
 	KeyRangeMap<ServerCacheInfo> keyInfo; // keyrange -> all storage servers in all DCs for the keyrange
+	StorageTagIndex keyInfoTagIndex;
 	KeyRangeMap<bool> cacheInfo;
 	std::map<Key, ApplyMutationsData> uid_applyMutationsData;
 	bool firstProxy;
@@ -229,6 +237,7 @@ struct ProxyCommitData {
 	bool locked;
 	Optional<Value> metadataVersion;
 	double commitBatchInterval;
+	CommitBatchController commitBatchController;
 	bool provisional;
 
 	int64_t localCommitBatchesStarted;
@@ -265,9 +274,14 @@ struct ProxyCommitData {
 
 	EncryptionAtRestMode encryptMode;
 	Reference<GetEncryptCipherKeysMonitor> encryptionMonitor;
+	// Threads that encrypt a batch's mutations ahead of assignMutationsToStorageServers(), see
+	// PROXY_ENCRYPTION_THREADS. Not valid when mutations are encrypted on the network thread.
+	Reference<IThreadPool> encryptionThreads;
 
-	PromiseStream<ExpectedIdempotencyIdCountForKey> expectedIdempotencyIdCountForKey;
+	PromiseStream<ExpectedIdempotencyIdCounts> expectedIdempotencyIdCounts;
 	Standalone<VectorRef<MutationRef>> idempotencyClears;
+	// When a commit batch last wrote idempotency ids
+	double lastIdempotencyIdBatchTime = 0;
 
 	AsyncVar<bool> triggerCommit;
 
@@ -279,6 +293,9 @@ struct ProxyCommitData {
 	// more CPU efficient. When a tag related to a storage server does change, we empty out all of these vectors to
 	// signify they must be repopulated. We do not repopulate them immediately to avoid a slow task.
 	const std::vector<Tag>& tagsForKey(StringRef key) {
+		if (SERVER_KNOBS->PROXY_USE_FLAT_TAG_INDEX) {
+			return tagIndex().tagsForKey(key);
+		}
 		auto& tags = keyInfo[key].tags;
 		if (!tags.size()) {
 			auto& r = keyInfo.rangeContaining(key).value();
@@ -288,6 +305,15 @@ struct ProxyCommitData {
 		return tags;
 	}
 
+	// The flat copy of keyInfo used when PROXY_USE_FLAT_TAG_INDEX is set. keyInfoTagIndex must be updated or
+	// invalidated whenever keyInfo's boundaries or tags change; once invalidated, it is rebuilt on the next lookup.
+	const StorageTagIndex& tagIndex() {
+		if (!keyInfoTagIndex.isValid()) {
+			keyInfoTagIndex.rebuild(keyInfo);
+		}
+		return keyInfoTagIndex;
+	}
+
 	bool needsCacheTag(KeyRangeRef range) {
 		auto ranges = cacheInfo.intersectingRanges(range);
 		for (auto r : ranges) {
@@ -350,6 +376,7 @@ struct ProxyCommitData {
 	    mostRecentProcessedRequestNumber(0), firstProxy(firstProxy), encryptMode(encryptMode),
 	    encryptionMonitor(makeReference<GetEncryptCipherKeysMonitor>()), provisional(provisional), lastCoalesceTime(0),
 	    locked(false), commitBatchInterval(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN),
+	    commitBatchController(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN),
 	    localCommitBatchesStarted(0), getConsistentReadVersion(getConsistentReadVersion), commit(commit),
 	    cx(openDBOnServer(db, TaskPriority::DefaultEndpoint, LockAware::True)), db(db),
 	    singleKeyMutationEvent("SingleKeyMutation"_sr), lastTxsPop(0), popRemoteTxs(false), lastStartCommit(0),
@@ -133,6 +133,9 @@ struct ResolveTransactionBatchRequest : TimedRequest {
 	VectorRef<struct CommitTransactionRef> transactions;
 	VectorRef<int>
 	    txnStateTransactions; // Offsets of elements of transactions that have (transaction subsystem state) mutations
+	// For each element of transactions, the offset of the one it is pipelined behind, or one of ConflictBatch's other
+	// pipeline leader values. Empty if no transaction in the batch is pipelined.
+	VectorRef<int> pipelineLeaders;
 	ReplyPromise<ResolveTransactionBatchReply> reply;
 	Optional<UID> debugID;
 
@@ -150,6 +153,7 @@ struct ResolveTransactionBatchRequest : TimedRequest {
 		           debugID,
 		           writtenTags,
 		           spanContext,
+		           pipelineLeaders,
 		           arena);
 	}
 };
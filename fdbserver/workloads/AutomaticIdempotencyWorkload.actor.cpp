@@ -162,20 +162,12 @@ struct AutomaticIdempotencyWorkload : TestWorkload {
 			Version commitVersion;
 			uint8_t highOrderBatchIndex;
 			decodeIdempotencyKey(k, commitVersion, highOrderBatchIndex);
-			BinaryReader valReader(v, IncludeVersion());
-			int64_t timestamp; // ignored
-			valReader >> timestamp;
-			while (!valReader.empty()) {
-				uint8_t length;
-				valReader >> length;
-				StringRef id{ reinterpret_cast<const uint8_t*>(valReader.readBytes(length)), length };
-				uint8_t lowOrderBatchIndex;
-				valReader >> lowOrderBatchIndex;
+			decodeIdempotencyIdValue(v, [&](StringRef id, uint8_t lowOrderBatchIndex) {
 				TraceEvent("IdempotencyIdWorkloadIdCommitted")
 				    .detail("CommitVersion", commitVersion)
 				    .detail("HighOrderBatchIndex", highOrderBatchIndex)
 				    .detail("Id", id);
-			}
+			});
 		}
 		return Void();
 	}
@@ -217,17 +209,8 @@ struct AutomaticIdempotencyWorkload : TestWorkload {
 		uint8_t highOrderBatchIndex;
 		decodeIdempotencyKey(kv.key, *commitVersion, highOrderBatchIndex);
 
-		BinaryReader valReader(kv.value.begin(), kv.value.size(), IncludeVersion());
-		valReader >> *timestamp;
-
 		std::vector<Key> keys;
-		while (!valReader.empty()) {
-			uint8_t length;
-			valReader >> length;
-			StringRef id{ reinterpret_cast<const uint8_t*>(valReader.readBytes(length)), length };
-			uint8_t lowOrderBatchIndex;
-			valReader >> lowOrderBatchIndex;
-
+		*timestamp = decodeIdempotencyIdValue(kv.value, [&](StringRef id, uint8_t lowOrderBatchIndex) {
 			// Recover the key written in the transaction associated with this idempotency id
 			BinaryWriter keyWriter(Unversioned());
 			keyWriter.serializeBytes(keyPrefix);
@@ -236,7 +219,7 @@ struct AutomaticIdempotencyWorkload : TestWorkload {
 			keyWriter.serializeBinaryItem(lowOrderBatchIndex);
 
 			keys.push_back(keyWriter.toValue());
-		}
+		});
 
 		ASSERT(!keys.empty());
 		return keys;
@@ -0,0 +1,157 @@
+/*
+ * CommitLoadSweep.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbrpc/DDSketch.h"
+#include "fdbserver/CommitBatchController.h"
+#include "fdbserver/Knobs.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// Offers an increasing open-loop commit load, one step at a time, and reports the throughput and commit latency
+// percentiles achieved at each step. Used to evaluate commit batching policies such as COMMIT_BATCH_ADAPTIVE_CONTROL.
+struct CommitLoadSweepWorkload : TestWorkload {
+	static constexpr auto NAME = "CommitLoadSweep";
+
+	struct Step {
+		double offeredRate = 0;
+		int64_t committed = 0;
+		int64_t errors = 0;
+		DDSketch<double> latency;
+	};
+
+	double startRate;
+	double rateMultiplier;
+	int stepCount;
+	double stepDuration;
+	int writesPerTransaction;
+	int valueBytes;
+	int nodeCount;
+	Key keyPrefix;
+	// Largest fraction of control windows in which the adaptive batch interval may reverse direction
+	double maxReversalFraction;
+
+	std::vector<Step> steps;
+
+	CommitLoadSweepWorkload(WorkloadContext const& wcx) : TestWorkload(wcx) {
+		// Rates are per cluster and split evenly across clients
+		startRate = getOption(options, "startRate"_sr, 100.0) / clientCount;
+		rateMultiplier = getOption(options, "rateMultiplier"_sr, 2.0);
+		stepCount = getOption(options, "stepCount"_sr, 5);
+		stepDuration = getOption(options, "stepDuration"_sr, 10.0);
+		writesPerTransaction = getOption(options, "writesPerTransaction"_sr, 5);
+		valueBytes = getOption(options, "valueBytes"_sr, 100);
+		nodeCount = getOption(options, "nodeCount"_sr, 10000);
+		keyPrefix = getOption(options, "keyPrefix"_sr, "commitLoadSweep/"_sr);
+		maxReversalFraction = getOption(options, "maxReversalFraction"_sr, 0.25);
+		steps.resize(stepCount);
+	}
+
+	Key keyForIndex(int index) const { return Key(format("%08d", index)).withPrefix(keyPrefix); }
+
+	Future<Void> setup(Database const& cx) override { return Void(); }
+
+	Future<Void> start(Database const& cx) override { return _start(cx, this); }
+
+	ACTOR static Future<Void> commitOne(Database cx, CommitLoadSweepWorkload* self, Step* step) {
+		state Transaction tr(cx);
+		state double start = now();
+		loop {
+			try {
+				for (int i = 0; i < self->writesPerTransaction; i++) {
+					tr.set(self->keyForIndex(deterministicRandom()->randomInt(0, self->nodeCount)),
+					       deterministicRandom()->randomAlphaNumeric(self->valueBytes));
+				}
+				wait(tr.commit());
+				++step->committed;
+				step->latency.addSample(now() - start);
+				return Void();
+			} catch (Error& e) {
+				++step->errors;
+				wait(tr.onError(e));
+			}
+		}
+	}
+
+	ACTOR static Future<Void> runStep(Database cx, CommitLoadSweepWorkload* self, Step* step) {
+		state double end = now() + self->stepDuration;
+		state std::vector<Future<Void>> inFlight;
+		// Open loop: transactions are started at the offered rate regardless of how many are still committing
+		while (now() < end) {
+			inFlight.push_back(commitOne(cx, self, step));
+			wait(delay(-log(deterministicRandom()->random01()) / step->offeredRate));
+		}
+		wait(waitForAll(inFlight));
+		return Void();
+	}
+
+	ACTOR static Future<Void> _start(Database cx, CommitLoadSweepWorkload* self) {
+		state int i = 0;
+		state double rate = self->startRate;
+		for (; i < self->stepCount; i++) {
+			state Step* step = &self->steps[i];
+			step->offeredRate = rate;
+			state double stepStart = now();
+			wait(runStep(cx, self, step));
+			TraceEvent("CommitLoadSweepStep")
+			    .detail("ClientId", self->clientId)
+			    .detail("Step", i)
+			    .detail("OfferedRate", step->offeredRate)
+			    .detail("AchievedRate", step->committed / (now() - stepStart))
+			    .detail("Errors", step->errors)
+			    .detail("P50", step->latency.percentile(0.5))
+			    .detail("P99", step->latency.percentile(0.99))
+			    .detail("AdaptiveBatching", SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL);
+			rate *= self->rateMultiplier;
+		}
+		return Void();
+	}
+
+	Future<bool> check(Database const& cx) override {
+		for (const auto& step : steps) {
+			if (step.committed == 0) {
+				TraceEvent(SevError, "CommitLoadSweepNoProgress").detail("OfferedRate", step.offeredRate);
+				return false;
+			}
+		}
+		// In simulation the commit proxies run in this process, so whether their batch intervals settled can be checked
+		if (SERVER_KNOBS->COMMIT_BATCH_ADAPTIVE_CONTROL && g_network->isSimulated() && clientId == 0) {
+			const auto& stats = CommitBatchController::processStats();
+			if (stats.reversals * SERVER_KNOBS->COMMIT_BATCH_CONTROL_CONFIRM_WINDOWS >
+			    stats.windows * maxReversalFraction) {
+				TraceEvent(SevError, "CommitLoadSweepBatchIntervalOscillating")
+				    .detail("Windows", stats.windows)
+				    .detail("Reversals", stats.reversals);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		for (int i = 0; i < steps.size(); i++) {
+			m.emplace_back(format("Step%d Commits/sec", i), steps[i].committed / stepDuration, Averaged::False);
+			m.emplace_back(format("Step%d P99 Commit Latency", i), steps[i].latency.percentile(0.99), Averaged::True);
+		}
+	}
+};
+
+WorkloadFactory<CommitLoadSweepWorkload> CommitLoadSweepWorkloadFactory;
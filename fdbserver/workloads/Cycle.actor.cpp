@@ -56,6 +56,8 @@ struct CycleWorkload : TestWorkload, CycleMembers<MultiTenancy> {
 	static constexpr auto NAME = MultiTenancy ? "TenantCycle" : "Cycle";
 	static constexpr auto TenantEnabled = MultiTenancy;
 	int actorCount, nodeCount;
+	int64_t readVersionMaxStalenessMs;
+	int64_t sharedReadVersionMaxAgeMs;
 	double testDuration, transactionsPerSecond, minExpectedTransactionsPerSecond, traceParentProbability;
 	Key keyPrefix;
 
@@ -72,6 +74,8 @@ struct CycleWorkload : TestWorkload, CycleMembers<MultiTenancy> {
 		nodeCount = getOption(options, "nodeCount"_sr, transactionsPerSecond * clientCount);
 		keyPrefix = unprintable(getOption(options, "keyPrefix"_sr, ""_sr).toString());
 		traceParentProbability = getOption(options, "traceParentProbability"_sr, 0.01);
+		readVersionMaxStalenessMs = getOption(options, "readVersionMaxStalenessMs"_sr, (int64_t)0);
+		sharedReadVersionMaxAgeMs = getOption(options, "sharedReadVersionMaxAgeMs"_sr, (int64_t)0);
 		minExpectedTransactionsPerSecond = transactionsPerSecond * getOption(options, "expectedRate"_sr, 0.7);
 		if constexpr (MultiTenancy) {
 			ASSERT(g_network->isSimulated());
@@ -160,6 +164,14 @@ struct CycleWorkload : TestWorkload, CycleMembers<MultiTenancy> {
 					tr.setOption(FDBTransactionOptions::SPAN_PARENT,
 					             BinaryWriter::toValue(span.context, IncludeVersion()));
 				}
+				if (self->readVersionMaxStalenessMs > 0 && deterministicRandom()->coinflip()) {
+					tr.setOption(FDBTransactionOptions::READ_VERSION_MAX_STALENESS,
+					             StringRef((uint8_t*)&self->readVersionMaxStalenessMs, sizeof(int64_t)));
+				}
+				if (self->sharedReadVersionMaxAgeMs > 0 && deterministicRandom()->coinflip()) {
+					tr.setOption(FDBTransactionOptions::SHARE_READ_VERSION,
+					             StringRef((uint8_t*)&self->sharedReadVersionMaxAgeMs, sizeof(int64_t)));
+				}
 				while (true) {
 					try {
 						self->setAuthToken(tr);
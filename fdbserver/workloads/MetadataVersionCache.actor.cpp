@@ -0,0 +1,154 @@
+/*
+ * MetadataVersionCache.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbclient/SystemData.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// Tests the client read cache for METADATA_VERSION_CACHED_PREFIX prefixes. Each client caches a prefix of its own and
+// alternates between writing under it and reading it back. Some writes bump the metadata version and some, against
+// the rules for cached prefixes, don't. Reads served through the cache must match storage whenever every write since
+// the last bump was followed by one; after an unannounced write they may be stale, which is only counted.
+struct MetadataVersionCacheWorkload : TestWorkload {
+	static constexpr auto NAME = "MetadataVersionCache";
+
+	double testDuration;
+	int nodeCount;
+	double bumpProbability;
+	Key prefix;
+
+	// Whether the writes since the last metadata version bump, if any, were followed by one
+	bool mustMatch = true;
+	int64_t checkedReads = 0;
+	int64_t staleReads = 0;
+	bool failed = false;
+
+	MetadataVersionCacheWorkload(WorkloadContext const& wcx) : TestWorkload(wcx) {
+		testDuration = getOption(options, "testDuration"_sr, 30.0);
+		nodeCount = getOption(options, "nodeCount"_sr, 100);
+		bumpProbability = getOption(options, "bumpProbability"_sr, 0.7);
+		prefix = getOption(options, "prefix"_sr, "metadataVersionCache/"_sr).withSuffix(format("%04d/", clientId));
+	}
+
+	Key keyForIndex(int index) const { return Key(format("%04d", index)).withPrefix(prefix); }
+
+	Future<Void> setup(Database const& cx) override {
+		cx->setOption(FDBDatabaseOptions::METADATA_VERSION_CACHED_PREFIX, prefix);
+		return Void();
+	}
+
+	Future<Void> start(Database const& cx) override { return timeout(_start(cx, this), testDuration, Void()); }
+
+	ACTOR static Future<Void> write(Database cx, MetadataVersionCacheWorkload* self) {
+		state Transaction tr(cx);
+		state bool bump = deterministicRandom()->random01() < self->bumpProbability;
+		loop {
+			try {
+				int writes = deterministicRandom()->randomInt(1, 5);
+				for (int i = 0; i < writes; i++) {
+					Key key = self->keyForIndex(deterministicRandom()->randomInt(0, self->nodeCount));
+					if (deterministicRandom()->random01() < 0.2) {
+						tr.clear(key);
+					} else {
+						tr.set(key, deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(1, 50)));
+					}
+				}
+				if (bump) {
+					tr.atomicOp(metadataVersionKey, metadataVersionRequiredValue, MutationRef::SetVersionstampedValue);
+				}
+				wait(tr.commit());
+				break;
+			} catch (Error& e) {
+				wait(tr.onError(e));
+			}
+		}
+		// Even if the commit was retried after commit_unknown_result, every attempt made the same choice to bump
+		self->mustMatch = bump;
+		return Void();
+	}
+
+	ACTOR static Future<Void> read(Database cx, MetadataVersionCacheWorkload* self) {
+		state Transaction tr(cx);
+		state Key key = self->keyForIndex(deterministicRandom()->randomInt(0, self->nodeCount));
+		loop {
+			try {
+				// firstGreaterOrEqual on both ends goes through the cache, while firstGreaterThan(prefix), which
+				// selects the same rows since prefix itself is never written, reads storage at the same version
+				state RangeResult cached = wait(tr.getRange(prefixRange(self->prefix), CLIENT_KNOBS->TOO_MANY));
+				state Optional<Value> cachedValue = wait(tr.get(key));
+				RangeResult stored = wait(tr.getRange(firstGreaterThan(self->prefix),
+				                                      firstGreaterOrEqual(strinc(self->prefix)),
+				                                      CLIENT_KNOBS->TOO_MANY));
+				Optional<Value> storedValue;
+				for (const auto& kv : stored) {
+					if (kv.key == key) {
+						storedValue = kv.value;
+					}
+				}
+				bool match = cached.size() == stored.size() && !cached.more && !stored.more &&
+				             std::equal(cached.begin(), cached.end(), stored.begin()) && cachedValue == storedValue;
+				if (self->mustMatch) {
+					++self->checkedReads;
+					if (!match) {
+						TraceEvent(SevError, "MetadataVersionCacheStaleRead")
+						    .detail("Prefix", self->prefix)
+						    .detail("Key", key)
+						    .detail("ReadVersion", tr.getReadVersion().get())
+						    .detail("CachedRows", cached.size())
+						    .detail("StoredRows", stored.size());
+						self->failed = true;
+					}
+				} else if (!match) {
+					++self->staleReads;
+				}
+				return Void();
+			} catch (Error& e) {
+				wait(tr.onError(e));
+			}
+		}
+	}
+
+	ACTOR static Future<Void> _start(Database cx, MetadataVersionCacheWorkload* self) {
+		loop {
+			if (deterministicRandom()->coinflip()) {
+				wait(write(cx, self));
+			}
+			wait(read(cx, self));
+		}
+	}
+
+	Future<bool> check(Database const& cx) override {
+		TraceEvent("MetadataVersionCacheCheck")
+		    .detail("ClientId", clientId)
+		    .detail("CheckedReads", checkedReads)
+		    .detail("StaleReads", staleReads)
+		    .detail("CacheHits", cx->transactionMetadataVersionCacheHits.getValue());
+		return !failed;
+	}
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		m.emplace_back("Checked Reads", checkedReads, Averaged::False);
+		m.emplace_back("Stale Reads", staleReads, Averaged::False);
+	}
+};
+
+WorkloadFactory<MetadataVersionCacheWorkload> MetadataVersionCacheWorkloadFactory;
@@ -0,0 +1,153 @@
+/*
+ * PipelinedCommit.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// Pushes chains of transactions, each pipelined behind the previous one with Transaction::setPipelineLeader() and
+// committed without waiting for its leader's reply, the way a queue producer would. Each transaction records its
+// commit versionstamp under <prefix><chain>/<position>. Checks that a transaction in a chain only committed if the
+// one before it did, and at a later versionstamp.
+struct PipelinedCommitWorkload : TestWorkload {
+	static constexpr auto NAME = "PipelinedCommit";
+
+	double testDuration;
+	int actorCount;
+	int chainLength;
+	Key keyPrefix;
+
+	int64_t chains = 0;
+	int64_t committed = 0;
+	int64_t aborted = 0;
+
+	PipelinedCommitWorkload(WorkloadContext const& wcx) : TestWorkload(wcx) {
+		testDuration = getOption(options, "testDuration"_sr, 10.0);
+		actorCount = getOption(options, "actorCount"_sr, 5);
+		chainLength = getOption(options, "chainLength"_sr, 4);
+		keyPrefix = getOption(options, "keyPrefix"_sr, "pipelinedCommit/"_sr).withSuffix(format("%d/", clientId));
+	}
+
+	Future<Void> setup(Database const& cx) override { return Void(); }
+
+	Future<Void> start(Database const& cx) override {
+		std::vector<Future<Void>> clients;
+		for (int i = 0; i < actorCount; i++) {
+			clients.push_back(pushChains(cx, this));
+		}
+		return timeout(waitForAll(clients), testDuration, Void());
+	}
+
+	ACTOR static Future<Void> pushChain(Database cx, PipelinedCommitWorkload* self) {
+		state Key chainPrefix = self->keyPrefix.withSuffix(format("%016llx/", deterministicRandom()->randomUInt64()));
+		// Transactions keep a pointer to themselves while committing, so they must not move
+		state std::vector<std::unique_ptr<Transaction>> trs;
+		state std::vector<Future<Void>> commits;
+		for (int i = 0; i < self->chainLength; i++) {
+			trs.push_back(std::make_unique<Transaction>(cx));
+			if (i > 0) {
+				trs[i]->setPipelineLeader(*trs[i - 1]);
+			}
+			trs[i]->atomicOp(chainPrefix.withSuffix(format("%04d", i)),
+			                 "0123456789\x00\x00\x00\x00"_sr,
+			                 MutationRef::SetVersionstampedValue);
+			commits.push_back(trs[i]->commit());
+		}
+
+		state int next = 0;
+		for (; next < commits.size(); next++) {
+			try {
+				wait(commits[next]);
+				++self->committed;
+			} catch (Error& e) {
+				if (e.code() == error_code_actor_cancelled) {
+					throw;
+				}
+				// Chains aren't retried, the check only relies on what did commit
+				++self->aborted;
+			}
+		}
+		++self->chains;
+		return Void();
+	}
+
+	ACTOR static Future<Void> pushChains(Database cx, PipelinedCommitWorkload* self) {
+		loop {
+			wait(pushChain(cx, self));
+		}
+	}
+
+	ACTOR static Future<bool> _check(Database cx, PipelinedCommitWorkload* self) {
+		state Transaction tr(cx);
+		state RangeResult rows;
+		state Key begin = self->keyPrefix;
+		loop {
+			try {
+				RangeResult batch = wait(tr.getRange(KeyRangeRef(begin, strinc(self->keyPrefix)), 1000));
+				rows.append_deep(rows.arena(), batch.begin(), batch.size());
+				if (!batch.more) {
+					break;
+				}
+				begin = keyAfter(batch.back().key);
+			} catch (Error& e) {
+				wait(tr.onError(e));
+			}
+		}
+
+		// Rows are sorted by chain and then by position
+		bool ok = true;
+		for (int i = 0; i < rows.size(); i++) {
+			const KeyRef key = rows[i].key.removePrefix(self->keyPrefix);
+			const int position = atoi(key.substr(key.size() - 4).toString().c_str());
+			if (position == 0) {
+				continue;
+			}
+			const KeyRef previous = i > 0 ? rows[i - 1].key.removePrefix(self->keyPrefix) : KeyRef();
+			const bool leaderCommitted = previous.size() == key.size() &&
+			                             previous.substr(0, key.size() - 4) == key.substr(0, key.size() - 4) &&
+			                             atoi(previous.substr(key.size() - 4).toString().c_str()) == position - 1;
+			if (!leaderCommitted || !(rows[i - 1].value.substr(0, 10) < rows[i].value.substr(0, 10))) {
+				TraceEvent(SevError, "PipelinedCommitOrderViolated")
+				    .detail("Key", rows[i].key)
+				    .detail("LeaderCommitted", leaderCommitted);
+				ok = false;
+			}
+		}
+		TraceEvent("PipelinedCommitCheck")
+		    .detail("ClientId", self->clientId)
+		    .detail("Chains", self->chains)
+		    .detail("Committed", self->committed)
+		    .detail("Aborted", self->aborted)
+		    .detail("Rows", rows.size());
+		return ok;
+	}
+
+	Future<bool> check(Database const& cx) override { return _check(cx, this); }
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		m.emplace_back("Chains", chains, Averaged::False);
+		m.emplace_back("Committed", committed, Averaged::False);
+		m.emplace_back("Aborted", aborted, Averaged::False);
+		m.emplace_back("Commits/sec", committed / testDuration, Averaged::False);
+	}
+};
+
+WorkloadFactory<PipelinedCommitWorkload> PipelinedCommitWorkloadFactory;
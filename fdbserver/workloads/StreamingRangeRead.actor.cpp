@@ -32,13 +32,16 @@
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
-ACTOR Future<Void> streamUsingGetRange(PromiseStream<RangeResult> results, Transaction* tr, KeyRange keys) {
+ACTOR Future<Void> streamUsingGetRange(PromiseStream<RangeResult> results,
+                                       Transaction* tr,
+                                       KeyRange keys,
+                                       int byteLimit) {
 	state KeySelectorRef begin = firstGreaterOrEqual(keys.begin);
 	state KeySelectorRef end = firstGreaterOrEqual(keys.end);
 
 	try {
 		loop {
-			GetRangeLimits limits(GetRangeLimits::ROW_LIMIT_UNLIMITED, 1e6);
+			GetRangeLimits limits(GetRangeLimits::ROW_LIMIT_UNLIMITED, byteLimit);
 			limits.minRows = 0;
 			state RangeResult rep = wait(tr->getRange(begin, end, limits, Snapshot::True));
 
@@ -80,11 +83,14 @@ ACTOR Future<Void> convertStream(PromiseStream<RangeResult> input, PromiseStream
 struct StreamingRangeReadWorkload : KVWorkload {
 	static constexpr auto NAME = "StreamingRangeRead";
 	double testDuration;
+	// If set, the get range side of the comparison uses PARALLEL_RANGE_READS with random byte limits
+	bool parallelRangeReads;
 	std::string valueString;
 	Future<Void> client;
 
 	StreamingRangeReadWorkload(WorkloadContext const& wcx) : KVWorkload(wcx) {
 		testDuration = getOption(options, "testDuration"_sr, 60.0);
+		parallelRangeReads = getOption(options, "parallelRangeReads"_sr, false);
 		valueString = std::string(maxValueBytes, '.');
 	}
 
@@ -120,9 +126,15 @@ struct StreamingRangeReadWorkload : KVWorkload {
 			state PromiseStream<KeyValue> compareResults;
 
 			try {
+				state int byteLimit = 1e6;
+				if (self->parallelRangeReads) {
+					tr.setOption(FDBTransactionOptions::PARALLEL_RANGE_READS);
+					byteLimit = deterministicRandom()->randomInt(CLIENT_KNOBS->REPLY_BYTE_LIMIT + 1, 1e6);
+				}
 				state Future<Void> compareConvert = convertStream(compareRaw, compareResults);
 				state Future<Void> streamConvert = convertStream(streamRaw, streamResults);
-				state Future<Void> compare = streamUsingGetRange(compareRaw, &tr, KeyRangeRef(next, normalKeys.end));
+				state Future<Void> compare =
+				    streamUsingGetRange(compareRaw, &tr, KeyRangeRef(next, normalKeys.end), byteLimit);
 				state Future<Void> stream = tr.getRangeStream(streamRaw,
 				                                              KeySelector(firstGreaterOrEqual(next), next.arena()),
 				                                              KeySelector(firstGreaterOrEqual(normalKeys.end)),
@@ -55,6 +55,10 @@ void forceLinkRandomKeyValueUtilsTests();
 void forceLinkSimKmsVaultTests();
 void forceLinkRESTSimKmsVaultTest();
 void forceLinkActorFuzzUnitTests();
+void forceLinkTimerWheelTests();
+void forceLinkTaskQueueTests();
+void forceLinkBinaryTraceLogFormatterTests();
+void forceLinkThreadShardsTests();
 
 struct UnitTestWorkload : TestWorkload {
 	static constexpr auto NAME = "UnitTests";
@@ -125,6 +129,10 @@ struct UnitTestWorkload : TestWorkload {
 		forceLinkSimKmsVaultTests();
 		forceLinkRESTSimKmsVaultTest();
 		forceLinkActorFuzzUnitTests();
+		forceLinkTimerWheelTests();
+		forceLinkTaskQueueTests();
+		forceLinkBinaryTraceLogFormatterTests();
+		forceLinkThreadShardsTests();
 	}
 
 	Future<Void> setup(Database const& cx) override {
@@ -20,6 +20,12 @@
 
 #include "flow/Arena.h"
 
+#include <array>
+#include <bit>
+#include <mutex>
+#include <vector>
+
+#include "flow/Knobs.h"
 #include "flow/UnitTest.h"
 #include "flow/ScopeExit.h"
 
@@ -105,6 +111,191 @@ void makeNoAccess(void*, size_t) {}
 void makeDefined(void*, size_t) {}
 void makeUndefined(void*, size_t) {}
 #endif
+
+// Blocks larger than ArenaBlock::LARGE, such as those of large range read or peek replies, are rounded up to one of
+// four size classes per power of two, up to 8MB. A thread keeps the blocks of these classes it frees, up to
+// ARENA_BLOCK_CACHE_BYTES of them, and reuses them for the next blocks of the same class instead of going back to the
+// system allocator.
+constexpr int kHugeBlockMinClassBits = 13; // The first classes are (8KB,10KB], (10KB,12KB], (12KB,14KB], (14KB,16KB]
+constexpr int kHugeBlockMaxClassBits = 23;
+constexpr int kHugeBlockClassesPerDoubling = 4;
+constexpr int kHugeBlockClasses = (kHugeBlockMaxClassBits - kHugeBlockMinClassBits) * kHugeBlockClassesPerDoubling;
+constexpr int kHugeBlockMaxCachedSize = 1 << kHugeBlockMaxClassBits;
+static_assert(ArenaBlock::LARGE > (1 << kHugeBlockMinClassBits));
+
+int hugeBlockSizeClass(int size) {
+	ASSERT(size >= ArenaBlock::LARGE && size <= kHugeBlockMaxCachedSize);
+	// size is in (2^bits, 2^(bits+1)], which is split into kHugeBlockClassesPerDoubling steps
+	const int bits = 31 - std::countl_zero(uint32_t(size - 1));
+	const int step = 1 << (bits - 2);
+	const int steps = (size + step - 1) / step;
+	return (bits - kHugeBlockMinClassBits) * kHugeBlockClassesPerDoubling + steps - kHugeBlockClassesPerDoubling - 1;
+}
+
+int hugeBlockClassSize(int sizeClass) {
+	const int bits = sizeClass / kHugeBlockClassesPerDoubling + kHugeBlockMinClassBits;
+	return (sizeClass % kHugeBlockClassesPerDoubling + kHugeBlockClassesPerDoubling + 1) << (bits - 2);
+}
+
+int64_t hugeBlockCacheLimit() {
+	// Blocks allocated while a keepalive scope is active must be freed through it
+	return FLOW_KNOBS && !keepalive_allocator::isActive() ? FLOW_KNOBS->ARENA_BLOCK_CACHE_BYTES : 0;
+}
+
+// With FAST_ALLOC_HUGE_PAGES, arena blocks of more than 256 bytes come from huge pages on the local NUMA node, as the
+// smaller ones already do through FastAllocator. Blocks allocated while a keepalive scope is active must still come
+// from it.
+bool hugePageArenaBlocks() {
+	return FLOW_KNOBS && FLOW_KNOBS->FAST_ALLOC_HUGE_PAGES && !keepalive_allocator::isActive();
+}
+
+// With FAST_ALLOC_HUGE_PAGES, blocks of the size classes are carved out of slabs from allocateHugePages(), which all
+// threads share. Like FastAllocator's magazines, they are never given back to the system: those freed when their
+// thread's cache is full go on a free list of their class instead.
+struct HugePageBlocks {
+	std::mutex mutex;
+	std::array<std::vector<uint8_t*>, kHugeBlockClasses> freeBlocks;
+	// The part of the current slab not yet carved into blocks
+	uint8_t* slabNext = nullptr;
+	uint8_t* slabEnd = nullptr;
+};
+
+HugePageBlocks& hugePageBlocks() {
+	// Never destroyed, since blocks are freed by static destructors too
+	static HugePageBlocks* blocks = new HugePageBlocks();
+	return *blocks;
+}
+
+uint8_t* allocateHugePageBlock(int sizeClass) {
+	const int size = hugeBlockClassSize(sizeClass);
+	HugePageBlocks& blocks = hugePageBlocks();
+	std::lock_guard<std::mutex> lock(blocks.mutex);
+	if (!blocks.freeBlocks[sizeClass].empty()) {
+		uint8_t* block = blocks.freeBlocks[sizeClass].back();
+		blocks.freeBlocks[sizeClass].pop_back();
+		g_hugeArenaRecycledBytes.fetch_add(size);
+		makeUndefined(block, size);
+		return block;
+	}
+	g_hugeArenaAllocatedBytes.fetch_add(size);
+	if (blocks.slabEnd - blocks.slabNext >= size) {
+		uint8_t* block = blocks.slabNext;
+		blocks.slabNext += size;
+		return block;
+	}
+	// Blocks of the larger classes take slabs of several huge pages. What is left of the new slab past the block
+	// becomes the current slab if there is more of it than of the old one.
+	const size_t slabSize = (size + kHugePageBytes - 1) / kHugePageBytes * kHugePageBytes;
+	bool hugePages;
+	uint8_t* block = (uint8_t*)allocateHugePages(slabSize, hugePages);
+	if (hugePages) {
+		g_hugeArenaHugePageMemory.fetch_add(slabSize);
+	}
+	if (slabSize - size > size_t(blocks.slabEnd - blocks.slabNext)) {
+		blocks.slabNext = block + size;
+		blocks.slabEnd = block + slabSize;
+	}
+	return block;
+}
+
+void freeHugePageBlock(uint8_t* block, int sizeClass) {
+	makeNoAccess(block, hugeBlockClassSize(sizeClass));
+	HugePageBlocks& blocks = hugePageBlocks();
+	std::lock_guard<std::mutex> lock(blocks.mutex);
+	blocks.freeBlocks[sizeClass].push_back(block);
+}
+
+struct HugeBlockCache {
+	struct Block {
+		uint8_t* block;
+		bool hugePages; // Carved out of a huge page slab, see allocateHugePageBlock()
+	};
+	std::array<std::vector<Block>, kHugeBlockClasses> blocks;
+	int64_t bytes = 0;
+
+	~HugeBlockCache();
+};
+
+thread_local HugeBlockCache hugeBlockCache;
+// Set once the thread's cache has been destroyed, so that blocks freed by later thread exit handlers and static
+// destructors go straight back to the system allocator
+thread_local bool hugeBlockCacheDestroyed = false;
+
+HugeBlockCache::~HugeBlockCache() {
+	for (int sizeClass = 0; sizeClass < kHugeBlockClasses; ++sizeClass) {
+		for (const Block& b : blocks[sizeClass]) {
+			if (b.hugePages) {
+				freeHugePageBlock(b.block, sizeClass);
+			} else {
+				makeUndefined(b.block, hugeBlockClassSize(sizeClass));
+				delete[] b.block;
+			}
+		}
+	}
+	g_hugeArenaCachedBytes.fetch_sub(bytes);
+	hugeBlockCacheDestroyed = true;
+}
+
+// Returns a block of at least size bytes, and sets size to its actual size and hugePages to whether it was carved out
+// of a huge page slab
+uint8_t* allocateHugeBlock(int& size, bool& hugePages) {
+	hugePages = false;
+	if (size <= kHugeBlockMaxCachedSize && (hugeBlockCacheLimit() > 0 || hugePageArenaBlocks())) {
+		const int sizeClass = hugeBlockSizeClass(size);
+		size = hugeBlockClassSize(sizeClass);
+		if (!hugeBlockCacheDestroyed && !hugeBlockCache.blocks[sizeClass].empty()) {
+			const HugeBlockCache::Block b = hugeBlockCache.blocks[sizeClass].back();
+			hugeBlockCache.blocks[sizeClass].pop_back();
+			hugeBlockCache.bytes -= size;
+			g_hugeArenaCachedBytes.fetch_sub(size);
+			g_hugeArenaRecycledBytes.fetch_add(size);
+			makeUndefined(b.block, size);
+			hugePages = b.hugePages;
+			return b.block;
+		}
+		if (hugePageArenaBlocks()) {
+			hugePages = true;
+			return allocateHugePageBlock(sizeClass);
+		}
+	}
+	g_hugeArenaAllocatedBytes.fetch_add(size);
+	return allocateAndMaybeKeepalive(size);
+}
+
+void freeHugeBlock(ArenaBlock* b, int size, bool hugePages) {
+	if (size <= kHugeBlockMaxCachedSize && !hugeBlockCacheDestroyed) {
+		const int64_t limit = hugeBlockCacheLimit();
+		const int sizeClass = hugeBlockSizeClass(size);
+		// Blocks allocated while the cache was disabled may not be the size of their class
+		if (hugeBlockCache.bytes + size <= limit && hugeBlockClassSize(sizeClass) == size) {
+			hugeBlockCache.blocks[sizeClass].push_back({ reinterpret_cast<uint8_t*>(b), hugePages });
+			hugeBlockCache.bytes += size;
+			g_hugeArenaCachedBytes.fetch_add(size);
+			makeNoAccess(b, size);
+			return;
+		}
+	}
+	if (hugePages) {
+		freeHugePageBlock(reinterpret_cast<uint8_t*>(b), hugeBlockSizeClass(size));
+	} else {
+		freeOrMaybeKeepalive(b);
+	}
+}
+
+template <int Size>
+ArenaBlock* allocateMediumBlock(bool& hugePages) {
+	hugePages = hugePageArenaBlocks();
+	return (ArenaBlock*)(hugePages ? FastAllocator<Size>::allocate() : allocateAndMaybeKeepalive(Size));
+}
+
+template <int Size>
+void freeMediumBlock(ArenaBlock* b) {
+	if (b->hugePages) {
+		FastAllocator<Size>::release(b);
+	} else {
+		freeOrMaybeKeepalive(b);
+	}
+}
 } // namespace
 
 Arena::Arena() : impl(nullptr) {}
@@ -376,6 +567,7 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 			reqSize = std::max(reqSize, std::min(prevSize * 2, std::max(LARGE - 1, reqSize * 4)));
 		}
 
+		bool hugePages = false;
 		if (reqSize < LARGE) {
 			if (reqSize <= 128) {
 				b = (ArenaBlock*)FastAllocator<128>::allocate();
@@ -386,23 +578,23 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 				b->bigSize = 256;
 				INSTRUMENT_ALLOCATE("Arena256");
 			} else if (reqSize <= 512) {
-				b = (ArenaBlock*)allocateAndMaybeKeepalive(512);
+				b = allocateMediumBlock<512>(hugePages);
 				b->bigSize = 512;
 				INSTRUMENT_ALLOCATE("Arena512");
 			} else if (reqSize <= 1024) {
-				b = (ArenaBlock*)allocateAndMaybeKeepalive(1024);
+				b = allocateMediumBlock<1024>(hugePages);
 				b->bigSize = 1024;
 				INSTRUMENT_ALLOCATE("Arena1024");
 			} else if (reqSize <= 2048) {
-				b = (ArenaBlock*)allocateAndMaybeKeepalive(2048);
+				b = allocateMediumBlock<2048>(hugePages);
 				b->bigSize = 2048;
 				INSTRUMENT_ALLOCATE("Arena2048");
 			} else if (reqSize <= 4096) {
-				b = (ArenaBlock*)allocateAndMaybeKeepalive(4096);
+				b = allocateMediumBlock<4096>(hugePages);
 				b->bigSize = 4096;
 				INSTRUMENT_ALLOCATE("Arena4096");
 			} else {
-				b = (ArenaBlock*)allocateAndMaybeKeepalive(8192);
+				b = allocateMediumBlock<8192>(hugePages);
 				b->bigSize = 8192;
 				INSTRUMENT_ALLOCATE("Arena8192");
 			}
@@ -410,16 +602,18 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 			b->tinySize = b->tinyUsed = NOT_TINY;
 			b->bigUsed = sizeof(ArenaBlock);
 			b->secure = 0;
+			b->hugePages = hugePages;
 		} else {
+			b = (ArenaBlock*)allocateHugeBlock(reqSize, hugePages);
 #ifdef ALLOC_INSTRUMENTATION
 			allocInstr["ArenaHugeKB"].alloc((reqSize + 1023) >> 10);
 #endif
-			b = (ArenaBlock*)allocateAndMaybeKeepalive(reqSize);
 			b->tinySize = b->tinyUsed = NOT_TINY;
 			b->bigSize = reqSize;
 			b->totalSizeEstimate = b->bigSize;
 			b->bigUsed = sizeof(ArenaBlock);
 			b->secure = 0;
+			b->hugePages = hugePages;
 
 #if !DEBUG_DETERMINISM
 			if (FLOW_KNOBS && g_allocation_tracing_disabled == 0 &&
@@ -506,26 +700,26 @@ void ArenaBlock::destroyLeaf() {
 			FastAllocator<256>::release(this);
 			INSTRUMENT_RELEASE("Arena256");
 		} else if (bigSize <= 512) {
-			freeOrMaybeKeepalive(this);
+			freeMediumBlock<512>(this);
 			INSTRUMENT_RELEASE("Arena512");
 		} else if (bigSize <= 1024) {
-			freeOrMaybeKeepalive(this);
+			freeMediumBlock<1024>(this);
 			INSTRUMENT_RELEASE("Arena1024");
 		} else if (bigSize <= 2048) {
-			freeOrMaybeKeepalive(this);
+			freeMediumBlock<2048>(this);
 			INSTRUMENT_RELEASE("Arena2048");
 		} else if (bigSize <= 4096) {
-			freeOrMaybeKeepalive(this);
+			freeMediumBlock<4096>(this);
 			INSTRUMENT_RELEASE("Arena4096");
 		} else if (bigSize <= 8192) {
-			freeOrMaybeKeepalive(this);
+			freeMediumBlock<8192>(this);
 			INSTRUMENT_RELEASE("Arena8192");
 		} else {
 #ifdef ALLOC_INSTRUMENTATION
 			allocInstr["ArenaHugeKB"].dealloc((bigSize + 1023) >> 10);
 #endif
 			g_hugeArenaMemory.fetch_sub(bigSize);
-			freeOrMaybeKeepalive(this);
+			freeHugeBlock(this, bigSize, hugePages);
 		}
 	}
 }
@@ -1039,3 +1233,49 @@ TEST_CASE("/flow/Arena/Secure") {
 	}
 	return Void();
 }
+
+TEST_CASE("/flow/Arena/HugeBlockCache") {
+	for (int size : { (int)ArenaBlock::LARGE, 10240, 10241, 1 << 20, (1 << 20) + 1, kHugeBlockMaxCachedSize }) {
+		const int sizeClass = hugeBlockSizeClass(size);
+		ASSERT_GE(hugeBlockClassSize(sizeClass), size);
+		ASSERT(sizeClass == 0 || hugeBlockClassSize(sizeClass - 1) < size);
+		ASSERT_LE(hugeBlockClassSize(sizeClass), size + size / 4);
+	}
+	ASSERT_EQ(hugeBlockClassSize(kHugeBlockClasses - 1), kHugeBlockMaxCachedSize);
+
+	// A block freed into the cache is used for the next block of its class
+	constexpr int dataSize = 100000;
+	const int blockSize = hugeBlockClassSize(hugeBlockSizeClass(dataSize + sizeof(ArenaBlock)));
+	if (hugeBlockCacheDestroyed || hugeBlockCache.bytes + blockSize > hugeBlockCacheLimit()) {
+		return Void();
+	}
+	const int64_t recycled = g_hugeArenaRecycledBytes.load();
+	const int64_t cached = hugeBlockCache.bytes;
+	uint8_t* first;
+	{
+		Arena arena(dataSize);
+		first = new (arena) uint8_t[dataSize];
+		ASSERT_EQ(arena.getSize(), blockSize);
+	}
+	ASSERT_EQ(hugeBlockCache.bytes, cached + blockSize);
+	{
+		Arena arena(dataSize);
+		ASSERT(new (arena) uint8_t[dataSize] == first);
+	}
+	ASSERT_GE(g_hugeArenaRecycledBytes.load(), recycled + blockSize);
+	return Void();
+}
+
+TEST_CASE("/flow/Arena/HugePageBlocks") {
+	// A freed block goes on the free list of its class and is used for the next block of that class
+	for (int sizeClass : { 0, hugeBlockSizeClass(3 << 20) }) {
+		const int size = hugeBlockClassSize(sizeClass);
+		uint8_t* block = allocateHugePageBlock(sizeClass);
+		memset(block, 0xff, size);
+		freeHugePageBlock(block, sizeClass);
+		uint8_t* again = allocateHugePageBlock(sizeClass);
+		ASSERT(again == block);
+		freeHugePageBlock(again, sizeClass);
+	}
+	return Void();
+}
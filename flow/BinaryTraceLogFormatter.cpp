@@ -0,0 +1,420 @@
+/*
+ * BinaryTraceLogFormatter.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/BinaryTraceLogFormatter.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#include "flow/UnitTest.h"
+#include "flow/XmlTraceLogFormatter.h"
+
+// A file is the header followed by events. An event is its length as a varint, then the number of fields and the
+// fields. A field is its name, either 0 and the name itself or one more than the number of a name already seen in the
+// file, then the type of its value and the value.
+namespace {
+
+const char* const header = "FDBBinaryTrace 1\n";
+
+// Names past this many are written out every time, so that events with made up names don't grow the table forever
+constexpr int maxInternedNames = 1 << 16;
+
+enum ValueType : uint8_t {
+	String = 0, // The length and the characters
+	Integer = 1, // A zigzag encoded varint
+	Repeated = 2, // The same value as the field had in the previous event that had it
+	Double = 3, // The 8 bytes of the double, little endian, which reads back as printed with %g
+};
+
+void appendVarint(std::string& out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+void appendString(std::string& out, std::string const& s) {
+	appendVarint(out, s.size());
+	out.append(s);
+}
+
+// Only accepts integers that are written the way they would be printed, so that converting the file back gives the
+// same strings (not "007" or "-0", for example)
+bool parseInteger(std::string const& value, int64_t& out) {
+	const char* end = value.data() + value.size();
+	auto [parsed, ec] = std::from_chars(value.data(), end, out);
+	if (value.empty() || ec != std::errc() || parsed != end) {
+		return false;
+	}
+	char printed[24];
+	auto [printedEnd, printEc] = std::to_chars(printed, printed + sizeof(printed), out);
+	return printEc == std::errc() && printedEnd - printed == value.size() &&
+	       memcmp(printed, value.data(), value.size()) == 0;
+}
+
+// The value of a field the way it is written. Integers and doubles that details added as numbers are written without
+// ever being turned into strings.
+BinaryTraceLogFormatter::Value toValue(const TraceEventFields& fields, int index) {
+	BinaryTraceLogFormatter::Value value;
+	if (const TraceEventFields::Number* number = fields.getNumber(index)) {
+		if (auto integer = std::get_if<int64_t>(number)) {
+			value.type = ValueType::Integer;
+			value.integer = *integer;
+		} else if (auto unsignedInteger = std::get_if<uint64_t>(number);
+		           unsignedInteger && *unsignedInteger <= std::numeric_limits<int64_t>::max()) {
+			value.type = ValueType::Integer;
+			value.integer = *unsignedInteger;
+		} else if (auto d = std::get_if<double>(number)) {
+			value.type = ValueType::Double;
+			static_assert(sizeof(double) == sizeof(uint64_t));
+			memcpy(&value.integer, d, sizeof(double));
+		} else {
+			value.type = ValueType::String;
+			value.string = TraceEventFields::formatNumber(*number);
+		}
+	} else if (parseInteger(fields[index].second, value.integer)) {
+		value.type = ValueType::Integer;
+	} else {
+		value.type = ValueType::String;
+		value.string = fields[index].second;
+	}
+	return value;
+}
+
+bool readVarint(StringRef& data, uint64_t& value) {
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (data.empty()) {
+			return false;
+		}
+		uint8_t byte = data[0];
+		data = data.substr(1);
+		value |= uint64_t(byte & 0x7f) << shift;
+		if (byte < 0x80) {
+			return true;
+		}
+	}
+	throw file_corrupt();
+}
+
+// Reads from the body of an event, where running out of data means it is corrupt
+uint64_t readVarintFromEvent(StringRef& data) {
+	uint64_t value;
+	if (!readVarint(data, value)) {
+		throw file_corrupt();
+	}
+	return value;
+}
+
+std::string readStringFromEvent(StringRef& data) {
+	uint64_t length = readVarintFromEvent(data);
+	if (length > data.size()) {
+		throw file_corrupt();
+	}
+	std::string s = data.substr(0, length).toString();
+	data = data.substr(length);
+	return s;
+}
+
+} // namespace
+
+void BinaryTraceLogFormatter::addref() {
+	ReferenceCounted<BinaryTraceLogFormatter>::addref();
+}
+
+void BinaryTraceLogFormatter::delref() {
+	ReferenceCounted<BinaryTraceLogFormatter>::delref();
+}
+
+const char* BinaryTraceLogFormatter::getExtension() const {
+	return "fdbtrace";
+}
+
+const char* BinaryTraceLogFormatter::getHeader() const {
+	names.clear();
+	lastValues.clear();
+	return header;
+}
+
+const char* BinaryTraceLogFormatter::getFooter() const {
+	return "";
+}
+
+std::string BinaryTraceLogFormatter::formatEvent(const TraceEventFields& fields) const {
+	std::string event;
+	appendVarint(event, fields.size());
+	for (int i = 0; i < fields.size(); ++i) {
+		std::string const& name = fields[i].first;
+		int id = -1;
+		auto interned = names.find(name);
+		if (interned != names.end()) {
+			id = interned->second;
+			appendVarint(event, id + 1);
+		} else {
+			appendVarint(event, 0);
+			appendString(event, name);
+			if (names.size() < maxInternedNames) {
+				id = names.size();
+				names.emplace(name, id);
+				lastValues.emplace_back();
+			}
+		}
+
+		Value value = toValue(fields, i);
+		if (id >= 0 && lastValues[id] == value) {
+			event.push_back(ValueType::Repeated);
+			continue;
+		}
+		event.push_back(value.type);
+		if (value.type == ValueType::Integer) {
+			appendVarint(event, (uint64_t(value.integer) << 1) ^ uint64_t(value.integer >> 63));
+		} else if (value.type == ValueType::Double) {
+			for (int byte = 0; byte < 8; ++byte) {
+				event.push_back(static_cast<char>(uint64_t(value.integer) >> (byte * 8)));
+			}
+		} else {
+			appendString(event, value.string);
+		}
+		if (id >= 0) {
+			lastValues[id] = std::move(value);
+		}
+	}
+
+	std::string out;
+	out.reserve(event.size() + 5);
+	appendVarint(out, event.size());
+	out.append(event);
+	return out;
+}
+
+BinaryTraceLogReader::BinaryTraceLogReader(StringRef data) : remaining(data) {
+	if (!remaining.startsWith(StringRef(header))) {
+		throw file_corrupt();
+	}
+	remaining = remaining.substr(strlen(header));
+}
+
+bool BinaryTraceLogReader::next(TraceEventFields& fields) {
+	StringRef data = remaining;
+	uint64_t length;
+	if (!readVarint(data, length) || length > data.size()) {
+		return false;
+	}
+	StringRef event = data.substr(0, length);
+	remaining = data.substr(length);
+
+	fields = TraceEventFields();
+	for (uint64_t count = readVarintFromEvent(event); count > 0; --count) {
+		int id = -1;
+		std::string name;
+		if (uint64_t nameRef = readVarintFromEvent(event); nameRef == 0) {
+			name = readStringFromEvent(event);
+			if (names.size() < maxInternedNames) {
+				id = names.size();
+				names.push_back(name);
+				lastValues.emplace_back();
+			}
+		} else if (nameRef <= names.size()) {
+			id = nameRef - 1;
+			name = names[id];
+		} else {
+			throw file_corrupt();
+		}
+
+		if (event.empty()) {
+			throw file_corrupt();
+		}
+		uint8_t type = event[0];
+		event = event.substr(1);
+		std::string value;
+		if (type == ValueType::Repeated && id >= 0) {
+			value = lastValues[id];
+		} else if (type == ValueType::Integer) {
+			uint64_t zigzag = readVarintFromEvent(event);
+			value = std::to_string(int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1));
+		} else if (type == ValueType::Double) {
+			if (event.size() < 8) {
+				throw file_corrupt();
+			}
+			uint64_t bits = 0;
+			for (int byte = 0; byte < 8; ++byte) {
+				bits |= uint64_t(event[byte]) << (byte * 8);
+			}
+			event = event.substr(8);
+			double d;
+			memcpy(&d, &bits, sizeof(double));
+			value = TraceEventFields::formatNumber(d);
+		} else if (type == ValueType::String) {
+			value = readStringFromEvent(event);
+		} else {
+			throw file_corrupt();
+		}
+		if (id >= 0) {
+			lastValues[id] = value;
+		}
+		fields.addField(std::move(name), std::move(value));
+	}
+	if (!event.empty()) {
+		throw file_corrupt();
+	}
+	return true;
+}
+
+namespace {
+
+TraceEventFields randomTraceEvent(int i) {
+	// Values that must come back exactly as they were, whether or not they look like integers
+	static const std::vector<std::string> values = { "",
+		                                             "0",
+		                                             "-0",
+		                                             "007",
+		                                             "+5",
+		                                             "-1",
+		                                             "9223372036854775807",
+		                                             "-9223372036854775808",
+		                                             "9223372036854775808",
+		                                             "18446744073709551615",
+		                                             "1.5",
+		                                             "0x1f",
+		                                             std::string("a\0b", 3),
+		                                             "\xff\n\"<>&" };
+	TraceEventFields fields;
+	fields.addField("Severity", deterministicRandom()->coinflip() ? "10" : "20");
+	fields.addField("Time", format("%.6f", 1.7e9 + i * 0.001));
+	fields.addField("Type", format("Event%d", deterministicRandom()->randomInt(0, 10)));
+	fields.addField("Machine", "1.2.3.4:4500");
+	for (int f = deterministicRandom()->randomInt(0, 8); f > 0; --f) {
+		std::string value = deterministicRandom()->coinflip()
+		                        ? deterministicRandom()->randomChoice(values)
+		                        : std::to_string(deterministicRandom()->randomInt64(std::numeric_limits<int64_t>::min(),
+		                                                                            std::numeric_limits<int64_t>::max()));
+		fields.addField(format("Detail%d", deterministicRandom()->randomInt(0, 20)), std::move(value));
+	}
+	// Details added as numbers
+	static const std::vector<TraceEventFields::Number> numbers = { int64_t(0),
+		                                                           int64_t(-1),
+		                                                           std::numeric_limits<int64_t>::min(),
+		                                                           uint64_t(7),
+		                                                           std::numeric_limits<uint64_t>::max(),
+		                                                           0.0,
+		                                                           -0.0,
+		                                                           1.5,
+		                                                           1e300,
+		                                                           std::numeric_limits<double>::infinity() };
+	for (int f = deterministicRandom()->randomInt(0, 4); f > 0; --f) {
+		fields.addField(format("Number%d", deterministicRandom()->randomInt(0, 5)),
+		                deterministicRandom()->randomChoice(numbers));
+	}
+	return fields;
+}
+
+// a was read back from a file, so all its values are strings
+void checkSameEvent(TraceEventFields const& a, TraceEventFields b) {
+	b.formatValues();
+	ASSERT_EQ(a.size(), b.size());
+	for (int i = 0; i < a.size(); ++i) {
+		ASSERT(a[i] == b[i]);
+	}
+}
+
+} // namespace
+
+TEST_CASE("/flow/BinaryTraceLogFormatter/roundTrip") {
+	BinaryTraceLogFormatter formatter;
+	std::vector<TraceEventFields> events;
+	for (int i = 0; i < 1000; ++i) {
+		events.push_back(randomTraceEvent(i));
+	}
+
+	// Each file can be read without the ones before it
+	std::vector<std::string> files;
+	for (int i = 0; i < events.size(); ++i) {
+		if (i % 300 == 0) {
+			files.push_back(formatter.getHeader());
+		}
+		files.back() += formatter.formatEvent(events[i]);
+	}
+	int read = 0;
+	TraceEventFields fields;
+	for (auto const& file : files) {
+		BinaryTraceLogReader reader{ StringRef(file) };
+		while (reader.next(fields)) {
+			checkSameEvent(fields, events[read++]);
+		}
+	}
+	ASSERT_EQ(read, events.size());
+
+	// An event that was only partly written is left out
+	std::string file = formatter.getHeader();
+	file += formatter.formatEvent(events[0]);
+	file += formatter.formatEvent(events[1]).substr(0, 3);
+	BinaryTraceLogReader reader{ StringRef(file) };
+	ASSERT(reader.next(fields));
+	checkSameEvent(fields, events[0]);
+	ASSERT(!reader.next(fields));
+	return Void();
+}
+
+TEST_CASE("/flow/BinaryTraceLogFormatter/size") {
+	BinaryTraceLogFormatter formatter;
+	XmlTraceLogFormatter xmlFormatter;
+	formatter.getHeader();
+	size_t bytes = 0, xmlBytes = 0;
+	for (int i = 0; i < 100; ++i) {
+		TraceEventFields fields = randomTraceEvent(i);
+		bytes += formatter.formatEvent(fields).size();
+		xmlBytes += xmlFormatter.formatEvent(fields).size();
+	}
+	ASSERT_LT(bytes, xmlBytes);
+	return Void();
+}
+
+namespace {
+template <class T>
+void checkNumberDetail(T value) {
+	ASSERT(isTraceNumber<T>);
+	ASSERT_EQ(TraceEventFields::formatNumber(toTraceNumber(value)), Traceable<T>::toString(value));
+}
+} // namespace
+
+TEST_CASE("/flow/BinaryTraceLogFormatter/numberDetails") {
+	// Details added as numbers print the same as they would have as strings
+	checkNumberDetail(true);
+	checkNumberDetail(short(-7));
+	checkNumberDetail(std::numeric_limits<int>::min());
+	checkNumberDetail(std::numeric_limits<unsigned>::max());
+	checkNumberDetail(std::numeric_limits<long>::min());
+	checkNumberDetail(std::numeric_limits<unsigned long long>::max());
+	checkNumberDetail(-0.0);
+	checkNumberDetail(1.0 / 3);
+	checkNumberDetail(1e-300);
+
+	TraceEventFields fields = randomTraceEvent(0);
+	TraceEventFields formatted = fields;
+	formatted.formatValues();
+	XmlTraceLogFormatter xmlFormatter;
+	ASSERT_EQ(xmlFormatter.formatEvent(fields), xmlFormatter.formatEvent(formatted));
+	ASSERT_EQ(fields.toString(), formatted.toString());
+	return Void();
+}
+
+void forceLinkBinaryTraceLogFormatterTests() {}
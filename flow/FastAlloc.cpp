@@ -113,6 +113,10 @@ template <int Size>
 void* FastAllocator<Size>::freelist = nullptr;
 
 std::atomic<int64_t> g_hugeArenaMemory(0);
+std::atomic<int64_t> g_hugeArenaAllocatedBytes(0);
+std::atomic<int64_t> g_hugeArenaRecycledBytes(0);
+std::atomic<int64_t> g_hugeArenaCachedBytes(0);
+std::atomic<int64_t> g_hugeArenaHugePageMemory(0);
 
 double hugeArenaLastLogged = 0;
 std::map<std::string, std::pair<int, int64_t>> hugeArenaTraces;
@@ -248,7 +252,14 @@ struct FastAllocator<Size>::GlobalData {
 	std::atomic<long long> totalMemory;
 	long long partialMagazineUnallocatedMemory;
 	std::atomic<long long> activeThreads;
-	GlobalData() : totalMemory(0), partialMagazineUnallocatedMemory(0), activeThreads(0) {
+	// The part of the current slab not yet made into magazines, with FAST_ALLOC_HUGE_PAGES
+	uint8_t* slabNext = nullptr;
+	uint8_t* slabEnd = nullptr;
+	bool slabHugePages = false;
+	std::atomic<long long> hugePageSlabs;
+	std::atomic<long long> hugePageMemory;
+	GlobalData()
+	  : totalMemory(0), partialMagazineUnallocatedMemory(0), activeThreads(0), hugePageSlabs(0), hugePageMemory(0) {
 		InitializeCriticalSection(&mutex);
 	}
 };
@@ -273,6 +284,18 @@ long long FastAllocator<Size>::getActiveThreads() {
 	return globalData()->activeThreads.load();
 }
 
+template <int Size>
+long long FastAllocator<Size>::getHugePageMemory() {
+	return globalData()->hugePageMemory.load();
+}
+
+template <int Size>
+long long FastAllocator<Size>::getMappedPages() {
+	constexpr long long pageSize = 4096;
+	return globalData()->hugePageSlabs.load() +
+	       (globalData()->totalMemory.load() - globalData()->hugePageMemory.load() + pageSize - 1) / pageSize;
+}
+
 #if FAST_ALLOCATOR_DEBUG
 static int64_t getSizeCode(int i) {
 	switch (i) {
@@ -550,6 +573,9 @@ void FastAllocator<Size>::getMagazine() {
 		return;
 	}
 	globalData()->totalMemory.fetch_add(magazine_size * Size);
+#if !FAST_ALLOCATOR_DEBUG
+	void* slabMagazine = FLOW_KNOBS && FLOW_KNOBS->FAST_ALLOC_HUGE_PAGES ? takeSlabMagazine() : nullptr;
+#endif
 	LeaveCriticalSection(&globalData()->mutex);
 
 // Allocate a new page of data from the system allocator
@@ -576,9 +602,8 @@ void FastAllocator<Size>::getMagazine() {
 	ASSERT(block == desiredBlock);
 #endif
 #else
-	// FIXME: We should be able to allocate larger magazine sizes here if we
-	// detect that the underlying system supports hugepages.  Using hugepages
-	// with smaller-than-2MiB magazine sizes strands memory.  See issue #909.
+	// Using hugepages with smaller-than-2MiB magazine sizes strands memory (see issue #909), so with
+	// FAST_ALLOC_HUGE_PAGES the magazine was carved out of a larger slab above instead.
 #if !DEBUG_DETERMINISM
 	if (FLOW_KNOBS && g_allocation_tracing_disabled == 0 &&
 	    nondeterministicRandom()->random01() < (magazine_size * Size) / FLOW_KNOBS->FAST_ALLOC_LOGGING_BYTES) {
@@ -592,7 +617,8 @@ void FastAllocator<Size>::getMagazine() {
 #else
 	const bool includeGuardPages = true;
 #endif
-	block = (void**)::allocate(magazine_size * Size, /*allowLargePages*/ false, includeGuardPages);
+	block = slabMagazine ? (void**)slabMagazine
+	                     : (void**)::allocate(magazine_size * Size, /*allowLargePages*/ false, includeGuardPages);
 #endif
 
 	// void** block = new void*[ magazine_size * PSize ];
@@ -606,6 +632,28 @@ void FastAllocator<Size>::getMagazine() {
 	thr.freelist = block;
 	thr.count = magazine_size;
 }
+// Called with the mutex held. Magazines share the huge pages of a slab, since giving each magazine huge pages of its
+// own would strand most of them (see issue #909).
+template <int Size>
+void* FastAllocator<Size>::takeSlabMagazine() {
+	GlobalData* data = globalData();
+	if (data->slabNext == data->slabEnd) {
+		bool hugePages;
+		data->slabNext = (uint8_t*)allocateHugePages(kFastAllocSlabBytes, hugePages);
+		data->slabEnd = data->slabNext + kFastAllocSlabBytes;
+		data->slabHugePages = hugePages;
+		if (hugePages) {
+			data->hugePageSlabs.fetch_add(1);
+		}
+	}
+	void* magazine = data->slabNext;
+	data->slabNext += kFastAllocMagazineBytes;
+	if (data->slabHugePages) {
+		data->hugePageMemory.fetch_add(magazine_size * Size);
+	}
+	return magazine;
+}
+
 template <int Size>
 void FastAllocator<Size>::releaseMagazine(void* mag) {
 	EnterCriticalSection(&globalData()->mutex);
@@ -28,6 +28,7 @@
 // either we pull g_simulator into flow, or flow (and the I/O path) will be unable to log performance
 // metrics.
 #include <limits>
+#include <thread>
 
 #pragma region HistogramRegistry
 
@@ -88,7 +89,18 @@ void HistogramRegistry::clear() {
 const char* const Histogram::UnitToStringMapper[] = { "milliseconds", "bytes", "bytes_per_second",
 	                                                  "percentage",   "count", "none" };
 
+void Histogram::collectThreadBuckets() {
+	threadBuckets.forEach([this](ThreadBuckets& shard) {
+		for (uint32_t i = 0; i < 32; i++) {
+			uint32_t count = shard.buckets[i].load(std::memory_order_relaxed);
+			buckets[i] += count - shard.collected[i];
+			shard.collected[i] = count;
+		}
+	});
+}
+
 void Histogram::writeToLog(double elapsed) {
+	collectThreadBuckets();
 	bool active = false;
 	for (uint32_t i = 0; i < 32; i++) {
 		if (buckets[i]) {
@@ -249,3 +261,34 @@ TEST_CASE("/flow/histogram/smoke_test") {
 
 	return Void();
 }
+
+TEST_CASE("/flow/histogram/threads") {
+	Reference<Histogram> h = Histogram::getHistogram("smoke_test"_sr, "threads"_sr, Histogram::Unit::bytes);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([h] {
+			for (uint32_t i = 0; i < 1000; i++) {
+				h->sampleOnAnyThread(1);
+				h->sampleOnAnyThread(i < 500 ? 2 : 1 << 20);
+			}
+		});
+	}
+	h->sample(1);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	h->collectThreadBuckets();
+	ASSERT(h->buckets[0] == 4001);
+	ASSERT(h->buckets[1] == 2000);
+	ASSERT(h->buckets[20] == 2000);
+	GetHistogramRegistry().logReport();
+	ASSERT(h->buckets[0] == 0);
+
+	// Samples are only added in once
+	h->sampleSecondsOnAnyThread(0.000003);
+	h->collectThreadBuckets();
+	h->collectThreadBuckets();
+	ASSERT(h->buckets[0] == 0 && h->buckets[1] == 1);
+	return Void();
+}
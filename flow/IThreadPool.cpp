@@ -21,6 +21,10 @@
 #include "flow/IThreadPool.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 // The ifndef's allow us to compile with pre-built boost.  Otherwise, we get
 // errors about double-defines.  As of this writing, the automatically downloaded
 // build of boost doesn't define these, but the pre-built version does.  (The old
@@ -125,8 +129,249 @@ public:
 	int priority() const { return pri; }
 };
 
+thread_local IThreadPoolReceiver* ThreadPool::Thread::threadUserObject;
+
+class WorkStealingThreadPool final : public IThreadPool, public ReferenceCounted<WorkStealingThreadPool> {
+	// The queue of one thread, or of the actions posted before there were any threads. Its lanes are FIFO, and
+	// other threads steal from the front too, so that a lane's actions start in about the order they were posted.
+	struct Queue {
+		ThreadSpinLock lock;
+		std::atomic<int> size{ 0 }; // So that threads looking for work don't take the locks of empty queues
+		std::deque<PThreadAction> lanes[threadActionPriorities];
+
+		void push(PThreadAction const* begin, PThreadAction const* end) {
+			ThreadSpinLockHolder holder(lock);
+			for (auto action = begin; action != end; ++action) {
+				lanes[static_cast<int>((*action)->getPriority())].push_back(*action);
+			}
+			size.fetch_add(end - begin, std::memory_order_relaxed);
+		}
+
+		PThreadAction pop(int lane) {
+			if (size.load(std::memory_order_relaxed) == 0) {
+				return nullptr;
+			}
+			ThreadSpinLockHolder holder(lock);
+			if (lanes[lane].empty()) {
+				return nullptr;
+			}
+			PThreadAction action = lanes[lane].front();
+			lanes[lane].pop_front();
+			size.fetch_sub(1, std::memory_order_relaxed);
+			return action;
+		}
+
+		void cancelAll() {
+			ThreadSpinLockHolder holder(lock);
+			for (auto& lane : lanes) {
+				for (auto action : lane) {
+					action->cancel();
+				}
+				lane.clear();
+			}
+			size.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	struct alignas(MAX_CACHE_LINE_SIZE) Thread {
+		WorkStealingThreadPool* pool;
+		int index;
+		IThreadPoolReceiver* userObject;
+		THREAD_HANDLE handle; // Owned by main thread
+		Queue queue;
+		static thread_local Thread* current;
+		Thread(WorkStealingThreadPool* pool, int index, IThreadPoolReceiver* userObject)
+		  : pool(pool), index(index), userObject(userObject) {}
+		~Thread() { ASSERT_ABORT(!userObject); }
+
+		void run() {
+			setThreadPriority(pool->pri);
+			current = this;
+			try {
+				userObject->init();
+				while (PThreadAction action = pool->next(*this)) {
+					(*action)(userObject);
+				}
+			} catch (Error& e) {
+				TraceEvent(SevError, "ThreadPoolError").error(e);
+			}
+			delete userObject;
+			userObject = nullptr;
+		}
+	};
+	THREAD_FUNC start(void* p) {
+		((Thread*)p)->run();
+		THREAD_RETURN;
+	}
+
+	// Threads are added to the end and only deleted by stop(), so threads[0, threadCount) can be read without a lock
+	static constexpr int maxThreads = 1024;
+	std::atomic<Thread*> threads[maxThreads];
+	std::atomic<int> threadCount{ 0 };
+	std::atomic<uint32_t> nextThread{ 0 };
+	Queue unassigned;
+
+	// The number of actions in all of the queues. Threads with nothing to do sleep until it is positive.
+	std::atomic<int64_t> queued{ 0 };
+	std::atomic<int> sleeping{ 0 };
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	std::atomic<bool> stopping{ false };
+	int stackSize;
+	int pri;
+
+	Thread* currentThread() const {
+		Thread* thread = Thread::current;
+		return thread && thread->pool == this ? thread : nullptr;
+	}
+
+	// The queue an action posted by the calling thread goes to
+	Queue& postQueue() {
+		if (Thread* thread = currentThread()) {
+			return thread->queue;
+		}
+		int count = threadCount.load(std::memory_order_acquire);
+		if (count == 0) {
+			return unassigned;
+		}
+		return threads[nextThread.fetch_add(1, std::memory_order_relaxed) % count].load()->queue;
+	}
+
+	// Called after count actions have been queued. Both this and next() read what the other wrote (queued and
+	// sleeping) after writing their own, so either the sleeping thread sees the actions or it is woken here.
+	void wakeThreads(int count) {
+		queued.fetch_add(count);
+		int asleep = sleeping.load();
+		if (asleep > 0) {
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			if (count >= asleep) {
+				wake.notify_all();
+			} else {
+				for (int i = 0; i < count; ++i) {
+					wake.notify_one();
+				}
+			}
+		}
+	}
+
+	// The highest priority action. Actions posted before there were any threads come first, since they were posted
+	// before any in the threads' queues. Then the thread's own queue, and then the other threads' queues, starting with
+	// the next thread's so that they aren't all robbed in the same order.
+	PThreadAction take(Thread& self) {
+		int count = threadCount.load(std::memory_order_acquire);
+		for (int lane = threadActionPriorities - 1; lane >= 0; --lane) {
+			PThreadAction action = unassigned.pop(lane);
+			if (!action) {
+				action = self.queue.pop(lane);
+			}
+			for (int i = 1; !action && i < count; ++i) {
+				action = threads[(self.index + i) % count].load()->queue.pop(lane);
+			}
+			if (action) {
+				queued.fetch_sub(1);
+				return action;
+			}
+		}
+		return nullptr;
+	}
+
+	// Returns the next action for the thread to run, or nullptr once the pool is stopping
+	PThreadAction next(Thread& self) {
+		while (!stopping.load(std::memory_order_relaxed)) {
+			if (PThreadAction action = take(self)) {
+				return action;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleeping.fetch_add(1);
+			wake.wait(lock, [this] { return queued.load() > 0 || stopping.load(); });
+			sleeping.fetch_sub(1);
+		}
+		return nullptr;
+	}
+
+public:
+	WorkStealingThreadPool(int stackSize, int pri) : stackSize(stackSize), pri(pri) {}
+	~WorkStealingThreadPool() override {}
+	Future<Void> stop(Error const& e = success()) override {
+		if (stopping.exchange(true))
+			return Void();
+		ReferenceCounted<WorkStealingThreadPool>::addref();
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wake.notify_all();
+		}
+		int count = threadCount.load();
+		for (int i = 0; i < count; i++) {
+			waitThread(threads[i].load()->handle);
+		}
+		for (int i = 0; i < count; i++) {
+			threads[i].load()->queue.cancelAll();
+			delete threads[i].load();
+		}
+		unassigned.cancelAll();
+		ReferenceCounted<WorkStealingThreadPool>::delref();
+		return Void();
+	}
+
+	Future<Void> getError() const override { return Never(); } // FIXME
+	void addref() override { ReferenceCounted<WorkStealingThreadPool>::addref(); }
+	void delref() override {
+		if (ReferenceCounted<WorkStealingThreadPool>::delref_no_destroy()) {
+			stop();
+			delete this;
+		}
+	}
+	void addThread(IThreadPoolReceiver* userData, const char* name) override {
+		int index = threadCount.load();
+		ASSERT(index < maxThreads);
+		Thread* thread = new Thread(this, index, userData);
+		threads[index].store(thread);
+		threadCount.store(index + 1, std::memory_order_release);
+		thread->handle = g_network->startThread(start, thread, stackSize, name);
+	}
+	void post(PThreadAction action) override {
+		if (stopping.load()) {
+			action->cancel();
+			return;
+		}
+		postQueue().push(&action, &action + 1);
+		wakeThreads(1);
+	}
+	// Spreads the actions over as few queues as there are threads to run them, taking each queue's lock once
+	void postBatch(std::vector<PThreadAction> const& actions) override {
+		if (stopping.load()) {
+			for (auto action : actions) {
+				action->cancel();
+			}
+			return;
+		}
+		if (actions.empty()) {
+			return;
+		}
+		int count = threadCount.load(std::memory_order_acquire);
+		if (currentThread() || count == 0) {
+			postQueue().push(actions.data(), actions.data() + actions.size());
+		} else {
+			int queues = std::min<int>(count, actions.size());
+			for (int i = 0; i < queues; ++i) {
+				postQueue().push(actions.data() + actions.size() * i / queues,
+				                 actions.data() + actions.size() * (i + 1) / queues);
+			}
+		}
+		wakeThreads(actions.size());
+	}
+};
+
+thread_local WorkStealingThreadPool::Thread* WorkStealingThreadPool::Thread::current;
+
 Reference<IThreadPool> createGenericThreadPool(int stackSize, int pri) {
+	if (FLOW_KNOBS->THREAD_POOL_WORK_STEALING) {
+		return createWorkStealingThreadPool(stackSize, pri);
+	}
 	return Reference<IThreadPool>(new ThreadPool(stackSize, pri));
 }
 
-thread_local IThreadPoolReceiver* ThreadPool::Thread::threadUserObject;
+Reference<IThreadPool> createWorkStealingThreadPool(int stackSize, int pri) {
+	return Reference<IThreadPool>(new WorkStealingThreadPool(stackSize, pri));
+}
@@ -24,7 +24,9 @@
 #include "flow/IThreadPool.h"
 
 #include <pthread.h>
+#include <atomic>
 #include <iostream>
+#include <memory>
 
 #include "flow/UnitTest.h"
 #include "flow/actorcompiler.h" // has to be last include
@@ -162,6 +164,166 @@ TEST_CASE("/flow/IThreadPool/ThreadReturnPromiseStream") {
 	return Void();
 }
 
+struct WorkStealingReceiver final : IThreadPoolReceiver {
+	explicit WorkStealingReceiver(IThreadPool* pool) : pool(pool) {}
+	void init() override {}
+
+	// Keeps its thread busy until released, so that the actions posted after it queue up
+	struct BlockAction final : TypedAction<WorkStealingReceiver, BlockAction> {
+		std::shared_ptr<std::atomic<bool>> released;
+		explicit BlockAction(std::shared_ptr<std::atomic<bool>> released) : released(released) {}
+		double getTimeEstimate() const override { return 3.; }
+	};
+
+	void action(BlockAction& a) {
+		while (!a.released->load()) {
+			threadSleep(0.001);
+		}
+	}
+
+	struct RecordAction final : TypedAction<WorkStealingReceiver, RecordAction> {
+		ThreadActionPriority priority;
+		std::vector<ThreadActionPriority>* order;
+		ThreadReturnPromise<Void> done;
+		RecordAction(ThreadActionPriority priority, std::vector<ThreadActionPriority>* order)
+		  : priority(priority), order(order) {}
+		double getTimeEstimate() const override { return 3.; }
+		ThreadActionPriority getPriority() const override { return priority; }
+	};
+
+	void action(RecordAction& a) {
+		a.order->push_back(a.priority);
+		a.done.send(Void());
+	}
+
+	struct SequenceAction final : TypedAction<WorkStealingReceiver, SequenceAction> {
+		int sequence;
+		std::vector<int>* order;
+		ThreadReturnPromise<Void> done;
+		SequenceAction(int sequence, std::vector<int>* order) : sequence(sequence), order(order) {}
+		double getTimeEstimate() const override { return 3.; }
+	};
+
+	void action(SequenceAction& a) {
+		a.order->push_back(a.sequence);
+		a.done.send(Void());
+	}
+
+	struct ChildAction final : TypedAction<WorkStealingReceiver, ChildAction> {
+		std::atomic<int>* remaining;
+		explicit ChildAction(std::atomic<int>* remaining) : remaining(remaining) {}
+		double getTimeEstimate() const override { return 3.; }
+	};
+
+	void action(ChildAction& a) { a.remaining->fetch_sub(1); }
+
+	// Posts children, which go to this thread's own queue, and waits for them, which only finishes if other threads
+	// steal them
+	struct SpawnAction final : TypedAction<WorkStealingReceiver, SpawnAction> {
+		int children;
+		ThreadReturnPromise<Void> done;
+		explicit SpawnAction(int children) : children(children) {}
+		double getTimeEstimate() const override { return 3.; }
+	};
+
+	void action(SpawnAction& a) {
+		std::atomic<int> remaining(a.children);
+		std::vector<PThreadAction> children;
+		for (int i = 0; i < a.children; ++i) {
+			children.push_back(new ChildAction(&remaining));
+		}
+		pool->postBatch(children);
+		while (remaining.load() > 0) {
+			threadSleep(0.001);
+		}
+		a.done.send(Void());
+	}
+
+private:
+	IThreadPool* pool;
+};
+
+TEST_CASE("/flow/IThreadPool/WorkStealing/Priority") {
+	noUnseed = true;
+
+	state Reference<IThreadPool> pool = createWorkStealingThreadPool();
+	pool->addThread(new WorkStealingReceiver(pool.getPtr()), "thread-foo");
+
+	// The blocking action is posted first and isn't below any of the others, so none of them can start before it and
+	// all of them are queued by the time it finishes
+	state std::shared_ptr<std::atomic<bool>> released = std::make_shared<std::atomic<bool>>(false);
+	state std::vector<ThreadActionPriority> order;
+	state std::vector<Future<Void>> done;
+	pool->post(new WorkStealingReceiver::BlockAction(released));
+	for (auto priority : { ThreadActionPriority::Low, ThreadActionPriority::Normal, ThreadActionPriority::High }) {
+		auto* a = new WorkStealingReceiver::RecordAction(priority, &order);
+		done.push_back(a->done.getFuture());
+		pool->post(a);
+	}
+	released->store(true);
+	wait(waitForAll(done));
+
+	std::vector<ThreadActionPriority> expected = { ThreadActionPriority::High,
+		                                           ThreadActionPriority::Normal,
+		                                           ThreadActionPriority::Low };
+	ASSERT(order == expected);
+
+	wait(pool->stop());
+
+	return Void();
+}
+
+TEST_CASE("/flow/IThreadPool/WorkStealing/PostedBeforeThreads") {
+	noUnseed = true;
+
+	state Reference<IThreadPool> pool = createWorkStealingThreadPool();
+
+	// The actions posted before the thread is added run first, although the ones posted after it are queued in the
+	// thread's own queue by the time the blocking action finishes
+	state std::shared_ptr<std::atomic<bool>> released = std::make_shared<std::atomic<bool>>(false);
+	state std::vector<int> order;
+	state std::vector<Future<Void>> done;
+	pool->post(new WorkStealingReceiver::BlockAction(released));
+	for (int i = 0; i < 6; ++i) {
+		if (i == 3) {
+			pool->addThread(new WorkStealingReceiver(pool.getPtr()), "thread-foo");
+		}
+		auto* a = new WorkStealingReceiver::SequenceAction(i, &order);
+		done.push_back(a->done.getFuture());
+		pool->post(a);
+	}
+	released->store(true);
+	wait(waitForAll(done));
+
+	ASSERT(order == std::vector<int>({ 0, 1, 2, 3, 4, 5 }));
+
+	wait(pool->stop());
+
+	return Void();
+}
+
+TEST_CASE("/flow/IThreadPool/WorkStealing/Steal") {
+	noUnseed = true;
+
+	state Reference<IThreadPool> pool = createWorkStealingThreadPool();
+	for (int i = 0; i < 4; ++i) {
+		pool->addThread(new WorkStealingReceiver(pool.getPtr()), "thread-foo");
+	}
+
+	// Each spawning action blocks the thread whose queue its children are in, so they have to be stolen
+	state std::vector<Future<Void>> done;
+	for (int i = 0; i < 3; ++i) {
+		auto* a = new WorkStealingReceiver::SpawnAction(100);
+		done.push_back(a->done.getFuture());
+		pool->post(a);
+	}
+	wait(timeoutError(waitForAll(done), 60.0));
+
+	wait(pool->stop());
+
+	return Void();
+}
+
 #else
 void forceLinkIThreadPoolTests() {}
 #endif
@@ -70,14 +70,18 @@ void escapeString(std::ostringstream& oss, const std::string& source) {
 std::string JsonTraceLogFormatter::formatEvent(const TraceEventFields& fields) const {
 	std::ostringstream oss;
 	oss << "{  ";
-	for (auto iter = fields.begin(); iter != fields.end(); ++iter) {
-		if (iter != fields.begin()) {
+	for (int i = 0; i < fields.size(); ++i) {
+		if (i > 0) {
 			oss << ", ";
 		}
 		oss << "\"";
-		escapeString(oss, iter->first);
+		escapeString(oss, fields[i].first);
 		oss << "\": \"";
-		escapeString(oss, iter->second);
+		if (const TraceEventFields::Number* number = fields.getNumber(i)) {
+			oss << TraceEventFields::formatNumber(*number);
+		} else {
+			escapeString(oss, fields[i].second);
+		}
 		oss << "\"";
 	}
 	oss << " }\n";
@@ -73,8 +73,10 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 
 	init( FAST_ALLOC_LOGGING_BYTES,                           10e6 );
 	init( FAST_ALLOC_ALLOW_GUARD_PAGES,                      false );
+	init( FAST_ALLOC_HUGE_PAGES,                             false );
 	init( HUGE_ARENA_LOGGING_BYTES,                          100e6 );
 	init( HUGE_ARENA_LOGGING_INTERVAL,                         5.0 );
+	init( ARENA_BLOCK_CACHE_BYTES,                        32LL<<20 ); if( randomize && BUGGIFY ) ARENA_BLOCK_CACHE_BYTES = deterministicRandom()->coinflip() ? 0 : 1LL<<20;
 	init( ABORT_ON_FAILURE,                                  false );
 
 	init( MEMORY_USAGE_CHECK_INTERVAL,                         1.0 );
@@ -132,6 +134,7 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 	init( TLS_HANDSHAKE_THREAD_STACKSIZE,                64 * 1024 );
 	init( TLS_MALLOC_ARENA_MAX,                                  6 );
 	init( TLS_HANDSHAKE_LIMIT,                                1000 );
+	init( THREAD_POOL_WORK_STEALING,                        false );
 
 	init( NETWORK_TEST_CLIENT_COUNT,                            30 );
 	init( NETWORK_TEST_REPLY_SIZE,                           600e3 );
@@ -215,8 +218,9 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 	init( TSC_YIELD_TIME,                                  1000000 );
 	init( MIN_LOGGED_PRIORITY_BUSY_FRACTION,                  0.05 );
 	init( CERT_FILE_MAX_SIZE,                      5 * 1024 * 1024 );
-	init( READY_QUEUE_RESERVED_SIZE,                          8192 );
+	init( READY_QUEUE_RESERVED_SIZE,                          8192 ); // Unused, kept so existing knob settings are accepted
 	init( TASKS_PER_REACTOR_CHECK,                             100 );
+	init( TIMER_WHEEL_RESOLUTION,                            0.001 ); if( randomize && BUGGIFY ) TIMER_WHEEL_RESOLUTION = deterministicRandom()->coinflip() ? 0 : deterministicRandom()->random01();
 
 	//Network
 	init( PACKET_LIMIT,                                  100LL<<20 );
@@ -228,6 +232,11 @@ void FlowKnobs::initialize(Randomize randomize, IsSimulated isSimulated) {
 	init( FLOW_TCP_NODELAY,                                      1 );
 	init( FLOW_TCP_QUICKACK,                                     0 );
 	init( RESOLVE_PREFER_IPV4_ADDR,                          false );  // Default to prefer IPv6 addresses. Set to true to prefer IPv4 addresses.
+	init( NETWORK_IO_URING,                                  false );  // Only takes effect in builds with FLOW_USE_IO_URING
+	init( IO_URING_ENTRIES,                                   1024 );
+	init( IO_URING_RECEIVE_BUFFERS,                           1024 );  // Rounded up to a power of two
+	init( IO_URING_RECEIVE_BUFFER_SIZE,                  16 * 1024 );
+	init( IO_URING_MAX_UNSENT_BYTES,                    256 * 1024 );
 
 	//Sim2
 	init( MIN_OPEN_TIME,                                    0.0002 );
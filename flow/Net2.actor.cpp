@@ -279,6 +279,9 @@ public:
 #endif
 			delete this;
 		}
+
+		// A delay nobody waits on anymore
+		bool isCancelled() const { return !swiftJob && promise.getFutureReferenceCount() == 0; }
 	};
 
 	TaskQueue<PromiseTask> taskQueue;
@@ -416,6 +419,15 @@ public:
 	explicit Connection(boost::asio::io_service& io_service)
 	  : id(nondeterministicRandom()->randomUniqueID()), socket(io_service) {}
 
+#ifdef FLOW_USE_IO_URING
+	~Connection() {
+		// Otherwise the receive in flight would keep the socket open
+		if (uring) {
+			uring->close();
+		}
+	}
+#endif
+
 	// This is not part of the IConnection interface, because it is wrapped by INetwork::connect()
 	ACTOR static Future<Reference<IConnection>> connect(boost::asio::io_service* ios, NetworkAddress addr) {
 		state Reference<Connection> self(new Connection(*ios));
@@ -450,6 +462,11 @@ public:
 	// returns when write() can write at least one byte
 	Future<Void> onWritable() override {
 		++g_net2->countWriteProbes;
+#ifdef FLOW_USE_IO_URING
+		if (uring) {
+			return uring->onWritable();
+		}
+#endif
 		BindPromise p("N2_WriteProbeError", id);
 		auto f = p.getFuture();
 		socket.async_write_some(boost::asio::null_buffers(), std::move(p));
@@ -459,6 +476,11 @@ public:
 	// returns when read() can read at least one byte
 	Future<Void> onReadable() override {
 		++g_net2->countReadProbes;
+#ifdef FLOW_USE_IO_URING
+		if (uring) {
+			return uring->onReadable();
+		}
+#endif
 		BindPromise p("N2_ReadProbeError", id);
 		auto f = p.getFuture();
 		socket.async_read_some(boost::asio::null_buffers(), std::move(p));
@@ -470,6 +492,11 @@ public:
 	int read(uint8_t* begin, uint8_t* end) override {
 		boost::system::error_code err;
 		++g_net2->countReads;
+#ifdef FLOW_USE_IO_URING
+		if (uring) {
+			return readUring(begin, end);
+		}
+#endif
 		size_t toRead = end - begin;
 		size_t size = socket.read_some(boost::asio::mutable_buffers_1(begin, toRead), err);
 		g_net2->bytesReceived += size;
@@ -492,6 +519,11 @@ public:
 	int write(SendBuffer const* data, int limit) override {
 		boost::system::error_code err;
 		++g_net2->countWrites;
+#ifdef FLOW_USE_IO_URING
+		if (uring) {
+			return writeUring(data, limit);
+		}
+#endif
 
 		size_t sent = socket.write_some(
 		    boost::iterator_range<SendBufferIterator>(SendBufferIterator(data, limit), SendBufferIterator()), err);
@@ -533,10 +565,20 @@ private:
 	UID id;
 	tcp::socket socket;
 	NetworkAddress peer_address;
+#ifdef FLOW_USE_IO_URING
+	Reference<UringSocket> uring;
+#endif
 
 	void init() {
 		// Socket settings that have to be set after connect or accept succeeds
 		socket.non_blocking(true);
+#ifdef FLOW_USE_IO_URING
+		uring = g_net2->reactor.attachUring(socket.native_handle());
+		if (uring) {
+			// io_uring fails operations on non-blocking sockets that would block, instead of waiting for them
+			socket.non_blocking(false);
+		}
+#endif
 		if (FLOW_KNOBS->FLOW_TCP_NODELAY & 1) {
 			socket.set_option(boost::asio::ip::tcp::no_delay(true));
 		}
@@ -551,6 +593,11 @@ private:
 	}
 
 	void closeSocket() {
+#ifdef FLOW_USE_IO_URING
+		if (uring) {
+			uring->close();
+		}
+#endif
 		boost::system::error_code error;
 		socket.close(error);
 		if (error)
@@ -580,6 +627,33 @@ private:
 		    .detail("Message", error.message());
 		closeSocket();
 	}
+
+#ifdef FLOW_USE_IO_URING
+	int readUring(uint8_t* begin, uint8_t* end) {
+		int size = uring->read(begin, end);
+		g_net2->bytesReceived += size;
+		if (size == 0) {
+			if (uring->error()) {
+				onReadError(uring->error());
+				throw connection_failed();
+			}
+			++g_net2->countWouldBlock;
+		}
+		return size;
+	}
+
+	int writeUring(SendBuffer const* data, int limit) {
+		if (uring->error()) {
+			onWriteError(uring->error());
+			throw connection_failed();
+		}
+		int queued = uring->write(data, limit);
+		if (queued == 0) {
+			++g_net2->countWouldBlock;
+		}
+		return queued;
+	}
+#endif
 };
 
 class ReadPromise {
@@ -2059,6 +2133,11 @@ ASIOReactor::ASIOReactor(Net2* net) : do_not_stop(ios), network(net), firstTimer
 }
 
 void ASIOReactor::sleep(double sleepTime) {
+#ifdef FLOW_USE_IO_URING
+	if (uring) {
+		uring->submit();
+	}
+#endif
 	if (sleepTime > FLOW_KNOBS->BUSY_WAIT_THRESHOLD) {
 		if (FLOW_KNOBS->REACTOR_FLAGS & 4) {
 #ifdef __linux
@@ -2086,10 +2165,32 @@ void ASIOReactor::sleep(double sleepTime) {
 }
 
 void ASIOReactor::react() {
+#ifdef FLOW_USE_IO_URING
+	if (uring) {
+		uring->submit();
+		network->countASIOEvents += uring->poll();
+	}
+#endif
 	while (ios.poll_one())
 		++network->countASIOEvents; // Make this a task?
 }
 
+#ifdef FLOW_USE_IO_URING
+Reference<UringSocket> ASIOReactor::attachUring(int fd) {
+	if (!FLOW_KNOBS->NETWORK_IO_URING || uringUnavailable) {
+		return Reference<UringSocket>();
+	}
+	if (!uring) {
+		uring = UringReactor::create(ios);
+		if (!uring) {
+			uringUnavailable = true;
+			return Reference<UringSocket>();
+		}
+	}
+	return uring->attach(fd);
+}
+#endif
+
 void ASIOReactor::wake() {
 	ios.post(nullCompletionHandler);
 }
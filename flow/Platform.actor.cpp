@@ -116,6 +116,7 @@ static_assert(std::is_same<boost::asio::ip::address_v6::bytes_type, std::array<u
 #ifdef __linux__
 /* Needed for memory allocation */
 #include <linux/mman.h>
+#include <linux/mempolicy.h>
 /* Needed for processor affinity */
 #include <sched.h>
 /* Needed for getProcessorTime* and setpriority */
@@ -2205,6 +2206,41 @@ void* allocate(size_t length, bool allowLargePages, bool includeGuardPages) {
 	return block;
 }
 
+void* allocateHugePages(size_t length, bool& hugePages) {
+#ifdef __linux__
+	ASSERT(length % kHugePageBytes == 0);
+	// Reserved huge pages, if there are any
+	static std::atomic<bool> hugetlbFail = false;
+	void* block = MAP_FAILED;
+	if (!hugetlbFail) {
+		block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		hugetlbFail = block == MAP_FAILED;
+	}
+	hugePages = block != MAP_FAILED;
+
+	// Otherwise transparent huge pages, which need the block aligned to the huge page size
+	if (!hugePages) {
+		uint8_t* mapped = (uint8_t*)mmapSafe(
+		    nullptr, length + kHugePageBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		const size_t head = (kHugePageBytes - uintptr_t(mapped) % kHugePageBytes) % kHugePageBytes;
+		if (head) {
+			munmap(mapped, head);
+		}
+		munmap(mapped + head + length, kHugePageBytes - head);
+		block = mapped + head;
+		hugePages = madvise(block, length, MADV_HUGEPAGE) == 0;
+	}
+
+	// Place the pages on the node of the thread that first touches them, even if the process's policy is to interleave
+	// them. Failing is harmless, so don't check.
+	syscall(SYS_mbind, block, length, MPOL_LOCAL, nullptr, 0, 0);
+	return block;
+#else
+	hugePages = false;
+	return allocate(length, false, false);
+#endif
+}
+
 #if 0
 void* numaAllocate(size_t size) {
 	void* thePtr = (void*)0xA00000000LL;
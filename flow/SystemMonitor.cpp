@@ -71,7 +71,9 @@ SystemStatistics getSystemStatistics() {
 #define DETAILALLOCATORMEMUSAGE(size)                                                                                  \
 	detail("TotalMemory" #size, FastAllocator<size>::getTotalMemory())                                                 \
 	    .detail("ApproximateUnusedMemory" #size, FastAllocator<size>::getApproximateMemoryUnused())                    \
-	    .detail("ActiveThreads" #size, FastAllocator<size>::getActiveThreads())
+	    .detail("ActiveThreads" #size, FastAllocator<size>::getActiveThreads())                                        \
+	    .detail("HugePageMemory" #size, FastAllocator<size>::getHugePageMemory())                                      \
+	    .detail("MappedPages" #size, FastAllocator<size>::getMappedPages())
 
 namespace {
 
@@ -198,6 +200,10 @@ SystemStatistics customSystemMonitor(std::string const& eventName, StatisticsSta
 			    .DETAILALLOCATORMEMUSAGE(8192)
 			    .DETAILALLOCATORMEMUSAGE(16384)
 			    .detail("HugeArenaMemory", g_hugeArenaMemory.load())
+			    .detail("HugeArenaAllocatedBytes", g_hugeArenaAllocatedBytes.load())
+			    .detail("HugeArenaRecycledBytes", g_hugeArenaRecycledBytes.load())
+			    .detail("HugeArenaCachedBytes", g_hugeArenaCachedBytes.load())
+			    .detail("HugeArenaHugePageMemory", g_hugeArenaHugePageMemory.load())
 			    .detail("DCID", machineState.dcId)
 			    .detail("ZoneID", machineState.zoneId)
 			    .detail("MachineID", machineState.machineId);
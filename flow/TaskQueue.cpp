@@ -0,0 +1,122 @@
+/*
+ * TaskQueue.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/TaskQueue.h"
+
+#include <queue>
+
+#include "flow/UnitTest.h"
+
+namespace {
+
+struct TestTask {
+	int id;
+	TaskPriority priority = TaskPriority::Zero;
+	bool isCancelled() const { return false; }
+};
+
+} // namespace
+
+TEST_CASE("/flow/TaskQueue/readyOrder") {
+	TaskQueue<TestTask> queue;
+	// The order tasks ran in before the ready queue was bucketed: by priority, then first in first out
+	std::priority_queue<std::pair<int64_t, int>> reference;
+	int64_t issued = 0;
+	std::vector<std::unique_ptr<TestTask>> tasks;
+
+	// Named priorities, and the in-between ones that incrementPriority() and friends produce
+	const std::vector<TaskPriority> priorities = { TaskPriority::Max,
+		                                           TaskPriority::RunLoop,
+		                                           TaskPriority::DefaultDelay,
+		                                           TaskPriority::DefaultYield,
+		                                           incrementPriority(TaskPriority::DefaultEndpoint),
+		                                           TaskPriority::DefaultEndpoint,
+		                                           TaskPriority::Low,
+		                                           TaskPriority::Zero };
+	for (int step = 0; step < 10000; ++step) {
+		if (deterministicRandom()->random01() < 0.6) {
+			TaskPriority priority = deterministicRandom()->coinflip()
+			                            ? deterministicRandom()->randomChoice(priorities)
+			                            : static_cast<TaskPriority>(deterministicRandom()->randomInt(0, 10000));
+			tasks.push_back(std::make_unique<TestTask>(TestTask{ step, priority }));
+			queue.addReady(priority, tasks.back().get());
+			reference.emplace((int64_t(priority) << 32) - (++issued), step);
+		} else if (queue.hasReadyTask()) {
+			ASSERT(!reference.empty());
+			ASSERT_EQ(queue.getReadyTaskPriority(), reference.top().first);
+			ASSERT_EQ(queue.getReadyTask()->id, reference.top().second);
+			ASSERT(queue.getReadyTaskID() == queue.getReadyTask()->priority);
+			queue.popReadyTask();
+			reference.pop();
+		}
+		ASSERT_EQ(queue.getNumReadyTasks(), reference.size());
+	}
+
+	queue.clear();
+	ASSERT(!queue.hasReadyTask());
+	queue.addReady(TaskPriority::Low, tasks[0].get());
+	ASSERT(queue.getReadyTask() == tasks[0].get());
+	return Void();
+}
+
+TEST_CASE("/flow/TaskQueue/timers") {
+	TaskQueue<TestTask> queue;
+	TestTask first{ 1 }, second{ 2 }, third{ 3 };
+	queue.addTimer(2.0, TaskPriority::DefaultDelay, &third);
+	queue.addTimer(1.0, TaskPriority::DefaultDelay, &second);
+	queue.addTimer(1.0, TaskPriority::Max, &first);
+	ASSERT_EQ(queue.getSleepTime(0.5), 0.5);
+
+	// Timers that come due together run by priority
+	queue.processReadyTimers(1.5);
+	ASSERT_EQ(queue.getNumReadyTasks(), 2);
+	ASSERT(queue.getReadyTask() == &first);
+	queue.popReadyTask();
+	ASSERT(queue.getReadyTask() == &second);
+	queue.popReadyTask();
+	ASSERT_EQ(queue.getSleepTime(1.5), 0.5);
+	queue.processReadyTimers(2.0);
+	ASSERT(queue.getReadyTask() == &third);
+	queue.popReadyTask();
+	ASSERT_EQ(queue.getSleepTime(2.0), 0);
+	return Void();
+}
+
+TEST_CASE("/flow/TaskQueue/timersWithReadyTasks") {
+	TaskQueue<TestTask> queue;
+	TestTask first{ 1 }, second{ 2 }, third{ 3 }, fourth{ 4 }, fifth{ 5 };
+	queue.addTimer(1.0, TaskPriority::DefaultDelay, &first);
+	queue.addReady(TaskPriority::DefaultDelay, &second);
+	queue.addTimer(0.5, TaskPriority::DefaultDelay, &third);
+	queue.addReady(TaskPriority::DefaultDelay, &fourth);
+	queue.processReadyTimers(1.0);
+	queue.addReady(TaskPriority::DefaultDelay, &fifth);
+
+	// Timers run in the order they were added among ready tasks of the same priority, not after the tasks made ready
+	// before they came due, nor in the order they came due in
+	for (TestTask* task : { &first, &second, &third, &fourth, &fifth }) {
+		ASSERT(queue.getReadyTask() == task);
+		queue.popReadyTask();
+	}
+	ASSERT(!queue.hasReadyTask());
+	return Void();
+}
+
+void forceLinkTaskQueueTests() {}
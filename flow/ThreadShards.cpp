@@ -0,0 +1,119 @@
+/*
+ * ThreadShards.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/ThreadShards.h"
+
+#include <thread>
+
+#include "flow/UnitTest.h"
+
+namespace {
+
+struct ThreadShardSlots {
+	Mutex mutex;
+	std::vector<int> freeSlots;
+	int slots = 0;
+	uint64_t owners = 0;
+};
+
+ThreadShardSlots& threadShardSlotAllocator() {
+	static ThreadShardSlots allocator;
+	return allocator;
+}
+
+} // namespace
+
+namespace detail {
+
+std::pair<int, uint64_t> allocateThreadShardSlot() {
+	ThreadShardSlots& allocator = threadShardSlotAllocator();
+	MutexHolder holder(allocator.mutex);
+	int slot;
+	if (allocator.freeSlots.empty()) {
+		slot = allocator.slots++;
+	} else {
+		slot = allocator.freeSlots.back();
+		allocator.freeSlots.pop_back();
+	}
+	return { slot, ++allocator.owners };
+}
+
+void freeThreadShardSlot(int slot) {
+	ThreadShardSlots& allocator = threadShardSlotAllocator();
+	MutexHolder holder(allocator.mutex);
+	allocator.freeSlots.push_back(slot);
+}
+
+} // namespace detail
+
+TEST_CASE("/flow/ThreadShards/threads") {
+	struct Shard {
+		std::atomic<int64_t> value{ 0 };
+	};
+	constexpr int threadCount = 4;
+	constexpr int increments = 100000;
+	ThreadShards<Shard> shards;
+	auto sum = [&] {
+		int64_t total = 0;
+		shards.forEach([&](Shard const& shard) { total += shard.value.load(std::memory_order_relaxed); });
+		return total;
+	};
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&] {
+			for (int i = 0; i < increments; ++i) {
+				auto& value = shards.local().value;
+				value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+		});
+	}
+	// Totals read while the threads are adding never go backwards
+	for (int64_t last = 0, total = 0; total < threadCount * increments; last = total) {
+		total = sum();
+		ASSERT_GE(total, last);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQ(sum(), threadCount * increments);
+	int count = 0;
+	shards.forEach([&](Shard const&) { ++count; });
+	ASSERT_EQ(count, threadCount);
+	return Void();
+}
+
+TEST_CASE("/flow/ThreadShards/reuse") {
+	// A ThreadShards that reuses the slot of a destroyed one starts with new shards
+	for (int i = 0; i < 10; ++i) {
+		ThreadShards<int> shards;
+		ASSERT_EQ(shards.local(), 0);
+		shards.local() = i + 1;
+		ASSERT_EQ(shards.local(42), i + 1);
+	}
+	ThreadShards<int> first, second;
+	first.local(1);
+	second.local(2);
+	ASSERT_EQ(first.local(), 1);
+	ASSERT_EQ(second.local(), 2);
+	return Void();
+}
+
+void forceLinkThreadShardsTests() {}
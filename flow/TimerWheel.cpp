@@ -0,0 +1,129 @@
+/*
+ * TimerWheel.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/TimerWheel.h"
+
+#include <map>
+#include <unordered_set>
+
+#include "flow/UnitTest.h"
+
+namespace {
+
+std::unordered_set<int> cancelledTimers;
+
+struct DiscardCancelledTimers {
+	bool operator()(int id) const { return cancelledTimers.erase(id) > 0; }
+};
+
+// Checks that the wheel pops the same timers as a reference ordered map, given timers spread over the given horizon
+void testAgainstReference(double resolution, double start, double horizon) {
+	TimerWheel<int, DiscardCancelledTimers> wheel(resolution);
+	std::multimap<double, int> reference;
+	cancelledTimers.clear();
+	double now = start;
+	int nextId = 0;
+	for (int step = 0; step < 2000; ++step) {
+		for (int i = deterministicRandom()->randomInt(0, 10); i > 0; --i) {
+			// Mostly short timeouts, some long ones, and some exactly due
+			const double delay = deterministicRandom()->random01() < 0.1
+			                         ? horizon * deterministicRandom()->random01()
+			                         : deterministicRandom()->coinflip() ? 0 : 0.01 * deterministicRandom()->random01();
+			wheel.push(now + delay, nextId);
+			reference.emplace(now + delay, nextId);
+			++nextId;
+		}
+		if (!reference.empty() && deterministicRandom()->random01() < 0.2) {
+			auto cancelled = reference.begin();
+			std::advance(cancelled, deterministicRandom()->randomInt(0, reference.size()));
+			cancelledTimers.insert(cancelled->second);
+			reference.erase(cancelled);
+		}
+
+		Optional<double> next = wheel.nextTime();
+		ASSERT_EQ(next.present(), !reference.empty());
+		if (next.present()) {
+			ASSERT_EQ(next.get(), reference.begin()->first);
+		}
+
+		// Either sleep until the next timer, as simulation does, or wake up early
+		if (next.present() && deterministicRandom()->coinflip()) {
+			now = next.get();
+		} else {
+			now += 0.01 * deterministicRandom()->random01();
+		}
+		double last = -1;
+		wheel.popUntil(now, [&](int id) {
+			ASSERT(!reference.empty());
+			auto expected = reference.begin();
+			ASSERT_LE(expected->first, now);
+			ASSERT_GE(expected->first, last);
+			// Timers due at the same time may come out in any order
+			auto popped = expected;
+			while (popped != reference.end() && popped->first == expected->first && popped->second != id) {
+				++popped;
+			}
+			ASSERT(popped != reference.end() && popped->first == expected->first);
+			last = popped->first;
+			reference.erase(popped);
+		});
+		ASSERT(reference.empty() || reference.begin()->first > now);
+	}
+	ASSERT_LE(reference.size(), wheel.size());
+}
+
+} // namespace
+
+TEST_CASE("/flow/TimerWheel/simple") {
+	TimerWheel<int> wheel(0.001);
+	ASSERT(wheel.empty());
+	ASSERT(!wheel.nextTime().present());
+	wheel.push(2.5, 3);
+	wheel.push(0.0005, 1);
+	wheel.push(1e6, 4);
+	wheel.push(1.0, 2);
+	ASSERT_EQ(wheel.size(), 4);
+	ASSERT_EQ(wheel.nextTime().get(), 0.0005);
+
+	std::vector<int> popped;
+	wheel.popUntil(1.0, [&](int id) { popped.push_back(id); });
+	ASSERT(popped == std::vector<int>({ 1, 2 }));
+	ASSERT_EQ(wheel.nextTime().get(), 2.5);
+
+	// Timers added behind the cursor still come out in order
+	wheel.push(1.5, 5);
+	ASSERT_EQ(wheel.nextTime().get(), 1.5);
+	popped.clear();
+	wheel.popUntil(1e6, [&](int id) { popped.push_back(id); });
+	ASSERT(popped == std::vector<int>({ 5, 3, 4 }));
+	ASSERT(wheel.empty());
+	return Void();
+}
+
+TEST_CASE("/flow/TimerWheel/random") {
+	for (double resolution : { 0.0, 1e-6, 0.001, 0.1 }) {
+		testAgainstReference(resolution, 0, 100);
+		// Times like Net2's, with timers far enough out to overflow the top level
+		testAgainstReference(resolution, 1.7e9 + deterministicRandom()->random01(), 1e7);
+	}
+	return Void();
+}
+
+void forceLinkTimerWheelTests() {}
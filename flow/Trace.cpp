@@ -24,6 +24,7 @@
 #include "flow/Knobs.h"
 #include "flow/XmlTraceLogFormatter.h"
 #include "flow/JsonTraceLogFormatter.h"
+#include "flow/BinaryTraceLogFormatter.h"
 #include "flow/flow.h"
 #include "flow/DeterministicRandom.h"
 #include "flow/ProcessEvents.h"
@@ -131,8 +132,12 @@ private:
 
 	Reference<IThreadPool> writer;
 	uint64_t rollsize;
+	uint64_t maxLogsSize;
 	Mutex mutex;
 
+	// Bytes written to the current file of each binary trace log, by extension
+	std::map<std::string, uint64_t> binaryLogLengths;
+
 	EventMetricHandle<TraceEventNameID> SevErrorNames;
 	EventMetricHandle<TraceEventNameID> SevWarnAlwaysNames;
 	EventMetricHandle<TraceEventNameID> SevWarnNames;
@@ -226,6 +231,9 @@ public:
 		Reference<ITraceLogWriter> logWriter;
 		Reference<ITraceLogFormatter> formatter;
 		Reference<BarrierList> barriers;
+		// Writers of the binary trace logs, by extension. They are created on the network thread, but only ever
+		// referenced from this thread.
+		std::map<std::string, Reference<ITraceLogWriter>> binaryLogWriters;
 
 		struct Open final : TypedAction<WriterThread, Open> {
 			double getTimeEstimate() const override { return 0; }
@@ -241,6 +249,9 @@ public:
 		void action(Close& c) {
 			logWriter->write(formatter->getFooter());
 			logWriter->close();
+			for (auto& [extension, binaryLogWriter] : binaryLogWriters) {
+				binaryLogWriter->close();
+			}
 		}
 
 		struct Roll final : TypedAction<WriterThread, Roll> {
@@ -252,6 +263,37 @@ public:
 			logWriter->write(formatter->getHeader());
 		}
 
+		struct OpenBinary final : TypedAction<WriterThread, OpenBinary> {
+			std::string extension;
+			Reference<ITraceLogWriter> logWriter;
+
+			OpenBinary(std::string const& extension, Reference<ITraceLogWriter>&& logWriter)
+			  : extension(extension), logWriter(std::move(logWriter)) {}
+			double getTimeEstimate() const override { return 0; }
+		};
+		void action(OpenBinary& o) {
+			Reference<ITraceLogWriter>& binaryLogWriter = binaryLogWriters[o.extension];
+			binaryLogWriter = std::move(o.logWriter);
+			binaryLogWriter->open();
+		}
+
+		struct WriteBinary final : TypedAction<WriterThread, WriteBinary> {
+			std::string extension;
+			std::string records;
+			bool roll;
+
+			WriteBinary(std::string const& extension, std::string&& records, bool roll)
+			  : extension(extension), records(std::move(records)), roll(roll) {}
+			double getTimeEstimate() const override { return .001; }
+		};
+		void action(WriteBinary& a) {
+			Reference<ITraceLogWriter>& binaryLogWriter = binaryLogWriters[a.extension];
+			if (a.roll) {
+				binaryLogWriter->roll();
+			}
+			binaryLogWriter->write(a.records);
+		}
+
 		struct Barrier final : TypedAction<WriterThread, Barrier> {
 			double getTimeEstimate() const override { return 0; }
 		};
@@ -334,6 +376,7 @@ public:
 		writer->addThread(new WriterThread(barriers, logWriter, formatter), "fdb-trace-log");
 
 		rollsize = rs;
+		this->maxLogsSize = maxLogsSize;
 
 		auto a = new WriterThread::Open;
 		writer->post(a);
@@ -365,6 +408,52 @@ public:
 		}
 	}
 
+	bool writeBinary(std::string const& extension, std::string&& records) {
+		MutexHolder holder(mutex);
+		if (!opened) {
+			return false;
+		}
+
+		auto [length, created] = binaryLogLengths.try_emplace(extension, 0);
+		if (created) {
+			// Partial file renaming is left to the trace files, which would otherwise rename each other's files
+			Reference<ITraceLogWriter> logWriter(new FileTraceLogWriter(
+			    directory,
+			    processName,
+			    basename,
+			    extension,
+			    "",
+			    maxLogsSize,
+			    [this]() { barriers->triggerAll(); },
+			    issues));
+			writer->post(new WriterThread::OpenBinary(extension, std::move(logWriter)));
+		}
+		const bool roll = rollsize && length->second > 0 && length->second + records.size() > rollsize;
+		if (roll) {
+			length->second = 0;
+		}
+		length->second += records.size();
+		writer->post(new WriterThread::WriteBinary(extension, std::move(records), roll));
+		return true;
+	}
+
+	std::vector<std::string> binaryFiles(std::string const& extension) {
+		MutexHolder holder(mutex);
+		std::vector<std::string> files;
+		if (!opened) {
+			return files;
+		}
+		// Files are named <basename>.<index width>.<index>.<extension>, so they sort by index
+		const std::string prefix = basename.substr(basename.rfind('/') + 1) + ".";
+		for (const auto& file : platform::listFiles(directory, "." + extension)) {
+			if (file.starts_with(prefix)) {
+				files.push_back(joinPath(directory, file));
+			}
+		}
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
 	void annotateEvent(TraceEventFields& fields) {
 		MutexHolder holder(mutex);
 		if (!opened || fields.isAnnotated())
@@ -424,6 +513,10 @@ public:
 			}
 		}
 
+		// The latest events are read as strings, so they are formatted here rather than on the writer thread
+		if (trackError || !trackLatestKey.empty()) {
+			fields.formatValues();
+		}
 		if (trackError) {
 			latestEventCache.setLatestError(fields);
 		}
@@ -693,6 +786,11 @@ bool traceFormatImpl(std::string& format) {
 			g_traceLog.formatter = Reference<ITraceLogFormatter>(new JsonTraceLogFormatter());
 		}
 		return true;
+	} else if (format == "binary") {
+		if (!validate) {
+			g_traceLog.formatter = Reference<ITraceLogFormatter>(new BinaryTraceLogFormatter());
+		}
+		return true;
 	} else {
 		if (!validate) {
 			g_traceLog.formatter = Reference<ITraceLogFormatter>(new XmlTraceLogFormatter());
@@ -835,6 +933,14 @@ bool traceFileIsOpen() {
 	return g_traceLog.isOpen();
 }
 
+bool writeBinaryTraceLog(std::string const& extension, std::string&& records) {
+	return g_traceLog.writeBinary(extension, std::move(records));
+}
+
+std::vector<std::string> getBinaryTraceLogFiles(std::string const& extension) {
+	return g_traceLog.binaryFiles(extension);
+}
+
 void addTraceRole(std::string const& role) {
 	g_traceLog.addRole(role);
 }
@@ -1138,6 +1244,28 @@ BaseTraceEvent& BaseTraceEvent::detailImpl(std::string&& key, std::string&& valu
 	return *this;
 }
 
+BaseTraceEvent& BaseTraceEvent::detailNumber(std::string&& key, TraceEventFields::Number value) {
+	// The longest a formatted number can be: 20 characters for an integer, and fewer for a double printed with %g
+	constexpr int maxNumberLength = 20;
+	if (maxFieldLength >= 0 && maxFieldLength < maxNumberLength) {
+		return detailImpl(std::move(key), TraceEventFields::formatNumber(value), false);
+	}
+	init();
+	if (enabled) {
+		++g_allocation_tracing_disabled;
+		fields.addField(std::move(key), value);
+
+		if (maxEventLength >= 0 && fields.sizeBytes() > maxEventLength) {
+			TraceEvent(g_network && g_network->isSimulated() ? SevError : SevWarnAlways, "TraceEventOverflow")
+			    .setMaxEventLength(1000)
+			    .detail("TraceFirstBytes", fields.toString().substr(0, 300));
+			enabled = BaseTraceEvent::State::disabled();
+		}
+		--g_allocation_tracing_disabled;
+	}
+	return *this;
+}
+
 void BaseTraceEvent::setField(const char* key, int64_t value) {
 	++g_allocation_tracing_disabled;
 	tmpEventMetric->setField(key, value);
@@ -1591,6 +1719,41 @@ void TraceEventFields::addField(std::string&& key, std::string&& value) {
 	fields.emplace_back(std::move(key), std::move(value));
 }
 
+namespace {
+// What a number is counted as in sizeBytes() until it is formatted
+constexpr size_t numberBytes = 8;
+} // namespace
+
+void TraceEventFields::addField(std::string&& key, Number value) {
+	bytes += key.size() + numberBytes;
+	numbers.emplace_back(fields.size(), value);
+	fields.emplace_back(std::move(key), std::string());
+}
+
+const TraceEventFields::Number* TraceEventFields::getNumber(int index) const {
+	auto number = std::lower_bound(
+	    numbers.begin(), numbers.end(), index, [](auto const& number, int index) { return number.first < index; });
+	return number != numbers.end() && number->first == index ? &number->second : nullptr;
+}
+
+void TraceEventFields::formatValues() {
+	for (auto const& [index, number] : numbers) {
+		fields[index].second = formatNumber(number);
+		bytes = bytes - numberBytes + fields[index].second.size();
+	}
+	numbers.clear();
+}
+
+std::string TraceEventFields::formatNumber(const Number& value) {
+	// The same as Traceable<T>::toString() gives
+	if (auto integer = std::get_if<int64_t>(&value)) {
+		return format("%lld", *integer);
+	} else if (auto unsignedInteger = std::get_if<uint64_t>(&value)) {
+		return format("%llu", *unsignedInteger);
+	}
+	return format("%g", std::get<double>(value));
+}
+
 size_t TraceEventFields::size() const {
 	return fields.size();
 }
@@ -1621,9 +1784,10 @@ const TraceEventFields::Field& TraceEventFields::operator[](int index) const {
 }
 
 bool TraceEventFields::tryGetValue(std::string key, std::string& outValue) const {
-	for (auto itr = begin(); itr != end(); ++itr) {
-		if (itr->first == key) {
-			outValue = itr->second;
+	for (int i = 0; i < fields.size(); ++i) {
+		if (fields[i].first == key) {
+			const Number* number = getNumber(i);
+			outValue = number ? formatNumber(*number) : fields[i].second;
 			return true;
 		}
 	}
@@ -1777,14 +1941,15 @@ double TraceEventFields::getDouble(std::string key, bool permissive) const {
 
 std::string TraceEventFields::toString() const {
 	std::string str;
-	bool first = true;
-	for (auto itr = begin(); itr != end(); ++itr) {
-		if (!first) {
+	for (int i = 0; i < fields.size(); ++i) {
+		if (i > 0) {
 			str += ", ";
 		}
-		first = false;
 
-		str += format("\"%s\"=\"%s\"", itr->first.c_str(), itr->second.c_str());
+		const Number* number = getNumber(i);
+		str += format("\"%s\"=\"%s\"",
+		              fields[i].first.c_str(),
+		              number ? formatNumber(*number).c_str() : fields[i].second.c_str());
 	}
 
 	return str;
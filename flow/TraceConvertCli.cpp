@@ -0,0 +1,151 @@
+/*
+ * TraceConvertCli.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <fmt/format.h>
+#include "flow/BinaryTraceLogFormatter.h"
+#include "flow/Error.h"
+#include "flow/JsonTraceLogFormatter.h"
+#include "flow/Platform.h"
+#include "flow/XmlTraceLogFormatter.h"
+#include "SimpleOpt/SimpleOpt.h"
+
+enum ETraceConvertOpt : int {
+	OPT_HELP,
+	OPT_FORMAT,
+	OPT_STDOUT,
+};
+
+CSimpleOpt::SOption gOptions[] = { { OPT_HELP, "--help", SO_NONE },
+	                               { OPT_HELP, "-h", SO_NONE },
+	                               { OPT_FORMAT, "--format", SO_REQ_SEP },
+	                               { OPT_FORMAT, "-f", SO_REQ_SEP },
+	                               { OPT_STDOUT, "--stdout", SO_NONE },
+	                               SO_END_OF_OPTIONS };
+
+void printUsage(std::string_view binary) {
+	fmt::print(stdout,
+	           "traceconvert: converts binary trace log files to xml or json\n\n"
+	           "Usage: {} [OPTIONS...] FILE...\n\n"
+	           "Each FILE is written next to it, with its extension replaced by that of the format.\n\n"
+	           "  --format FORMAT, -f FORMAT (default: xml)\n"
+	           "                xml or json.\n\n"
+	           "  --stdout (default: no)\n"
+	           "                Write the converted files to standard output instead.\n\n",
+	           binary);
+}
+
+// Converts one file. Returns false, after saying why, if it can't be read or isn't a binary trace log file.
+bool convert(std::string const& input, ITraceLogFormatter const& formatter, bool toStdout) {
+	std::ifstream in(input, std::ios::binary);
+	if (!in) {
+		fmt::print(stderr, "ERROR: could not open '{}'\n", input);
+		return false;
+	}
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	std::string output;
+	try {
+		BinaryTraceLogReader reader{ StringRef(data) };
+		output = formatter.getHeader();
+		TraceEventFields fields;
+		while (reader.next(fields)) {
+			output += formatter.formatEvent(fields);
+		}
+		output += formatter.getFooter();
+	} catch (Error& e) {
+		fmt::print(stderr, "ERROR: '{}' is not a binary trace log file ({})\n", input, e.what());
+		return false;
+	}
+
+	if (toStdout) {
+		std::cout << output;
+		return true;
+	}
+	std::string outputName = input;
+	if (auto dot = outputName.rfind('.'); dot != std::string::npos && outputName.find('/', dot) == std::string::npos) {
+		outputName.resize(dot);
+	}
+	outputName += std::string(".") + formatter.getExtension();
+	std::ofstream out(outputName, std::ios::binary | std::ios::trunc);
+	out << output;
+	if (!out) {
+		fmt::print(stderr, "ERROR: could not write '{}'\n", outputName);
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	std::string format = "xml";
+	bool toStdout = false;
+	auto args = CSimpleOpt(argc, argv, gOptions, SO_O_EXACT | SO_O_HYPHEN_TO_UNDERSCORE);
+	while (args.Next()) {
+		if (auto err = args.LastError()) {
+			switch (err) {
+			case SO_ARG_MISSING:
+				fmt::print(stderr, "ERROR: argument missing for option '{}'\n", args.OptionText());
+				return FDB_EXIT_ERROR;
+			case SO_OPT_INVALID:
+				fmt::print(stderr, "ERROR: unknown option '{}'\n", args.OptionText());
+				return FDB_EXIT_ERROR;
+			default:
+				fmt::print(
+				    stderr, "ERROR: unknown error {} with option '{}'\n", static_cast<int>(err), args.OptionText());
+				return FDB_EXIT_ERROR;
+			}
+		}
+		switch (args.OptionId()) {
+		case OPT_HELP:
+			printUsage(argv[0]);
+			return FDB_EXIT_SUCCESS;
+		case OPT_FORMAT:
+			format = args.OptionArg();
+			break;
+		case OPT_STDOUT:
+			toStdout = true;
+			break;
+		}
+	}
+
+	Reference<ITraceLogFormatter> formatter;
+	if (format == "xml") {
+		formatter = makeReference<XmlTraceLogFormatter>();
+	} else if (format == "json") {
+		formatter = makeReference<JsonTraceLogFormatter>();
+	} else {
+		fmt::print(stderr, "ERROR: unknown format '{}'\n", format);
+		return FDB_EXIT_ERROR;
+	}
+	if (args.FileCount() == 0) {
+		printUsage(argv[0]);
+		return FDB_EXIT_ERROR;
+	}
+
+	bool converted = true;
+	for (int i = 0; i < args.FileCount(); ++i) {
+		converted = convert(args.File(i), *formatter, toStdout) && converted;
+	}
+	return converted ? FDB_EXIT_SUCCESS : FDB_EXIT_ERROR;
+}
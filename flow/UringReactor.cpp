@@ -0,0 +1,371 @@
+/*
+ * UringReactor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/UringReactor.h"
+
+#ifdef FLOW_USE_IO_URING
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include "flow/CodeProbe.h"
+#include "flow/Knobs.h"
+#include "flow/Trace.h"
+
+namespace N2 {
+
+UringSocket::~UringSocket() {
+	while (!received.empty()) {
+		reactor->returnBuffer(received.front().buffer);
+		received.pop_front();
+	}
+}
+
+int UringSocket::read(uint8_t* begin, uint8_t* end) {
+	uint8_t* p = begin;
+	while (p != end && !received.empty()) {
+		Received& r = received.front();
+		const int n = std::min<int64_t>(end - p, r.length - r.offset);
+		memcpy(p, reactor->buffers.get() + size_t(r.buffer) * reactor->bufferSize + r.offset, n);
+		p += n;
+		r.offset += n;
+		if (r.offset == r.length) {
+			reactor->returnBuffer(r.buffer);
+			received.pop_front();
+		}
+	}
+	return p - begin;
+}
+
+int UringSocket::write(SendBuffer const* data, int limit) {
+	limit = std::min(limit, sendSpace());
+	int queued = 0;
+	for (auto p = data; p && queued < limit; p = p->next) {
+		const int n = std::min(p->bytes_unsent(), limit - queued);
+		unsent.insert(unsent.end(), p->data() + p->bytes_sent, p->data() + p->bytes_sent + n);
+		queued += n;
+	}
+	if (queued) {
+		queueSubmit();
+	}
+	return queued;
+}
+
+Future<Void> UringSocket::onReadable() {
+	if (!received.empty() || err) {
+		return Void();
+	}
+	if (readable.isSet()) {
+		readable = Promise<Void>();
+	}
+	return readable.getFuture();
+}
+
+Future<Void> UringSocket::onWritable() {
+	if (sendSpace() > 0 || err) {
+		return Void();
+	}
+	if (writable.isSet()) {
+		writable = Promise<Void>();
+	}
+	return writable.getFuture();
+}
+
+void UringSocket::close() {
+	if (closed) {
+		return;
+	}
+	closed = true;
+	for (auto [op, inFlight] : { std::make_pair(UringReactor::Op::Receive, receiving),
+	                             std::make_pair(UringReactor::Op::Send, sendInFlight) }) {
+		if (inFlight) {
+			io_uring_sqe* sqe = reactor->getSqe();
+			io_uring_prep_cancel64(sqe, reinterpret_cast<uintptr_t>(this) | uintptr_t(op), 0);
+			io_uring_sqe_set_data64(sqe, uintptr_t(UringReactor::Op::Cancel));
+		}
+	}
+	// Cancel now rather than at the next submit, so that the socket really closes when the Connection closes it
+	reactor->submit();
+}
+
+int UringSocket::sendSpace() const {
+	const int64_t waiting = unsent.size() + (sending.size() - sendOffset);
+	return std::max<int64_t>(0, FLOW_KNOBS->IO_URING_MAX_UNSENT_BYTES - waiting);
+}
+
+void UringSocket::fail(boost::system::error_code const& e) {
+	if (!err) {
+		err = e;
+	}
+	if (readable.canBeSet()) {
+		readable.send(Void());
+	}
+	if (writable.canBeSet()) {
+		writable.send(Void());
+	}
+}
+
+void UringSocket::queueSubmit() {
+	if (!submitQueued) {
+		submitQueued = true;
+		reactor->submitQueue.push_back(Reference<UringSocket>::addRef(this));
+	}
+}
+
+UringReactor::UringReactor(boost::asio::io_context& ios) : eventDescriptor(ios) {}
+
+std::unique_ptr<UringReactor> UringReactor::create(boost::asio::io_context& ios) {
+	std::unique_ptr<UringReactor> reactor(new UringReactor(ios));
+	auto unavailable = [](const char* reason, int error) {
+		TraceEvent(SevWarnAlways, "Net2IoUringUnavailable")
+		    .detail("Reason", reason)
+		    .detail("Error", strerror(error))
+		    .detail("ErrorCode", error);
+		return nullptr;
+	};
+
+	// Only the network thread uses the ring. Single issuer rings came in Linux 6.0, as did multishot receives, so this
+	// also checks that those are supported.
+	int result = io_uring_queue_init(FLOW_KNOBS->IO_URING_ENTRIES, &reactor->ring, IORING_SETUP_SINGLE_ISSUER);
+	if (result < 0) {
+		return unavailable("QueueInit", -result);
+	}
+	reactor->ringInitialized = true;
+
+	reactor->bufferCount = std::bit_ceil(unsigned(std::clamp(FLOW_KNOBS->IO_URING_RECEIVE_BUFFERS, 1, 1 << 15)));
+	reactor->bufferSize = FLOW_KNOBS->IO_URING_RECEIVE_BUFFER_SIZE;
+	reactor->bufferRing = io_uring_setup_buf_ring(&reactor->ring, reactor->bufferCount, bufferGroup, 0, &result);
+	if (!reactor->bufferRing) {
+		return unavailable("SetupBufferRing", -result);
+	}
+	reactor->buffers.reset(new uint8_t[size_t(reactor->bufferCount) * reactor->bufferSize]);
+	for (int i = 0; i < reactor->bufferCount; ++i) {
+		reactor->returnBuffer(i);
+	}
+
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0) {
+		return unavailable("EventFD", errno);
+	}
+	reactor->eventDescriptor.assign(fd);
+	result = io_uring_register_eventfd(&reactor->ring, fd);
+	if (result < 0) {
+		return unavailable("RegisterEventFD", -result);
+	}
+	reactor->watchEventFD();
+
+	TraceEvent("Net2IoUringEnabled")
+	    .detail("Entries", FLOW_KNOBS->IO_URING_ENTRIES)
+	    .detail("ReceiveBuffers", reactor->bufferCount)
+	    .detail("ReceiveBufferSize", reactor->bufferSize);
+	return reactor;
+}
+
+UringReactor::~UringReactor() {
+	if (bufferRing) {
+		io_uring_free_buf_ring(&ring, bufferRing, bufferCount, bufferGroup);
+	}
+	if (ringInitialized) {
+		io_uring_queue_exit(&ring);
+	}
+}
+
+Reference<UringSocket> UringReactor::attach(int fd) {
+	Reference<UringSocket> socket(new UringSocket(this, fd));
+	socket->queueSubmit();
+	return socket;
+}
+
+void UringReactor::submit() {
+	if (returnedBuffers) {
+		io_uring_buf_ring_advance(bufferRing, returnedBuffers);
+		freeBuffers += returnedBuffers;
+		returnedBuffers = 0;
+		for (auto& socket : waitingForBuffers) {
+			socket->queueSubmit();
+		}
+		waitingForBuffers.clear();
+	}
+
+	submitting.swap(submitQueue);
+	for (auto& socket : submitting) {
+		socket->submitQueued = false;
+		prepare(socket.getPtr());
+	}
+	submitting.clear();
+
+	if (unsubmitted) {
+		unsubmitted = false;
+		int result = io_uring_submit(&ring);
+		if (result < 0) {
+			TraceEvent(SevError, "Net2IoUringSubmitError").detail("Error", strerror(-result));
+		}
+	}
+}
+
+int UringReactor::poll() {
+	// Take every completion off the ring before handling any, since handling them runs actors
+	io_uring_cqe* cqe;
+	unsigned head;
+	completions.clear();
+	io_uring_for_each_cqe(&ring, head, cqe) {
+		completions.push_back(Completion{ cqe->user_data, cqe->res, cqe->flags });
+	}
+	io_uring_cq_advance(&ring, completions.size());
+
+	for (auto const& c : completions) {
+		const Op op = static_cast<Op>(c.userData & opMask);
+		if (op != Op::Cancel) {
+			complete(reinterpret_cast<UringSocket*>(c.userData & ~opMask), op, c.result, c.flags);
+		}
+	}
+	return completions.size();
+}
+
+io_uring_sqe* UringReactor::getSqe() {
+	io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+	if (!sqe) {
+		// The submission queue is full, so submit what is in it
+		io_uring_submit(&ring);
+		sqe = io_uring_get_sqe(&ring);
+		ASSERT(sqe);
+	}
+	unsubmitted = true;
+	return sqe;
+}
+
+void UringReactor::prepare(UringSocket* socket) {
+	if (socket->closed || socket->err) {
+		return;
+	}
+	if (!socket->receiving) {
+		io_uring_sqe* sqe = getSqe();
+		io_uring_prep_recv_multishot(sqe, socket->fd, nullptr, 0, 0);
+		sqe->flags |= IOSQE_BUFFER_SELECT;
+		sqe->buf_group = bufferGroup;
+		io_uring_sqe_set_data64(sqe, reinterpret_cast<uintptr_t>(socket) | uintptr_t(Op::Receive));
+		socket->receiving = true;
+		socket->addref();
+	}
+	if (!socket->sendInFlight) {
+		if (socket->sending.empty()) {
+			socket->sending.swap(socket->unsent);
+			socket->sendOffset = 0;
+		}
+		if (!socket->sending.empty()) {
+			io_uring_sqe* sqe = getSqe();
+			io_uring_prep_send(sqe,
+			                   socket->fd,
+			                   socket->sending.data() + socket->sendOffset,
+			                   socket->sending.size() - socket->sendOffset,
+			                   MSG_NOSIGNAL);
+			io_uring_sqe_set_data64(sqe, reinterpret_cast<uintptr_t>(socket) | uintptr_t(Op::Send));
+			socket->sendInFlight = true;
+			socket->addref();
+		}
+	}
+}
+
+void UringReactor::complete(UringSocket* socket, Op op, int result, uint32_t flags) {
+	if (op == Op::Receive) {
+		if (flags & IORING_CQE_F_BUFFER) {
+			const uint16_t buffer = flags >> IORING_CQE_BUFFER_SHIFT;
+			--freeBuffers;
+			if (result > 0 && !socket->closed) {
+				socket->received.push_back(UringSocket::Received{ buffer, 0, result });
+				if (socket->readable.canBeSet()) {
+					socket->readable.send(Void());
+				}
+			} else {
+				returnBuffer(buffer);
+			}
+		}
+		const bool more = flags & IORING_CQE_F_MORE;
+		if (!more) {
+			socket->receiving = false;
+		}
+		if (result == 0) {
+			socket->fail(boost::asio::error::eof);
+		} else if (result == -ENOBUFS) {
+			CODE_PROBE(true, "io_uring receive ran out of provided buffers");
+			if (freeBuffers + returnedBuffers > 0) {
+				socket->queueSubmit();
+			} else {
+				waitingForBuffers.push_back(Reference<UringSocket>::addRef(socket));
+			}
+		} else if (result < 0) {
+			socket->fail(boost::system::error_code(-result, boost::system::system_category()));
+		} else if (!more) {
+			// The kernel ends a multishot receive now and then, so start another
+			socket->queueSubmit();
+		}
+	} else {
+		ASSERT(op == Op::Send);
+		socket->sendInFlight = false;
+		if (result < 0) {
+			socket->fail(boost::system::error_code(-result, boost::system::system_category()));
+		} else {
+			// Sends can be short, in which case the rest is sent next time
+			socket->sendOffset += result;
+			if (socket->sendOffset == socket->sending.size()) {
+				socket->sending.clear();
+				socket->sendOffset = 0;
+			}
+			if (!socket->sending.empty() || !socket->unsent.empty()) {
+				socket->queueSubmit();
+			}
+			if (socket->writable.canBeSet() && socket->sendSpace() > 0) {
+				socket->writable.send(Void());
+			}
+		}
+	}
+	// Each operation holds a reference until it is done
+	if (op == Op::Send || !(flags & IORING_CQE_F_MORE)) {
+		socket->delref();
+	}
+}
+
+void UringReactor::returnBuffer(uint16_t buffer) {
+	io_uring_buf_ring_add(bufferRing,
+	                      buffers.get() + size_t(buffer) * bufferSize,
+	                      bufferSize,
+	                      buffer,
+	                      io_uring_buf_ring_mask(bufferCount),
+	                      returnedBuffers++);
+}
+
+void UringReactor::watchEventFD() {
+	eventDescriptor.async_read_some(boost::asio::buffer(&eventValue, sizeof(eventValue)),
+	                                [this](boost::system::error_code const& error, size_t) {
+		                                if (error) {
+			                                // The reactor is being destroyed
+			                                return;
+		                                }
+		                                poll();
+		                                watchEventFD();
+	                                });
+}
+
+} // namespace N2
+
+#endif // FLOW_USE_IO_URING
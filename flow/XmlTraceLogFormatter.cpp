@@ -78,10 +78,14 @@ std::string XmlTraceLogFormatter::formatEvent(const TraceEventFields& fields) co
 	std::ostringstream oss;
 	oss << "<Event ";
 
-	for (auto itr : fields) {
-		escape(oss, itr.first);
+	for (int i = 0; i < fields.size(); ++i) {
+		escape(oss, fields[i].first);
 		oss << "=\"";
-		escape(oss, itr.second);
+		if (const TraceEventFields::Number* number = fields.getNumber(i)) {
+			oss << TraceEventFields::formatNumber(*number);
+		} else {
+			escape(oss, fields[i].second);
+		}
 		oss << "\" ";
 	}
 
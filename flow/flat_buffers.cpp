@@ -24,6 +24,7 @@
 #include "flow/Arena.h"
 #include "flow/serialize.h"
 #include "flow/ObjectSerializer.h"
+#include "flow/ObjectView.h"
 
 #include <algorithm>
 #include <iomanip>
@@ -614,4 +615,161 @@ TEST_CASE("/flow/FlatBuffers/NonEmptyUnorderedSet") {
 	return Void();
 }
 
+struct FixedInner {
+	int16_t a = 0;
+	int64_t b = 0;
+	template <class Archiver>
+	void serialize(Archiver& ar) {
+		serializer(ar, a, b);
+	}
+};
+
+struct FixedMessage {
+	uint8_t a = 0;
+	FixedInner inner;
+	std::tuple<int16_t, bool, int64_t> c;
+	double d = 0;
+	template <class Archiver>
+	void serialize(Archiver& ar) {
+		serializer(ar, a, inner, c, d);
+	}
+};
+
+struct VariableMessage {
+	int64_t a = 0;
+	std::vector<int> b;
+	template <class Archiver>
+	void serialize(Archiver& ar) {
+		serializer(ar, a, b);
+	}
+};
+
+TEST_CASE("/flow/FlatBuffers/fixedLayout") {
+	Arena arena;
+	TestContext context{ arena };
+	ASSERT(!detail::get_vtableset(VariableMessage{}, context)->fixed_layout);
+	const auto* vtableset = detail::get_vtableset(FixedMessage{}, context);
+	ASSERT(vtableset->fixed_layout);
+
+	// Messages saved with the layout computed for the first one are the same as when it's computed for each
+	for (int i = 0; i < 100; ++i) {
+		FixedMessage message;
+		message.a = deterministicRandom()->randomInt(0, 256);
+		message.inner.a = deterministicRandom()->randomInt(-32768, 32768);
+		message.inner.b = deterministicRandom()->randomInt64(std::numeric_limits<int64_t>::min(),
+		                                                     std::numeric_limits<int64_t>::max());
+		message.c = { deterministicRandom()->randomInt(0, 100), deterministicRandom()->coinflip(), i };
+		message.d = deterministicRandom()->random01();
+		const uint8_t* fixed = detail::save_fixed_layout(context, message, vtableset, FileIdentifier{ 1234 });
+		const uint8_t* any = detail::save_any_layout(context, message, vtableset, FileIdentifier{ 1234 });
+		ASSERT_EQ(arena.get_size(fixed), arena.get_size(any));
+		ASSERT(memcmp(fixed, any, arena.get_size(any)) == 0);
+
+		FixedMessage loaded;
+		detail::load(loaded, fixed, context);
+		ASSERT(loaded.a == message.a && loaded.inner.a == message.inner.a && loaded.inner.b == message.inner.b);
+		ASSERT(loaded.c == message.c && loaded.d == message.d);
+	}
+	return Void();
+}
+
 } // namespace unit_tests
+
+namespace {
+
+struct ViewTestEntry {
+	StringRef key;
+	int64_t version = 0;
+};
+
+} // namespace
+
+template <>
+struct string_serialized_traits<ViewTestEntry> : std::true_type {
+	int32_t getSize(const ViewTestEntry& item) const { return sizeof(uint32_t) + item.key.size() + sizeof(int64_t); }
+
+	uint32_t save(uint8_t* out, const ViewTestEntry& item) const {
+		uint32_t size = item.key.size();
+		memcpy(out, &size, sizeof(size));
+		memcpy(out + sizeof(size), item.key.begin(), size);
+		memcpy(out + sizeof(size) + size, &item.version, sizeof(item.version));
+		return getSize(item);
+	}
+
+	template <class Context>
+	uint32_t load(const uint8_t* data, ViewTestEntry& item, Context& context) {
+		uint32_t size;
+		memcpy(&size, data, sizeof(size));
+		item.key = StringRef(context.tryReadZeroCopy(data + sizeof(size), size), size);
+		memcpy(&item.version, data + sizeof(size) + size, sizeof(item.version));
+		return getSize(item);
+	}
+};
+
+namespace {
+
+struct ViewTestMessage {
+	constexpr static FileIdentifier file_identifier = 9514729;
+	Arena arena;
+	int64_t version = 0;
+	Optional<int64_t> popped;
+	VectorRef<StringRef> keys;
+	VectorRef<ViewTestEntry, VecSerStrategy::String> entries;
+	bool more = false;
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, version, popped, keys, entries, more, arena);
+	}
+};
+
+bool pointsInto(StringRef s, StringRef buffer) {
+	return s.begin() >= buffer.begin() && s.end() <= buffer.end();
+}
+
+} // namespace
+
+TEST_CASE("/flow/FlatBuffers/ObjectView") {
+	ViewTestMessage message;
+	message.version = deterministicRandom()->randomInt64(0, 1e12);
+	message.popped = message.version - 1;
+	message.more = true;
+	for (int i = deterministicRandom()->randomInt(0, 100); i > 0; --i) {
+		const int keyLength = deterministicRandom()->randomInt(0, 20);
+		StringRef key(message.arena, deterministicRandom()->randomAlphaNumeric(keyLength));
+		message.keys.push_back(message.arena, key);
+		message.entries.push_back(message.arena, ViewTestEntry{ key, i });
+	}
+	Standalone<StringRef> serialized = ObjectWriter::toValue(message, Unversioned());
+
+	ObjectView<ViewTestMessage> view(serialized.arena(), serialized, Unversioned());
+	ASSERT_EQ(view.get<&ViewTestMessage::version>(), message.version);
+	ASSERT(view.get<&ViewTestMessage::popped>() == message.popped);
+	ASSERT(view.get<&ViewTestMessage::more>());
+
+	// Elements are read in place, in any order for flatbuffers vectors and in order for string serialized ones
+	auto keys = view.getVector<&ViewTestMessage::keys>();
+	ASSERT_EQ(keys.size(), message.keys.size());
+	for (int i = keys.size() - 1; i >= 0; --i) {
+		ASSERT(keys[i] == message.keys[i]);
+		ASSERT(keys[i].empty() || pointsInto(keys[i], serialized));
+	}
+	int i = 0;
+	for (auto const& entry : view.getVector<&ViewTestMessage::entries>()) {
+		ASSERT(entry.key == message.entries[i].key && entry.version == message.entries[i].version);
+		ASSERT(entry.key.empty() || pointsInto(entry.key, serialized));
+		++i;
+	}
+	ASSERT_EQ(i, message.entries.size());
+
+	// Members left at their defaults
+	ViewTestMessage empty;
+	serialized = ObjectWriter::toValue(empty, Unversioned());
+	ObjectView<ViewTestMessage> emptyView(serialized.arena(), serialized, Unversioned());
+	ASSERT(!emptyView.get<&ViewTestMessage::popped>().present());
+	ASSERT(!emptyView.get<&ViewTestMessage::more>());
+	ASSERT(emptyView.getVector<&ViewTestMessage::keys>().empty());
+	ASSERT(emptyView.getVector<&ViewTestMessage::entries>().begin() ==
+	       emptyView.getVector<&ViewTestMessage::entries>().end());
+	return Void();
+}
@@ -180,6 +180,7 @@ struct ArenaBlock : NonCopyable, ThreadSafeReferenceCounted<ArenaBlock> {
 	// if tinySize != NOT_TINY, following variables aren't used
 	uint32_t bigSize, bigUsed; // include block header
 	uint32_t nextBlockOffset;
+	bool hugePages; // If this is set, the block came from huge pages rather than new[], see FAST_ALLOC_HUGE_PAGES
 	mutable size_t totalSizeEstimate; // Estimate of the minimum total size of arena blocks this one reaches
 
 	void addref();
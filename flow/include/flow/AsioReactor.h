@@ -26,6 +26,7 @@
 #include <boost/bind/bind.hpp>
 
 #include "flow/flow.h"
+#include "flow/UringReactor.h"
 
 namespace N2 { // No indent, it's the whole file
 
@@ -46,9 +47,20 @@ public:
 	boost::asio::io_service::work
 	    do_not_stop; // Reactor needs to keep running when there is nothing to do until stopped explicitly
 
+#ifdef FLOW_USE_IO_URING
+	// Returns the io_uring state to drive a newly connected socket with, or an empty reference if it should be driven
+	// through ios instead
+	Reference<UringSocket> attachUring(int fd);
+#endif
+
 private:
 	Net2* network;
 	boost::asio::deadline_timer firstTimer;
+#ifdef FLOW_USE_IO_URING
+	// Created on first use, so that NETWORK_IO_URING can be set after the network is
+	std::unique_ptr<UringReactor> uring;
+	bool uringUnavailable = false;
+#endif
 
 	static void nullWaitHandler(const boost::system::error_code&) {}
 	static void nullCompletionHandler() {}
@@ -0,0 +1,84 @@
+/*
+ * BinaryTraceLogFormatter.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_BINARY_TRACE_LOG_FORMATTER_H
+#define FLOW_BINARY_TRACE_LOG_FORMATTER_H
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flow/Arena.h"
+#include "flow/FastRef.h"
+#include "flow/Trace.h"
+
+// Writes trace events in a compact binary form, which traceconvert turns back into XML or JSON. Field names are
+// interned: each is written out the first time it appears in a file, and by number after that. Integers are written as
+// varints and doubles as their 8 bytes. Details that were added as numbers (see TraceEventFields::Number) are written
+// that way without ever being turned into strings, which XML and JSON have to do on the writer thread. A value that is
+// the same as the field's value in the previous event that had it takes a single byte, which covers the fields like
+// Machine and Roles that every event repeats.
+//
+// Every file starts with the header and can be read on its own.
+struct BinaryTraceLogFormatter final : public ITraceLogFormatter, ReferenceCounted<BinaryTraceLogFormatter> {
+	void addref() override;
+	void delref() override;
+
+	const char* getExtension() const override;
+	// Also forgets the names interned so far, since a new file is starting
+	const char* getHeader() const override;
+	const char* getFooter() const override;
+	std::string formatEvent(const TraceEventFields& fields) const override;
+
+	// A value as it is written: an integer, the bits of a double, or a string
+	struct Value {
+		uint8_t type = 0;
+		int64_t integer = 0;
+		std::string string;
+
+		bool operator==(const Value& other) const {
+			return type == other.type && integer == other.integer && string == other.string;
+		}
+	};
+
+private:
+	// Called only from the trace log's writer thread
+	mutable std::unordered_map<std::string, int> names;
+	mutable std::vector<Value> lastValues;
+};
+
+// Reads the events of a file written by BinaryTraceLogFormatter
+class BinaryTraceLogReader {
+public:
+	// data must outlive the reader. Throws file_corrupt() if it doesn't start with the header.
+	explicit BinaryTraceLogReader(StringRef data);
+
+	// Reads the next event into fields. Returns false at the end of the file, or if all that is left of it is an event
+	// whose writing was cut short. Throws file_corrupt() if the event can't be decoded.
+	bool next(TraceEventFields& fields);
+
+private:
+	StringRef remaining;
+	std::vector<std::string> names;
+	std::vector<std::string> lastValues;
+};
+
+#endif
@@ -103,6 +103,9 @@ void recordDeallocation(void* ptr);
 #endif
 
 inline constexpr auto kFastAllocMagazineBytes = 128 << 10;
+// With FAST_ALLOC_HUGE_PAGES, magazines are carved out of slabs of this many bytes
+inline constexpr auto kFastAllocSlabBytes = 2 << 20;
+static_assert(kFastAllocSlabBytes % kFastAllocMagazineBytes == 0);
 
 template <int Size>
 class FastAllocator {
@@ -114,6 +117,11 @@ public:
 	static long long getTotalMemory();
 	static long long getApproximateMemoryUnused();
 	static long long getActiveThreads();
+	// Memory in magazines carved out of huge pages
+	static long long getHugePageMemory();
+	// Number of pages, huge or not, that the memory in magazines is spread over, and so the number of TLB entries it
+	// takes to map it all
+	static long long getMappedPages();
 
 #ifdef ALLOC_INSTRUMENTATION
 	static volatile int32_t pageCount;
@@ -168,10 +176,19 @@ private:
 	static void* freelist;
 
 	static void getMagazine();
+	static void* takeSlabMagazine();
 	static void releaseMagazine(void*);
 };
 
 extern std::atomic<int64_t> g_hugeArenaMemory;
+// Bytes of arena blocks larger than 8KB newly allocated, reused from a thread's cache of freed blocks or the free lists
+// of huge page blocks, and sitting in those caches
+extern std::atomic<int64_t> g_hugeArenaAllocatedBytes;
+extern std::atomic<int64_t> g_hugeArenaRecycledBytes;
+extern std::atomic<int64_t> g_hugeArenaCachedBytes;
+// Bytes of huge pages mapped for arena blocks larger than 8KB with FAST_ALLOC_HUGE_PAGES. Smaller ones come from
+// FastAllocator and are counted by its getHugePageMemory().
+extern std::atomic<int64_t> g_hugeArenaHugePageMemory;
 void hugeArenaSample(int size);
 void releaseAllThreadMagazines();
 int64_t getTotalUnusedAllocatedMemory();
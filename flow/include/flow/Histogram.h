@@ -23,6 +23,8 @@
 #pragma once
 
 #include <flow/Arena.h>
+#include <flow/ThreadShards.h>
+#include <atomic>
 #include <string>
 #include <map>
 #include <unordered_map>
@@ -105,31 +107,18 @@ public:
 	}
 
 	// This histogram buckets samples into powers of two.
-	inline void sample(uint32_t sample) {
-		size_t idx;
-#ifdef _WIN32
-		unsigned long index;
-		// _BitScanReverse sets index to the position of the first non-zero bit, so
-		// _BitScanReverse(sample) ~= log_2(sample).  _BitScanReverse returns false if
-		// sample is zero.
-		idx = _BitScanReverse(&index, sample) ? index : 0;
-#else
-		// __builtin_clz counts the leading zeros in its uint32_t argument.  So, 31-clz ~= log_2(sample).
-		// __builtin_clz(0) is undefined.
-		idx = sample ? (31 - __builtin_clz(sample)) : 0;
-#endif
-		ASSERT(idx < 32);
-		buckets[idx]++;
-	}
+	inline void sample(uint32_t sample) { buckets[powerOfTwoBucket(sample)]++; }
 
-	inline void sampleSeconds(double delta) {
-		uint64_t delta_usec = (delta * 1000000);
-		if (delta_usec > UINT32_MAX) {
-			sample(UINT32_MAX);
-		} else {
-			sample((uint32_t)(delta * 1000000)); // convert to microseconds and truncate to integer
-		}
+	inline void sampleSeconds(double delta) { sample(secondsToMicroseconds(delta)); }
+
+	// Like sample() and sampleSeconds(), but may be called from any thread. Each thread counts into buckets of its
+	// own, which are added into these when the histogram is logged.
+	inline void sampleOnAnyThread(uint32_t sample) {
+		std::atomic<uint32_t>& bucket = threadBuckets.local().buckets[powerOfTwoBucket(sample)];
+		bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 	}
+
+	inline void sampleSecondsOnAnyThread(double delta) { sampleOnAnyThread(secondsToMicroseconds(delta)); }
 	// Histogram buckets samples into linear interval of size 4 percent.
 	inline void samplePercentage(double pct) {
 		ASSERT(pct >= 0.0);
@@ -162,6 +151,9 @@ public:
 			i = 0;
 		}
 	}
+	// Adds in the samples taken by other threads since the last call
+	void collectThreadBuckets();
+
 	void writeToLog(double elapsed = -1.0);
 
 	std::string name() const { return generateName(this->group, this->op); }
@@ -175,6 +167,40 @@ public:
 	uint32_t buckets[32];
 	uint32_t lowerBound;
 	uint32_t upperBound;
+
+private:
+	static size_t powerOfTwoBucket(uint32_t sample) {
+		size_t idx;
+#ifdef _WIN32
+		unsigned long index;
+		// _BitScanReverse sets index to the position of the first non-zero bit, so
+		// _BitScanReverse(sample) ~= log_2(sample).  _BitScanReverse returns false if
+		// sample is zero.
+		idx = _BitScanReverse(&index, sample) ? index : 0;
+#else
+		// __builtin_clz counts the leading zeros in its uint32_t argument.  So, 31-clz ~= log_2(sample).
+		// __builtin_clz(0) is undefined.
+		idx = sample ? (31 - __builtin_clz(sample)) : 0;
+#endif
+		ASSERT(idx < 32);
+		return idx;
+	}
+
+	static uint32_t secondsToMicroseconds(double delta) {
+		uint64_t delta_usec = (delta * 1000000);
+		if (delta_usec > UINT32_MAX) {
+			return UINT32_MAX;
+		}
+		return (uint32_t)(delta * 1000000); // convert to microseconds and truncate to integer
+	}
+
+	struct ThreadBuckets {
+		// Only stored to by the thread sampling into them
+		std::atomic<uint32_t> buckets[32] = {};
+		// What had been added into the histogram's buckets as of the last collectThreadBuckets()
+		uint32_t collected[32] = {};
+	};
+	ThreadShards<ThreadBuckets> threadBuckets;
 };
 
 #endif // FLOW_HISTOGRAM_H
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <string_view>
+#include <vector>
 
 #include "flow/flow.h"
 
@@ -39,6 +40,9 @@
 // Then the caller calls post() as many times as desired.  Each call will invoke the given thread action on
 // any one of the thread pool receivers passed to addThread().
 
+// Actions may be posted in batches with postBatch(), and an action's getPriority() lets a pool that orders its queue
+// run it ahead of (or after) actions posted before it. Pools are free to ignore priorities.
+
 // TypedAction<> is a utility subclass to make it easier to create thread actions and receivers.
 
 // ThreadReturnPromise<> can be safely use to pass return values from thread actions back to the g_network thread
@@ -49,10 +53,14 @@ public:
 	virtual void init() = 0;
 };
 
+enum class ThreadActionPriority { Low = 0, Normal = 1, High = 2 };
+constexpr int threadActionPriorities = 3;
+
 struct ThreadAction {
 	virtual void operator()(IThreadPoolReceiver*) = 0; // self-destructs
 	virtual void cancel() = 0;
 	virtual double getTimeEstimate() const = 0; // for simulation
+	virtual ThreadActionPriority getPriority() const { return ThreadActionPriority::Normal; }
 };
 typedef ThreadAction* PThreadAction;
 
@@ -62,6 +70,11 @@ public:
 	virtual Future<Void> getError() const = 0; // asynchronously throws an error if there is an internal error
 	virtual void addThread(IThreadPoolReceiver* userData, const char* name = nullptr) = 0;
 	virtual void post(PThreadAction action) = 0;
+	virtual void postBatch(std::vector<PThreadAction> const& actions) {
+		for (auto action : actions) {
+			post(action);
+		}
+	}
 	virtual Future<Void> stop(Error const& e = success()) = 0;
 	virtual bool isCoro() const { return false; }
 	virtual void addref() = 0;
@@ -144,8 +157,16 @@ private:
 	PromiseStream<T> promiseStream;
 };
 
+// Returns a work stealing pool if FLOW_KNOBS->THREAD_POOL_WORK_STEALING is set, and otherwise one whose threads all
+// take actions from one queue
 Reference<IThreadPool> createGenericThreadPool(int stackSize = 0, int pri = 10);
 
+// A pool whose threads each have their own queue, with a lane for each ThreadActionPriority. Actions posted from one of
+// its threads go to that thread's queue, and others are spread across the queues round robin. A thread runs the
+// highest priority action it can find: one posted before there were any threads first, then one from its own queue,
+// then one from the others'.
+Reference<IThreadPool> createWorkStealingThreadPool(int stackSize = 0, int pri = 10);
+
 class DummyThreadPool final : public IThreadPool, ReferenceCounted<DummyThreadPool> {
 public:
 	~DummyThreadPool() override {}
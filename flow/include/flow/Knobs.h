@@ -131,8 +131,12 @@ public:
 
 	double FAST_ALLOC_LOGGING_BYTES;
 	bool FAST_ALLOC_ALLOW_GUARD_PAGES;
+	// Carve FastAlloc magazines out of huge pages on the allocating thread's NUMA node (Linux only)
+	bool FAST_ALLOC_HUGE_PAGES;
 	double HUGE_ARENA_LOGGING_BYTES;
 	double HUGE_ARENA_LOGGING_INTERVAL;
+	// Bytes of freed arena blocks larger than 8KB each thread keeps for reuse, 0 to free them right away
+	int64_t ARENA_BLOCK_CACHE_BYTES;
 	// This setting allows to let the fdbserver abort instead of exit to generate coredumps
 	// in case of a failure.
 	bool ABORT_ON_FAILURE;
@@ -198,6 +202,7 @@ public:
 	int TLS_HANDSHAKE_THREAD_STACKSIZE;
 	int TLS_MALLOC_ARENA_MAX;
 	int TLS_HANDSHAKE_LIMIT;
+	bool THREAD_POOL_WORK_STEALING;
 
 	int NETWORK_TEST_CLIENT_COUNT;
 	int NETWORK_TEST_REPLY_SIZE;
@@ -283,6 +288,7 @@ public:
 	int CERT_FILE_MAX_SIZE;
 	int READY_QUEUE_RESERVED_SIZE;
 	int TASKS_PER_REACTOR_CHECK;
+	double TIMER_WHEEL_RESOLUTION; // Seconds per tick of Net2's timer wheel, or 0 to keep timers in a heap
 
 	// Network
 	int64_t PACKET_LIMIT;
@@ -294,6 +300,11 @@ public:
 	int FLOW_TCP_NODELAY;
 	int FLOW_TCP_QUICKACK;
 	bool RESOLVE_PREFER_IPV4_ADDR;
+	bool NETWORK_IO_URING; // Drive TCP connections with io_uring instead of epoll
+	int IO_URING_ENTRIES;
+	int IO_URING_RECEIVE_BUFFERS;
+	int IO_URING_RECEIVE_BUFFER_SIZE;
+	int IO_URING_MAX_UNSENT_BYTES; // Per connection
 
 	// Sim2
 	// FIMXE: more parameters could be factored out
@@ -0,0 +1,259 @@
+/*
+ * ObjectView.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_OBJECT_VIEW_H
+#define FLOW_OBJECT_VIEW_H
+#pragma once
+
+#include <iterator>
+#include <type_traits>
+
+#include "flow/Arena.h"
+#include "flow/ObjectSerializer.h"
+
+namespace detail {
+
+template <class MemberPointer>
+struct member_pointer_traits;
+
+template <class M, class C>
+struct member_pointer_traits<M C::*> {
+	using type = M;
+};
+
+// A flatbuffers table: its fields are found through the vtable it points to
+struct TableRef {
+	const uint16_t* vtable = nullptr;
+	const uint8_t* table = nullptr;
+	uint16_t vtableLength = 0;
+	uint16_t tableLength = 0;
+
+	TableRef() = default;
+	// current points to the offset of the table, as a table member of another table or vector does
+	explicit TableRef(const uint8_t* current) {
+		current += interpret_as<uint32_t>(current);
+		vtable = reinterpret_cast<const uint16_t*>(current - interpret_as<int32_t>(current));
+		table = current;
+		vtableLength = vtable[0] / sizeof(uint16_t);
+		tableLength = vtable[1];
+	}
+
+	// i is the vtable index, which starts at 2 for the first member
+	const uint8_t* field(int i) const { return i < vtableLength && vtable[i] >= 4 ? table + vtable[i] : nullptr; }
+};
+
+// Visits the members of a message the way LoadMember does, to find the vtable index of one of them
+template <class Context>
+struct FieldLocator : Context {
+	static constexpr bool isDeserializing = true;
+	static constexpr bool isSerializing = false;
+	static constexpr bool is_fb_visitor = true;
+
+	const void* target;
+	int index = -1;
+
+	FieldLocator(const void* target, Context& context) : Context(context), target(target) {}
+
+	template <class... Members>
+	void operator()(Members&... members) {
+		int i = 2;
+		for_each(
+		    [&](auto& member) {
+			    using Member = std::decay_t<decltype(member)>;
+			    if (static_cast<const void*>(&member) == target && index < 0) {
+				    index = i;
+			    }
+			    if constexpr (is_vector_of_union_like<Member> || is_union_like<Member>) {
+				    i += 2;
+			    } else if constexpr (_SizeOf<Member>::size != 0) {
+				    ++i;
+			    }
+		    },
+		    members...);
+	}
+};
+
+} // namespace detail
+
+// A read-only view of the elements of a VectorRef member of a message, which deserializes each element when it is
+// accessed instead of building the whole vector. Elements of a VectorRef serialized as flatbuffers can be accessed in
+// any order; those of one serialized as a string (VecSerStrategy::String) only by iterating, since their sizes vary.
+template <class T, VecSerStrategy SerStrategy>
+class VectorView {
+public:
+	VectorView(ArenaObjectReader const& reader, const uint8_t* current) : reader(reader) {
+		if (!current) {
+			return;
+		}
+		current += detail::interpret_as<uint32_t>(current);
+		if constexpr (SerStrategy == VecSerStrategy::String) {
+			// The elements follow the size of the string and the number of elements
+			if (detail::interpret_as<uint32_t>(current) < sizeof(uint32_t)) {
+				return;
+			}
+			current += sizeof(uint32_t);
+		}
+		count = detail::interpret_as<uint32_t>(current);
+		elements = current + sizeof(uint32_t);
+	}
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	T operator[](int i) const {
+		static_assert(SerStrategy == VecSerStrategy::FlatBuffers, "String serialized vectors can only be iterated");
+		ASSERT(i >= 0 && i < count);
+		T value;
+		LoadContext<ArenaObjectReader> context(&reader);
+		detail::load_helper(value, elements + i * detail::fb_size<T>, context);
+		return value;
+	}
+
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		const_iterator(VectorView const* view, int index, const uint8_t* current)
+		  : view(view), index(index), current(current) {
+			load();
+		}
+
+		reference operator*() const { return value; }
+		pointer operator->() const { return &value; }
+		const_iterator& operator++() {
+			current += valueBytes;
+			++index;
+			load();
+			return *this;
+		}
+		bool operator==(const_iterator const& rhs) const { return index == rhs.index; }
+		bool operator!=(const_iterator const& rhs) const { return index != rhs.index; }
+
+	private:
+		void load() {
+			if (index >= view->count) {
+				return;
+			}
+			LoadContext<ArenaObjectReader> context(&view->reader);
+			if constexpr (SerStrategy == VecSerStrategy::String) {
+				valueBytes = string_serialized_traits<T>().load(current, value, context);
+			} else {
+				detail::load_helper(value, current, context);
+				valueBytes = detail::fb_size<T>;
+			}
+		}
+
+		VectorView const* view;
+		int index;
+		const uint8_t* current;
+		int valueBytes = 0;
+		T value;
+	};
+
+	const_iterator begin() const { return const_iterator(this, 0, elements); }
+	const_iterator end() const { return const_iterator(this, count, nullptr); }
+
+private:
+	static_assert(!detail::is_union_like<T>, "Vectors of unions can't be viewed");
+
+	mutable ArenaObjectReader reader;
+	const uint8_t* elements = nullptr;
+	int count = 0;
+};
+
+// A read-only view of a message of type T as written by ObjectWriter, which deserializes only the members it is asked
+// for, in place in the received buffer, instead of materializing the whole message. StringRefs and the like point into
+// the buffer, which the view keeps alive through the reader's arena, and VectorRef members can be read an element at a
+// time through getVector(), so that reading a large reply doesn't rebuild its vectors.
+//
+// Members are named by pointer to member, as in view.get<&GetKeyValuesReply::more>(). Their position in the message is
+// found once per member from T::serialize(), which therefore must not depend on the protocol version.
+template <class T>
+class ObjectView {
+public:
+	explicit ObjectView(ArenaObjectReader const& messageReader) : reader(messageReader) {
+		static_assert(detail::expect_serialize_member<T>, "Only messages with a serialize() method can be viewed");
+		const uint8_t* data = reader.data();
+		ASSERT(read_file_identifier(data) == FileIdentifierFor<T>::value);
+		// ObjectWriter serializes T as the only member of a root table
+		const uint8_t* current = detail::TableRef(data).field(2);
+		if (current) {
+			table = detail::TableRef(current);
+		}
+	}
+
+	template <class VersionOptions>
+	ObjectView(Arena const& arena, StringRef message, VersionOptions vo)
+	  : ObjectView(ArenaObjectReader(arena, message, vo)) {}
+
+	// Returns a copy of the given member, which is default constructed if the message doesn't have it
+	template <auto Member>
+	typename detail::member_pointer_traits<decltype(Member)>::type get() const {
+		typename detail::member_pointer_traits<decltype(Member)>::type member{};
+		LoadContext<ArenaObjectReader> context(&reader);
+		int i = fieldIndex<Member>();
+		detail::LoadMember<LoadContext<ArenaObjectReader>>{
+			table.vtable, table.table, table.vtableLength, table.tableLength, i, context
+		}(member);
+		return member;
+	}
+
+	template <auto Member>
+	auto getVector() const {
+		using Vector = typename detail::member_pointer_traits<decltype(Member)>::type;
+		return makeVectorView(static_cast<Vector const*>(nullptr), table.field(fieldIndex<Member>()));
+	}
+
+	Arena const& arena() const { return reader.arena(); }
+
+private:
+	template <class Element, VecSerStrategy SerStrategy>
+	VectorView<Element, SerStrategy> makeVectorView(VectorRef<Element, SerStrategy> const*,
+	                                                const uint8_t* current) const {
+		return VectorView<Element, SerStrategy>(reader, current);
+	}
+
+	template <auto Member>
+	int fieldIndex() const {
+		static const int index = [this] {
+			LoadContext<ArenaObjectReader> context(&reader);
+			detail::FieldLocator<LoadContext<ArenaObjectReader>> locator(nullptr, context);
+			T message;
+			locator.target = &(message.*Member);
+			if constexpr (serializable_traits<T>::value) {
+				serializable_traits<T>::serialize(locator, message);
+			} else {
+				message.serialize(locator);
+			}
+			ASSERT(locator.index >= 0);
+			return locator.index;
+		}();
+		return index;
+	}
+
+	mutable ArenaObjectReader reader;
+	detail::TableRef table;
+};
+
+#endif
@@ -313,6 +313,13 @@ void setMemoryQuota(size_t limit);
 
 void* allocate(size_t length, bool allowLargePages, bool includeGuardPages);
 
+inline constexpr size_t kHugePageBytes = 2 << 20;
+
+// Allocates length bytes, a multiple of kHugePageBytes, aligned to kHugePageBytes and placed on the calling thread's
+// NUMA node. They are backed by huge pages if the system has any reserved, and otherwise by transparent huge pages if
+// it allows them. Sets hugePages to whether it got or asked for either. Elsewhere than Linux this is just allocate().
+void* allocateHugePages(size_t length, bool& hugePages);
+
 void setAffinity(int proc);
 
 void threadSleep(double seconds);
@@ -22,24 +22,30 @@
 #define FLOW_TASK_QUEUE_H
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <queue>
 #include <vector>
 #include "flow/TDMetric.actor.h"
+#include "flow/Deque.h"
 #include "flow/network.h"
 #include "flow/ThreadSafeQueue.h"
+#include "flow/TimerWheel.h"
 
 template <typename Task>
 // A queue of ordered tasks, both ready to execute, and delayed for later execution.
 // All functions must be called on the main thread, except for addReadyThreadSafe() which can be called from any thread.
+// Task must have an isCancelled() method, which returns true if running it would have no effect.
 class TaskQueue {
 public:
-	TaskQueue() : tasksIssued(0), ready(FLOW_KNOBS->READY_QUEUE_RESERVED_SIZE) {}
+	TaskQueue() : tasksIssued(0), timers(FLOW_KNOBS->TIMER_WHEEL_RESOLUTION) {}
 
 	// Add a task that is ready to be executed.
 	void addReady(TaskPriority taskId, Task* t) { this->ready.push(OrderedTask(getFIFOPriority(taskId), taskId, t)); }
 	// Add a task to be executed at a given future time instant (a "timer").
 	void addTimer(double at, TaskPriority taskId, Task* t) {
-		this->timers.push(DelayedTask(at, getFIFOPriority(taskId), taskId, t));
+		this->timers.push(at, OrderedTask(getFIFOPriority(taskId), taskId, t));
 	}
 	// Add a task that is ready to be executed, potentially called from a thread that is different from main.
 	// Returns true iff the main thread need to be woken up to execute this task.
@@ -65,9 +71,10 @@ public:
 		return b;
 	}
 	// Returns a time interval a caller should sleep from now until the next timer.
-	double getSleepTime(double now) const {
-		if (!timers.empty()) {
-			return timers.top().at - now;
+	double getSleepTime(double now) {
+		Optional<double> next = timers.nextTime();
+		if (next.present()) {
+			return next.get() - now;
 		}
 		return 0;
 	}
@@ -75,12 +82,11 @@ public:
 	// Moves all timers that are scheduled to be executed at or before now to the ready queue.
 	void processReadyTimers(double now) {
 		[[maybe_unused]] int numTimers = 0;
-		while (!timers.empty() && timers.top().at <= now + INetwork::TIME_EPS) {
+		timers.popUntil(now + INetwork::TIME_EPS, [&](OrderedTask const& t) {
 			++numTimers;
 			++countTimers;
-			ready.push(timers.top());
-			timers.pop();
-		}
+			ready.push(t);
+		});
 		FDB_TRACE_PROBE(run_loop_ready_timers, numTimers);
 	}
 
@@ -112,10 +118,8 @@ public:
 	}
 
 	void clear() {
-		decltype(ready) _1;
-		ready.swap(_1);
-		decltype(timers) _2;
-		timers.swap(_2);
+		ready.clear();
+		timers.clear();
 	}
 
 private:
@@ -128,19 +132,124 @@ private:
 		bool operator<(OrderedTask const& rhs) const { return priority < rhs.priority; }
 	};
 
-	struct DelayedTask : OrderedTask {
-		double at;
-		DelayedTask(double at, int64_t priority, TaskPriority taskID, Task* task)
-		  : OrderedTask(priority, taskID, task), at(at) {}
-		bool operator<(DelayedTask const& rhs) const { return at > rhs.at; } // Ordering is reversed for priority_queue
+	// Timers whose tasks were cancelled are freed without being run
+	struct DiscardCancelled {
+		bool operator()(OrderedTask const& t) const {
+			if (t.task->isCancelled()) {
+				delete t.task;
+				return true;
+			}
+			return false;
+		}
 	};
 
-	template <class T>
-	class ReadyQueue : public std::priority_queue<T, std::vector<T>> {
+	// Ready tasks in a bucket per TaskPriority, with a bitmap of the non-empty buckets. Buckets are created the first
+	// time a priority is seen and kept ordered from highest to lowest priority. Tasks come out in the same order as
+	// from a priority queue of their FIFO priorities. Tasks added as ready have the newest FIFO priority of their
+	// bucket, so each bucket keeps them in a FIFO queue and adding or taking one doesn't depend on the number of ready
+	// tasks. Timers that come due keep the FIFO priority they were added with, so they can belong ahead of tasks
+	// already in the bucket, and go in a heap of their own.
+	class ReadyQueue {
 	public:
-		typedef typename std::priority_queue<T, std::vector<T>>::size_type size_type;
-		ReadyQueue(size_type capacity = 0) { reserve(capacity); };
-		void reserve(size_type capacity) { this->c.reserve(capacity); }
+		void push(OrderedTask const& t) {
+			const int bucket = getBucket(t.taskID);
+			buckets[bucket].push(t);
+			nonEmpty[bucket / 64] |= uint64_t(1) << (bucket % 64);
+			++count;
+		}
+		OrderedTask const& top() const { return buckets[firstNonEmpty()].top(); }
+		void pop() {
+			const int bucket = firstNonEmpty();
+			buckets[bucket].pop();
+			if (buckets[bucket].empty()) {
+				nonEmpty[bucket / 64] &= ~(uint64_t(1) << (bucket % 64));
+			}
+			--count;
+		}
+		bool empty() const { return count == 0; }
+		size_t size() const { return count; }
+		void clear() {
+			for (auto& bucket : buckets) {
+				bucket.tasks.clear();
+				bucket.earlier = std::priority_queue<OrderedTask>();
+			}
+			std::fill(nonEmpty.begin(), nonEmpty.end(), 0);
+			count = 0;
+		}
+
+	private:
+		struct Bucket {
+			TaskPriority taskID;
+			// Tasks in FIFO order
+			Deque<OrderedTask> tasks;
+			// Tasks that belong ahead of the back of tasks
+			std::priority_queue<OrderedTask> earlier;
+
+			void push(OrderedTask const& t) {
+				if (tasks.empty() || t < tasks.back()) {
+					tasks.push_back(t);
+				} else {
+					earlier.push(t);
+				}
+			}
+			bool earlierFirst() const { return !earlier.empty() && (tasks.empty() || tasks.front() < earlier.top()); }
+			OrderedTask const& top() const { return earlierFirst() ? earlier.top() : tasks.front(); }
+			void pop() {
+				if (earlierFirst()) {
+					earlier.pop();
+				} else {
+					tasks.pop_front();
+				}
+			}
+			bool empty() const { return tasks.empty() && earlier.empty(); }
+		};
+
+		struct CachedBucket {
+			TaskPriority taskID = TaskPriority::Zero;
+			int bucket = -1;
+		};
+
+		int firstNonEmpty() const {
+			for (int word = 0;; ++word) {
+				if (nonEmpty[word]) {
+					return word * 64 + std::countr_zero(nonEmpty[word]);
+				}
+			}
+		}
+
+		int getBucket(TaskPriority taskID) {
+			CachedBucket& cached = cache[static_cast<size_t>(taskID) % cache.size()];
+			if (cached.bucket >= 0 && cached.taskID == taskID) {
+				return cached.bucket;
+			}
+			auto it = std::lower_bound(buckets.begin(), buckets.end(), taskID, [](Bucket const& b, TaskPriority p) {
+				return b.taskID > p;
+			});
+			const int bucket = it - buckets.begin();
+			if (it == buckets.end() || it->taskID != taskID) {
+				addBucket(bucket, taskID);
+			}
+			cached = CachedBucket{ taskID, bucket };
+			return bucket;
+		}
+
+		// Rare: only the first time a task is added at a priority
+		void addBucket(int bucket, TaskPriority taskID) {
+			buckets.insert(buckets.begin() + bucket, Bucket{ taskID, Deque<OrderedTask>(), {} });
+			nonEmpty.assign((buckets.size() + 63) / 64, 0);
+			for (int i = 0; i < buckets.size(); ++i) {
+				if (!buckets[i].empty()) {
+					nonEmpty[i / 64] |= uint64_t(1) << (i % 64);
+				}
+			}
+			cache.fill(CachedBucket());
+		}
+
+		std::vector<Bucket> buckets;
+		std::vector<uint64_t> nonEmpty;
+		// Bucket indices by priority, direct mapped
+		std::array<CachedBucket, 256> cache;
+		size_t count = 0;
 	};
 
 	// Returns a unique priority value for a task which preserves FIFO ordering
@@ -148,10 +257,10 @@ private:
 	int64_t getFIFOPriority(TaskPriority taskId) { return (int64_t(taskId) << 32) - (++tasksIssued); }
 	uint64_t tasksIssued;
 
-	ReadyQueue<OrderedTask> ready;
+	ReadyQueue ready;
 	ThreadSafeQueue<std::pair<TaskPriority, Task*>> threadReady;
 
-	std::priority_queue<DelayedTask, std::vector<DelayedTask>> timers;
+	TimerWheel<OrderedTask, DiscardCancelled> timers;
 
 	Int64MetricHandle countTimers;
 	Int64MetricHandle countCantSleep;
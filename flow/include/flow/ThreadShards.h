@@ -0,0 +1,110 @@
+/*
+ * ThreadShards.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_THREAD_SHARDS_H
+#define FLOW_THREAD_SHARDS_H
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "flow/Arena.h"
+#include "flow/ThreadPrimitives.h"
+
+namespace detail {
+
+struct ThreadShardSlot {
+	void* shard = nullptr;
+	uint64_t owner = 0;
+};
+
+// The calling thread's shard of each ThreadShards, by slot
+inline thread_local std::vector<ThreadShardSlot> threadShardSlots;
+
+// Returns a free slot, and a number no ThreadShards has had before to tell its shards apart from those left in the
+// slot by an earlier one
+std::pair<int, uint64_t> allocateThreadShardSlot();
+void freeThreadShardSlot(int slot);
+
+} // namespace detail
+
+// One copy (shard) of some state per thread that updates it, so that threads don't share cache lines or contend on
+// atomics. A thread's shard is created the first time it calls local(), and kept until the ThreadShards is destroyed,
+// so what threads that have exited did can still be aggregated.
+//
+// forEach() runs on one thread while the others go on updating their shards, so a Shard has to be readable while its
+// thread writes it: typically relaxed atomics that only that thread stores to, or a lock only contended by forEach().
+template <class Shard>
+class ThreadShards : NonCopyable {
+public:
+	ThreadShards() { std::tie(slot, owner) = detail::allocateThreadShardSlot(); }
+	~ThreadShards() { detail::freeThreadShardSlot(slot); }
+
+	// Returns the calling thread's shard, which is constructed from args if this is the thread's first call
+	template <class... Args>
+	Shard& local(Args&&... args) {
+		auto& slots = detail::threadShardSlots;
+		if (slot < slots.size() && slots[slot].owner == owner) {
+			return *static_cast<Shard*>(slots[slot].shard);
+		}
+		return addLocal(std::forward<Args>(args)...);
+	}
+
+	template <class F>
+	void forEach(F&& f) const {
+		MutexHolder holder(mutex);
+		for (auto const& padded : shards) {
+			f(padded->shard);
+		}
+	}
+
+private:
+	struct alignas(MAX_CACHE_LINE_SIZE) PaddedShard {
+		Shard shard;
+
+		template <class... Args>
+		explicit PaddedShard(Args&&... args) : shard(std::forward<Args>(args)...) {}
+	};
+
+	template <class... Args>
+	Shard& addLocal(Args&&... args) {
+		auto padded = std::make_unique<PaddedShard>(std::forward<Args>(args)...);
+		Shard& shard = padded->shard;
+		{
+			MutexHolder holder(mutex);
+			shards.push_back(std::move(padded));
+		}
+		auto& slots = detail::threadShardSlots;
+		if (slot >= slots.size()) {
+			slots.resize(slot + 1);
+		}
+		slots[slot] = { &shard, owner };
+		return shard;
+	}
+
+	int slot;
+	uint64_t owner;
+	mutable Mutex mutex;
+	std::vector<std::unique_ptr<PaddedShard>> shards;
+};
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * TimerWheel.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_TIMER_WHEEL_H
+#define FLOW_TIMER_WHEEL_H
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include "flow/Error.h"
+#include "flow/Optional.h"
+
+struct NeverDiscard {
+	template <class T>
+	bool operator()(T const&) const {
+		return false;
+	}
+};
+
+// A hierarchical timing wheel: a queue of values ordered by the time they are due at, where adding a value that isn't
+// due soon is O(1).
+//
+// Values due at or before the wheel's cursor tick are kept in a binary heap ordered by their exact time. Later values
+// are kept in one of four levels of 256 slots, level l slots each spanning 256^l ticks of the given resolution, and are
+// cascaded down the levels into the heap once the cursor reaches their slot. Values too far ahead for the top level
+// wait in an overflow list. The heap always holds the earliest values, so values come out in the same order whatever
+// the resolution, which keeps simulation deterministic. A resolution of 0 keeps every value in the heap.
+//
+// Values for which Discard returns true when they are cascaded or come due are dropped instead, so that cancelled
+// timers can be freed without being run. Discard is responsible for freeing anything they own.
+template <class T, class Discard = NeverDiscard>
+class TimerWheel {
+public:
+	explicit TimerWheel(double resolution = 0) : resolution(resolution) {}
+
+	void push(double at, T const& value) {
+		++count;
+		insert(Entry{ at, value });
+	}
+
+	// Calls f with each value due at or before time, in order, and removes them
+	template <class F>
+	void popUntil(double time, F const& f) {
+		if (resolution > 0) {
+			advance(tickOf(time));
+		}
+		while (!heap.empty() && heap.top().at <= time) {
+			T value = heap.top().value;
+			heap.pop();
+			--count;
+			if (!discard(value)) {
+				f(value);
+			}
+		}
+	}
+
+	// Returns when the next value is due, or an empty Optional if there are no values left
+	Optional<double> nextTime() {
+		while (true) {
+			while (!heap.empty() && discard(heap.top().value)) {
+				heap.pop();
+				--count;
+			}
+			if (!heap.empty()) {
+				return heap.top().at;
+			}
+			// Slots aren't ordered, so rather than scan the earliest one on every call, cascade it until its earliest
+			// values reach the heap. This moves the cursor past the current time, but only to the next value's tick,
+			// so the values inserted before it comes due that go to the heap instead of a slot are due soon anyway.
+			if (resolution <= 0 || !cascadeNext(std::numeric_limits<int64_t>::max())) {
+				return {};
+			}
+		}
+	}
+
+	bool empty() const { return count == 0; }
+	// Includes values that will be discarded
+	size_t size() const { return count; }
+
+	void clear() { *this = TimerWheel(resolution); }
+
+private:
+	struct Entry {
+		double at;
+		T value;
+		// Ordering is reversed for priority_queue
+		bool operator<(Entry const& rhs) const { return at > rhs.at; }
+	};
+
+	static constexpr int levelBits = 8;
+	static constexpr int levels = 4;
+	static constexpr int slotsPerLevel = 1 << levelBits;
+
+	int64_t tickOf(double at) const { return int64_t(std::floor(at / resolution)); }
+
+	void insert(Entry&& entry) {
+		if (resolution <= 0) {
+			heap.push(std::move(entry));
+			return;
+		}
+		const int64_t tick = tickOf(entry.at);
+		if (tick <= cursor) {
+			heap.push(std::move(entry));
+			return;
+		}
+		// The lowest level whose slots share the cursor's higher order ticks
+		for (int level = 0; level < levels; ++level) {
+			if ((tick >> (levelBits * (level + 1))) == (cursor >> (levelBits * (level + 1)))) {
+				const int slot = (tick >> (levelBits * level)) & (slotsPerLevel - 1);
+				slots[level][slot].push_back(std::move(entry));
+				occupied[level][slot / 64] |= uint64_t(1) << (slot % 64);
+				return;
+			}
+		}
+		overflowMinTick = overflow.empty() ? tick : std::min(overflowMinTick, tick);
+		overflow.push_back(std::move(entry));
+	}
+
+	// Finds the occupied slot with the earliest values. Values in a level all come before values in higher levels, and
+	// within a level only slots after the cursor's are occupied.
+	bool nextSlot(int& level, int& slot, int64_t& start) const {
+		for (level = 0; level < levels; ++level) {
+			const int current = (cursor >> (levelBits * level)) & (slotsPerLevel - 1);
+			for (int word = (current + 1) / 64; word < slotsPerLevel / 64; ++word) {
+				uint64_t bits = occupied[level][word];
+				if (word == (current + 1) / 64) {
+					bits &= ~uint64_t(0) << ((current + 1) % 64);
+				}
+				if (bits) {
+					slot = word * 64 + std::countr_zero(bits);
+					const int blockShift = levelBits * (level + 1);
+					start = ((cursor >> blockShift) << blockShift) | (int64_t(slot) << (levelBits * level));
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Cascades the earliest occupied slot, or the overflow list if every slot is empty, unless it starts after tick.
+	// Returns whether there was one to cascade.
+	bool cascadeNext(int64_t tick) {
+		int level, slot;
+		int64_t start;
+		if (nextSlot(level, slot, start)) {
+			if (start > tick) {
+				return false;
+			}
+			cursor = start;
+			cascade(slots[level][slot]);
+			occupied[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+			return true;
+		}
+		if (!overflow.empty()) {
+			const int topShift = levelBits * levels;
+			start = (overflowMinTick >> topShift) << topShift;
+			if (start > tick) {
+				return false;
+			}
+			cursor = start;
+			cascade(overflow);
+			return true;
+		}
+		return false;
+	}
+
+	// Moves the cursor to tick, cascading every value due by the end of it into the heap
+	void advance(int64_t tick) {
+		while (cascadeNext(tick)) {
+		}
+		// Nothing is due before the end of tick, so every slot still occupied is past it
+		cursor = std::max(cursor, tick);
+	}
+
+	void cascade(std::vector<Entry>& entries) {
+		std::vector<Entry> cascading;
+		cascading.swap(entries);
+		for (auto& entry : cascading) {
+			if (discard(entry.value)) {
+				--count;
+			} else {
+				insert(std::move(entry));
+			}
+		}
+		// Values in a slot never cascade back into it, so keep its allocation
+		if (entries.empty()) {
+			cascading.clear();
+			entries.swap(cascading);
+		}
+	}
+
+	double resolution;
+	Discard discard;
+	int64_t cursor = 0;
+	size_t count = 0;
+	std::priority_queue<Entry, std::vector<Entry>> heap;
+	std::array<std::array<std::vector<Entry>, slotsPerLevel>, levels> slots;
+	std::array<std::array<uint64_t, slotsPerLevel / 64>, levels> occupied{};
+	std::vector<Entry> overflow;
+	int64_t overflowMinTick = 0;
+};
+
+#endif /* FLOW_TIMER_WHEEL_H */
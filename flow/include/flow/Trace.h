@@ -31,6 +31,7 @@
 #include <map>
 #include <set>
 #include <type_traits>
+#include <variant>
 #include "flow/BooleanParam.h"
 #include "flow/IRandom.h"
 #include "flow/Error.h"
@@ -121,6 +122,16 @@ public:
 	void addField(const std::string& key, const std::string& value);
 	void addField(std::string&& key, std::string&& value);
 
+	// Integer and double details are kept as numbers, and the trace log formatters turn them into strings on the
+	// writer thread. Until then the values of their fields are empty, except to tryGetValue() and toString().
+	typedef std::variant<int64_t, uint64_t, double> Number;
+	void addField(std::string&& key, Number value);
+	// The number held by the field at index, or nullptr if the field's value is a string
+	const Number* getNumber(int index) const;
+	// Makes the numbers the values of their fields
+	void formatValues();
+	static std::string formatNumber(const Number& value);
+
 	const Field& operator[](int index) const;
 	bool tryGetValue(std::string key, std::string& outValue) const;
 	std::string getValue(std::string key) const;
@@ -145,6 +156,7 @@ public:
 
 private:
 	FieldContainer fields;
+	std::vector<std::pair<int, Number>> numbers; // By field index
 	size_t bytes;
 	bool annotated;
 };
@@ -215,6 +227,21 @@ struct SpecialTraceMetricType
 
 TRACE_METRIC_TYPE(double, double);
 
+// Details of these types are added to the event as numbers, see TraceEventFields::Number
+template <class T>
+constexpr bool isTraceNumber = std::is_integral_v<std::remove_cv_t<T>> || std::is_same_v<std::remove_cv_t<T>, double>;
+
+template <class T>
+TraceEventFields::Number toTraceNumber(const T& value) {
+	if constexpr (std::is_same_v<std::remove_cv_t<T>, double>) {
+		return double(value);
+	} else if constexpr (std::is_signed_v<T>) {
+		return int64_t(value);
+	} else {
+		return uint64_t(value);
+	}
+}
+
 class AuditedEvent;
 
 inline constexpr AuditedEvent operator""_audit(const char*, size_t) noexcept;
@@ -279,6 +306,10 @@ struct SWIFT_CXX_IMPORT_OWNED BaseTraceEvent {
 	typename std::enable_if<Traceable<T>::value && !std::is_enum_v<T>, BaseTraceEvent&>::type detail(std::string&& key,
 	                                                                                                 const T& value) {
 		if (enabled && init()) {
+			if constexpr (isTraceNumber<T>) {
+				setField(key.c_str(), SpecialTraceMetricType<std::remove_cv_t<T>>::getValue(value));
+				return detailNumber(std::move(key), toTraceNumber(value));
+			}
 			auto s = Traceable<T>::toString(value);
 			addMetric(key.c_str(), value, s);
 			return detailImpl(std::move(key), std::move(s), false);
@@ -290,6 +321,10 @@ struct SWIFT_CXX_IMPORT_OWNED BaseTraceEvent {
 	typename std::enable_if<Traceable<T>::value && !std::is_enum_v<T>, BaseTraceEvent&>::type detail(const char* key,
 	                                                                                                 const T& value) {
 		if (enabled && init()) {
+			if constexpr (isTraceNumber<T>) {
+				setField(key, SpecialTraceMetricType<std::remove_cv_t<T>>::getValue(value));
+				return detailNumber(std::string(key), toTraceNumber(value));
+			}
 			auto s = Traceable<T>::toString(value);
 			addMetric(key, value, s);
 			return detailImpl(std::string(key), std::move(s), false);
@@ -379,6 +414,7 @@ protected:
 	// which can write field metrics of a more appropriate type than string but use detailf() to add to the TraceEvent.
 	BaseTraceEvent& detailfNoMetric(std::string&& key, const char* valueFormat, ...);
 	BaseTraceEvent& detailImpl(std::string&& key, std::string&& value, bool writeEventMetricField = true);
+	BaseTraceEvent& detailNumber(std::string&& key, TraceEventFields::Number value);
 
 public:
 	BaseTraceEvent& backtrace(const std::string& prefix = "");
@@ -561,6 +597,13 @@ void closeTraceFile();
 bool traceFileIsOpen();
 void flushTraceFileVoid();
 
+// Appends records, in a format of the caller's choosing, to a binary log: a set of files that are named, rolled and
+// cleaned up like the trace files, but with the given extension. The records are written by the trace log writer
+// thread. Returns false, without writing anything, if the trace files are not open.
+bool writeBinaryTraceLog(std::string const& extension, std::string&& records);
+// Returns the paths of this process's files of the binary log with the given extension, oldest first.
+std::vector<std::string> getBinaryTraceLogFiles(std::string const& extension);
+
 // Changes the format of trace files. Returns false if the format is unrecognized. No longer safe to call after a call
 // to openTraceFile.
 bool selectTraceFormatter(std::string format);
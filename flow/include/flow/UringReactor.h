@@ -0,0 +1,171 @@
+/*
+ * UringReactor.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_URINGREACTOR_H
+#define FLOW_URINGREACTOR_H
+#pragma once
+
+#ifdef FLOW_USE_IO_URING
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <liburing.h>
+
+#include "flow/flow.h"
+#include "flow/Deque.h"
+
+namespace N2 { // No indent, it's the whole file
+
+class UringReactor;
+
+// The io_uring side of one TCP connection driven by a UringReactor. Data is received by a multishot receive into
+// buffers the kernel picks from the reactor's provided buffer ring, so read() copies out of memory instead of making a
+// syscall. write() copies data into a send buffer that the reactor sends, together with those of every other
+// connection, in one io_uring_submit() per run loop iteration.
+//
+// The socket itself still belongs to the Connection. Each operation in flight holds a reference, so that this outlives
+// them.
+class UringSocket final : public ReferenceCounted<UringSocket>, NonCopyable {
+public:
+	~UringSocket();
+
+	// Copies received data into [begin,end) and returns the number of bytes copied. Returns 0 if there is none; then
+	// error() tells whether more could arrive.
+	int read(uint8_t* begin, uint8_t* end);
+
+	// Queues up to limit bytes of the given SendBuffer chain to be sent, and returns the number of bytes queued (might
+	// be 0 if too many bytes are already waiting to be sent)
+	int write(SendBuffer const* data, int limit);
+
+	// Ready when read() would return data, or the connection has failed
+	Future<Void> onReadable();
+	// Ready when write() would queue data, or the connection has failed
+	Future<Void> onWritable();
+
+	// Set once the connection fails or the peer closes it; data received before that can still be read
+	boost::system::error_code const& error() const { return err; }
+
+	// Cancels the receive. Must be called before the socket is closed, since operations in flight keep it open.
+	void close();
+
+private:
+	friend class UringReactor;
+
+	UringSocket(UringReactor* reactor, int fd) : reactor(reactor), fd(fd) {}
+
+	struct Received {
+		uint16_t buffer;
+		int offset;
+		int length;
+	};
+
+	int sendSpace() const;
+	void fail(boost::system::error_code const& e);
+	void queueSubmit();
+
+	UringReactor* reactor;
+	int fd;
+	bool closed = false;
+	boost::system::error_code err;
+
+	Deque<Received> received;
+	bool receiving = false;
+	Promise<Void> readable;
+
+	// Bytes being sent, of which sendOffset have been sent so far, and bytes waiting for them to finish
+	std::vector<uint8_t> sending;
+	size_t sendOffset = 0;
+	bool sendInFlight = false;
+	std::vector<uint8_t> unsent;
+	Promise<Void> writable;
+
+	// Whether this is in the reactor's list of sockets to submit operations for
+	bool submitQueued = false;
+};
+
+// Drives the TCP connections of a Net2 with io_uring, alongside ASIOReactor, which still drives everything else. The
+// ring's completions signal an eventfd watched by ASIOReactor's io_context, so that sleeping in the io_context wakes up
+// for them.
+class UringReactor : NonCopyable {
+public:
+	// Returns nullptr, after logging why, if this kernel doesn't support what the reactor needs (Linux 6.0 or later)
+	static std::unique_ptr<UringReactor> create(boost::asio::io_context& ios);
+	~UringReactor();
+
+	Reference<UringSocket> attach(int fd);
+
+	// Submits the receives and sends queued since the last call, in a single syscall
+	void submit();
+
+	// Handles the completions the kernel has posted, and returns how many there were
+	int poll();
+
+private:
+	friend class UringSocket;
+
+	// The operation is kept in the low bits of the UringSocket pointer each operation's user data holds
+	enum class Op : uintptr_t { Receive = 1, Send = 2, Cancel = 3 };
+	static constexpr uintptr_t opMask = 3;
+	static constexpr int bufferGroup = 0;
+
+	struct Completion {
+		uint64_t userData;
+		int result;
+		uint32_t flags;
+	};
+
+	explicit UringReactor(boost::asio::io_context& ios);
+
+	io_uring_sqe* getSqe();
+	void prepare(UringSocket* socket);
+	void complete(UringSocket* socket, Op op, int result, uint32_t flags);
+	void returnBuffer(uint16_t buffer);
+	void watchEventFD();
+
+	io_uring ring;
+	bool ringInitialized = false;
+	io_uring_buf_ring* bufferRing = nullptr;
+	std::unique_ptr<uint8_t[]> buffers;
+	int bufferCount = 0;
+	int bufferSize = 0;
+	// Buffers given back since the buffer ring was last advanced
+	int returnedBuffers = 0;
+	int freeBuffers = 0;
+
+	boost::asio::posix::stream_descriptor eventDescriptor;
+	uint64_t eventValue = 0;
+
+	std::vector<Reference<UringSocket>> submitQueue;
+	std::vector<Reference<UringSocket>> submitting;
+	std::vector<Completion> completions;
+	// Sockets whose receive stopped because every buffer was in use
+	std::vector<Reference<UringSocket>> waitingForBuffers;
+	// Whether operations have been prepared but not submitted
+	bool unsubmitted = false;
+};
+
+} // namespace N2
+
+#endif // FLOW_USE_IO_URING
+
+#endif
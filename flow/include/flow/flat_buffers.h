@@ -693,6 +693,9 @@ struct VTableSet {
 	// Sorted map
 	std::vector<std::pair<const VTable*, int>> offsets;
 	std::vector<uint8_t> packed_tables;
+	// Whether every table in the message has only fixed size members (no vectors, unions or dynamically sized
+	// members), so that where everything is written doesn't depend on the message's contents
+	bool fixed_layout = true;
 };
 
 template <class Context>
@@ -714,10 +717,15 @@ struct TraverseMessageTypes : Context {
 	};
 
 	template <class T>
-	std::enable_if_t<!expect_serialize_member<T> && !is_vector_like<T> && !is_union_like<T>> operator()(const T&) {}
+	std::enable_if_t<!expect_serialize_member<T> && !is_vector_like<T> && !is_union_like<T>> operator()(const T&) {
+		if constexpr (is_dynamic_size<T>) {
+			f.fixed_layout = false;
+		}
+	}
 
 	template <class VectorLike>
 	std::enable_if_t<is_vector_like<VectorLike>> operator()(const VectorLike& members) {
+		f.fixed_layout = false;
 		using VectorTraits = vector_like_traits<VectorLike>;
 		using T = typename VectorTraits::value_type;
 		// we don't need to check for recursion here because the next call
@@ -732,6 +740,7 @@ struct TraverseMessageTypes : Context {
 		using UnionTraits = union_like_traits<UnionLike>;
 		static_assert(pack_size(typename UnionTraits::alternatives{}) <= 254,
 		              "Up to 254 alternatives are supported for unions");
+		f.fixed_layout = false;
 		union_helper(typename UnionTraits::alternatives{});
 	}
 
@@ -752,6 +761,7 @@ struct InsertVTableLambda : Context {
 	static constexpr bool isSerializing = false;
 	static constexpr bool is_fb_visitor = true;
 	std::set<const VTable*>& vtables;
+	bool fixed_layout = true;
 
 	template <class... Members>
 	void operator()(const Members&... members) {
@@ -789,7 +799,7 @@ VTableSet get_vtableset_impl(const Root& root, const Context& context) {
 		offsets.push_back({ vtable, i });
 		i += vec_bytes(vtable->begin(), vtable->end());
 	}
-	return VTableSet{ offsets, packed_tables };
+	return VTableSet{ offsets, packed_tables, vlambda.fixed_layout };
 }
 
 template <class Root, class Context>
@@ -1307,9 +1317,18 @@ auto fake_root(Members&... members) {
 	return FakeRoot<Members...>(members...);
 }
 
+// Where each part of a message goes, as computed by PrecomputeSize
+struct MessageLayout {
+	int size;
+	int vtable_start;
+	std::vector<int> writeToOffsets;
+};
+
 template <class Context, class Root>
-uint8_t* save(Context& context, const Root& root, FileIdentifier file_identifier) {
-	const auto* vtableset = get_vtableset(root, context);
+uint8_t* save_any_layout(Context& context,
+                         const Root& root,
+                         const VTableSet* vtableset,
+                         FileIdentifier file_identifier) {
 	PrecomputeSize<Context> precompute_size(context);
 	int vtable_start;
 	save_with_vtables(root, vtableset, precompute_size, &vtable_start, file_identifier, context);
@@ -1321,6 +1340,35 @@ uint8_t* save(Context& context, const Root& root, FileIdentifier file_identifier
 	return out;
 }
 
+// Saves a message with a fixed layout, computing the layout only the first time a Root is saved on this thread. The
+// message is written exactly as save_any_layout() would.
+template <class Context, class Root>
+uint8_t* save_fixed_layout(Context& context,
+                           const Root& root,
+                           const VTableSet* vtableset,
+                           FileIdentifier file_identifier) {
+	static thread_local MessageLayout layout = [&] {
+		PrecomputeSize<Context> precompute_size(context);
+		int vtable_start;
+		save_with_vtables(root, vtableset, precompute_size, &vtable_start, file_identifier, context);
+		return MessageLayout{ precompute_size.current_buffer_size, vtable_start, precompute_size.writeToOffsets };
+	}();
+	uint8_t* out = context.allocate(layout.size);
+	WriteToBuffer writeToBuffer{ context, layout.size, layout.vtable_start, out, layout.writeToOffsets.begin() };
+	int vtable_start;
+	save_with_vtables(root, vtableset, writeToBuffer, &vtable_start, file_identifier, context);
+	return out;
+}
+
+template <class Context, class Root>
+uint8_t* save(Context& context, const Root& root, FileIdentifier file_identifier) {
+	const auto* vtableset = get_vtableset(root, context);
+	if (vtableset->fixed_layout) {
+		return save_fixed_layout(context, root, vtableset, file_identifier);
+	}
+	return save_any_layout(context, root, vtableset, file_identifier);
+}
+
 template <class Root, class Context>
 void load(Root& root, const uint8_t* in, Context& context) {
 	detail::load_helper(root, in, context);
@@ -27,6 +27,9 @@
 #include "flow/network.h"
 #include "flow/ThreadHelper.actor.h"
 #include "flow/IAsyncFile.h"
+#include "flow/IConnection.h"
+#include "flow/Net2Packet.h"
+#include "fdbclient/IKnobCollection.h"
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -77,3 +80,78 @@ static void bench_ionet2(benchmark::State& benchState) {
 }
 
 BENCHMARK(bench_ionet2)->Range(1, 1 << 16)->ReportAggregatesOnly(true);
+
+ACTOR static Future<Void> sendMessages(Reference<IConnection> conn, int messageBytes, int messages) {
+	state UnsentPacketQueue packets;
+	state std::string message(messageBytes, 'x');
+	state int queued = 0;
+	while (queued < messages) {
+		// Queue a batch of messages and write them out, as connectionWriter does
+		{
+			PacketWriter writer(packets.getWriteBuffer(messageBytes), nullptr, Unversioned());
+			for (int i = 0; i < 64 && queued < messages; ++i, ++queued) {
+				writer.serializeBytes(StringRef(message));
+			}
+			packets.setWriteBuffer(writer.finish());
+		}
+		loop {
+			int sent = conn->write(packets.getUnsent(), FLOW_KNOBS->MAX_PACKET_SEND_BYTES);
+			if (sent) {
+				packets.sent(sent);
+			}
+			if (packets.empty()) {
+				break;
+			}
+			wait(conn->onWritable());
+			wait(yield(TaskPriority::WriteSocket));
+		}
+	}
+	return Void();
+}
+
+ACTOR static Future<Void> receiveBytes(Reference<IConnection> conn, int64_t bytes) {
+	state std::vector<uint8_t> buffer(FLOW_KNOBS->MIN_PACKET_BUFFER_BYTES * 16);
+	state int64_t received = 0;
+	while (received < bytes) {
+		int readBytes = conn->read(buffer.data(), buffer.data() + buffer.size());
+		received += readBytes;
+		if (readBytes == 0) {
+			wait(conn->onReadable());
+			wait(delay(0, TaskPriority::ReadSocket));
+		}
+	}
+	return Void();
+}
+
+// Streams messages over a loopback TCP connection. Both ends run on the one network thread, so items per second is
+// messages per second per core.
+ACTOR static Future<Void> benchNet2LoopbackActor(benchmark::State* benchState) {
+	state int messageBytes = benchState->range(0);
+	state bool useIoUring = benchState->range(1);
+	state int messages = std::max(64, (16 << 20) / messageBytes);
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_io_uring",
+	                                                          KnobValueRef::create(bool{ useIoUring }));
+
+	state Reference<IListener> listener = INetworkConnections::net()->listen(NetworkAddress::parse("127.0.0.1:0"));
+	state Future<Reference<IConnection>> accepted = listener->accept();
+	state Reference<IConnection> client = wait(INetworkConnections::net()->connect(listener->getListenAddress()));
+	state Reference<IConnection> server = wait(accepted);
+
+	while (benchState->KeepRunning()) {
+		wait(sendMessages(client, messageBytes, messages) && receiveBytes(server, int64_t(messages) * messageBytes));
+	}
+	benchState->SetItemsProcessed(int64_t(messages) * benchState->iterations());
+	benchState->SetBytesProcessed(int64_t(messages) * messageBytes * benchState->iterations());
+
+	client->close();
+	server->close();
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob("network_io_uring", KnobValueRef::create(bool{ false }));
+	return Void();
+}
+
+static void bench_net2_loopback(benchmark::State& benchState) {
+	onMainThread([&benchState] { return benchNet2LoopbackActor(&benchState); }).blockUntilReady();
+}
+
+// The second argument selects io_uring, which only makes a difference in builds with FLOW_USE_IO_URING
+BENCHMARK(bench_net2_loopback)->ArgsProduct({ { 64, 1024, 16384 }, { 0, 1 } })->UseRealTime();
@@ -21,6 +21,7 @@
 #include "benchmark/benchmark.h"
 
 #include "fdbclient/BuildIdempotencyIdMutations.h"
+#include "fdbclient/IdempotencyIdExpiry.h"
 
 // We don't want the compiler to know that this is always false. It is though.
 static bool getRuntimeFalse() {
@@ -57,3 +58,67 @@ static void bench_add_idempotency_ids(benchmark::State& state) {
 }
 
 BENCHMARK(bench_add_idempotency_ids)->ArgsProduct({ benchmark::CreateRange(1, 16384, 4), { 0, 16, 255 } });
+
+// Everything a commit proxy does per commit batch for idempotency ids: building the idempotency id values, tracking
+// them until their clients expire them, and clearing them. Batches are cleared in groups, as they would be with
+// IDEMPOTENCY_ID_CLEAR_INTERVAL. An idSize of 0 measures the overhead without idempotency ids.
+static void bench_idempotency_commit_overhead(benchmark::State& state) {
+	auto numTransactions = state.range(0);
+	auto idSize = state.range(1);
+	bool compactFormat = state.range(2);
+	constexpr int batchesPerClear = 16;
+	auto trs = std::vector<CommitTransactionRequest>(numTransactions);
+	IdempotencyIdKVBuilder idempotencyKVBuilder;
+	idempotencyKVBuilder.setCompactFormat(compactFormat);
+	IdempotencyIdExpiry expiry;
+	Version commitVersion = 0;
+	auto committed = std::vector<uint8_t>(numTransactions, 1);
+	for (auto& tr : trs) {
+		if (idSize > 0) {
+			auto id = makeString(idSize, tr.arena);
+			deterministicRandom()->randomBytes(mutateString(id), idSize);
+			tr.idempotencyId = IdempotencyIdRef(tr.arena, IdempotencyIdRef(id));
+		}
+	}
+	bool locked = getRuntimeFalse();
+	int64_t bytes = 0;
+	int64_t clearCount = 0;
+	std::vector<std::pair<uint8_t, int16_t>> idCounts;
+	for (auto _ : state) {
+		Version prevVersion = commitVersion;
+		commitVersion += 10;
+		idCounts.clear();
+		buildIdempotencyIdMutations(
+		    trs, idempotencyKVBuilder, commitVersion, committed, 1, locked, [&](const KeyValue& kv) {
+			    bytes += kv.expectedSize();
+		    });
+		if (idSize > 0) {
+			for (int h = 0; h * 256 < numTransactions; ++h) {
+				idCounts.emplace_back(h, std::min<int64_t>(numTransactions - h * 256, 256));
+			}
+		}
+		expiry.addBatch(prevVersion, commitVersion, idCounts, 0);
+		for (auto [highOrderBatchIndex, count] : idCounts) {
+			for (int i = 0; i < count; ++i) {
+				expiry.expire(commitVersion, highOrderBatchIndex, 0);
+			}
+		}
+		if (commitVersion % (10 * batchesPerClear) == 0) {
+			Standalone<VectorRef<MutationRef>> clears;
+			expiry.takeClears(clears);
+			for (auto const& clear : clears) {
+				bytes += clear.expectedSize();
+			}
+			clearCount += clears.size();
+		}
+	}
+	state.counters["TimePerTransaction"] = benchmark::Counter(
+	    state.iterations() * numTransactions, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters["BytesPerTransaction"] =
+	    benchmark::Counter(double(bytes) / std::max<int64_t>(1, state.iterations() * numTransactions));
+	state.counters["ClearsPerBatch"] =
+	    benchmark::Counter(double(clearCount) / std::max<int64_t>(1, state.iterations()));
+}
+
+BENCHMARK(bench_idempotency_commit_overhead)
+    ->ArgsProduct({ benchmark::CreateRange(1, 4096, 8), { 0, 16, 32 }, { 0, 1 } });
@@ -18,11 +18,23 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 
+#include "fdbclient/IKnobCollection.h"
+#include "flow/Arena.h"
+#include "flow/FastAlloc.h"
+#include "flow/Platform.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 static void bench_memcmp(benchmark::State& state) {
 	constexpr int kLength = 10000;
 	std::unique_ptr<char[]> b1{ new char[kLength] };
@@ -47,5 +59,76 @@ static void bench_memcpy(benchmark::State& state) {
 	}
 }
 
+// Creates and frees an arena holding one reply of the given size, the way a storage server serves range reads, with
+// or without the thread's cache of freed arena blocks
+static void bench_arena_huge_block(benchmark::State& state) {
+	const int bytes = state.range(0);
+	const bool cache = state.range(1);
+	const int64_t cacheBytes = FLOW_KNOBS->ARENA_BLOCK_CACHE_BYTES;
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob(
+	    "arena_block_cache_bytes", KnobValueRef::create(int64_t{ cache ? 32LL << 20 : 0 }));
+	const int64_t allocated = g_hugeArenaAllocatedBytes.load();
+	const int64_t recycled = g_hugeArenaRecycledBytes.load();
+
+	for (auto _ : state) {
+		Arena arena(bytes);
+		uint8_t* reply = new (arena) uint8_t[bytes];
+		reply[0] = reply[bytes - 1] = 1;
+		benchmark::DoNotOptimize(reply);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["AllocatedBytes"] = g_hugeArenaAllocatedBytes.load() - allocated;
+	state.counters["RecycledBytes"] = g_hugeArenaRecycledBytes.load() - recycled;
+	IKnobCollection::getMutableGlobalKnobCollection().setKnob(
+	    "arena_block_cache_bytes", KnobValueRef::create(int64_t{ cacheBytes }));
+}
+
 BENCHMARK(bench_memcmp);
 BENCHMARK(bench_memcpy);
+BENCHMARK(bench_arena_huge_block)->ArgsProduct({ { 16 << 10, 1 << 20, 4 << 20 }, { 0, 1 } });
+
+#ifdef __linux__
+// Reads memory laid out the way FastAlloc lays out magazines, one page at a time in random order so that each read
+// needs a TLB entry of its own. The magazines are either mapped one by one, as by default, or carved out of huge page
+// slabs, as with FAST_ALLOC_HUGE_PAGES.
+static void bench_magazine_random_access(benchmark::State& state) {
+	const size_t bytes = size_t(state.range(0)) << 20;
+	const bool slabs = state.range(1);
+	constexpr size_t kStride = 4096;
+
+	std::vector<std::pair<uint8_t*, size_t>> mappings;
+	std::vector<uint8_t*> pages;
+	bool hugePages = false;
+	for (size_t allocated = 0; allocated < bytes;) {
+		const size_t length = slabs ? kFastAllocSlabBytes : kFastAllocMagazineBytes;
+		uint8_t* block = (uint8_t*)(slabs ? allocateHugePages(length, hugePages)
+		                                  : allocate(length, /*allowLargePages*/ false, /*includeGuardPages*/ false));
+		mappings.emplace_back(block, length);
+		for (size_t offset = 0; offset < length; offset += kStride) {
+			pages.push_back(block + offset);
+		}
+		allocated += length;
+	}
+
+	// Link the pages into a single cycle in random order
+	std::shuffle(pages.begin(), pages.end(), std::mt19937(1));
+	for (size_t i = 0; i < pages.size(); ++i) {
+		*reinterpret_cast<void**>(pages[i]) = pages[(i + 1) % pages.size()];
+	}
+
+	void* p = pages[0];
+	for (auto _ : state) {
+		p = *reinterpret_cast<void**>(p);
+		benchmark::DoNotOptimize(p);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["HugePages"] = hugePages;
+	state.counters["TlbFootprint"] = slabs && hugePages ? mappings.size() : pages.size();
+
+	for (auto [block, length] : mappings) {
+		munmap(block, length);
+	}
+}
+
+BENCHMARK(bench_magazine_random_access)->ArgsProduct({ { 64, 1024 }, { 0, 1 } });
+#endif
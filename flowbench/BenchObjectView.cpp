@@ -0,0 +1,65 @@
+/*
+ * BenchObjectView.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/StorageServerInterface.h"
+#include "flow/ObjectView.h"
+
+static Standalone<StringRef> makeGetKeyValuesReply(int rows) {
+	GetKeyValuesReply reply;
+	for (int i = 0; i < rows; ++i) {
+		reply.data.push_back_deep(reply.arena, KeyValueRef(format("key%08d", i), std::string(100, 'v')));
+	}
+	reply.version = 1;
+	reply.more = true;
+	return ObjectWriter::toValue(reply, Unversioned());
+}
+
+// Reads a range read reply the way a client consumes it, either deserializing all of it or through an ObjectView
+static void bench_get_key_values_reply(benchmark::State& state) {
+	const int rows = state.range(0);
+	const bool view = state.range(1);
+	Standalone<StringRef> message = makeGetKeyValuesReply(rows);
+
+	for (auto _ : state) {
+		int64_t bytes = 0;
+		if (view) {
+			ObjectView<GetKeyValuesReply> reply(message.arena(), message, Unversioned());
+			for (auto const& kv : reply.getVector<&GetKeyValuesReply::data>()) {
+				bytes += kv.expectedSize();
+			}
+			benchmark::DoNotOptimize(reply.get<&GetKeyValuesReply::more>());
+		} else {
+			GetKeyValuesReply reply;
+			ArenaObjectReader reader(message.arena(), message, Unversioned());
+			reader.deserialize(reply);
+			for (auto const& kv : reply.data) {
+				bytes += kv.expectedSize();
+			}
+			benchmark::DoNotOptimize(reply.more);
+		}
+		benchmark::DoNotOptimize(bytes);
+	}
+	state.SetItemsProcessed(int64_t(rows) * state.iterations());
+	state.SetBytesProcessed(int64_t(message.size()) * state.iterations());
+}
+
+BENCHMARK(bench_get_key_values_reply)->ArgsProduct({ { 10, 1000, 10000 }, { 0, 1 } });
@@ -0,0 +1,144 @@
+/*
+ * BenchRPCSerialization.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/CommitProxyInterface.h"
+#include "fdbclient/StorageServerInterface.h"
+#include "flow/ThreadHelper.actor.h"
+
+// Replies are sent as ErrorOr<EnsureTable<Reply>>, as FlowTransport does
+template <class Reply>
+using WireReply = ErrorOr<EnsureTable<Reply>>;
+
+// Gives messages typical contents; the others are sent as default constructed
+template <class T>
+static void fill(T&) {}
+
+template <class Reply>
+static void fill(WireReply<Reply>& reply) {
+	reply = Reply();
+}
+
+static void fill(GetValueRequest& req) {
+	req.key = "user/0000123456"_sr;
+	req.version = 1;
+}
+
+static void fill(GetKeyValuesRequest& req) {
+	req.begin = firstGreaterOrEqual(StringRef(req.arena, "user/0000123456"_sr));
+	req.end = firstGreaterOrEqual(StringRef(req.arena, "user/0000123999"_sr));
+	req.version = 1;
+	req.limit = 100;
+	req.limitBytes = 80000;
+}
+
+static void fill(CommitTransactionRequest& req) {
+	for (int i = 0; i < 10; ++i) {
+		KeyRef key = StringRef(req.arena, format("user/%010d", i));
+		req.transaction.mutations.push_back_deep(req.arena, MutationRef(MutationRef::SetValue, key, "value"_sr));
+		req.transaction.write_conflict_ranges.push_back_deep(req.arena, singleKeyRange(key));
+	}
+	req.transaction.read_snapshot = 1;
+}
+
+static void fill(WireReply<GetValueReply>& reply) {
+	reply = GetValueReply(Optional<Value>(Value(std::string(100, 'v'))), false);
+}
+
+static void fill(WireReply<GetKeyValuesReply>& reply) {
+	GetKeyValuesReply kvs;
+	for (int i = 0; i < 100; ++i) {
+		kvs.data.push_back_deep(kvs.arena, KeyValueRef(format("user/%010d", i), std::string(100, 'v')));
+	}
+	kvs.version = 1;
+	reply = kvs;
+}
+
+template <class T>
+static T makeMessage() {
+	T message;
+	fill(message);
+	return message;
+}
+
+// Serializing a request registers its reply endpoint with FlowTransport, and deserializing one waits for the reply, so
+// both run on the network thread
+template <class T>
+static void bench_rpc_serialize(benchmark::State& state) {
+	onMainThread([&] {
+		T message = makeMessage<T>();
+		int64_t bytes = 0;
+		for (auto _ : state) {
+			ObjectWriter writer(AssumeVersion(g_network->protocolVersion()));
+			writer.serialize(message);
+			bytes += writer.toStringRef().size();
+		}
+		state.SetItemsProcessed(state.iterations());
+		state.SetBytesProcessed(bytes);
+		return Future<Void>(Void());
+	}).blockUntilReady();
+}
+
+template <class T>
+static void bench_rpc_deserialize(benchmark::State& state) {
+	onMainThread([&] {
+		Standalone<StringRef> serialized =
+		    ObjectWriter::toValue(makeMessage<T>(), AssumeVersion(g_network->protocolVersion()));
+		for (auto _ : state) {
+			T message;
+			ArenaObjectReader reader(serialized.arena(), serialized, AssumeVersion(g_network->protocolVersion()));
+			reader.deserialize(message);
+			if constexpr (HasReply<T>) {
+				// Lets the reply's sender finish without sending anything
+				message.reply.sendError(never_reply());
+			}
+			benchmark::DoNotOptimize(message);
+		}
+		state.SetItemsProcessed(state.iterations());
+		state.SetBytesProcessed(int64_t(serialized.size()) * state.iterations());
+		return Future<Void>(Void());
+	}).blockUntilReady();
+}
+
+#define BENCH_RPC_MESSAGE(T)                                                                                           \
+	BENCHMARK_TEMPLATE(bench_rpc_serialize, T);                                                                        \
+	BENCHMARK_TEMPLATE(bench_rpc_deserialize, T)
+
+BENCH_RPC_MESSAGE(GetValueRequest);
+BENCH_RPC_MESSAGE(WireReply<GetValueReply>);
+BENCH_RPC_MESSAGE(GetKeyRequest);
+BENCH_RPC_MESSAGE(WireReply<GetKeyReply>);
+BENCH_RPC_MESSAGE(GetKeyValuesRequest);
+BENCH_RPC_MESSAGE(WireReply<GetKeyValuesReply>);
+BENCH_RPC_MESSAGE(GetMappedKeyValuesRequest);
+BENCH_RPC_MESSAGE(WireReply<GetMappedKeyValuesReply>);
+BENCH_RPC_MESSAGE(WatchValueRequest);
+BENCH_RPC_MESSAGE(WireReply<WatchValueReply>);
+BENCH_RPC_MESSAGE(GetReadVersionRequest);
+BENCH_RPC_MESSAGE(WireReply<GetReadVersionReply>);
+BENCH_RPC_MESSAGE(CommitTransactionRequest);
+BENCH_RPC_MESSAGE(WireReply<CommitID>);
+BENCH_RPC_MESSAGE(GetKeyServerLocationsRequest);
+BENCH_RPC_MESSAGE(WireReply<GetKeyServerLocationsReply>);
+BENCH_RPC_MESSAGE(StorageQueuingMetricsRequest);
+BENCH_RPC_MESSAGE(WireReply<StorageQueuingMetricsReply>);
+BENCH_RPC_MESSAGE(GetStorageMetricsRequest);
+BENCH_RPC_MESSAGE(WireReply<GetStorageMetricsReply>);
@@ -0,0 +1,157 @@
+/*
+ * BenchStorageTagIndex.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/StorageTagIndex.h"
+
+static constexpr int KEY_SIZE = 16;
+static constexpr int TEAMS = 64;
+
+// Builds a keyInfo map with the given number of shards, each served by one of TEAMS triples of tags, and returns
+// the shard boundaries.
+static std::vector<Key> populateKeyInfo(KeyRangeMap<ServerCacheInfo>& keyInfo, int shards) {
+	std::vector<Key> boundaries;
+	for (int i = 0; i < shards; i++) {
+		boundaries.push_back(Key(deterministicRandom()->randomAlphaNumeric(KEY_SIZE)));
+	}
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+	for (int i = 0; i < boundaries.size(); i++) {
+		ServerCacheInfo info;
+		const int team = deterministicRandom()->randomInt(0, TEAMS);
+		for (int j = 0; j < 3; j++) {
+			info.tags.emplace_back(0, 3 * team + j);
+		}
+		keyInfo.insert(KeyRangeRef(boundaries[i], i + 1 < boundaries.size() ? boundaries[i + 1] : allKeys.end), info);
+	}
+	return boundaries;
+}
+
+static std::vector<Key> randomKeys(int count) {
+	std::vector<Key> keys;
+	for (int i = 0; i < count; i++) {
+		keys.push_back(Key(deterministicRandom()->randomAlphaNumeric(KEY_SIZE)));
+	}
+	return keys;
+}
+
+static void bench_key_range_map_tags_for_key(benchmark::State& state) {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	populateKeyInfo(keyInfo, state.range(0));
+	auto keys = randomKeys(1024);
+	size_t i = 0;
+	for (auto _ : state) {
+		auto r = keyInfo.rangeContaining(keys[i++ % keys.size()]);
+		r.value().populateTags();
+		benchmark::DoNotOptimize(r.value().tags.data());
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+static void bench_storage_tag_index_tags_for_key(benchmark::State& state) {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	populateKeyInfo(keyInfo, state.range(0));
+	StorageTagIndex index;
+	index.rebuild(keyInfo);
+	auto keys = randomKeys(1024);
+	size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(index.tagsForKey(keys[i++ % keys.size()]).data());
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+// Clears that each span width + 1 shards, or fewer near the end of the key space
+static std::vector<KeyRange> randomClears(const std::vector<Key>& boundaries, int width) {
+	std::vector<KeyRange> clears;
+	for (int i = 0; i < 1024; i++) {
+		const int first = deterministicRandom()->randomInt(0, boundaries.size());
+		const int last = std::min<int>(first + width, boundaries.size() - 1);
+		clears.push_back(KeyRangeRef(keyAfter(boundaries[first]), keyAfter(boundaries[last])));
+	}
+	return clears;
+}
+
+static void bench_key_range_map_tags_for_range(benchmark::State& state) {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	auto clears = randomClears(populateKeyInfo(keyInfo, state.range(0)), state.range(1));
+	size_t i = 0;
+	for (auto _ : state) {
+		std::set<Tag> tags;
+		for (auto r : keyInfo.intersectingRanges(clears[i++ % clears.size()])) {
+			r.value().populateTags();
+			tags.insert(r.value().tags.begin(), r.value().tags.end());
+		}
+		benchmark::DoNotOptimize(tags.size());
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+static void bench_storage_tag_index_tags_for_range(benchmark::State& state) {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	auto clears = randomClears(populateKeyInfo(keyInfo, state.range(0)), state.range(1));
+	StorageTagIndex index;
+	index.rebuild(keyInfo);
+	size_t i = 0;
+	for (auto _ : state) {
+		std::set<Tag> tags;
+		const std::vector<Tag>* single = index.tagsForRange(clears[i++ % clears.size()], tags);
+		benchmark::DoNotOptimize(single ? single->size() : tags.size());
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+static void bench_storage_tag_index_rebuild(benchmark::State& state) {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	populateKeyInfo(keyInfo, state.range(0));
+	StorageTagIndex index;
+	for (auto _ : state) {
+		index.rebuild(keyInfo);
+		benchmark::DoNotOptimize(index.shardCount());
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+// A shard move: one shard's tags change, and the index is patched. Includes the rebuilds that fold the overlay back
+// into the flat copy.
+static void bench_storage_tag_index_update(benchmark::State& state) {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	auto boundaries = populateKeyInfo(keyInfo, state.range(0));
+	StorageTagIndex index;
+	index.rebuild(keyInfo);
+	size_t i = 0;
+	for (auto _ : state) {
+		const int shard = deterministicRandom()->randomInt(0, boundaries.size());
+		KeyRangeRef range(boundaries[shard], shard + 1 < boundaries.size() ? boundaries[shard + 1] : allKeys.end);
+		ServerCacheInfo info;
+		info.tags.emplace_back(0, 3 * (i++ % TEAMS));
+		keyInfo.insert(range, info);
+		index.update(keyInfo, range);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+BENCHMARK(bench_key_range_map_tags_for_key)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK(bench_storage_tag_index_tags_for_key)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK(bench_key_range_map_tags_for_range)->ArgsProduct({ { 1 << 12, 1 << 16 }, { 0, 1, 8 } });
+BENCHMARK(bench_storage_tag_index_tags_for_range)->ArgsProduct({ { 1 << 12, 1 << 16 }, { 0, 1, 8 } });
+BENCHMARK(bench_storage_tag_index_rebuild)->RangeMultiplier(16)->Range(16, 1 << 16);
+BENCHMARK(bench_storage_tag_index_update)->RangeMultiplier(16)->Range(16, 1 << 16);
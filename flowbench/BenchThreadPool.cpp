@@ -0,0 +1,147 @@
+/*
+ * BenchThreadPool.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "flow/IThreadPool.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+constexpr int tasksPerIteration = 1000;
+constexpr int shortTaskWork = 100;
+constexpr int longTaskWork = 100 * shortTaskWork;
+
+void spin(int work) {
+	uint64_t x = work;
+	for (int i = 0; i < work; ++i) {
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		benchmark::DoNotOptimize(x);
+	}
+}
+
+struct BenchReceiver final : IThreadPoolReceiver {
+	void init() override {}
+};
+
+// With the default knobs, createGenericThreadPool() is the pool whose threads share one queue
+Reference<IThreadPool> createBenchThreadPool(bool workStealing, int threads) {
+	Reference<IThreadPool> pool = workStealing ? createWorkStealingThreadPool() : createGenericThreadPool();
+	for (int i = 0; i < threads; ++i) {
+		pool->addThread(new BenchReceiver(), "bench-pool");
+	}
+	return pool;
+}
+
+struct Task final : ThreadAction {
+	int work;
+	int children;
+	IThreadPool* pool;
+	std::atomic<int>* completed;
+
+	Task(int work, int children, IThreadPool* pool, std::atomic<int>* completed)
+	  : work(work), children(children), pool(pool), completed(completed) {}
+
+	void operator()(IThreadPoolReceiver*) override {
+		if (children > 0) {
+			std::vector<PThreadAction> actions;
+			for (int i = 0; i < children; ++i) {
+				actions.push_back(new Task(work, 0, pool, completed));
+			}
+			pool->postBatch(actions);
+		}
+		spin(work);
+		completed->fetch_add(1, std::memory_order_release);
+		delete this;
+	}
+	void cancel() override { delete this; }
+	double getTimeEstimate() const override { return 0; }
+};
+
+void waitForTasks(std::atomic<int>& completed, int count) {
+	while (completed.load(std::memory_order_acquire) < count) {
+		std::this_thread::yield();
+	}
+}
+
+} // namespace
+
+// Posts a mix of short and long tasks from outside the pool, one at a time or as a batch
+static void bench_thread_pool_mixed(benchmark::State& state) {
+	int threads = state.range(0);
+	int longPercent = state.range(1);
+	bool workStealing = state.range(2);
+	bool batched = state.range(3);
+	Reference<IThreadPool> pool = createBenchThreadPool(workStealing, threads);
+
+	std::atomic<int> completed;
+	std::vector<PThreadAction> actions;
+	for (auto _ : state) {
+		completed.store(0);
+		actions.clear();
+		for (int i = 0; i < tasksPerIteration; ++i) {
+			// Spreads the long tasks out instead of posting them together
+			int work = (i * 37) % 100 < longPercent ? longTaskWork : shortTaskWork;
+			actions.push_back(new Task(work, 0, pool.getPtr(), &completed));
+		}
+		if (batched) {
+			pool->postBatch(actions);
+		} else {
+			for (auto action : actions) {
+				pool->post(action);
+			}
+		}
+		waitForTasks(completed, tasksPerIteration);
+	}
+	state.SetItemsProcessed(tasksPerIteration * state.iterations());
+	pool->stop();
+}
+
+// Each thread runs a task that posts the rest of the work from inside the pool, which the work stealing pool puts in
+// that thread's own queue for the others to steal
+static void bench_thread_pool_fan_out(benchmark::State& state) {
+	int threads = state.range(0);
+	bool workStealing = state.range(1);
+	Reference<IThreadPool> pool = createBenchThreadPool(workStealing, threads);
+
+	int children = tasksPerIteration / threads - 1;
+	int tasks = threads * (children + 1);
+	std::atomic<int> completed;
+	for (auto _ : state) {
+		completed.store(0);
+		for (int i = 0; i < threads; ++i) {
+			pool->post(new Task(shortTaskWork, children, pool.getPtr(), &completed));
+		}
+		waitForTasks(completed, tasks);
+	}
+	state.SetItemsProcessed(tasks * state.iterations());
+	pool->stop();
+}
+
+BENCHMARK(bench_thread_pool_mixed)
+    ->ArgsProduct({ { 1, 4, 16 }, { 0, 10 }, { 0, 1 }, { 0, 1 } })
+    ->ArgNames({ "threads", "longPercent", "workStealing", "batched" })
+    ->UseRealTime();
+BENCHMARK(bench_thread_pool_fan_out)
+    ->ArgsProduct({ { 1, 4, 16 }, { 0, 1 } })
+    ->ArgNames({ "threads", "workStealing" })
+    ->UseRealTime();
@@ -21,6 +21,10 @@
 #include "benchmark/benchmark.h"
 
 #include "flow/Platform.h"
+#include "flow/IRandom.h"
+#include "flow/TimerWheel.h"
+
+#include <vector>
 
 static void bench_timer(benchmark::State& state) {
 	for (auto _ : state) {
@@ -38,3 +42,48 @@ static void bench_timer_monotonic(benchmark::State& state) {
 
 BENCHMARK(bench_timer)->ReportAggregatesOnly(true);
 BENCHMARK(bench_timer_monotonic)->ReportAggregatesOnly(true);
+
+namespace {
+
+int cancelledTimerPercent = 0;
+
+// Whether a timer was cancelled before it was due, as a function of its id
+struct DiscardCancelledTimers {
+	bool operator()(uint32_t id) const { return (id * 2654435761u) % 100 < cancelledTimerPercent; }
+};
+
+} // namespace
+
+// Keeps state.range(0) timers outstanding, mostly timeouts of a few seconds like those created by timeoutError() and
+// failure monitoring, while time advances in small steps like a busy run loop. state.range(2) percent of timers are
+// cancelled before they're due. A resolution (state.range(1), in microseconds) of 0 keeps timers in a binary heap, as
+// Net2 did before TIMER_WHEEL_RESOLUTION, anything else uses the timing wheel.
+static void bench_timer_queue(benchmark::State& state) {
+	const size_t outstanding = state.range(0);
+	const double resolution = state.range(1) / 1e6;
+	cancelledTimerPercent = state.range(2);
+	TimerWheel<uint32_t, DiscardCancelledTimers> timers(resolution);
+	std::vector<double> timeouts(1 << 16);
+	for (auto& timeout : timeouts) {
+		timeout = deterministicRandom()->random01() < 0.1 ? 60 * deterministicRandom()->random01()
+		                                                  : 5 * deterministicRandom()->random01();
+	}
+	double now = 1.7e9;
+	uint32_t nextId = 0;
+	int64_t fired = 0;
+	int64_t added = 0;
+	for (auto _ : state) {
+		now += 1e-4;
+		timers.popUntil(now, [&](uint32_t) { ++fired; });
+		while (timers.size() < outstanding) {
+			timers.push(now + timeouts[nextId % timeouts.size()], nextId);
+			++nextId;
+			++added;
+		}
+	}
+	state.counters["TimersAdded"] = benchmark::Counter(added, benchmark::Counter::kIsRate);
+	state.counters["TimersFired"] = benchmark::Counter(fired, benchmark::Counter::kIsRate);
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+BENCHMARK(bench_timer_queue)->ArgsProduct({ { 1 << 10, 1 << 14, 1 << 18 }, { 0, 1000 }, { 0, 90 } });
@@ -0,0 +1,83 @@
+/*
+ * BenchTuple.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/Tuple.h"
+
+// An index entry as written by a typical layer: (subspace, index name, value, primary key). The argument is the length
+// of the indexed value; every 16th value contains a null that must be escaped.
+static Tuple indexTuple(int valueLength, int i) {
+	std::string value = deterministicRandom()->randomAlphaNumeric(valueLength);
+	if (i % 16 == 0 && valueLength > 0) {
+		value[valueLength / 2] = '\x00';
+	}
+	return Tuple::makeTuple(
+	    "idx"_sr, Tuple::UnicodeStr("by_email"_sr), StringRef(value), deterministicRandom()->randomInt64(0, 1e12));
+}
+
+static void bench_tuple_pack(benchmark::State& state) {
+	const int valueLength = state.range(0);
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < 64; i++) {
+		tuples.push_back(indexTuple(valueLength, i));
+	}
+	size_t i = 0;
+	for (auto _ : state) {
+		const Tuple& t = tuples[i++ % tuples.size()];
+		Tuple packed = Tuple::makeTuple(
+		    t.getString(0), Tuple::UnicodeStr(t.getString(1)), t.getString(2).contents(), t.getInt(3));
+		benchmark::DoNotOptimize(packed.pack().size());
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+static void bench_tuple_unpack(benchmark::State& state) {
+	const int valueLength = state.range(0);
+	std::vector<Standalone<StringRef>> keys;
+	for (int i = 0; i < 64; i++) {
+		keys.push_back(indexTuple(valueLength, i).pack());
+	}
+	size_t i = 0;
+	for (auto _ : state) {
+		Tuple t = Tuple::unpack(keys[i++ % keys.size()]);
+		benchmark::DoNotOptimize(t.getString(2).size() + t.getInt(3));
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+// Decodes only the primary key, the last element of the index entry
+static void bench_tuple_unpack_element(benchmark::State& state) {
+	const int valueLength = state.range(0);
+	std::vector<Standalone<StringRef>> keys;
+	for (int i = 0; i < 64; i++) {
+		keys.push_back(indexTuple(valueLength, i).pack());
+	}
+	size_t i = 0;
+	for (auto _ : state) {
+		StringRef element = Tuple::elementRawString(keys[i++ % keys.size()], 3);
+		benchmark::DoNotOptimize(Tuple::unpack(element).getInt(0));
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+BENCHMARK(bench_tuple_pack)->Arg(0)->Arg(16)->Arg(256);
+BENCHMARK(bench_tuple_unpack)->Arg(0)->Arg(16)->Arg(256);
+BENCHMARK(bench_tuple_unpack_element)->Arg(0)->Arg(16)->Arg(256);
@@ -0,0 +1,56 @@
+/*
+ * BenchWriteMap.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2024 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/WriteMap.h"
+
+static constexpr int KEY_SIZE = 16;
+static constexpr int VALUE_SIZE = 100;
+
+// Client-side write map work of one transaction: each key is set and then read back, and the commit walks the whole
+// map. The first argument is the flat entry limit (0 always uses the tree), the second the number of keys written.
+static void bench_write_map_transaction(benchmark::State& state) {
+	const int flatEntryLimit = state.range(0);
+	const int writes = state.range(1);
+	std::vector<Key> keys;
+	for (int i = 0; i < writes; i++) {
+		keys.push_back(Key(deterministicRandom()->randomAlphaNumeric(KEY_SIZE)));
+	}
+	Value value(deterministicRandom()->randomAlphaNumeric(VALUE_SIZE));
+
+	for (auto _ : state) {
+		Arena arena;
+		WriteMap map(&arena, flatEntryLimit);
+		for (const auto& key : keys) {
+			map.mutate(key, MutationRef::SetValue, value, true);
+			WriteMap::iterator it(&map);
+			it.skip(key);
+			benchmark::DoNotOptimize(it.is_operation());
+		}
+		WriteMap::iterator it(&map);
+		for (it.skip(allKeys.begin); it.beginKey() < allKeys.end; ++it) {
+			benchmark::DoNotOptimize(it.is_conflict_range());
+		}
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+BENCHMARK(bench_write_map_transaction)->ArgsProduct({ { 0, 32 }, { 1, 4, 8, 16, 64 } });